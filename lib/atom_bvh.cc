@@ -0,0 +1,521 @@
+# include "../median-path/detail/atom_bvh.h"
+# include "../median-path/detail/parallel_algorithms.h"
+# include "../median-path/detail/skeleton_profiles.h"
+# include "../median-path/detail/space_filling_curves.h"
+
+# include <cmath>
+# include <limits>
+# include <memory>
+# include <queue>
+
+BEGIN_MP_NAMESPACE
+
+  /* Maximum depth of a hierarchy: codes are 63 bits long and equal codes are
+   * distinguished by the bits of their positions. */
+  static const size_t max_bvh_depth = 128;
+
+  /* Boxes are stored in the precision of atoms, while queries are done in
+   * real: box bounds are rounded outward to contain the balls. */
+  template< typename T >
+  static inline T round_down( real v ) noexcept
+  {
+    T result = T( v );
+    return real( result ) > v ? std::nextafter( result, -std::numeric_limits< T >::max() ) : result;
+  }
+
+  template< typename T >
+  static inline T round_up( real v ) noexcept
+  {
+    T result = T( v );
+    return real( result ) < v ? std::nextafter( result, std::numeric_limits< T >::max() ) : result;
+  }
+
+  template< typename atom_type, typename index_type >
+  basic_atom_bvh< atom_type, index_type >::basic_atom_bvh()
+    : m_atoms{ nullptr }, m_size{ 0 }, m_needs_build{ true }, m_needs_refit{ false }
+  {}
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::swap( basic_atom_bvh& other ) noexcept
+  {
+    m_nodes.swap( other.m_nodes );
+    m_parents.swap( other.m_parents );
+    std::swap( m_atoms, other.m_atoms );
+    std::swap( m_size, other.m_size );
+
+    const bool build = m_needs_build.load( std::memory_order_relaxed );
+    const bool refit = m_needs_refit.load( std::memory_order_relaxed );
+    m_needs_build.store( other.m_needs_build.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+    m_needs_refit.store( other.m_needs_refit.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+    other.m_needs_build.store( build, std::memory_order_relaxed );
+    other.m_needs_refit.store( refit, std::memory_order_relaxed );
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::build( const atom* atoms, index size )
+  {
+    m_atoms = atoms;
+    m_size = size;
+    m_needs_build.store( false, std::memory_order_relaxed );
+    m_needs_refit.store( false, std::memory_order_relaxed );
+    if( !size )
+      {
+        m_nodes.clear();
+        m_parents.clear();
+        return;
+      }
+
+    // bounding box of the centers, to map them into the unit cube
+    real minx = REAL_MAX, miny = REAL_MAX, minz = REAL_MAX;
+    real maxx = -REAL_MAX, maxy = -REAL_MAX, maxz = -REAL_MAX;
+    # pragma omp parallel for reduction(min:minx,miny,minz) reduction(max:maxx,maxy,maxz)
+    for( index i = 0; i < size; ++ i )
+      {
+        const real x = atoms[i].x, y = atoms[i].y, z = atoms[i].z;
+        minx = std::min( minx, x ); maxx = std::max( maxx, x );
+        miny = std::min( miny, y ); maxy = std::max( maxy, y );
+        minz = std::min( minz, z ); maxz = std::max( maxz, z );
+      }
+    const real extent = std::max( std::max( maxx - minx, maxy - miny ), maxz - minz );
+    const real inverse_extent = extent > 0 ? real( 1 ) / extent : real( 0 );
+
+    std::vector< std::pair< uint64_t, index > > keys( size );
+    # pragma omp parallel for
+    for( index i = 0; i < size; ++ i )
+      {
+        keys[i].first = morton_code(
+            ( atoms[i].x - minx ) * inverse_extent,
+            ( atoms[i].y - miny ) * inverse_extent,
+            ( atoms[i].z - minz ) * inverse_extent );
+        keys[i].second = i;
+      }
+    parallel_sort( keys.begin(), keys.end() );
+
+    const index number_of_nodes = 2 * size - 1;
+    m_nodes.resize( number_of_nodes );
+    m_parents.resize( number_of_nodes );
+    std::vector< uint64_t > codes( size );
+    node* nodes = m_nodes.data();
+    # pragma omp parallel for
+    for( index i = 0; i < size; ++ i )
+      {
+        codes[i] = keys[i].first;
+        nodes[ size - 1 + i ].left = keys[i].second;
+        nodes[ size - 1 + i ].right = keys[i].second;
+      }
+    decltype( keys )().swap( keys );
+
+    compute_internal_nodes( codes.data() );
+    compute_bounds( atoms );
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::compute_internal_nodes( const uint64_t* codes )
+  {
+    const index size = m_size;
+    node* nodes = m_nodes.data();
+    index* parents = m_parents.data();
+    parents[0] = 0;
+
+    /* length of the longest common prefix of the keys at positions i and j,
+     * a key being a code followed by its position */
+    auto delta = [codes,size]( int64_t i, int64_t j ) -> int
+      {
+        if( j < 0 || j >= int64_t( size ) )
+          return -1;
+        const uint64_t x = codes[i] ^ codes[j];
+        if( x )
+          return __builtin_clzll( x );
+        return 64 + __builtin_clzll( uint64_t( i ^ j ) );
+      };
+
+    # pragma omp parallel for
+    for( int64_t i = 0; i < int64_t( size ) - 1; ++ i )
+      {
+        // direction of the range of this node
+        const int d = delta( i, i + 1 ) > delta( i, i - 1 ) ? 1 : -1;
+
+        // upper bound of the length of the range, then its exact length
+        const int delta_min = delta( i, i - d );
+        int64_t lmax = 2;
+        while( delta( i, i + lmax * d ) > delta_min )
+          lmax *= 2;
+        int64_t l = 0;
+        for( int64_t t = lmax / 2; t >= 1; t /= 2 )
+          if( delta( i, i + ( l + t ) * d ) > delta_min )
+            l += t;
+        const int64_t j = i + l * d;
+
+        // split position, by binary search
+        const int delta_node = delta( i, j );
+        int64_t s = 0;
+        int64_t t = l;
+        do
+          {
+            t = ( t + 1 ) >> 1;
+            if( delta( i, i + ( s + t ) * d ) > delta_node )
+              s += t;
+          }
+        while( t > 1 );
+        const int64_t gamma = i + s * d + std::min( d, 0 );
+
+        const index left = std::min( i, j ) == gamma ? index( size - 1 + gamma ) : index( gamma );
+        const index right = std::max( i, j ) == gamma + 1 ? index( size + gamma ) : index( gamma + 1 );
+        nodes[i].left = left;
+        nodes[i].right = right;
+        parents[left] = index( i );
+        parents[right] = index( i );
+      }
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::compute_bounds( const atom* atoms )
+  {
+    const index size = m_size;
+    node* nodes = m_nodes.data();
+    const index* parents = m_parents.data();
+
+    /* each internal node is computed by the second of its children to be
+     * done, such that all leaves walk up the tree in parallel */
+    std::unique_ptr< std::atomic< uint8_t >[] > arrivals(
+      new std::atomic< uint8_t >[ size ] );
+    # pragma omp parallel for
+    for( index i = 0; i < size; ++ i )
+      arrivals[i].store( 0, std::memory_order_relaxed );
+
+    # pragma omp parallel for
+    for( index i = 0; i < size; ++ i )
+      {
+        node& leaf = nodes[ size - 1 + i ];
+        const atom& a = atoms[ leaf.left ];
+        const real center[3] = { a.x, a.y, a.z };
+        for( int k = 0; k < 3; ++ k )
+          {
+            leaf.min[k] = round_down< real_type >( center[k] - real( a.w ) );
+            leaf.max[k] = round_up< real_type >( center[k] + real( a.w ) );
+          }
+        leaf.max_radius = a.w;
+
+        index current = size - 1 + i;
+        while( current )
+          {
+            const index parent = parents[ current ];
+            if( !arrivals[ parent ].fetch_add( 1, std::memory_order_acq_rel ) )
+              break;
+            node& n = nodes[ parent ];
+            const node& l = nodes[ n.left ];
+            const node& r = nodes[ n.right ];
+            for( int k = 0; k < 3; ++ k )
+              {
+                n.min[k] = std::min( l.min[k], r.min[k] );
+                n.max[k] = std::max( l.max[k], r.max[k] );
+              }
+            n.max_radius = std::max( l.max_radius, r.max_radius );
+            current = parent;
+          }
+      }
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::refit( const atom* atoms )
+  {
+    m_atoms = atoms;
+    m_needs_refit.store( false, std::memory_order_relaxed );
+    if( m_size )
+      compute_bounds( atoms );
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::release() noexcept
+  {
+    std::vector< node >().swap( m_nodes );
+    std::vector< index >().swap( m_parents );
+    m_atoms = nullptr;
+    m_size = 0;
+    m_needs_build.store( true, std::memory_order_relaxed );
+    m_needs_refit.store( false, std::memory_order_relaxed );
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::synchronize( const atom* atoms, index size )
+  {
+    if( m_needs_build.load( std::memory_order_relaxed ) || size != m_size )
+      build( atoms, size );
+    else if( m_needs_refit.load( std::memory_order_relaxed ) || atoms != m_atoms )
+      refit( atoms );
+  }
+
+  template< typename atom_type, typename index_type >
+  real
+  basic_atom_bvh< atom_type, index_type >::lower_bound( const node& n, const vec3& p ) const noexcept
+  {
+    /* a point outside a box is outside all its balls, and at least at the
+     * distance of the box from them. A point inside a box is at least at -r
+     * of the surface of a ball of radius r. */
+    real squared_distance = 0;
+    for( int k = 0; k < 3; ++ k )
+      {
+        const real outside = std::max( std::max( real( n.min[k] ) - p[k], p[k] - real( n.max[k] ) ), real( 0 ) );
+        squared_distance += outside * outside;
+      }
+    return squared_distance > 0 ? std::sqrt( squared_distance ) : -real( n.max_radius );
+  }
+
+  template< typename atom_type, typename index_type >
+  bool
+  basic_atom_bvh< atom_type, index_type >::contains( const vec3& p ) const
+  {
+    if( !m_size )
+      return false;
+    const node* nodes = m_nodes.data();
+    const index first_leaf = m_size - 1;
+    index stack[ max_bvh_depth ];
+    size_t top = 0;
+    index current = 0;
+    while( true )
+      {
+        const node& n = nodes[ current ];
+        if( p.x >= n.min[0] && p.x <= n.max[0]
+         && p.y >= n.min[1] && p.y <= n.max[1]
+         && p.z >= n.min[2] && p.z <= n.max[2] )
+          {
+            if( current >= first_leaf )
+              {
+                const atom& a = m_atoms[ n.left ];
+                const real dx = p.x - a.x, dy = p.y - a.y, dz = p.z - a.z;
+                if( dx * dx + dy * dy + dz * dz < real( a.w ) * a.w )
+                  return true;
+              }
+            else
+              {
+                stack[ top++ ] = n.right;
+                current = n.left;
+                continue;
+              }
+          }
+        if( !top )
+          return false;
+        current = stack[ --top ];
+      }
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::contains(
+    const vec3* points, size_t number_of_points, uint8_t* result ) const
+  {
+    # pragma omp parallel for schedule(dynamic,64)
+    for( size_t i = 0; i < number_of_points; ++ i )
+      result[i] = contains( points[i] );
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::get_atoms_containing(
+    const vec3& p, std::vector< index >& result ) const
+  {
+    result.clear();
+    if( !m_size )
+      return;
+    const node* nodes = m_nodes.data();
+    const index first_leaf = m_size - 1;
+    index stack[ max_bvh_depth ];
+    size_t top = 0;
+    index current = 0;
+    while( true )
+      {
+        const node& n = nodes[ current ];
+        if( p.x >= n.min[0] && p.x <= n.max[0]
+         && p.y >= n.min[1] && p.y <= n.max[1]
+         && p.z >= n.min[2] && p.z <= n.max[2] )
+          {
+            if( current >= first_leaf )
+              {
+                const atom& a = m_atoms[ n.left ];
+                const real dx = p.x - a.x, dy = p.y - a.y, dz = p.z - a.z;
+                if( dx * dx + dy * dy + dz * dz < real( a.w ) * a.w )
+                  result.push_back( n.left );
+              }
+            else
+              {
+                stack[ top++ ] = n.right;
+                current = n.left;
+                continue;
+              }
+          }
+        if( !top )
+          return;
+        current = stack[ --top ];
+      }
+  }
+
+  template< typename atom_type, typename index_type >
+  index_type
+  basic_atom_bvh< atom_type, index_type >::get_closest_surface(
+    const vec3& p, real& distance ) const
+  {
+    distance = REAL_MAX;
+    index best = m_size;
+    if( !m_size )
+      return best;
+    const node* nodes = m_nodes.data();
+    const index first_leaf = m_size - 1;
+    std::pair< real, index > stack[ max_bvh_depth ];
+    size_t top = 0;
+    stack[ top++ ] = std::make_pair( lower_bound( nodes[0], p ), index( 0 ) );
+    while( top )
+      {
+        const auto entry = stack[ --top ];
+        if( entry.first >= distance )
+          continue;
+        const node& n = nodes[ entry.second ];
+        if( entry.second >= first_leaf )
+          {
+            const atom& a = m_atoms[ n.left ];
+            const real dx = p.x - a.x, dy = p.y - a.y, dz = p.z - a.z;
+            const real d = std::sqrt( dx * dx + dy * dy + dz * dz ) - a.w;
+            if( d < distance )
+              {
+                distance = d;
+                best = n.left;
+              }
+            continue;
+          }
+        // visit the closest child first: it is pushed last
+        std::pair< real, index > left( lower_bound( nodes[ n.left ], p ), n.left );
+        std::pair< real, index > right( lower_bound( nodes[ n.right ], p ), n.right );
+        if( left.first < right.first )
+          std::swap( left, right );
+        if( left.first < distance )
+          stack[ top++ ] = left;
+        if( right.first < distance )
+          stack[ top++ ] = right;
+      }
+    return best;
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::get_closest_surfaces(
+    const vec3* points, size_t number_of_points, index* indices, real* distances ) const
+  {
+    # pragma omp parallel for schedule(dynamic,64)
+    for( size_t i = 0; i < number_of_points; ++ i )
+      indices[i] = get_closest_surface( points[i], distances[i] );
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::get_nearest_atoms(
+    const vec3& p, size_t k, std::vector< index >& result ) const
+  {
+    result.clear();
+    if( !m_size || !k )
+      return;
+    const node* nodes = m_nodes.data();
+    const index first_leaf = m_size - 1;
+    // the k best atoms found so far, the worst on top
+    std::priority_queue< std::pair< real, index > > best;
+    auto bound = [&best,k]()
+      {
+        return best.size() < k ? REAL_MAX : best.top().first;
+      };
+
+    std::pair< real, index > stack[ max_bvh_depth ];
+    size_t top = 0;
+    stack[ top++ ] = std::make_pair( lower_bound( nodes[0], p ), index( 0 ) );
+    while( top )
+      {
+        const auto entry = stack[ --top ];
+        if( entry.first >= bound() )
+          continue;
+        const node& n = nodes[ entry.second ];
+        if( entry.second >= first_leaf )
+          {
+            const atom& a = m_atoms[ n.left ];
+            const real dx = p.x - a.x, dy = p.y - a.y, dz = p.z - a.z;
+            const real d = std::sqrt( dx * dx + dy * dy + dz * dz ) - a.w;
+            if( d < bound() )
+              {
+                if( best.size() == k )
+                  best.pop();
+                best.push( std::make_pair( d, n.left ) );
+              }
+            continue;
+          }
+        std::pair< real, index > left( lower_bound( nodes[ n.left ], p ), n.left );
+        std::pair< real, index > right( lower_bound( nodes[ n.right ], p ), n.right );
+        if( left.first < right.first )
+          std::swap( left, right );
+        if( left.first < bound() )
+          stack[ top++ ] = left;
+        if( right.first < bound() )
+          stack[ top++ ] = right;
+      }
+
+    result.resize( best.size() );
+    for( size_t i = best.size(); i; -- i )
+      {
+        result[ i - 1 ] = best.top().second;
+        best.pop();
+      }
+  }
+
+  template< typename atom_type, typename index_type >
+  void
+  basic_atom_bvh< atom_type, index_type >::get_overlapping_atoms(
+    const vec3& center, real radius, std::vector< index >& result ) const
+  {
+    result.clear();
+    if( !m_size )
+      return;
+    const node* nodes = m_nodes.data();
+    const index first_leaf = m_size - 1;
+    const real squared_radius = radius * radius;
+    index stack[ max_bvh_depth ];
+    size_t top = 0;
+    index current = 0;
+    while( true )
+      {
+        const node& n = nodes[ current ];
+        real squared_distance = 0;
+        for( int k = 0; k < 3; ++ k )
+          {
+            const real outside = std::max( std::max( real( n.min[k] ) - center[k], center[k] - real( n.max[k] ) ), real( 0 ) );
+            squared_distance += outside * outside;
+          }
+        if( squared_distance < squared_radius )
+          {
+            if( current >= first_leaf )
+              {
+                const atom& a = m_atoms[ n.left ];
+                const real dx = center.x - a.x, dy = center.y - a.y, dz = center.z - a.z;
+                const real r = radius + a.w;
+                if( dx * dx + dy * dy + dz * dz < r * r )
+                  result.push_back( n.left );
+              }
+            else
+              {
+                stack[ top++ ] = n.right;
+                current = n.left;
+                continue;
+              }
+          }
+        if( !top )
+          return;
+        current = stack[ --top ];
+      }
+  }
+
+  template class basic_atom_bvh< graphics_origin::geometry::ball, uint32_t >;
+  template class basic_atom_bvh< single_precision_ball, uint32_t >;
+  template class basic_atom_bvh< graphics_origin::geometry::ball, uint64_t >;
+
+END_MP_NAMESPACE
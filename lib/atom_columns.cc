@@ -0,0 +1,108 @@
+# include "../median-path/detail/atom_columns.h"
+# include "../median-path/detail/skeleton_profiles.h"
+
+BEGIN_MP_NAMESPACE
+
+  template< typename atom_type >
+  constexpr size_t basic_atom_columns< atom_type >::padding;
+
+  template< typename atom_type >
+  basic_atom_columns< atom_type >::basic_atom_columns()
+    : size{ 0 }, capacity{ 0 }, m_dirty{ true }
+  {}
+
+  template< typename atom_type >
+  basic_atom_columns< atom_type >::~basic_atom_columns()
+  {}
+
+  template< typename atom_type >
+  void
+  basic_atom_columns< atom_type >::swap( basic_atom_columns& other ) noexcept
+  {
+    x.swap( other.x );
+    y.swap( other.y );
+    z.swap( other.z );
+    r.swap( other.r );
+    std::swap( size, other.size );
+    std::swap( capacity, other.capacity );
+
+    const bool dirty = is_dirty();
+    m_dirty.store( other.is_dirty(), std::memory_order_relaxed );
+    other.m_dirty.store( dirty, std::memory_order_relaxed );
+  }
+
+  template< typename atom_type >
+  void
+  basic_atom_columns< atom_type >::assign( const atom* atoms, size_t number_of_atoms )
+  {
+    if( number_of_atoms > capacity )
+      {
+        // round the capacity to the next multiple of padding
+        const size_t new_capacity = ( number_of_atoms + padding - 1 ) / padding * padding;
+        x.reset( aligned_allocate< real_type >( new_capacity ) );
+        y.reset( aligned_allocate< real_type >( new_capacity ) );
+        z.reset( aligned_allocate< real_type >( new_capacity ) );
+        r.reset( aligned_allocate< real_type >( new_capacity ) );
+        capacity = new_capacity;
+      }
+
+    real_type* px = x.get();
+    real_type* py = y.get();
+    real_type* pz = z.get();
+    real_type* pr = r.get();
+    # pragma omp parallel for
+    for( size_t i = 0; i < number_of_atoms; ++ i )
+      {
+        const atom& a = atoms[ i ];
+        px[ i ] = a.x;
+        py[ i ] = a.y;
+        pz[ i ] = a.z;
+        pr[ i ] = a.w;
+      }
+
+    /* fill the padding with a copy of the last atom: min/max reductions
+     * can then run over the full capacity without changing their results. */
+    if( number_of_atoms )
+      {
+        const atom& last = atoms[ number_of_atoms - 1 ];
+        for( size_t i = number_of_atoms; i < capacity; ++ i )
+          {
+            px[ i ] = last.x;
+            py[ i ] = last.y;
+            pz[ i ] = last.z;
+            pr[ i ] = last.w;
+          }
+      }
+
+    size = number_of_atoms;
+    m_dirty.store( false, std::memory_order_release );
+  }
+
+  template< typename atom_type >
+  void
+  basic_atom_columns< atom_type >::synchronize( const atom* atoms, size_t number_of_atoms )
+  {
+    if( !is_dirty() )
+      return;
+    std::lock_guard< std::mutex > lock( m_synchronization );
+    if( is_dirty() )
+      assign( atoms, number_of_atoms );
+  }
+
+  template< typename atom_type >
+  void
+  basic_atom_columns< atom_type >::release() noexcept
+  {
+    x.reset();
+    y.reset();
+    z.reset();
+    r.reset();
+    size = 0;
+    capacity = 0;
+    m_dirty.store( true, std::memory_order_relaxed );
+  }
+
+  template struct basic_atom_columns< graphics_origin::geometry::ball >;
+  template struct basic_atom_columns< single_precision_ball >;
+
+END_MP_NAMESPACE
@@ -18,12 +18,17 @@ namespace median_path {
 
   namespace atomizer {
 
-    shrinking_ball_vertex_constant_initial_radius::shrinking_ball_vertex_constant_initial_radius(
-        const parameters_type& parameters,
+    /* atoms of one vertex each, computed in parallel and inserted without
+     * locking, whatever the atom index type of the skeleton */
+    template< typename skeleton_type >
+    static void
+    shrink_balls(
+        const shrinking_ball_vertex_constant_initial_radius::parameters_type& parameters,
         const skeletonizable_shape& shape,
-        median_skeleton& result )
-    : parameters{ parameters }
+        skeleton_type& result,
+        median_skeleton::atom_property_index& atom_to_sampling_property_index )
     {
+      typedef shrinking_ball_vertex_constant_initial_radius::atom_to_sampling_type atom_to_sampling_type;
       graphics_origin::geometry::mesh_vertices_kdtree kdtree( shape );
 
       const auto nvertices = shape.n_vertices();
@@ -35,6 +40,8 @@ namespace median_path {
       base_property_buffer& mapping = result.add_atom_property<atom_to_sampling_type>( "atom_to_sampling" );
       atom_to_sampling_property_index = result.get_atom_property_index( mapping );
 
+      // at most one atom per vertex: threads insert atoms without locking
+      result.begin_concurrent_add( nvertices );
       # pragma omp parallel
       {
         typedef graphics_origin::geometry::mesh_vertices_kdtree::vertex_index vertex_index;
@@ -72,16 +79,32 @@ namespace median_path {
             if( std::isfinite( center.x ) && std::isfinite( center.y )
               && std::isfinite( center.z) && std::isfinite( radius ) )
               {
-                median_skeleton::atom_handle handle;
-                # pragma omp critical
-                handle = result.add( median_skeleton::atom( center, radius ) );
+                auto handle = result.concurrent_add( typename skeleton_type::atom( center, radius ) );
 
                 mapping.get<atom_to_sampling_type>( result.get_index( handle ) ) = { i, other_index };
               }
           }
       }
+      result.end_concurrent_add();
+    }
+
+    shrinking_ball_vertex_constant_initial_radius::shrinking_ball_vertex_constant_initial_radius(
+        const parameters_type& parameters,
+        const skeletonizable_shape& shape,
+        median_skeleton& result )
+    : parameters{ parameters }
+    {
+      shrink_balls( parameters, shape, result, atom_to_sampling_property_index );
     }
 
+    shrinking_ball_vertex_constant_initial_radius::shrinking_ball_vertex_constant_initial_radius(
+        const parameters_type& parameters,
+        const skeletonizable_shape& shape,
+        large_median_skeleton& result )
+    : parameters{ parameters }
+    {
+      shrink_balls( parameters, shape, result, atom_to_sampling_property_index );
+    }
   }
 
 }
@@ -15,22 +15,33 @@
 BEGIN_MP_NAMESPACE
 
   typedef CGAL::Epick dt_kernel;
-  typedef CGAL::Triangulation_vertex_base_with_info_2< median_skeleton::atom_index, dt_kernel > dt_vertex_base;
-  typedef CGAL::Triangulation_face_base_2< dt_kernel > dt_face_base;
-  typedef CGAL::Triangulation_data_structure_2< dt_vertex_base, dt_face_base > dt_datastructure;
-  typedef CGAL::Delaunay_triangulation_2< dt_kernel, dt_datastructure > dt;
 
+  /* Delaunay triangulation whose vertices store the index of their atom, with
+   * the atom index type of a skeleton profile */
+  template< typename atom_index >
+  struct indexed_delaunay_triangulation {
+    typedef CGAL::Triangulation_vertex_base_with_info_2< atom_index, dt_kernel > vertex_base;
+    typedef CGAL::Triangulation_face_base_2< dt_kernel > face_base;
+    typedef CGAL::Triangulation_data_structure_2< vertex_base, face_base > datastructure;
+    typedef CGAL::Delaunay_triangulation_2< dt_kernel, datastructure > type;
+  };
+
+  template< typename skeleton_type >
   void delaunay_reconstruction(
-      median_skeleton& skeleton,
+      skeleton_type& skeleton,
       graphics_origin::geometry::mesh_spatial_optimization& msp,
-      std::vector< std::vector< uint32_t > >& vertex_to_atoms,
+      std::vector< std::vector< typename skeleton_type::atom_index > >& vertex_to_atoms,
       const structurer::parameters& params )
   {
+    typedef typename skeleton_type::atom_index atom_index;
+    typedef typename indexed_delaunay_triangulation< atom_index >::type dt;
     const auto ntriangles = msp.get_number_of_triangles();
+    basic_topology_builder< skeleton_type > builder( skeleton );
+    const skeleton_type& constant_skeleton = skeleton;
     # pragma omp parallel
     {
-      std::vector< median_skeleton::atom_index > indices;
-      median_skeleton::atom_index face[3];
+      std::vector< atom_index > indices;
+      atom_index face[3];
       # pragma omp for
       for( uint32_t i = 0; i < ntriangles; ++ i )
         {
@@ -53,9 +64,9 @@ BEGIN_MP_NAMESPACE
 
           for( auto begin = indices.begin(); begin != last; ++ begin )
             {
-              vec3 p = vec3{skeleton.get_atom_by_index( *begin ) };
+              vec3 p = vec3{constant_skeleton.get_atom_by_index( *begin ) };
               p -= dot( triangle.get_normal(), p - triangle.get_vertex(graphics_origin::geometry::triangle::V0) );
-              delaunay_triangulation.insert( dt::Point( dot( p, e1 ), dot( p, e2 ) ) )->info() = *begin;
+              delaunay_triangulation.insert( typename dt::Point( dot( p, e1 ), dot( p, e2 ) ) )->info() = *begin;
             }
           indices.resize( 0 );
 
@@ -72,9 +83,9 @@ BEGIN_MP_NAMESPACE
 
                   if( params.m_neighbors_should_intersect )
                     {
-                      const auto& atom0 = skeleton.get_atom_by_index( face[0] );
-                      const auto& atom1 = skeleton.get_atom_by_index( face[1] );
-                      const auto& atom2 = skeleton.get_atom_by_index( face[2] );
+                      const auto& atom0 = constant_skeleton.get_atom_by_index( face[0] );
+                      const auto& atom1 = constant_skeleton.get_atom_by_index( face[1] );
+                      const auto& atom2 = constant_skeleton.get_atom_by_index( face[2] );
 
                       if( !atom0.intersect( atom1 ) || !atom0.intersect( atom2 ) || !atom1.intersect( atom2 ) )
                         {
@@ -82,8 +93,7 @@ BEGIN_MP_NAMESPACE
                         }
                     }
 
-                  # pragma omp critical
-                  skeleton.add( face[0], face[1], face[2] );
+                  builder.add_face( face[0], face[1], face[2] );
                 }
             }
 //          else
@@ -103,15 +113,26 @@ BEGIN_MP_NAMESPACE
                     }
 
                   if( params.m_neighbors_should_intersect &&
-                      !skeleton.get_atom_by_index( face[0] ).intersect( skeleton.get_atom_by_index( face[1 ] ) ) )
+                      !constant_skeleton.get_atom_by_index( face[0] ).intersect( constant_skeleton.get_atom_by_index( face[1 ] ) ) )
                     continue;
 
-                  # pragma omp critical
-                  skeleton.add( face[0], face[1] );
+                  builder.add_link( face[0], face[1] );
                 }
             }
         }
     }
+    builder.commit();
   }
+
+  template void delaunay_reconstruction(
+      median_skeleton& skeleton,
+      graphics_origin::geometry::mesh_spatial_optimization& msp,
+      std::vector< std::vector< median_skeleton::atom_index > >& vertex_to_atoms,
+      const structurer::parameters& params );
+  template void delaunay_reconstruction(
+      large_median_skeleton& skeleton,
+      graphics_origin::geometry::mesh_spatial_optimization& msp,
+      std::vector< std::vector< large_median_skeleton::atom_index > >& vertex_to_atoms,
+      const structurer::parameters& params );
 END_MP_NAMESPACE
 
@@ -6,37 +6,143 @@
 # include "../median-path/detail/balls_format.h"
 # include "../median-path/detail/moff_format.h"
 # include "../median-path/detail/median_format.h"
+# include "../median-path/detail/mskel_format.h"
+# include "../median-path/detail/mpack_format.h"
 # include "../median-path/detail/web_format.h"
 
 # include <graphics-origin/tools/filesystem.h>
 # include <graphics-origin/tools/log.h>
 
+# include <algorithm>
+# include <atomic>
+# include <condition_variable>
+# include <deque>
+# include <functional>
 # include <list>
 # include <fstream>
 # include <mutex>
+# include <thread>
+# include <vector>
 
 BEGIN_MP_NAMESPACE
 
   namespace io {
 
+    /* the lists are never destroyed: release_loaders_and_savers() runs at
+     * exit, after the destruction of function local statics */
     static
     std::list<saver* >&
     get_savers()
     {
-      static std::list< saver*> instance;
-      return instance;
+      static std::list< saver*>* instance = new std::list< saver* >;
+      return *instance;
     }
 
     static
     std::list<loader* >&
     get_loaders()
     {
-      static std::list< loader* > instance;
-      return instance;
+      static std::list< loader* >* instance = new std::list< loader* >;
+      return *instance;
     }
 
     static std::mutex loaders_mutex;
     static std::mutex savers_mutex;
+    static std::atomic< uint32_t > archive_quantization_bits{ 16 };
+
+    /* Threads performing asynchronous operations. Threads are started when
+     * an operation is submitted and all started threads are busy, and they
+     * wait for new operations until the pool is destroyed. Submissions
+     * block while max_pending operations wait for a thread. */
+    class async_io_pool {
+    public:
+      async_io_pool()
+        : m_max_threads{ 2 }, m_max_pending{ 4 }, m_idle{ 0 }, m_running{ 0 }, m_stopping{ false }
+      {}
+
+      ~async_io_pool()
+      {
+        {
+          std::lock_guard< std::mutex > lock( m_mutex );
+          m_stopping = true;
+        }
+        m_not_empty.notify_all();
+        for( auto& thread : m_threads )
+          thread.join();
+      }
+
+      std::future< bool > submit( std::function< bool() > operation )
+      {
+        auto task = std::make_shared< std::packaged_task< bool() > >( std::move( operation ) );
+        auto result = task->get_future();
+        std::unique_lock< std::mutex > lock( m_mutex );
+        m_not_full.wait( lock, [this]{ return m_tasks.size() < m_max_pending; } );
+        m_tasks.push_back( [task]{ (*task)(); } );
+        if( m_tasks.size() > m_idle && m_threads.size() < m_max_threads )
+          m_threads.emplace_back( &async_io_pool::work, this );
+        m_not_empty.notify_one();
+        return result;
+      }
+
+      void set_limits( size_t number_of_threads, size_t max_pending )
+      {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_max_threads = std::max( number_of_threads, size_t(1) );
+        m_max_pending = std::max( max_pending, size_t(1) );
+        m_not_full.notify_all();
+      }
+
+      void wait()
+      {
+        std::unique_lock< std::mutex > lock( m_mutex );
+        m_done.wait( lock, [this]{ return m_tasks.empty() && !m_running; } );
+      }
+
+    private:
+      void work()
+      {
+        std::unique_lock< std::mutex > lock( m_mutex );
+        for( ;; )
+          {
+            ++ m_idle;
+            m_not_empty.wait( lock, [this]{ return m_stopping || !m_tasks.empty(); } );
+            -- m_idle;
+            if( m_tasks.empty() )
+              return;
+            auto task = std::move( m_tasks.front() );
+            m_tasks.pop_front();
+            ++ m_running;
+            m_not_full.notify_one();
+
+            lock.unlock();
+            task();
+            lock.lock();
+
+            -- m_running;
+            if( m_tasks.empty() && !m_running )
+              m_done.notify_all();
+          }
+      }
+
+      std::mutex m_mutex;
+      std::condition_variable m_not_empty;
+      std::condition_variable m_not_full;
+      std::condition_variable m_done;
+      std::deque< std::function< void() > > m_tasks;
+      std::vector< std::thread > m_threads;
+      size_t m_max_threads;
+      size_t m_max_pending;
+      size_t m_idle;
+      size_t m_running;
+      bool m_stopping;
+    };
+
+    static async_io_pool&
+    get_async_io_pool()
+    {
+      static async_io_pool instance;
+      return instance;
+    }
 
     bool can_load_from( const std::string& filename )
     {
@@ -45,95 +151,148 @@ BEGIN_MP_NAMESPACE
           LOG( error, "cannot load skeleton file [" << filename << "]: file does not exist");
           return false;
         }
-      bool result = false;
-      loaders_mutex.lock();
-        for( auto& pldr : get_loaders() )
-          {
-            if( pldr->can_load_from( filename ) )
-              {
-                result = true;
-                break;
-              }
-          }
-      loaders_mutex.unlock();
-      return result;
+      std::lock_guard< std::mutex > lock( loaders_mutex );
+      for( auto& pldr : get_loaders() )
+        if( pldr->can_load_from( filename ) )
+          return true;
+      return false;
     }
 
     bool can_save_to( const std::string& filename )
     {
-      bool result = false;
-      savers_mutex.lock();
-        for( auto& psvr : get_savers() )
-          {
-            if( psvr->can_save_to( filename ) )
-              {
-                result = true;
-                break;
-              }
-          }
-      savers_mutex.unlock();
-      return result;
+      std::lock_guard< std::mutex > lock( savers_mutex );
+      for( auto& psvr : get_savers() )
+        if( psvr->can_save_to( filename ) )
+          return true;
+      return false;
     }
 
-    bool load( median_skeleton& skeleton, const std::string& filename )
+    /* Only the selection of the loaders or savers of a file is done under
+     * the lock. They are then called outside of it: loads and saves run
+     * concurrently, and a loader or saver that throws does not leave the
+     * lock taken. Loaders and savers are only released at exit. */
+    template< typename skeleton_type >
+    static bool
+    load_skeleton( skeleton_type& skeleton, const std::string& filename )
     {
       if( !graphics_origin::tools::file_exist( filename ) )
         {
           LOG( error, "cannot load skeleton file [" << filename << "]: file does not exist");
           return false;
         }
-      bool result = false;
-      loaders_mutex.lock();
+      std::vector< loader* > candidates;
+      {
+        std::lock_guard< std::mutex > lock( loaders_mutex );
         for( auto& pldr : get_loaders() )
-          {
-            if( pldr->can_load_from( filename ) )
-              {
-                if( pldr->load( skeleton, filename ) )
-                  {
-                    result = true;
-                    break;
-                  }
-              }
-          }
-      loaders_mutex.unlock();
-      return result;
+          if( pldr->can_load_from( filename ) )
+            candidates.push_back( pldr );
+      }
+      for( auto& pldr : candidates )
+        if( pldr->load( skeleton, filename ) )
+          return true;
+      return false;
     }
 
-    bool save( median_skeleton& skeleton, const std::string& filename )
+    template< typename skeleton_type >
+    static bool
+    save_skeleton( const skeleton_type& skeleton, const std::string& filename )
     {
-      bool result = false;
-      savers_mutex.lock();
+      std::vector< saver* > candidates;
+      {
+        std::lock_guard< std::mutex > lock( savers_mutex );
         for( auto& psvr : get_savers() )
-          {
-            if( psvr->can_save_to( filename ) )
-              {
-                if( psvr->save( skeleton, filename ) )
-                  {
-                    result = true;
-                    break;
-                  }
-              }
-          }
-      savers_mutex.unlock();
-      if( !result )
-        {
-          LOG( error, "impossible to save this skeleton to " << filename );
-        }
-      return result;
+          if( psvr->can_save_to( filename ) )
+            candidates.push_back( psvr );
+      }
+      for( auto& psvr : candidates )
+        if( psvr->save( skeleton, filename ) )
+          return true;
+      LOG( error, "impossible to save this skeleton to " << filename );
+      return false;
+    }
+
+    bool load( median_skeleton& skeleton, const std::string& filename )
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    bool load( large_median_skeleton& skeleton, const std::string& filename )
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    bool save( const median_skeleton& skeleton, const std::string& filename )
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    bool save( const large_median_skeleton& skeleton, const std::string& filename )
+    {
+      return save_skeleton( skeleton, filename );
     }
 
     void add_loader( loader* ldr )
     {
-      loaders_mutex.lock();
-        get_loaders().push_back( ldr );
-      loaders_mutex.unlock();
+      std::lock_guard< std::mutex > lock( loaders_mutex );
+      get_loaders().push_back( ldr );
     }
 
     void add_saver( saver* svr )
     {
-      savers_mutex.lock();
-        get_savers().push_back( svr );
-      savers_mutex.unlock();
+      std::lock_guard< std::mutex > lock( savers_mutex );
+      get_savers().push_back( svr );
+    }
+
+    std::future< bool > save_async( std::shared_ptr< const median_skeleton > skeleton, const std::string& filename )
+    {
+      return get_async_io_pool().submit( [skeleton, filename]
+        {
+          return save_skeleton( *skeleton, filename );
+        } );
+    }
+
+    std::future< bool > save_async( std::shared_ptr< const large_median_skeleton > skeleton, const std::string& filename )
+    {
+      return get_async_io_pool().submit( [skeleton, filename]
+        {
+          return save_skeleton( *skeleton, filename );
+        } );
+    }
+
+    std::future< bool > load_async( std::shared_ptr< median_skeleton > skeleton, const std::string& filename )
+    {
+      return get_async_io_pool().submit( [skeleton, filename]
+        {
+          return load_skeleton( *skeleton, filename );
+        } );
+    }
+
+    std::future< bool > load_async( std::shared_ptr< large_median_skeleton > skeleton, const std::string& filename )
+    {
+      return get_async_io_pool().submit( [skeleton, filename]
+        {
+          return load_skeleton( *skeleton, filename );
+        } );
+    }
+
+    void set_async_io_limits( size_t number_of_threads, size_t max_pending_operations )
+    {
+      get_async_io_pool().set_limits( number_of_threads, max_pending_operations );
+    }
+
+    void wait_async_operations()
+    {
+      get_async_io_pool().wait();
+    }
+
+    void set_archive_quantization_bits( uint32_t bits )
+    {
+      archive_quantization_bits = std::min( std::max( bits, uint32_t(1) ), uint32_t(32) );
+    }
+
+    uint32_t get_archive_quantization_bits()
+    {
+      return archive_quantization_bits;
     }
 
     void init_default_loaders_and_savers()
@@ -141,11 +300,15 @@ BEGIN_MP_NAMESPACE
       add_loader( new moff_loader );
       add_loader( new balls_loader );
       add_loader( new median_loader );
+      add_loader( new mskel_loader );
+      add_loader( new mpack_loader );
 
       add_saver( new moff_saver );
       add_saver( new balls_saver );
       add_saver( new web_saver );
       add_saver( new median_saver );
+      add_saver( new mskel_saver );
+      add_saver( new mpack_saver );
     }
 
     void release_loaders_and_savers()
@@ -1,13 +1,54 @@
 # include "../median-path/median_skeleton.h"
 # include "../median-path/io.h"
+# include "../median-path/detail/parallel_algorithms.h"
 
 # include <graphics-origin/geometry/box.h>
 # include <graphics-origin/tools/log.h>
 
+# include <limits>
+
 BEGIN_MP_NAMESPACE
 
-  median_skeleton::atom_face_element::atom_face_element(
-    datastructure::face& f, face_handle fh, ushort i ) :
+# define mps_template_parameters                               \
+  template< typename profile >
+
+# define mps_type                                              \
+  basic_median_skeleton< profile >
+
+# define mps_definition(ret_type)                              \
+  mps_template_parameters                                      \
+  ret_type mps_type
+
+  /* Canonical form of a link or a face, used by bulk insertions to detect
+   * duplicates: the sorted atom indices and the position in the batch. */
+  template< typename atom_index, size_t n >
+  struct canonical_element {
+    std::array< atom_index, n > atoms;
+    size_t position;
+
+    bool operator<( const canonical_element& other ) const
+    {
+      return atoms < other.atoms
+          || ( atoms == other.atoms && position < other.position );
+    }
+  };
+
+  /* Remove the elements of a topology property satisfying a predicate. The
+   * memory of a property that becomes empty is released. */
+  template< typename property, typename predicate >
+  static void erase_if( property& elements, predicate&& p )
+  {
+    auto last = std::remove_if( elements.begin(), elements.end(), p );
+    if( last != elements.end() )
+      {
+        elements.erase( last, elements.end() );
+        if( elements.empty() )
+          property().swap( elements );
+      }
+  }
+
+  mps_definition()::atom_face_element::atom_face_element(
+    typename datastructure::face& f, face_handle fh, ushort i ) :
       face
         { fh }
   {
@@ -22,7 +63,7 @@ BEGIN_MP_NAMESPACE
     atoms[1] = f.atoms[i_plus_two];
   }
 
-  median_skeleton::atom_face_element::atom_face_element( ) :
+  mps_definition()::atom_face_element::atom_face_element( ) :
       links
         { link_handle {}, link_handle {}, link_handle {} }, atoms
         { atom_handle {}, atom_handle {} }, face
@@ -30,7 +71,7 @@ BEGIN_MP_NAMESPACE
   {
   }
 
-  median_skeleton::atom_face_element::atom_face_element(
+  mps_definition()::atom_face_element::atom_face_element(
     atom_face_element&& other ) :
       face
         { other.face }
@@ -42,8 +83,7 @@ BEGIN_MP_NAMESPACE
     atoms[1] = other.atoms[1];
   }
 
-  median_skeleton::atom_face_element&
-  median_skeleton::atom_face_element::operator=(
+  mps_definition(typename mps_type::atom_face_element&)::atom_face_element::operator=(
     atom_face_element&& other )
   {
     links[0] = other.links[0];
@@ -55,8 +95,8 @@ BEGIN_MP_NAMESPACE
     return *this;
   }
 
-  median_skeleton::link_face_element::link_face_element(
-    datastructure::face& f, face_handle fh, ushort i ) :
+  mps_definition()::link_face_element::link_face_element(
+    typename datastructure::face& f, face_handle fh, ushort i ) :
       face
         { fh }
   {
@@ -67,7 +107,7 @@ BEGIN_MP_NAMESPACE
     opposite = f.atoms[i_plus_two];
   }
 
-  median_skeleton::link_face_element::link_face_element( ) :
+  mps_definition()::link_face_element::link_face_element( ) :
       links
         { link_handle {}, link_handle {} }, opposite
         { atom_handle {} }, face
@@ -75,7 +115,7 @@ BEGIN_MP_NAMESPACE
   {
   }
 
-  median_skeleton::link_face_element::link_face_element(
+  mps_definition()::link_face_element::link_face_element(
     link_face_element&& other ) :
       face
         { other.face }
@@ -85,8 +125,7 @@ BEGIN_MP_NAMESPACE
     opposite = other.opposite;
   }
 
-  median_skeleton::link_face_element&
-  median_skeleton::link_face_element::operator=(
+  mps_definition(typename mps_type::link_face_element&)::link_face_element::operator=(
     link_face_element&& other )
   {
     links[0] = other.links[0];
@@ -96,12 +135,11 @@ BEGIN_MP_NAMESPACE
     return *this;
   }
 
-  void
-  median_skeleton::remove_link_to_face(
+  mps_definition(void)::remove_link_to_face(
     link_index idx, face_handle handle )
   {
     auto& face_elements =
-        m_impl->m_link_properties[link_faces_property_index]->get<
+        m_impl->m_link_properties[link_faces_property_index]->template get<
             link_faces_property >( idx );
     auto size = face_elements.size( );
     if( size <= 1 )
@@ -121,12 +159,11 @@ BEGIN_MP_NAMESPACE
       }
   }
 
-  void
-  median_skeleton::remove_atom_to_face(
+  mps_definition(void)::remove_atom_to_face(
     atom_index idx, face_handle handle )
   {
     auto& face_elements =
-        m_impl->m_atom_properties[atom_faces_property_index]->get<
+        m_impl->m_atom_properties[atom_faces_property_index]->template get<
             atom_faces_property >( idx );
     auto size = face_elements.size( );
     if( size <= 1 )
@@ -146,12 +183,11 @@ BEGIN_MP_NAMESPACE
       }
   }
 
-  void
-  median_skeleton::remove_atom_to_link(
+  mps_definition(void)::remove_atom_to_link(
     atom_index idx, link_handle handle )
   {
     auto& link_elements =
-        m_impl->m_atom_properties[atom_links_property_index]->get<
+        m_impl->m_atom_properties[atom_links_property_index]->template get<
             atom_links_property >( idx );
     auto size = link_elements.size( );
     if( size <= 1 )
@@ -171,55 +207,79 @@ BEGIN_MP_NAMESPACE
       }
   }
 
-  median_skeleton::median_skeleton(
+  mps_definition()::basic_median_skeleton(
     atom_index atom_capacity, link_index link_capacity,
     face_index face_capacity ) :
       m_impl
         { new datastructure
-          { atom_capacity, link_capacity, face_capacity } }
+          { atom_capacity, link_capacity, face_capacity } },
+      m_atom_layout
+        { array_of_structures },
+      m_topology_arena
+        { new small_vector_arena }
   {
-    m_impl->add_atom_property< atom_links_property >( "links" );
-    m_impl->add_atom_property< atom_faces_property >( "faces" );
-    m_impl->add_link_property< link_faces_property >( "faces" );
+    m_impl->template add_atom_property< atom_links_property >( "links" );
+    m_impl->template add_atom_property< atom_faces_property >( "faces" );
+    m_impl->template add_link_property< link_faces_property >( "faces" );
   }
 
-  median_skeleton::median_skeleton(
-    median_skeleton&& other ) :
+  mps_definition()::basic_median_skeleton(
+    basic_median_skeleton&& other ) :
       m_impl
-        { other.m_impl }
+        { other.m_impl },
+      m_atom_layout
+        { other.m_atom_layout },
+      m_topology_arena
+        { new small_vector_arena }
   {
     other.m_impl = new datastructure {};
+    m_atom_columns.swap( other.m_atom_columns );
+    m_atom_bvh.swap( other.m_atom_bvh );
+    m_frozen.swap( other.m_frozen );
+    m_topology_index.swap( other.m_topology_index );
+    m_topology_arena.swap( other.m_topology_arena );
+    m_change_journal.swap( other.m_change_journal );
   }
 
-  median_skeleton&
-  median_skeleton::operator=(
-    median_skeleton&& other )
+  mps_definition(mps_type&)::operator=(
+    basic_median_skeleton&& other )
   {
     delete m_impl;
     m_impl = other.m_impl;
     other.m_impl = nullptr;
+    m_atom_columns.swap( other.m_atom_columns );
+    m_atom_bvh.swap( other.m_atom_bvh );
+    m_atom_layout = other.m_atom_layout;
+    m_frozen = std::move( other.m_frozen );
+    m_topology_index = std::move( other.m_topology_index );
+    // the blocks of the previous topology were released with m_impl
+    m_topology_arena.swap( other.m_topology_arena );
+    m_change_journal = std::move( other.m_change_journal );
     return *this;
   }
 
-  median_skeleton::median_skeleton(
+  mps_definition()::basic_median_skeleton(
     const std::string& filename ) :
       m_impl
-        { new datastructure {} }
+        { new datastructure {} },
+      m_atom_layout
+        { array_of_structures },
+      m_topology_arena
+        { new small_vector_arena }
   {
-    m_impl->add_atom_property< atom_links_property >( "links" );
-    m_impl->add_atom_property< atom_faces_property >( "faces" );
-    m_impl->add_link_property< link_faces_property >( "faces" );
+    m_impl->template add_atom_property< atom_links_property >( "links" );
+    m_impl->template add_atom_property< atom_faces_property >( "faces" );
+    m_impl->template add_link_property< link_faces_property >( "faces" );
 
     load( filename );
   }
 
-  median_skeleton::~median_skeleton( )
+  mps_definition()::~basic_median_skeleton( )
   {
     delete m_impl;
   }
 
-  void
-  median_skeleton::reserve_atoms(
+  mps_definition(void)::reserve_atoms(
     atom_index new_atoms_capacity )
   {
     if( new_atoms_capacity > m_impl->m_atoms_capacity )
@@ -228,8 +288,7 @@ BEGIN_MP_NAMESPACE
       }
   }
 
-  void
-  median_skeleton::reserve_links(
+  mps_definition(void)::reserve_links(
     link_index new_links_capacity )
   {
     if( new_links_capacity > m_impl->m_links_capacity )
@@ -238,8 +297,7 @@ BEGIN_MP_NAMESPACE
       }
   }
 
-  void
-  median_skeleton::reserve_faces(
+  mps_definition(void)::reserve_faces(
     face_index new_faces_capacity )
   {
     if( new_faces_capacity > m_impl->m_faces_capacity )
@@ -248,97 +306,441 @@ BEGIN_MP_NAMESPACE
       }
   }
 
-  void
-  median_skeleton::clear(
-    atom_index atom_capacity, uint64_t link_capacity, uint64_t face_capacity )
+  mps_definition(void)::shrink_to_fit()
+  {
+    m_impl->shrink_atoms();
+    m_impl->shrink_links();
+    m_impl->shrink_faces();
+    m_atom_columns.release();
+    m_atom_bvh.release();
+    m_atom_compaction = compaction_plan< atom_index >();
+    m_link_compaction = compaction_plan< link_index >();
+    m_face_compaction = compaction_plan< face_index >();
+  }
+
+  mps_definition(void)::set_growth_policy(
+    const growth_policy& policy ) noexcept
+  {
+    m_impl->m_growth_policy = policy;
+  }
+
+  mps_definition(const growth_policy&)::get_growth_policy() const noexcept
+  {
+    return m_impl->m_growth_policy;
+  }
+
+  mps_definition(void)::clear(
+    atom_index atom_capacity, link_index link_capacity, face_index face_capacity )
   {
     m_impl->clear( atom_capacity, link_capacity, face_capacity );
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
+    m_frozen.reset();
+    if( m_topology_index )
+      {
+        m_topology_index->links.clear();
+        m_topology_index->faces.clear();
+      }
   }
 
-  bool
-  median_skeleton::load(
-    const std::string& filename )
+  mps_definition(mps_type)::clone() const
+  {
+    basic_median_skeleton result = clone_geometry_only();
+    result.m_impl->copy_links( *m_impl, link_faces_property_index + 1 );
+    result.m_impl->copy_faces( *m_impl, 0 );
+
+    /* topology properties are small vectors allocated from the arena of
+     * their skeleton: they are copied element by element in parallel */
+    auto& atom_links = *m_impl->m_atom_properties[atom_links_property_index];
+    auto& atom_faces = *m_impl->m_atom_properties[atom_faces_property_index];
+    auto& link_faces = *m_impl->m_link_properties[link_faces_property_index];
+    auto& result_atom_links = *result.m_impl->m_atom_properties[atom_links_property_index];
+    auto& result_atom_faces = *result.m_impl->m_atom_properties[atom_faces_property_index];
+    auto& result_link_faces = *result.m_impl->m_link_properties[link_faces_property_index];
+    auto& arena = *result.m_topology_arena;
+    const atom_index natoms = m_impl->m_atoms_size;
+    const link_index nlinks = m_impl->m_links_size;
+    # pragma omp parallel for
+    for( atom_index i = 0; i < natoms; ++i )
+      {
+        const auto& links = atom_links.template get< atom_links_property >( i );
+        result_atom_links.template get< atom_links_property >( i ).assign(
+            links.begin(), links.end(), arena );
+        const auto& faces = atom_faces.template get< atom_faces_property >( i );
+        result_atom_faces.template get< atom_faces_property >( i ).assign(
+            faces.begin(), faces.end(), arena );
+      }
+    # pragma omp parallel for
+    for( link_index i = 0; i < nlinks; ++i )
+      result_link_faces.template get< link_faces_property >( i ) =
+          link_faces.template get< link_faces_property >( i );
+
+    if( m_frozen )
+      result.m_frozen.reset( new frozen_topology( *m_frozen ) );
+    if( m_topology_index )
+      result.m_topology_index.reset( new topology_index( *m_topology_index ) );
+    return result;
+  }
+
+  mps_definition(mps_type)::clone_geometry_only() const
+  {
+    basic_median_skeleton result;
+    result.m_atom_layout = m_atom_layout;
+    result.m_impl->m_growth_policy = m_impl->m_growth_policy;
+    result.m_impl->copy_atoms( *m_impl, atom_faces_property_index + 1 );
+    return result;
+  }
+
+  mps_definition(void)::freeze()
+  {
+    if( m_frozen )
+      return;
+
+    auto& atom_links = *m_impl->m_atom_properties[atom_links_property_index];
+    auto& atom_faces = *m_impl->m_atom_properties[atom_faces_property_index];
+    auto& link_faces = *m_impl->m_link_properties[link_faces_property_index];
+    const atom_index natoms = m_impl->m_atoms_size;
+    const link_index nlinks = m_impl->m_links_size;
+
+    std::unique_ptr< frozen_topology > topology( new frozen_topology );
+    topology->atom_links_offsets.resize( natoms + 1 );
+    topology->atom_faces_offsets.resize( natoms + 1 );
+    topology->link_faces_offsets.resize( nlinks + 1 );
+
+    // count the number of elements of each row
+    topology->atom_links_offsets[0] = 0;
+    topology->atom_faces_offsets[0] = 0;
+# pragma omp parallel for
+    for( atom_index i = 0; i < natoms; ++i )
+      {
+        topology->atom_links_offsets[i + 1] = atom_links.template get< atom_links_property >( i ).size();
+        topology->atom_faces_offsets[i + 1] = atom_faces.template get< atom_faces_property >( i ).size();
+      }
+    topology->link_faces_offsets[0] = 0;
+# pragma omp parallel for
+    for( link_index i = 0; i < nlinks; ++i )
+      topology->link_faces_offsets[i + 1] = link_faces.template get< link_faces_property >( i ).size();
+
+    // prefix sums to get the row offsets
+    parallel_inclusive_scan( topology->atom_links_offsets.begin(), topology->atom_links_offsets.end() );
+    parallel_inclusive_scan( topology->atom_faces_offsets.begin(), topology->atom_faces_offsets.end() );
+    parallel_inclusive_scan( topology->link_faces_offsets.begin(), topology->link_faces_offsets.end() );
+
+    // copy the rows, the per element vectors are kept for thaw()
+    topology->atom_links.resize( topology->atom_links_offsets[natoms] );
+    topology->atom_faces.resize( topology->atom_faces_offsets[natoms] );
+    topology->link_faces.resize( topology->link_faces_offsets[nlinks] );
+# pragma omp parallel for
+    for( atom_index i = 0; i < natoms; ++i )
+      {
+        const auto& links = atom_links.template get< atom_links_property >( i );
+        std::copy( links.begin(), links.end(),
+                   topology->atom_links.begin() + topology->atom_links_offsets[i] );
+        const auto& faces = atom_faces.template get< atom_faces_property >( i );
+        std::copy( faces.begin(), faces.end(),
+                   topology->atom_faces.begin() + topology->atom_faces_offsets[i] );
+      }
+# pragma omp parallel for
+    for( link_index i = 0; i < nlinks; ++i )
+      {
+        const auto& faces = link_faces.template get< link_faces_property >( i );
+        std::copy( faces.begin(), faces.end(),
+                   topology->link_faces.begin() + topology->link_faces_offsets[i] );
+      }
+
+    m_frozen = std::move( topology );
+  }
+
+  mps_definition(void)::thaw()
+  {
+    // the per element vectors are up to date: only the arrays are released
+    m_frozen.reset();
+  }
+
+  mps_definition(bool)::is_frozen() const noexcept
+  {
+    return bool( m_frozen );
+  }
+
+  mps_definition(void)::set_topology_index( bool enabled )
+  {
+    if( !enabled )
+      {
+        m_topology_index.reset();
+        return;
+      }
+    if( m_topology_index )
+      return;
+
+    m_topology_index.reset( new topology_index );
+    const link_index nlinks = m_impl->m_links_size;
+    const face_index nfaces = m_impl->m_faces_size;
+    m_topology_index->links.reserve( nlinks );
+    m_topology_index->faces.reserve( nfaces );
+    for( link_index i = 0; i < nlinks; ++ i )
+      index_link(
+          link_handle( m_impl->m_link_index_to_handle_index[i],
+                       m_impl->m_link_handles[m_impl->m_link_index_to_handle_index[i]].counter ),
+          m_impl->m_links[i] );
+    for( face_index i = 0; i < nfaces; ++ i )
+      index_face(
+          face_handle( m_impl->m_face_index_to_handle_index[i],
+                       m_impl->m_face_handles[m_impl->m_face_index_to_handle_index[i]].counter ),
+          m_impl->m_faces[i] );
+  }
+
+  mps_definition(bool)::has_topology_index() const noexcept
+  {
+    return bool( m_topology_index );
+  }
+
+  template< typename atom_index >
+  static inline std::array< atom_index, 2 >
+  make_link_key( atom_index a, atom_index b )
+  {
+    return {{ std::min( a, b ), std::max( a, b ) }};
+  }
+
+  template< typename atom_index >
+  static inline std::array< atom_index, 3 >
+  make_face_key( atom_index a, atom_index b, atom_index c )
+  {
+    std::array< atom_index, 3 > key = {{ a, b, c }};
+    std::sort( key.begin(), key.end() );
+    return key;
+  }
+
+  mps_definition(void)::index_link( link_handle handle, const link& l )
+  {
+    if( m_topology_index )
+      m_topology_index->links.insert( make_link_key( l.h1.index, l.h2.index ), handle );
+  }
+
+  mps_definition(void)::unindex_link( const link& l )
+  {
+    if( m_topology_index )
+      m_topology_index->links.erase( make_link_key( l.h1.index, l.h2.index ) );
+  }
+
+  mps_definition(void)::index_face( face_handle handle, const face& f )
+  {
+    if( m_topology_index )
+      m_topology_index->faces.insert(
+          make_face_key( f.atoms[0].index, f.atoms[1].index, f.atoms[2].index ), handle );
+  }
+
+  mps_definition(void)::unindex_face( const face& f )
+  {
+    if( m_topology_index )
+      m_topology_index->faces.erase(
+          make_face_key( f.atoms[0].index, f.atoms[1].index, f.atoms[2].index ) );
+  }
+
+  mps_definition(void)::reorder(
+    space_filling_curve curve )
+  {
+    thaw();
+    const atom_index natoms = m_impl->m_atoms_size;
+    const link_index nlinks = m_impl->m_links_size;
+    const face_index nfaces = m_impl->m_faces_size;
+    if( !natoms )
+      return;
+
+    // atoms, by the codes of their centers in the unit cube of their box
+    {
+      const auto box = compute_centers_bounding_box();
+      const vec3 min = box.center - box.hsides;
+      const real extent = 2 * std::max( std::max( box.hsides.x, box.hsides.y ), box.hsides.z );
+      const real inverse_extent = extent > 0 ? real( 1 ) / extent : real( 0 );
+      const atom* atoms = m_impl->m_atoms.get();
+      std::vector< std::pair< uint64_t, atom_index > > keys( natoms );
+      # pragma omp parallel for
+      for( atom_index i = 0; i < natoms; ++ i )
+        {
+          keys[i].first = curve_code( curve,
+              ( atoms[i].x - min.x ) * inverse_extent,
+              ( atoms[i].y - min.y ) * inverse_extent,
+              ( atoms[i].z - min.z ) * inverse_extent );
+          keys[i].second = i;
+        }
+      parallel_sort( keys.begin(), keys.end() );
+
+      std::vector< atom_index > sources( natoms );
+      # pragma omp parallel for
+      for( atom_index i = 0; i < natoms; ++ i )
+        sources[i] = keys[i].second;
+      m_impl->permute_atoms( sources.data() );
+    }
+
+    // links and faces, by the sorted new indices of their atoms
+    if( nlinks )
+      {
+        std::vector< canonical_element< atom_index, 2 > > keys( nlinks );
+        const link* links = m_impl->m_links.get();
+        # pragma omp parallel for
+        for( link_index i = 0; i < nlinks; ++ i )
+          {
+            keys[i].atoms = make_link_key(
+                m_impl->m_atom_handles[ links[i].h1.index ].atom_index,
+                m_impl->m_atom_handles[ links[i].h2.index ].atom_index );
+            keys[i].position = i;
+          }
+        parallel_sort( keys.begin(), keys.end() );
+
+        std::vector< link_index > sources( nlinks );
+        # pragma omp parallel for
+        for( link_index i = 0; i < nlinks; ++ i )
+          sources[i] = keys[i].position;
+        m_impl->permute_links( sources.data() );
+      }
+
+    if( nfaces )
+      {
+        std::vector< canonical_element< atom_index, 3 > > keys( nfaces );
+        const face* faces = m_impl->m_faces.get();
+        # pragma omp parallel for
+        for( face_index i = 0; i < nfaces; ++ i )
+          {
+            keys[i].atoms = make_face_key(
+                m_impl->m_atom_handles[ faces[i].atoms[0].index ].atom_index,
+                m_impl->m_atom_handles[ faces[i].atoms[1].index ].atom_index,
+                m_impl->m_atom_handles[ faces[i].atoms[2].index ].atom_index );
+            keys[i].position = i;
+          }
+        parallel_sort( keys.begin(), keys.end() );
+
+        std::vector< face_index > sources( nfaces );
+        # pragma omp parallel for
+        for( face_index i = 0; i < nfaces; ++ i )
+          sources[i] = keys[i].position;
+        m_impl->permute_faces( sources.data() );
+      }
+
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
+  }
+
+  /* Skeleton formats read and write double precision skeletons, with either
+   * 32 or 64 bits atom handles. Skeletons of other profiles are converted from
+   * or to such skeleton. */
+  static bool load_skeleton( median_skeleton& skeleton, const std::string& filename )
+  {
+    return io::load( skeleton, filename );
+  }
+
+  static bool load_skeleton( large_median_skeleton& skeleton, const std::string& filename )
+  {
+    return io::load( skeleton, filename );
+  }
+
+  template< typename skeleton_type >
+  static bool load_skeleton( skeleton_type& skeleton, const std::string& filename )
+  {
+    median_skeleton buffer;
+    if( !io::load( buffer, filename ) )
+      return false;
+    skeleton.assign( buffer );
+    return true;
+  }
+
+  static bool save_skeleton( const median_skeleton& skeleton, const std::string& filename )
+  {
+    return io::save( skeleton, filename );
+  }
+
+  static bool save_skeleton( const large_median_skeleton& skeleton, const std::string& filename )
+  {
+    return io::save( skeleton, filename );
+  }
+
+  template< typename skeleton_type >
+  static bool save_skeleton( const skeleton_type& skeleton, const std::string& filename )
   {
-    return io::load( *this, filename );
+    median_skeleton buffer( skeleton );
+    return io::save( buffer, filename );
   }
 
-  bool
-  median_skeleton::save(
+  mps_definition(bool)::load(
     const std::string& filename )
   {
-    return io::save( *this, filename );
+    return load_skeleton( *this, filename );
+  }
+
+  mps_definition(bool)::save(
+    const std::string& filename ) const
+  {
+    return save_skeleton( *this, filename );
   }
 
-  median_skeleton::atom_index
-  median_skeleton::get_number_of_atoms( ) const noexcept
+  mps_definition(typename mps_type::atom_index)::get_number_of_atoms( ) const noexcept
   {
     return m_impl->m_atoms_size;
   }
-  uint64_t
-  median_skeleton::get_number_of_links( ) const noexcept
+  mps_definition(typename mps_type::link_index)::get_number_of_links( ) const noexcept
   {
     return m_impl->m_links_size;
   }
-  uint64_t
-  median_skeleton::get_number_of_faces( ) const noexcept
+  mps_definition(typename mps_type::face_index)::get_number_of_faces( ) const noexcept
   {
     return m_impl->m_faces_size;
   }
 
-  median_skeleton::atom_index
-  median_skeleton::get_atoms_capacity( ) const noexcept
+  mps_definition(typename mps_type::atom_index)::get_atoms_capacity( ) const noexcept
   {
     return m_impl->m_atoms_capacity;
   }
-  median_skeleton::link_index
-  median_skeleton::get_links_capacity( ) const noexcept
+  mps_definition(typename mps_type::link_index)::get_links_capacity( ) const noexcept
   {
     return m_impl->m_links_capacity;
   }
-  median_skeleton::face_index
-  median_skeleton::get_faces_capacity( ) const noexcept
+  mps_definition(typename mps_type::face_index)::get_faces_capacity( ) const noexcept
   {
     return m_impl->m_faces_capacity;
   }
 
-  uint64_t
-  median_skeleton::get_number_of_atom_properties( ) const noexcept
+  mps_definition(uint64_t)::get_number_of_atom_properties( ) const noexcept
   {
     return m_impl->m_atom_properties.size( ) - 2;
   }
 
-  uint64_t
-  median_skeleton::get_number_of_link_properties( ) const noexcept
+  mps_definition(uint64_t)::get_number_of_link_properties( ) const noexcept
   {
     return m_impl->m_link_properties.size( ) - 1;
   }
 
-  uint64_t
-  median_skeleton::get_number_of_face_properties( ) const noexcept
+  mps_definition(uint64_t)::get_number_of_face_properties( ) const noexcept
   {
     return m_impl->m_face_properties.size( );
   }
 
-  graphics_origin::geometry::aabox
-  median_skeleton::compute_bounding_box() const
+  mps_definition(graphics_origin::geometry::aabox)::compute_bounding_box() const
   {
+    /* the box is the cube around the bounding ball of the atoms. Merging
+     * balls is not a component wise reduction, thus this computation does
+     * not use the atom columns. */
+    typedef graphics_origin::geometry::ball ball;
     auto const size = m_impl->m_atoms_size;
     graphics_origin::geometry::aabox result;
     if( size )
       {
-        atom bball = m_impl->m_atoms[0];
+        const atom* atoms = m_impl->m_atoms.get();
+        auto to_ball = []( const atom& a )
+          {
+            return ball{ a.get_center(), a.get_radius() };
+          };
+        ball bball = to_ball( atoms[0] );
 # pragma omp parallel
           {
-            atom thread_bball = m_impl->m_atoms[0];
+            ball thread_bball = to_ball( atoms[0] );
 # pragma omp for
             for( atom_index i = 0; i < size; ++i )
               {
-                thread_bball.merge( m_impl->m_atoms[i] );
+                thread_bball.merge( to_ball( atoms[i] ) );
               }
 # pragma omp critical
             bball.merge( thread_bball );
           }
-        result.center = vec3{ bball };
+        result.center = bball.get_center();
         result.hsides.x = bball.w;
         result.hsides.y = bball.w;
         result.hsides.z = bball.w;
@@ -346,79 +748,287 @@ BEGIN_MP_NAMESPACE
     return result;
   }
 
-  void
-  median_skeleton::compute_minmax_radii(
+  mps_definition(void)::compute_minmax_radii(
     real& minr, real& maxr ) const
   {
-# pragma omp declare reduction(minatomradius: real: omp_out = std::min( omp_out, omp_in ))\
-      initializer(omp_priv = REAL_MAX )
-# pragma omp declare reduction(maxatomradius: real: omp_out = std::max( omp_out, omp_in ))\
-      initializer(omp_priv = -REAL_MAX )
     auto const size = m_impl->m_atoms_size;
     if( size )
       {
-        minr = REAL_MAX;
-        maxr = -REAL_MAX;
-# pragma omp parallel for reduction(minatomradius:minr) reduction(maxatomradius:maxr)
-        for( atom_index i = 0; i < size; ++i )
+        atom_real lminr = std::numeric_limits< atom_real >::max();
+        atom_real lmaxr = -lminr;
+        if( m_atom_layout == structure_of_arrays )
+          {
+            const auto& columns = get_atom_columns();
+            const atom_real* r = columns.r.get();
+            const size_t n = columns.capacity;
+# pragma omp parallel for simd aligned(r:simd_alignment) reduction(min:lminr) reduction(max:lmaxr)
+            for( size_t i = 0; i < n; ++i )
+              {
+                lminr = std::min( lminr, r[i] );
+                lmaxr = std::max( lmaxr, r[i] );
+              }
+          }
+        else
           {
-            const auto r = m_impl->m_atoms[i].w;
-            minr = std::min( minr, r );
-            maxr = std::max( maxr, r );
+            const atom* atoms = m_impl->m_atoms.get();
+# pragma omp parallel for reduction(min:lminr) reduction(max:lmaxr)
+            for( atom_index i = 0; i < size; ++i )
+              {
+                lminr = std::min( lminr, atoms[i].w );
+                lmaxr = std::max( lmaxr, atoms[i].w );
+              }
           }
+        minr = lminr;
+        maxr = lmaxr;
       }
   }
 
-  graphics_origin::geometry::aabox
-  median_skeleton::compute_centers_bounding_box() const
+  mps_definition(graphics_origin::geometry::aabox)::compute_centers_bounding_box() const
   {
-# pragma omp declare reduction(minatomcenter: vec3: omp_out = min( omp_out, omp_in )) \
-      initializer(omp_priv = vec3{REAL_MAX,REAL_MAX,REAL_MAX})
-# pragma omp declare reduction(maxatomcenter: vec3: omp_out = max( omp_out, omp_in )) \
-      initializer(omp_priv = vec3{-REAL_MAX,-REAL_MAX,-REAL_MAX})
     auto const size = m_impl->m_atoms_size;
-    if( size )
+    if( !size )
+      return graphics_origin::geometry::aabox{};
+
+    atom_real minx = std::numeric_limits< atom_real >::max();
+    atom_real miny = minx, minz = minx;
+    atom_real maxx = -minx, maxy = -minx, maxz = -minx;
+    if( m_atom_layout == structure_of_arrays )
+      {
+        const auto& columns = get_atom_columns();
+        const atom_real* x = columns.x.get();
+        const atom_real* y = columns.y.get();
+        const atom_real* z = columns.z.get();
+        const size_t n = columns.capacity;
+# pragma omp parallel for simd aligned(x,y,z:simd_alignment) \
+    reduction(min:minx,miny,minz) reduction(max:maxx,maxy,maxz)
+        for( size_t i = 0; i < n; ++i )
+          {
+            minx = std::min( minx, x[i] );
+            miny = std::min( miny, y[i] );
+            minz = std::min( minz, z[i] );
+            maxx = std::max( maxx, x[i] );
+            maxy = std::max( maxy, y[i] );
+            maxz = std::max( maxz, z[i] );
+          }
+      }
+    else
       {
-        vec3 minp = vec3
-          { REAL_MAX, REAL_MAX, REAL_MAX };
-        vec3 maxp = vec3
-          { -REAL_MAX, -REAL_MAX, -REAL_MAX };
-# pragma omp parallel for reduction(minatomcenter:minp) reduction(maxatomcenter:maxp)
+        const atom* atoms = m_impl->m_atoms.get();
+# pragma omp parallel for \
+    reduction(min:minx,miny,minz) reduction(max:maxx,maxy,maxz)
         for( atom_index i = 0; i < size; ++i )
           {
-            const auto p = vec3( m_impl->m_atoms[i] );
-            minp = min( minp, p );
-            maxp = max( maxp, p );
+            const atom& a = atoms[i];
+            minx = std::min( minx, a.x );
+            miny = std::min( miny, a.y );
+            minz = std::min( minz, a.z );
+            maxx = std::max( maxx, a.x );
+            maxy = std::max( maxy, a.y );
+            maxz = std::max( maxz, a.z );
+          }
+      }
+    return graphics_origin::geometry::aabox{
+      vec3{ minx, miny, minz }, vec3{ maxx, maxy, maxz } };
+  }
+
+  mps_definition(void)::transform(
+    real scale, const vec3& translation )
+  {
+    // computations are done in the precision of atoms
+    const atom_real factor = scale;
+    const atom_real radius_scale = std::abs( factor );
+    const atom_real tx = translation.x, ty = translation.y, tz = translation.z;
+    const atom_index size = m_impl->m_atoms_size;
+    atom* atoms = m_impl->m_atoms.get();
+# pragma omp parallel for simd
+    for( atom_index i = 0; i < size; ++i )
+      {
+        atom& a = atoms[i];
+        a.x = a.x * factor + tx;
+        a.y = a.y * factor + ty;
+        a.z = a.z * factor + tz;
+        a.w *= radius_scale;
+      }
+
+    // keep the columns synchronized instead of rebuilding them later
+    if( m_atom_layout == structure_of_arrays && !m_atom_columns.is_dirty() )
+      {
+        atom_real* x = m_atom_columns.x.get();
+        atom_real* y = m_atom_columns.y.get();
+        atom_real* z = m_atom_columns.z.get();
+        atom_real* r = m_atom_columns.r.get();
+        const size_t n = m_atom_columns.capacity;
+# pragma omp parallel for simd aligned(x,y,z,r:simd_alignment)
+        for( size_t i = 0; i < n; ++i )
+          {
+            x[i] = x[i] * factor + tx;
+            y[i] = y[i] * factor + ty;
+            z[i] = z[i] * factor + tz;
+            r[i] *= radius_scale;
           }
-        return graphics_origin::geometry::aabox{ minp, maxp };
       }
-    return graphics_origin::geometry::aabox{};
+
+    /* boxes of the hierarchy are refitted rather than transformed, such that
+     * they are rounded as the atoms are */
+    m_atom_bvh.invalidate_bounds();
+    if( m_change_journal )
+      m_change_journal->record( m_change_journal->atoms.modified_ranges, 0, size );
+  }
+
+  mps_definition(void)::set_atom_layout(
+    atom_layout layout )
+  {
+    if( layout != m_atom_layout )
+      {
+        m_atom_layout = layout;
+        if( layout == array_of_structures )
+          m_atom_columns.release();
+        else
+          m_atom_columns.invalidate();
+      }
+  }
+
+  mps_definition(typename mps_type::atom_layout)::get_atom_layout() const noexcept
+  {
+    return m_atom_layout;
+  }
+
+  mps_definition(const typename mps_type::atom_columns&)::get_atom_columns() const
+  {
+    m_atom_columns.synchronize( m_impl->m_atoms.get(), m_impl->m_atoms_size );
+    return m_atom_columns;
+  }
+
+  mps_definition(const typename mps_type::atom_bvh&)::get_atom_bvh() const
+  {
+    m_atom_bvh.synchronize( m_impl->m_atoms.get(), m_impl->m_atoms_size );
+    return m_atom_bvh;
+  }
+
+  mps_definition(void)::set_change_journal(
+    bool enable )
+  {
+    if( !enable )
+      m_change_journal.reset();
+    else if( !m_change_journal )
+      m_change_journal.reset( new change_journal );
+    m_impl->m_journal = m_change_journal.get();
+  }
+
+  mps_definition(bool)::has_change_journal() const noexcept
+  {
+    return bool( m_change_journal );
+  }
+
+  mps_definition(const change_journal*)::get_change_journal() const noexcept
+  {
+    return m_change_journal.get();
+  }
+
+  mps_definition(void)::clear_change_journal() noexcept
+  {
+    if( m_change_journal )
+      m_change_journal->clear();
+  }
+
+  mps_definition(void)::mark_atom_property_modified(
+    size_t property_index, atom_index begin, atom_index end )
+  {
+    if( m_change_journal )
+      m_change_journal->record_property( m_change_journal->atoms, property_index, begin, end );
+  }
+
+  mps_definition(void)::mark_link_property_modified(
+    size_t property_index, link_index begin, link_index end )
+  {
+    if( m_change_journal )
+      m_change_journal->record_property( m_change_journal->links, property_index, begin, end );
+  }
+
+  mps_definition(void)::mark_face_property_modified(
+    size_t property_index, face_index begin, face_index end )
+  {
+    if( m_change_journal )
+      m_change_journal->record_property( m_change_journal->faces, property_index, begin, end );
   }
 
-  median_skeleton::atom_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::atom_handle)::add(
     const vec3& position, const real& radius )
   {
+    thaw();
     auto pair = m_impl->create_atom( );
     pair.second = atom
       { position, radius };
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
     return pair.first;
   }
 
-  median_skeleton::atom_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::atom_handle)::add(
     const vec4& ball )
   {
+    thaw();
     auto pair = m_impl->create_atom( );
-    pair.second = ball;
+    pair.second = atom
+      { vec3{ ball.x, ball.y, ball.z }, ball.w };
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
+    return pair.first;
+  }
+
+  mps_definition(void)::begin_concurrent_add(
+    atom_index number_of_atoms )
+  {
+    thaw();
+    m_impl->begin_concurrent_atom_creation( number_of_atoms );
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
+  }
+
+  mps_definition(typename mps_type::atom_handle)::concurrent_add(
+    const vec3& position, const real& radius )
+  {
+    auto pair = m_impl->create_atom_concurrently( );
+    pair.second = atom
+      { position, radius };
+    return pair.first;
+  }
+
+  mps_definition(typename mps_type::atom_handle)::concurrent_add(
+    const vec4& ball )
+  {
+    auto pair = m_impl->create_atom_concurrently( );
+    pair.second = atom
+      { vec3{ ball.x, ball.y, ball.z }, ball.w };
     return pair.first;
   }
 
-  void
-  median_skeleton::remove_atom_special_properties(
+  mps_definition(void)::end_concurrent_add()
+  {
+    m_impl->end_concurrent_atom_creation( );
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
+  }
+
+  mps_definition(typename mps_type::atom_index)::add_atoms(
+    const vec4* balls, atom_index number_of_atoms )
+  {
+    thaw();
+    const atom_index first = m_impl->create_atoms( number_of_atoms );
+    atom* atoms = m_impl->m_atoms.get() + first;
+    # pragma omp parallel for
+    for( atom_index i = 0; i < number_of_atoms; ++ i )
+      atoms[ i ] = atom
+        { vec3{ balls[ i ].x, balls[ i ].y, balls[ i ].z }, balls[ i ].w };
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
+    return first;
+  }
+
+  mps_definition(void)::remove_atom_special_properties(
     atom_index idx )
   {
-    auto& faces = m_impl->m_atom_properties[atom_faces_property_index]->get<
+    auto& faces = m_impl->m_atom_properties[atom_faces_property_index]->template get<
         atom_faces_property >( idx );
     // remove all the faces passing by this atom
     for( auto& fh : faces )
@@ -436,31 +1046,33 @@ BEGIN_MP_NAMESPACE
                 m_impl->m_link_handles[fh.links[i].index].link_index, fh.face );
           }
         // remove this face from the tight buffer
+        unindex_face( m_impl->get( fh.face ) );
         m_impl->remove( fh.face ); // this removes all properties of the face
       }
     atom_faces_property( ).swap( faces ); // all mappings atom -> face for this atom are removed
 
-    auto& links = m_impl->m_atom_properties[atom_links_property_index]->get<
+    auto& links = m_impl->m_atom_properties[atom_links_property_index]->template get<
         atom_links_property >( idx );
     // remove all the links having this atom as end point
     for( auto& lh : links )
       {
         // remove the mapping atom -> link for the other end point
-        remove_atom_to_link( m_impl->m_atom_handles[lh.second].atom_index,
+        remove_atom_to_link( m_impl->m_atom_handles[lh.second.index].atom_index,
                              lh.first );
 
         // if this link was part of a face, the mapping link -> face is already removed
 
         // remove this link from the tight buffer
+        unindex_link( m_impl->get( lh.first ) );
         m_impl->remove( lh.first ); // this removes all other properties of the link
       }
     atom_links_property( ).swap( links );
   }
 
-  void
-  median_skeleton::remove(
+  mps_definition(void)::remove(
     atom_handle handle )
   {
+    thaw();
     if( handle.index < m_impl->m_atoms_capacity )
       {
         const auto& entry = m_impl->m_atom_handles[handle.index];
@@ -469,56 +1081,85 @@ BEGIN_MP_NAMESPACE
           {
             remove_atom_special_properties( entry.atom_index );
             m_impl->remove_atom_by_index( entry.atom_index );
+            m_atom_columns.invalidate();
+            m_atom_bvh.invalidate();
           }
       }
   }
 
-  void
-  median_skeleton::remove(
+  mps_definition(void)::remove(
     atom& e )
   {
+    thaw();
     auto index = m_impl->get_index( e );
     remove_atom_special_properties( index );
     m_impl->remove_atom_by_index( index );
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
   }
 
-  median_skeleton::atom&
-  median_skeleton::get(
+  mps_definition(typename mps_type::atom&)::get(
+    atom_handle handle )
+  {
+    atom& result = m_impl->get( handle );
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate_bounds();
+    if( m_change_journal )
+      {
+        const size_t index = &result - m_impl->m_atoms.get();
+        m_change_journal->record( m_change_journal->atoms.modified_ranges, index, index + 1 );
+      }
+    return result;
+  }
+
+  mps_definition(const typename mps_type::atom&)::get(
     atom_handle handle ) const
   {
     return m_impl->get( handle );
   }
 
-  median_skeleton::atom&
-  median_skeleton::get_atom_by_index(
+  mps_definition(typename mps_type::atom&)::get_atom_by_index(
+    atom_index index )
+  {
+    atom& result = m_impl->get_atom_by_index( index );
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate_bounds();
+    if( m_change_journal )
+      m_change_journal->record( m_change_journal->atoms.modified_ranges, index, index + 1 );
+    return result;
+  }
+
+  mps_definition(const typename mps_type::atom&)::get_atom_by_index(
     atom_index index ) const
   {
     return m_impl->get_atom_by_index( index );
   }
 
-  median_skeleton::atom_index
-  median_skeleton::get_index(
+  mps_definition(typename mps_type::atom_index)::get_index(
     atom_handle handle ) const
   {
     return m_impl->get_index( handle );
   }
 
-  median_skeleton::atom_index
-  median_skeleton::get_index(
+  mps_definition(void)::get_indices(
+    const atom_handle* handles, size_t number_of_handles, atom_index* indices ) const
+  {
+    access< default_check_policy >().get_indices( handles, number_of_handles, indices );
+  }
+
+  mps_definition(typename mps_type::atom_index)::get_index(
     atom& e ) const
   {
     return m_impl->get_index( e );
   }
 
-  median_skeleton::atom_handle
-  median_skeleton::get_handle(
+  mps_definition(typename mps_type::atom_handle)::get_handle(
     atom&e ) const
   {
     return m_impl->get_handle( e );
   }
 
-  bool
-  median_skeleton::is_valid(
+  mps_definition(bool)::is_valid(
     atom_handle handle ) const
   {
     if( handle.index < m_impl->m_atoms_capacity )
@@ -530,35 +1171,28 @@ BEGIN_MP_NAMESPACE
     return false;
   }
 
-  median_skeleton::link_index
-  median_skeleton::get_number_of_links(
+  mps_definition(typename mps_type::link_index)::get_number_of_links(
     atom& e ) const
   {
-    auto index = m_impl->get_index( e );
-    return m_impl->m_atom_properties[atom_links_property_index]->get<
-        atom_links_property >( index ).size( );
+    return get_atom_links( m_impl->get_index( e ) ).size( );
   }
-  median_skeleton::link_index
-  median_skeleton::get_number_of_links(
+  mps_definition(typename mps_type::link_index)::get_number_of_links(
     atom_index index ) const
   {
-# ifndef MP_SKELETON_NO_CHECK
-    if( index >= m_impl->m_atoms_size )
-      MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
-# endif
-    return m_impl->m_atom_properties[atom_links_property_index]->get<
-        atom_links_property >( index ).size( );
+    return get_atom_links( index ).size( );
   }
-  median_skeleton::link_index
-  median_skeleton::get_number_of_links(
+  mps_definition(typename mps_type::link_index)::get_number_of_links(
     atom_handle h ) const
   {
-    auto index = m_impl->get_index( h );
-    return m_impl->m_atom_properties[atom_links_property_index]->get<
-        atom_links_property >( index ).size( );
+    return get_atom_links( m_impl->get_index( h ) ).size( );
   }
 
-  bool median_skeleton::is_an_atom_property_name( const std::string& name ) const noexcept
+  mps_definition(base_property_buffer&)::add_atom_property( std::unique_ptr< base_property_buffer > property )
+  {
+    return *m_impl->add_atom_property( std::move( property ) );
+  }
+
+  mps_definition(bool)::is_an_atom_property_name( const std::string& name ) const noexcept
   {
     for( auto& property : m_impl->m_atom_properties )
       if( property->m_name == name )
@@ -566,7 +1200,7 @@ BEGIN_MP_NAMESPACE
     return false;
   }
 
-  base_property_buffer& median_skeleton::get_atom_property( const std::string& name )
+  mps_definition(base_property_buffer&)::get_atom_property( const std::string& name )
   {
     for( auto& property : m_impl->m_atom_properties )
       if( property->m_name == name )
@@ -574,14 +1208,21 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION(skeleton_invalid_atom_property_name);
   }
 
-  base_property_buffer& median_skeleton::get_atom_property( atom_property_index index )
+  mps_definition(base_property_buffer&)::get_atom_property( atom_property_index index )
+  {
+    if( index >= m_impl->m_atom_properties.size() )
+      MP_THROW_EXCEPTION(skeleton_invalid_atom_property_index);
+    return *m_impl->m_atom_properties[index];
+  }
+
+  mps_definition(const base_property_buffer&)::get_atom_property( atom_property_index index ) const
   {
     if( index >= m_impl->m_atom_properties.size() )
       MP_THROW_EXCEPTION(skeleton_invalid_atom_property_index);
     return *m_impl->m_atom_properties[index];
   }
 
-  median_skeleton::atom_property_index median_skeleton::get_atom_property_index( base_property_buffer& property ) const
+  mps_definition(typename mps_type::atom_property_index)::get_atom_property_index( base_property_buffer& property ) const
   {
     const size_t n = m_impl->m_atom_properties.size();
     for( size_t i = 0; i < n; ++ i )
@@ -590,23 +1231,22 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION(skeleton_invalid_atom_property_pointer);
   }
 
-  void median_skeleton::remove_atom_property( base_property_buffer& property )
+  mps_definition(void)::remove_atom_property( base_property_buffer& property )
   {
     m_impl->remove_atom_property( property );
   }
 
-  void median_skeleton::remove_atom_property( atom_property_index index )
+  mps_definition(void)::remove_atom_property( atom_property_index index )
   {
     m_impl->remove_atom_property( index );
   }
 
-  void median_skeleton::remove_atom_property( const std::string& name )
+  mps_definition(void)::remove_atom_property( const std::string& name )
   {
     m_impl->remove_atom_property( name );
   }
 
-  median_skeleton::link_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::link_handle)::add(
     atom_handle handle1, atom_handle handle2 )
   {
     if( handle1.index < m_impl->m_atoms_capacity
@@ -625,8 +1265,7 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION( skeleton_invalid_atom_handle );
   }
 
-  median_skeleton::link_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::link_handle)::add(
     atom& atom1, atom& atom2 )
   {
     if( &atom1 >= m_impl->m_atoms.get() && &atom2 >= m_impl->m_atoms.get()
@@ -644,8 +1283,7 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION( skeleton_invalid_atom_handle );
   }
 
-  median_skeleton::link_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::link_handle)::add(
     atom_index idx1, atom_index idx2 )
   {
     if( idx1 < m_impl->m_atoms_size && idx2 < m_impl->m_atoms_size )
@@ -655,8 +1293,101 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
   }
 
-  bool
-  median_skeleton::is_a_link(
+  mps_definition(typename mps_type::link_index)::add_links(
+    const std::vector< std::pair< atom_index, atom_index > >& links )
+  {
+    const size_t nlinks = links.size();
+    const atom_index natoms = m_impl->m_atoms_size;
+    bool valid = true;
+    # pragma omp parallel for reduction(&&:valid)
+    for( size_t i = 0; i < nlinks; ++ i )
+      valid = valid && links[i].first < natoms && links[i].second < natoms;
+    if( !valid )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
+    thaw();
+
+    // sort the links by their atoms to find duplicates
+    std::vector< canonical_element< atom_index, 2 > > keys( nlinks );
+    # pragma omp parallel for
+    for( size_t i = 0; i < nlinks; ++ i )
+      {
+        keys[i].atoms = {{ std::min( links[i].first, links[i].second ),
+                           std::max( links[i].first, links[i].second ) }};
+        keys[i].position = i;
+      }
+    parallel_sort( keys.begin(), keys.end() );
+
+    // keep the first occurrence of each link not already in the skeleton
+    const bool check_existing = m_impl->m_links_size;
+    std::vector< char > keep( nlinks );
+    # pragma omp parallel for
+    for( size_t i = 0; i < nlinks; ++ i )
+      {
+        keep[ keys[i].position ] = ( !i || keys[i - 1].atoms != keys[i].atoms )
+            && !( check_existing && is_a_link( keys[i].atoms[0], keys[i].atoms[1] ) );
+      }
+    decltype( keys )().swap( keys );
+
+    // count the new links of each atom to size the buffers once
+    std::vector< link_index > atom_new_links( natoms, 0 );
+    link_index new_links = 0;
+    # pragma omp parallel for reduction(+:new_links)
+    for( size_t i = 0; i < nlinks; ++ i )
+      {
+        if( keep[i] )
+          {
+            # pragma omp atomic
+            ++atom_new_links[ links[i].first ];
+            # pragma omp atomic
+            ++atom_new_links[ links[i].second ];
+            ++new_links;
+          }
+      }
+    if( !new_links )
+      return 0;
+
+    reserve_links( m_impl->m_links_size + new_links );
+    if( m_topology_index )
+      m_topology_index->links.reserve( m_impl->m_links_size + new_links );
+    # pragma omp parallel for
+    for( atom_index i = 0; i < natoms; ++ i )
+      {
+        if( atom_new_links[i] )
+          {
+            auto& atom_links = m_impl->m_atom_properties[atom_links_property_index]->template get<
+                atom_links_property >( i );
+            atom_links.reserve( atom_links.size() + atom_new_links[i], *m_topology_arena );
+          }
+      }
+
+    // fill the handle table, the links and the adjacency in a single pass
+    for( size_t i = 0; i < nlinks; ++ i )
+      {
+        if( !keep[i] )
+          continue;
+        const atom_index idx1 = links[i].first;
+        const atom_index idx2 = links[i].second;
+        auto entry_index1 = m_impl->m_atom_index_to_handle_index[idx1];
+        auto entry_index2 = m_impl->m_atom_index_to_handle_index[idx2];
+        atom_handle handle1( entry_index1,
+                             m_impl->m_atom_handles[entry_index1].counter );
+        atom_handle handle2( entry_index2,
+                             m_impl->m_atom_handles[entry_index2].counter );
+
+        auto result = m_impl->create_link( );
+        result.second.h1 = handle1;
+        result.second.h2 = handle2;
+        index_link( result.first, result.second );
+
+        m_impl->m_atom_properties[atom_links_property_index]->template get<
+            atom_links_property >( idx1 ).push_back( std::make_pair( result.first, handle2 ), *m_topology_arena );
+        m_impl->m_atom_properties[atom_links_property_index]->template get<
+            atom_links_property >( idx2 ).push_back( std::make_pair( result.first, handle1 ), *m_topology_arena );
+      }
+    return new_links;
+  }
+
+  mps_definition(bool)::is_a_link(
         atom_index idx1,
         atom_index idx2 ) const
   {
@@ -665,10 +1396,12 @@ BEGIN_MP_NAMESPACE
       MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
 # endif
     auto entry_index2 = m_impl->m_atom_index_to_handle_index[idx2];
+    if( m_topology_index )
+      return m_topology_index->links.find( make_link_key(
+          m_impl->m_atom_index_to_handle_index[idx1], entry_index2 ) ) != nullptr;
     atom_handle handle2( entry_index2, m_impl->m_atom_handles[entry_index2].counter );
-    auto& links1 = m_impl->m_atom_properties[ atom_links_property_index ]->get< atom_links_property >( idx1 );
 
-    for( auto& link : links1 )
+    for( auto& link : get_atom_links( idx1 ) )
       {
         if( link.second == handle2 )
           return true;
@@ -676,25 +1409,94 @@ BEGIN_MP_NAMESPACE
     return false;
   }
 
-  median_skeleton::link_handle
-  median_skeleton::do_add_link(
+  mps_template_parameters
+  typename mps_type::template element_range< std::pair< typename mps_type::link_handle, typename mps_type::atom_handle > >
+  mps_type::get_atom_links(
+    atom_index index ) const
+  {
+# ifndef MP_SKELETON_NO_CHECK
+    if( index >= m_impl->m_atoms_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
+# endif
+    if( m_frozen )
+      {
+        auto data = m_frozen->atom_links.data();
+        return { data + m_frozen->atom_links_offsets[index],
+                 data + m_frozen->atom_links_offsets[index + 1] };
+      }
+    auto& links = m_impl->m_atom_properties[atom_links_property_index]->template get<
+        atom_links_property >( index );
+    return { links.data(), links.data() + links.size() };
+  }
+
+  mps_template_parameters
+  typename mps_type::template element_range< typename mps_type::atom_face_element >
+  mps_type::get_atom_faces(
+    atom_index index ) const
+  {
+# ifndef MP_SKELETON_NO_CHECK
+    if( index >= m_impl->m_atoms_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
+# endif
+    if( m_frozen )
+      {
+        auto data = m_frozen->atom_faces.data();
+        return { data + m_frozen->atom_faces_offsets[index],
+                 data + m_frozen->atom_faces_offsets[index + 1] };
+      }
+    auto& faces = m_impl->m_atom_properties[atom_faces_property_index]->template get<
+        atom_faces_property >( index );
+    return { faces.data(), faces.data() + faces.size() };
+  }
+
+  mps_template_parameters
+  typename mps_type::template element_range< typename mps_type::link_face_element >
+  mps_type::get_link_faces(
+    link_index index ) const
+  {
+# ifndef MP_SKELETON_NO_CHECK
+    if( index >= m_impl->m_links_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_link_index );
+# endif
+    if( m_frozen )
+      {
+        auto data = m_frozen->link_faces.data();
+        return { data + m_frozen->link_faces_offsets[index],
+                 data + m_frozen->link_faces_offsets[index + 1] };
+      }
+    auto& faces = m_impl->m_link_properties[link_faces_property_index]->template get<
+        link_faces_property >( index );
+    return { faces.data(), faces.data() + faces.size() };
+  }
+
+  mps_definition(typename mps_type::link_handle)::do_add_link(
     atom_index idx1, atom_index idx2 )
   {
+    thaw();
     auto entry_index2 = m_impl->m_atom_index_to_handle_index[idx2];
     atom_handle handle2( entry_index2,
                          m_impl->m_atom_handles[entry_index2].counter );
-    auto& links1 = m_impl->m_atom_properties[atom_links_property_index]->get<
+    auto entry_index1 = m_impl->m_atom_index_to_handle_index[idx1];
+    auto& links1 = m_impl->m_atom_properties[atom_links_property_index]->template get<
         atom_links_property >( idx1 );
     // check for existing link
-    for( auto& link : links1 )
+    if( m_topology_index )
       {
-        if( link.second == handle2 )
-          return link.first;
+        auto existing = m_topology_index->links.find( make_link_key( entry_index1, entry_index2 ) );
+        if( existing )
+          return *existing;
+      }
+    else
+      {
+        for( auto& link : links1 )
+          {
+            if( link.second == handle2 )
+              return link.first;
+          }
       }
-    auto entry_index1 = m_impl->m_atom_index_to_handle_index[idx1];
     atom_handle handle1( entry_index1,
                          m_impl->m_atom_handles[entry_index1].counter );
-    auto& links2 = m_impl->m_atom_properties[atom_links_property_index]->get<
+    auto& links2 = m_impl->m_atom_properties[atom_links_property_index]->template get<
         atom_links_property >( idx2 );
 
     // set the link data
@@ -702,16 +1504,18 @@ BEGIN_MP_NAMESPACE
     result.second.h1 = handle1;
     result.second.h2 = handle2;
 
+    index_link( result.first, result.second );
+
     // set the link property for corresponding atoms
-    links1.push_back( std::make_pair( result.first, handle2 ) );
-    links2.push_back( std::make_pair( result.first, handle1 ) );
+    links1.push_back( std::make_pair( result.first, handle2 ), *m_topology_arena );
+    links2.push_back( std::make_pair( result.first, handle1 ), *m_topology_arena );
     return result.first;
   }
 
-  void
-  median_skeleton::remove(
+  mps_definition(void)::remove(
     link_handle handle )
   {
+    thaw();
     if( handle.index < m_impl->m_links_capacity )
       {
         const auto link_entry = m_impl->m_link_handles.get() + handle.index;
@@ -725,7 +1529,7 @@ BEGIN_MP_NAMESPACE
 
             // we start by destroying all the faces built with this link
             auto& faces =
-                m_impl->m_link_properties[link_faces_property_index]->get<
+                m_impl->m_link_properties[link_faces_property_index]->template get<
                     link_faces_property >( link_index );
             for( auto& face : faces )
               {
@@ -743,6 +1547,7 @@ BEGIN_MP_NAMESPACE
                     m_impl->m_atom_handles[face.opposite.index].atom_index,
                     face.face );
                 // remove the face from the tight buffer
+                unindex_face( m_impl->get( face.face ) );
                 m_impl->remove( face.face ); // this removes all other properties of that face
               }
             link_faces_property( ).swap( faces ); // all mappings link -> face for this link are removed
@@ -750,22 +1555,23 @@ BEGIN_MP_NAMESPACE
             // remove that link
             remove_atom_to_link( idx1, handle );
             remove_atom_to_link( idx2, handle );
+            unindex_link( link );
             m_impl->remove( handle ); // this removes all other properties of that link
           }
       }
   }
 
-  void
-  median_skeleton::remove(
+  mps_definition(void)::remove(
     link& e )
   {
+    thaw();
     auto link_index = m_impl->get_index( e );
 
     atom_index idx1 = m_impl->m_atom_handles[e.h1.index].atom_index;
     atom_index idx2 = m_impl->m_atom_handles[e.h2.index].atom_index;
 
     // we start by destroying all the faces built with this link
-    auto& faces = m_impl->m_link_properties[link_faces_property_index]->get<
+    auto& faces = m_impl->m_link_properties[link_faces_property_index]->template get<
         link_faces_property >( link_index );
     for( auto& face : faces )
       {
@@ -782,6 +1588,7 @@ BEGIN_MP_NAMESPACE
         remove_atom_to_face(
             m_impl->m_atom_handles[face.opposite.index].atom_index, face.face );
         // remove the face from the tight buffer
+        unindex_face( m_impl->get( face.face ) );
         m_impl->remove( face.face ); // this removes all other properties of that face
       }
     link_faces_property( ).swap( faces ); // all mappings link -> face for this link are removed
@@ -792,46 +1599,47 @@ BEGIN_MP_NAMESPACE
     handle.counter = m_impl->m_link_handles[handle.index].counter;
     remove_atom_to_link( idx1, handle );
     remove_atom_to_link( idx2, handle );
+    unindex_link( e );
     m_impl->remove( e ); // this removes all other properties of that link
   }
 
-  median_skeleton::link&
-  median_skeleton::get(
+  mps_definition(typename mps_type::link&)::get(
     link_handle handle ) const
   {
     return m_impl->get( handle );
   }
 
-  median_skeleton::link&
-  median_skeleton::get_link_by_index(
+  mps_definition(typename mps_type::link&)::get_link_by_index(
     link_index index ) const
   {
     return m_impl->get_link_by_index( index );
   }
 
-  median_skeleton::link_index
-  median_skeleton::get_index(
+  mps_definition(typename mps_type::link_index)::get_index(
     link_handle handle ) const
   {
     return m_impl->get_index( handle );
   }
 
-  median_skeleton::link_index
-  median_skeleton::get_index(
+  mps_definition(void)::get_indices(
+    const link_handle* handles, size_t number_of_handles, link_index* indices ) const
+  {
+    access< default_check_policy >().get_indices( handles, number_of_handles, indices );
+  }
+
+  mps_definition(typename mps_type::link_index)::get_index(
     link& e ) const
   {
     return m_impl->get_index( e );
   }
 
-  median_skeleton::link_handle
-  median_skeleton::get_handle(
+  mps_definition(typename mps_type::link_handle)::get_handle(
     link& e ) const
   {
     return m_impl->get_handle( e );
   }
 
-  bool
-  median_skeleton::is_valid(
+  mps_definition(bool)::is_valid(
     link_handle handle ) const
   {
     if( handle.index < m_impl->m_links_capacity )
@@ -843,35 +1651,28 @@ BEGIN_MP_NAMESPACE
     return false;
   }
 
-  median_skeleton::face_index
-  median_skeleton::get_number_of_faces(
+  mps_definition(typename mps_type::face_index)::get_number_of_faces(
     link& e ) const
   {
-    auto index = m_impl->get_index( e );
-    return m_impl->m_link_properties[link_faces_property_index]->get<
-        link_faces_property >( index ).size( );
+    return get_link_faces( m_impl->get_index( e ) ).size( );
   }
-  median_skeleton::face_index
-  median_skeleton::get_number_of_faces(
+  mps_definition(typename mps_type::face_index)::get_number_of_faces(
     link_index index ) const
   {
-# ifndef MP_SKELETON_NO_CHECK
-    if( index >= m_impl->m_links_size )
-      MP_THROW_EXCEPTION( skeleton_invalid_link_index );
-# endif
-    return m_impl->m_link_properties[link_faces_property_index]->get<
-        link_faces_property >( index ).size( );
+    return get_link_faces( index ).size( );
   }
-  median_skeleton::face_index
-  median_skeleton::get_number_of_faces(
+  mps_definition(typename mps_type::face_index)::get_number_of_faces(
     link_handle h ) const
   {
-    auto index = m_impl->get_index( h );
-    return m_impl->m_link_properties[link_faces_property_index]->get<
-        link_faces_property >( index ).size( );
+    return get_link_faces( m_impl->get_index( h ) ).size( );
   }
 
-  bool median_skeleton::is_an_link_property_name( const std::string& name ) const noexcept
+  mps_definition(base_property_buffer&)::add_link_property( std::unique_ptr< base_property_buffer > property )
+  {
+    return *m_impl->add_link_property( std::move( property ) );
+  }
+
+  mps_definition(bool)::is_an_link_property_name( const std::string& name ) const noexcept
   {
     for( auto& property : m_impl->m_link_properties )
       if( property->m_name == name )
@@ -879,7 +1680,7 @@ BEGIN_MP_NAMESPACE
     return false;
   }
 
-  base_property_buffer& median_skeleton::get_link_property( const std::string& name )
+  mps_definition(base_property_buffer&)::get_link_property( const std::string& name )
   {
     for( auto& property : m_impl->m_link_properties )
       if( property->m_name == name )
@@ -887,14 +1688,21 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION(skeleton_invalid_link_property_name);
   }
 
-  base_property_buffer& median_skeleton::get_link_property( link_property_index index )
+  mps_definition(base_property_buffer&)::get_link_property( link_property_index index )
+  {
+    if( index >= m_impl->m_link_properties.size() )
+      MP_THROW_EXCEPTION(skeleton_invalid_link_property_index);
+    return *m_impl->m_link_properties[index];
+  }
+
+  mps_definition(const base_property_buffer&)::get_link_property( link_property_index index ) const
   {
     if( index >= m_impl->m_link_properties.size() )
       MP_THROW_EXCEPTION(skeleton_invalid_link_property_index);
     return *m_impl->m_link_properties[index];
   }
 
-  median_skeleton::link_property_index median_skeleton::get_link_property_index( base_property_buffer& property ) const
+  mps_definition(typename mps_type::link_property_index)::get_link_property_index( base_property_buffer& property ) const
   {
     const size_t n = m_impl->m_link_properties.size();
     for( size_t i = 0; i < n; ++ i )
@@ -903,24 +1711,23 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION(skeleton_invalid_link_property_pointer);
   }
 
-  void median_skeleton::remove_link_property( base_property_buffer& property )
+  mps_definition(void)::remove_link_property( base_property_buffer& property )
   {
     m_impl->remove_link_property( property );
   }
 
-  void median_skeleton::remove_link_property( link_property_index index )
+  mps_definition(void)::remove_link_property( link_property_index index )
   {
     m_impl->remove_link_property( index );
   }
 
-  void median_skeleton::remove_link_property( const std::string& name )
+  mps_definition(void)::remove_link_property( const std::string& name )
   {
     m_impl->remove_link_property( name );
   }
 
-  void
-  median_skeleton::remove_link_indices(
-    bool* flags )
+  mps_definition(void)::remove_link_indices(
+    bool preserve_order )
   {
     /* When a link is removed:
      *   all its faces should be removed
@@ -929,118 +1736,57 @@ BEGIN_MP_NAMESPACE
      *   its two atoms should be notified they are no longer connected
      *     - the connection is identified by the link handle
      *     - thus this notification should be done before modifying the link buffer
-     *   it must be exchanged with the last link l of the tight buffer
-     *     - its handle wont be valid anymore
-     *     - the handle of l need to point to the new memory
-     *     - the index to handle index of l should be updated
-     */
-
-    const link_index link_size = m_impl->m_links_size;
-    /* For each link to remove:
-     *  - all faces connected are tagged, then removed
-     *  - the two atoms are notified they are no longer connected
+     *   the remaining links are moved to keep the buffer tight
+     *     - this is the job of compact_links(...)
      */
-      {
-        const face_index face_size = m_impl->m_faces_size;
-        bool* face_flags = new bool[face_size];
+    m_link_compaction.build( preserve_order );
+    const link_index nremoved = m_link_compaction.number_of_removed;
+    if( !nremoved )
+      return;
+    const uint8_t* flags = m_link_compaction.flags.data();
+    const link_index* removed = m_link_compaction.removed.data();
+
+    // tag all faces connected to a removed link
+    m_face_compaction.reset( m_impl->m_faces_size );
+    uint8_t* face_flags = m_face_compaction.flags.data();
 # pragma omp parallel for
-        for( face_index i = 0; i < face_size; ++i )
-          face_flags[i] = false;
-
-        for( link_index i = 0; i < link_size; ++i )
+    for( link_index k = 0; k < nremoved; ++k )
+      {
+        auto& lfaces =
+            m_impl->m_link_properties[link_faces_property_index]->template get<
+                link_faces_property >( removed[k] );
+        for( auto& lface : lfaces )
           {
-            if( flags[i] )
-              {
-                auto& lfaces =
-                    m_impl->m_link_properties[link_faces_property_index]->get<
-                        link_faces_property >( i );
-                for( auto& lface : lfaces )
-                  {
-                    face_flags[m_impl->m_face_handles[lface.face.index].face_index] =
-                        true;
-                  }
-
-                auto& link = m_impl->m_links[i];
-                link_handle lhandle( m_impl->m_link_index_to_handle_index[i],
-                                     0 );
-                lhandle.counter = m_impl->m_link_handles[lhandle.index].counter;
-
-                remove_atom_to_link(
-                    m_impl->m_atom_handles[link.h1.index].atom_index, lhandle );
-                remove_atom_to_link(
-                    m_impl->m_atom_handles[link.h2.index].atom_index, lhandle );
-              }
+# pragma omp atomic write
+            face_flags[m_impl->m_face_handles[lface.face.index].face_index] = 1;
           }
-        // this will deal with the atom_face_property and link_face_property
-        remove_faces_indices( face_flags );
-      }
-
-    /* INVARIANT:
-     * - all links with indices in [[0, left[[ are not removed
-     * - all links with indices in [[left, right[[ need to be checked
-     * - all links with indices in [[right, size[[ should have their properties cleaned
-     *
-     * Thus, in the end (i.e. when left == right ), we have:
-     * - links with indices in [[0,left[[ are clean and tight
-     * - links with indices in [[left, size[[ should have their properties cleaned
-     * - left is the new size of links */
-    link_index next_free_slot = m_impl->m_links_next_free_handle_slot;
-    link_index left = 0, right = link_size;
-    while( left < right )
-      {
-        if( flags[left] )
-          {
-            // update the left_entry
-            const auto left_entry_index =
-                m_impl->m_link_index_to_handle_index[left];
-            auto left_entry = m_impl->m_link_handles.get() + left_entry_index;
-            left_entry->next_free_index = next_free_slot;
-            left_entry->status = datastructure::STATUS_FREE;
-            next_free_slot = left_entry_index;
-
-            // look for a valid link in the end of the buffer
-            --right;
-            while( left < right && flags[right] )
-              {
-                const auto entry_index =
-                    m_impl->m_link_index_to_handle_index[right];
-                auto entry = m_impl->m_link_handles.get() + entry_index;
-                entry->next_free_index = next_free_slot;
-                entry->status = datastructure::STATUS_FREE;
-                next_free_slot = entry_index;
-                --right;
-              }
+      }
 
-            if( left != right )
-              {
-                // move the last link into this one to keep the buffer tight
-                m_impl->m_links[left] = std::move( m_impl->m_links[right] );
-                for( auto& property : m_impl->m_link_properties )
-                  property->move( right, left );
-
-                const auto right_entry_index =
-                    m_impl->m_link_index_to_handle_index[right];
-                auto right_entry = m_impl->m_link_handles.get() + right_entry_index;
-                right_entry->link_index = left;
-                m_impl->m_link_index_to_handle_index[left] = right_entry_index;
-                ++left;
-              }
-          }
-        else
-          ++left;
+    /* notify the atoms: each atom drops its removed links, such that no two
+     * threads modify the same atom */
+    const atom_index natoms = m_impl->m_atoms_size;
+# pragma omp parallel for schedule(dynamic,256)
+    for( atom_index i = 0; i < natoms; ++i )
+      {
+        auto& links = m_impl->m_atom_properties[atom_links_property_index]->template get<
+            atom_links_property >( i );
+        erase_if( links,
+          [this, flags]( const std::pair< link_handle, atom_handle >& alink )
+          {
+            return flags[m_impl->m_link_handles[alink.first.index].link_index] != 0;
+          });
       }
-    delete[] flags;
 
-    // destroy properties of links in [[left, size[[
-    for( auto& property : m_impl->m_link_properties )
-      property->destroy( left, link_size );
+    if( m_topology_index )
+      for( link_index k = 0; k < nremoved; ++k )
+        unindex_link( m_impl->m_links[removed[k]] );
 
-    m_impl->m_links_size = left;
-    m_impl->m_links_next_free_handle_slot = next_free_slot;
+    // this will deal with the atom_face_property and link_face_property
+    remove_faces_indices( preserve_order );
+    m_impl->compact_links( m_link_compaction );
   }
 
-  median_skeleton::face_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::face_handle)::add(
     atom& atom1, atom& atom2, atom& atom3 )
   {
     if( &atom1 >= m_impl->m_atoms.get() && &atom2 >= m_impl->m_atoms.get()
@@ -1061,8 +1807,7 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION( skeleton_invalid_atom_pointer );
   }
 
-  median_skeleton::face_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::face_handle)::add(
     atom_index idx1, atom_index idx2, atom_index idx3 )
   {
     if( idx1 < m_impl->m_atoms_size && idx2 < m_impl->m_atoms_size
@@ -1073,18 +1818,203 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
   }
 
-  median_skeleton::face_handle
-  median_skeleton::do_add_face(
+  mps_definition(typename mps_type::face_index)::add_faces(
+    const std::vector< std::array< atom_index, 3 > >& faces )
+  {
+    const size_t nfaces = faces.size();
+    const atom_index natoms = m_impl->m_atoms_size;
+    bool valid = true;
+    # pragma omp parallel for reduction(&&:valid)
+    for( size_t i = 0; i < nfaces; ++ i )
+      valid = valid && faces[i][0] < natoms && faces[i][1] < natoms
+          && faces[i][2] < natoms;
+    if( !valid )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
+    thaw();
+
+    auto get_atom_handle = [this]( atom_index index )
+      {
+        auto entry_index = m_impl->m_atom_index_to_handle_index[index];
+        return atom_handle( entry_index, m_impl->m_atom_handles[entry_index].counter );
+      };
+
+    // sort the faces by their atoms to find duplicates
+    std::vector< canonical_element< atom_index, 3 > > keys( nfaces );
+    # pragma omp parallel for
+    for( size_t i = 0; i < nfaces; ++ i )
+      {
+        keys[i].atoms = faces[i];
+        std::sort( keys[i].atoms.begin(), keys[i].atoms.end() );
+        keys[i].position = i;
+      }
+    parallel_sort( keys.begin(), keys.end() );
+
+    // keep the first occurrence of each valid face not already in the skeleton
+    const bool check_existing = m_impl->m_faces_size;
+    std::vector< char > keep( nfaces );
+    # pragma omp parallel for
+    for( size_t i = 0; i < nfaces; ++ i )
+      {
+        const auto& atoms = keys[i].atoms;
+        bool result = ( !i || keys[i - 1].atoms != atoms )
+            && atoms[0] != atoms[1] && atoms[1] != atoms[2];
+        if( result && check_existing && m_topology_index )
+          {
+            result = !m_topology_index->faces.find( make_face_key(
+                m_impl->m_atom_index_to_handle_index[ atoms[0] ],
+                m_impl->m_atom_index_to_handle_index[ atoms[1] ],
+                m_impl->m_atom_index_to_handle_index[ atoms[2] ] ) );
+          }
+        else if( result && check_existing )
+          {
+            const auto handle1 = get_atom_handle( atoms[1] );
+            const auto handle2 = get_atom_handle( atoms[2] );
+            for( auto& face : get_atom_faces( atoms[0] ) )
+              {
+                if( (face.atoms[0] == handle1 && face.atoms[1] == handle2)
+                    || (face.atoms[0] == handle2 && face.atoms[1] == handle1) )
+                  {
+                    result = false;
+                    break;
+                  }
+              }
+          }
+        keep[ keys[i].position ] = result;
+      }
+    decltype( keys )().swap( keys );
+
+    std::vector< size_t > kept;
+    for( size_t i = 0; i < nfaces; ++ i )
+      if( keep[i] )
+        kept.push_back( i );
+    const face_index new_faces = kept.size();
+    if( !new_faces )
+      return 0;
+
+    // create the missing links in bulk
+      {
+        std::vector< std::pair< atom_index, atom_index > > edges( 3 * kept.size() );
+        # pragma omp parallel for
+        for( size_t i = 0; i < kept.size(); ++ i )
+          {
+            const auto& face = faces[ kept[i] ];
+            edges[ 3 * i     ] = std::make_pair( face[0], face[1] );
+            edges[ 3 * i + 1 ] = std::make_pair( face[1], face[2] );
+            edges[ 3 * i + 2 ] = std::make_pair( face[2], face[0] );
+          }
+        add_links( edges );
+      }
+
+    // fetch the face links and count the new faces of each atom and link
+    std::vector< std::array< link_handle, 3 > > face_links( kept.size() );
+    std::vector< face_index > atom_new_faces( natoms, 0 );
+    std::vector< face_index > link_new_faces( m_impl->m_links_size, 0 );
+    # pragma omp parallel for
+    for( size_t i = 0; i < kept.size(); ++ i )
+      {
+        const auto& face = faces[ kept[i] ];
+        for( int j = 0; j < 3; ++ j )
+          {
+            const auto next = get_atom_handle( face[ (j + 1) % 3 ] );
+            if( m_topology_index )
+              {
+                face_links[i][j] = *m_topology_index->links.find( make_link_key(
+                    m_impl->m_atom_index_to_handle_index[ face[j] ], next.index ) );
+              }
+            else
+              {
+                for( auto& link : get_atom_links( face[j] ) )
+                  {
+                    if( link.second == next )
+                      {
+                        face_links[i][j] = link.first;
+                        break;
+                      }
+                  }
+              }
+            # pragma omp atomic
+            ++atom_new_faces[ face[j] ];
+            # pragma omp atomic
+            ++link_new_faces[ m_impl->m_link_handles[face_links[i][j].index].link_index ];
+          }
+      }
+
+    reserve_faces( m_impl->m_faces_size + new_faces );
+    if( m_topology_index )
+      m_topology_index->faces.reserve( m_impl->m_faces_size + new_faces );
+    # pragma omp parallel for
+    for( atom_index i = 0; i < natoms; ++ i )
+      {
+        if( atom_new_faces[i] )
+          {
+            auto& atom_faces = m_impl->m_atom_properties[atom_faces_property_index]->template get<
+                atom_faces_property >( i );
+            atom_faces.reserve( atom_faces.size() + atom_new_faces[i], *m_topology_arena );
+          }
+      }
+    # pragma omp parallel for
+    for( link_index i = 0; i < link_new_faces.size(); ++ i )
+      {
+        if( link_new_faces[i] )
+          {
+            auto& link_faces = m_impl->m_link_properties[link_faces_property_index]->template get<
+                link_faces_property >( i );
+            link_faces.reserve( link_faces.size() + link_new_faces[i] );
+          }
+      }
+
+    // fill the handle table, the faces and the adjacency in a single pass
+    for( size_t i = 0; i < kept.size(); ++ i )
+      {
+        const auto& face = faces[ kept[i] ];
+        auto result = m_impl->create_face( );
+        for( int j = 0; j < 3; ++ j )
+          {
+            result.second.atoms[j] = get_atom_handle( face[j] );
+            result.second.links[j] = face_links[i][j];
+          }
+        index_face( result.first, result.second );
+        for( ushort j = 0; j < 3; ++ j )
+          {
+            m_impl->m_atom_properties[atom_faces_property_index]->template get<
+                atom_faces_property >( face[j] ).push_back(
+                atom_face_element( result.second, result.first, j ), *m_topology_arena );
+            m_impl->m_link_properties[link_faces_property_index]->template get<
+                link_faces_property >(
+                m_impl->m_link_handles[face_links[i][j].index].link_index ).push_back(
+                link_face_element( result.second, result.first, j ) );
+          }
+      }
+    return new_faces;
+  }
+
+  mps_definition(typename mps_type::face_handle)::do_add_face(
     atom_index idx1, atom_index idx2, atom_index idx3 )
   {
-    auto& faces1 = m_impl->m_atom_properties[atom_faces_property_index]->get<
-        atom_faces_property >( idx1 );
-    for( auto& face : faces1 )
+    thaw();
+    // check for existing face
+    const auto entry_index2 = m_impl->m_atom_index_to_handle_index[idx2];
+    const auto entry_index3 = m_impl->m_atom_index_to_handle_index[idx3];
+    if( m_topology_index )
       {
-        if( (face.atoms[0] == idx2 && face.atoms[1] == idx3)
-            && (face.atoms[0] == idx3 && face.atoms[1] == idx2) )
+        auto existing = m_topology_index->faces.find( make_face_key(
+            m_impl->m_atom_index_to_handle_index[idx1], entry_index2, entry_index3 ) );
+        if( existing )
+          return *existing;
+      }
+    else
+      {
+        const atom_handle handle2( entry_index2, m_impl->m_atom_handles[entry_index2].counter );
+        const atom_handle handle3( entry_index3, m_impl->m_atom_handles[entry_index3].counter );
+        auto& faces1 = m_impl->m_atom_properties[atom_faces_property_index]->template get<
+            atom_faces_property >( idx1 );
+        for( auto& face : faces1 )
           {
-            return face.face;
+            if( (face.atoms[0] == handle2 && face.atoms[1] == handle3)
+                || (face.atoms[0] == handle3 && face.atoms[1] == handle2) )
+              {
+                return face.face;
+              }
           }
       }
 
@@ -1103,22 +2033,32 @@ BEGIN_MP_NAMESPACE
     // fetch the face links, creating them if needed
       {
         auto& links1 =
-            m_impl->m_atom_properties[atom_links_property_index]->get<
+            m_impl->m_atom_properties[atom_links_property_index]->template get<
                 atom_links_property >( idx1 );
         auto& links2 =
-            m_impl->m_atom_properties[atom_links_property_index]->get<
+            m_impl->m_atom_properties[atom_links_property_index]->template get<
                 atom_links_property >( idx2 );
         auto& links3 =
-            m_impl->m_atom_properties[atom_links_property_index]->get<
+            m_impl->m_atom_properties[atom_links_property_index]->template get<
                 atom_links_property >( idx3 );
 
         // search for link 1 -- 2
-        for( auto& link : links1 )
+        if( m_topology_index )
+          {
+            auto existing = m_topology_index->links.find( make_link_key(
+                result.second.atoms[0].index, result.second.atoms[1].index ) );
+            if( existing )
+              result.second.links[0] = *existing;
+          }
+        else
           {
-            if( link.second == result.second.atoms[1] )
+            for( auto& link : links1 )
               {
-                result.second.links[0] = link.first;
-                break;
+                if( link.second == result.second.atoms[1] )
+                  {
+                    result.second.links[0] = link.first;
+                    break;
+                  }
               }
           }
         // create the link 1 -- 2 if it does not exist
@@ -1129,19 +2069,30 @@ BEGIN_MP_NAMESPACE
             pair.second.h1 = result.second.atoms[0];
             pair.second.h2 = result.second.atoms[1];
 
-            links1.push_back( std::make_pair( pair.first, pair.second.h2 ) );
-            links2.push_back( std::make_pair( pair.first, pair.second.h1 ) );
+            links1.push_back( std::make_pair( pair.first, pair.second.h2 ), *m_topology_arena );
+            links2.push_back( std::make_pair( pair.first, pair.second.h1 ), *m_topology_arena );
 
             result.second.links[0] = pair.first;
+            index_link( pair.first, pair.second );
           }
 
         // search for link 2 -- 3
-        for( auto& link : links2 )
+        if( m_topology_index )
           {
-            if( link.second == result.second.atoms[2] )
+            auto existing = m_topology_index->links.find( make_link_key(
+                result.second.atoms[1].index, result.second.atoms[2].index ) );
+            if( existing )
+              result.second.links[1] = *existing;
+          }
+        else
+          {
+            for( auto& link : links2 )
               {
-                result.second.links[1] = link.first;
-                break;
+                if( link.second == result.second.atoms[2] )
+                  {
+                    result.second.links[1] = link.first;
+                    break;
+                  }
               }
           }
         // create the link 2 -- 3 if it does not exist
@@ -1152,19 +2103,30 @@ BEGIN_MP_NAMESPACE
             pair.second.h1 = result.second.atoms[1];
             pair.second.h2 = result.second.atoms[2];
 
-            links2.push_back( std::make_pair( pair.first, pair.second.h2 ) );
-            links3.push_back( std::make_pair( pair.first, pair.second.h1 ) );
+            links2.push_back( std::make_pair( pair.first, pair.second.h2 ), *m_topology_arena );
+            links3.push_back( std::make_pair( pair.first, pair.second.h1 ), *m_topology_arena );
 
             result.second.links[1] = pair.first;
+            index_link( pair.first, pair.second );
           }
 
         // search for the link 3 -- 1
-        for( auto& link : links3 )
+        if( m_topology_index )
           {
-            if( link.second == result.second.atoms[0] )
+            auto existing = m_topology_index->links.find( make_link_key(
+                result.second.atoms[2].index, result.second.atoms[0].index ) );
+            if( existing )
+              result.second.links[2] = *existing;
+          }
+        else
+          {
+            for( auto& link : links3 )
               {
-                result.second.links[2] = link.first;
-                break;
+                if( link.second == result.second.atoms[0] )
+                  {
+                    result.second.links[2] = link.first;
+                    break;
+                  }
               }
           }
         // create the link 0 -- 1 if it does not exist
@@ -1175,36 +2137,39 @@ BEGIN_MP_NAMESPACE
             pair.second.h1 = result.second.atoms[2];
             pair.second.h2 = result.second.atoms[0];
 
-            links3.push_back( std::make_pair( pair.first, pair.second.h2 ) );
-            links1.push_back( std::make_pair( pair.first, pair.second.h1 ) );
+            links3.push_back( std::make_pair( pair.first, pair.second.h2 ), *m_topology_arena );
+            links1.push_back( std::make_pair( pair.first, pair.second.h1 ), *m_topology_arena );
 
             result.second.links[2] = pair.first;
+            index_link( pair.first, pair.second );
           }
       }
 
+    index_face( result.first, result.second );
+
     // set the atom face elements
       {
-        m_impl->m_atom_properties[atom_faces_property_index]->get<
+        m_impl->m_atom_properties[atom_faces_property_index]->template get<
             atom_faces_property >( idx1 ).push_back(
-            atom_face_element( result.second, result.first, 0 ) );
-        m_impl->m_atom_properties[atom_faces_property_index]->get<
+            atom_face_element( result.second, result.first, 0 ), *m_topology_arena );
+        m_impl->m_atom_properties[atom_faces_property_index]->template get<
             atom_faces_property >( idx2 ).push_back(
-            atom_face_element( result.second, result.first, 1 ) );
-        m_impl->m_atom_properties[atom_faces_property_index]->get<
+            atom_face_element( result.second, result.first, 1 ), *m_topology_arena );
+        m_impl->m_atom_properties[atom_faces_property_index]->template get<
             atom_faces_property >( idx3 ).push_back(
-            atom_face_element( result.second, result.first, 2 ) );
+            atom_face_element( result.second, result.first, 2 ), *m_topology_arena );
       }
 
     // set the link face elements
-    m_impl->m_link_properties[link_faces_property_index]->get<
+    m_impl->m_link_properties[link_faces_property_index]->template get<
         link_faces_property >(
         m_impl->m_link_handles[result.second.links[0].index].link_index ).push_back(
         link_face_element( result.second, result.first, 0 ) );
-    m_impl->m_link_properties[link_faces_property_index]->get<
+    m_impl->m_link_properties[link_faces_property_index]->template get<
         link_faces_property >(
         m_impl->m_link_handles[result.second.links[1].index].link_index ).push_back(
         link_face_element( result.second, result.first, 1 ) );
-    m_impl->m_link_properties[link_faces_property_index]->get<
+    m_impl->m_link_properties[link_faces_property_index]->template get<
         link_faces_property >(
         m_impl->m_link_handles[result.second.links[2].index].link_index ).push_back(
         link_face_element( result.second, result.first, 2 ) );
@@ -1212,8 +2177,7 @@ BEGIN_MP_NAMESPACE
     return result.first;
   }
 
-  median_skeleton::face_handle
-  median_skeleton::add(
+  mps_definition(typename mps_type::face_handle)::add(
     atom_handle handle1, atom_handle handle2, atom_handle handle3 )
   {
     if( handle1.index < m_impl->m_atoms_capacity
@@ -1237,10 +2201,10 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION( skeleton_invalid_atom_handle );
   }
 
-  void
-  median_skeleton::remove(
+  mps_definition(void)::remove(
     face_handle handle )
   {
+    thaw();
     if( handle.index < m_impl->m_faces_capacity )
       {
         const auto face_entry = m_impl->m_face_handles.get() + handle.index;
@@ -1253,10 +2217,10 @@ BEGIN_MP_NAMESPACE
       }
   }
 
-  void
-  median_skeleton::remove(
+  mps_definition(void)::remove(
     face& e )
   {
+    thaw();
     auto index = get_index( e );
     auto handle_index = m_impl->m_face_index_to_handle_index[index];
     face_handle handle( handle_index,
@@ -1265,11 +2229,11 @@ BEGIN_MP_NAMESPACE
     m_impl->remove_face_by_index( index );
   }
 
-  void
-  median_skeleton::remove_face_topology_properties(
+  mps_definition(void)::remove_face_topology_properties(
     face_index idx, face_handle handle )
   {
     auto& face = m_impl->m_faces[idx];
+    unindex_face( face );
 
     remove_atom_to_face( m_impl->m_atom_handles[face.atoms[0].index].atom_index,
                          handle );
@@ -1286,43 +2250,43 @@ BEGIN_MP_NAMESPACE
                          handle );
   }
 
-  median_skeleton::face&
-  median_skeleton::get(
+  mps_definition(typename mps_type::face&)::get(
     face_handle handle ) const
   {
     return m_impl->get( handle );
   }
 
-  median_skeleton::face&
-  median_skeleton::get_face_by_index(
+  mps_definition(typename mps_type::face&)::get_face_by_index(
     face_index index ) const
   {
     return m_impl->get_face_by_index( index );
   }
 
-  median_skeleton::face_index
-  median_skeleton::get_index(
+  mps_definition(typename mps_type::face_index)::get_index(
     face_handle handle ) const
   {
     return m_impl->get_index( handle );
   }
 
-  median_skeleton::face_index
-  median_skeleton::get_index(
+  mps_definition(void)::get_indices(
+    const face_handle* handles, size_t number_of_handles, face_index* indices ) const
+  {
+    access< default_check_policy >().get_indices( handles, number_of_handles, indices );
+  }
+
+  mps_definition(typename mps_type::face_index)::get_index(
     face& e ) const
   {
     return m_impl->get_index( e );
   }
 
-  median_skeleton::face_handle
-  median_skeleton::get_handle(
+  mps_definition(typename mps_type::face_handle)::get_handle(
     face& e ) const
   {
     return m_impl->get_handle( e );
   }
 
-  bool
-  median_skeleton::is_valid(
+  mps_definition(bool)::is_valid(
     face_handle handle ) const
   {
     if( handle.index < m_impl->m_faces_capacity )
@@ -1334,7 +2298,12 @@ BEGIN_MP_NAMESPACE
     return false;
   }
 
-  bool median_skeleton::is_an_face_property_name( const std::string& name ) const noexcept
+  mps_definition(base_property_buffer&)::add_face_property( std::unique_ptr< base_property_buffer > property )
+  {
+    return *m_impl->add_face_property( std::move( property ) );
+  }
+
+  mps_definition(bool)::is_an_face_property_name( const std::string& name ) const noexcept
   {
     for( auto& property : m_impl->m_face_properties )
       if( property->m_name == name )
@@ -1342,7 +2311,7 @@ BEGIN_MP_NAMESPACE
     return false;
   }
 
-  base_property_buffer& median_skeleton::get_face_property( const std::string& name )
+  mps_definition(base_property_buffer&)::get_face_property( const std::string& name )
   {
     for( auto& property : m_impl->m_face_properties )
       if( property->m_name == name )
@@ -1350,14 +2319,21 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION(skeleton_invalid_face_property_name);
   }
 
-  base_property_buffer& median_skeleton::get_face_property( face_property_index index )
+  mps_definition(base_property_buffer&)::get_face_property( face_property_index index )
+  {
+    if( index >= m_impl->m_face_properties.size() )
+      MP_THROW_EXCEPTION(skeleton_invalid_face_property_index);
+    return *m_impl->m_face_properties[index];
+  }
+
+  mps_definition(const base_property_buffer&)::get_face_property( face_property_index index ) const
   {
     if( index >= m_impl->m_face_properties.size() )
       MP_THROW_EXCEPTION(skeleton_invalid_face_property_index);
     return *m_impl->m_face_properties[index];
   }
 
-  median_skeleton::face_property_index median_skeleton::get_face_property_index( base_property_buffer& property ) const
+  mps_definition(typename mps_type::face_property_index)::get_face_property_index( base_property_buffer& property ) const
   {
     const size_t n = m_impl->m_face_properties.size();
     for( size_t i = 0; i < n; ++ i )
@@ -1366,100 +2342,76 @@ BEGIN_MP_NAMESPACE
     MP_THROW_EXCEPTION(skeleton_invalid_face_property_pointer);
   }
 
-  void median_skeleton::remove_face_property( base_property_buffer& property )
+  mps_definition(void)::remove_face_property( base_property_buffer& property )
   {
     m_impl->remove_face_property( property );
   }
 
-  void median_skeleton::remove_face_property( face_property_index index )
+  mps_definition(void)::remove_face_property( face_property_index index )
   {
     m_impl->remove_face_property( index );
   }
 
-  void median_skeleton::remove_face_property( const std::string& name )
+  mps_definition(void)::remove_face_property( const std::string& name )
   {
     m_impl->remove_face_property( name );
   }
 
-  void
-  median_skeleton::remove_faces_indices(
-    bool* flags )
-  {
-    /* INVARIANT:
-     * - all faces with indices in [[0, left[[ are not removed
-     * - all faces with indices in [[left, right[[ need to be checked
-     * - all face properties in [[right, size[[ should be cleaned
-     *
-     * When a deleted face is detected, its references in atom and link
-     * properties are immediately removed. Indeed, such removals require
-     * to know the face handle and the face itself. If deleted faces are
-     * put in the end of the tight buffer, handles and faces need to be
-     * updated such that we could perform the removal in the end of the function.
-     *
-     * Thus, in the end (i.e. when left == right ), we have:
-     * - faces with indices in [[0,left[[ are clean and tight
-     * - face properties in [[left, size[[ should be cleaned
-     * - left is the new size of faces
-     */
+  mps_definition(void)::remove_faces_indices(
+    bool preserve_order )
+  {
+    /* References to removed faces in atom and link properties are dropped
+     * before the faces are moved, as they are found thanks to the face
+     * handles. Each atom and each link drops its own references, such that
+     * no two threads modify the same element. Then, compact_faces(...) keeps
+     * the face buffer tight. */
+    m_face_compaction.build( preserve_order );
+    const face_index nremoved = m_face_compaction.number_of_removed;
+    if( !nremoved )
+      return;
+    const uint8_t* flags = m_face_compaction.flags.data();
 
-    const face_index size = m_impl->m_faces_size;
-    face_index next_free_slot = m_impl->m_faces_next_free_handle_slot;
-    face_index left = 0, right = size;
-    while( left < right )
+    const atom_index natoms = m_impl->m_atoms_size;
+# pragma omp parallel for schedule(dynamic,256)
+    for( atom_index i = 0; i < natoms; ++i )
       {
-        if( flags[left] )
+        auto& faces = m_impl->m_atom_properties[atom_faces_property_index]->template get<
+            atom_faces_property >( i );
+        erase_if( faces,
+          [this, flags]( const atom_face_element& element )
           {
-            // update the left_entry
-            const auto left_entry_index =
-                m_impl->m_face_index_to_handle_index[left];
-            auto left_entry = m_impl->m_face_handles.get() + left_entry_index;
-            remove_face_topology_properties(
-                left, face_handle( left_entry_index, left_entry->counter ) );
-            left_entry->next_free_index = next_free_slot;
-            left_entry->status = datastructure::STATUS_FREE;
-            next_free_slot = left_entry_index;
-
-            // look for a valid face in the end of the buffer
-            --right;
-            while( left < right && flags[right] )
-              {
-                const auto entry_index =
-                    m_impl->m_face_index_to_handle_index[right];
-                auto entry = m_impl->m_face_handles.get() + entry_index;
-                remove_face_topology_properties(
-                    right, face_handle( entry_index, entry->counter ) );
-                entry->next_free_index = next_free_slot;
-                entry->status = datastructure::STATUS_FREE;
-                next_free_slot = entry_index;
-                --right;
-              }
+            return flags[m_impl->m_face_handles[element.face.index].face_index] != 0;
+          });
+      }
 
-            if( left != right )
-              {
-                // move the last face into this one to keep the buffer tight
-                m_impl->m_faces[left] = std::move( m_impl->m_faces[right] );
-                for( auto& property : m_impl->m_face_properties )
-                  property->move( right, left );
-
-                const auto right_entry_index =
-                    m_impl->m_face_index_to_handle_index[right];
-                auto right_entry = m_impl->m_face_handles.get() + right_entry_index;
-                right_entry->face_index = left;
-                m_impl->m_face_index_to_handle_index[left] = right_entry_index;
-                ++left;
-              }
-          }
-        else
-          ++left;
+    const link_index nlinks = m_impl->m_links_size;
+# pragma omp parallel for schedule(dynamic,256)
+    for( link_index i = 0; i < nlinks; ++i )
+      {
+        auto& faces = m_impl->m_link_properties[link_faces_property_index]->template get<
+            link_faces_property >( i );
+        erase_if( faces,
+          [this, flags]( const link_face_element& element )
+          {
+            return flags[m_impl->m_face_handles[element.face.index].face_index] != 0;
+          });
       }
-    delete[] flags;
 
-    // cleaning face properties in [[left, size[[
-    for( auto& property : m_impl->m_face_properties )
-      property->destroy( left, size );
+    if( m_topology_index )
+      {
+        const face_index* removed = m_face_compaction.removed.data();
+        for( face_index k = 0; k < nremoved; ++k )
+          unindex_face( m_impl->m_faces[removed[k]] );
+      }
 
-    m_impl->m_faces_size = left;
-    m_impl->m_faces_next_free_handle_slot = next_free_slot;
+    m_impl->compact_faces( m_face_compaction );
   }
 
+  template class basic_median_skeleton< default_skeleton_profile >;
+  template class basic_median_skeleton< single_precision_skeleton_profile >;
+  template class basic_median_skeleton< large_skeleton_profile >;
+
+# undef mps_template_parameters
+# undef mps_type
+# undef mps_definition
 END_MP_NAMESPACE
@@ -0,0 +1,79 @@
+# include "../median-path/property_types.h"
+
+# include <list>
+# include <mutex>
+
+BEGIN_MP_NAMESPACE
+
+  template< typename T >
+  static void
+  register_arithmetic_type( std::list< property_type >& types, const std::string& name )
+  {
+    types.push_back( make_property_type< T >( name ) );
+    types.push_back( make_property_type< std::array< T, 2 > >( name + "[2]" ) );
+    types.push_back( make_property_type< std::array< T, 3 > >( name + "[3]" ) );
+    types.push_back( make_property_type< std::array< T, 4 > >( name + "[4]" ) );
+  }
+
+  /* types are stored in a list such that pointers returned by the find
+   * functions stay valid */
+  static std::list< property_type >&
+  get_property_types()
+  {
+    static std::list< property_type > instance = []
+      {
+        std::list< property_type > types;
+        register_arithmetic_type< int8_t   >( types, "int8" );
+        register_arithmetic_type< int16_t  >( types, "int16" );
+        register_arithmetic_type< int32_t  >( types, "int32" );
+        register_arithmetic_type< int64_t  >( types, "int64" );
+        register_arithmetic_type< uint8_t  >( types, "uint8" );
+        register_arithmetic_type< uint16_t >( types, "uint16" );
+        register_arithmetic_type< uint32_t >( types, "uint32" );
+        register_arithmetic_type< uint64_t >( types, "uint64" );
+        register_arithmetic_type< float    >( types, "float32" );
+        register_arithmetic_type< double   >( types, "float64" );
+        types.push_back( make_property_type< vec2 >( "vec2" ) );
+        types.push_back( make_property_type< vec3 >( "vec3" ) );
+        types.push_back( make_property_type< vec4 >( "vec4" ) );
+        return types;
+      }();
+    return instance;
+  }
+
+  static std::mutex property_types_mutex;
+
+  void register_property_type( const property_type& type )
+  {
+    std::lock_guard< std::mutex > lock( property_types_mutex );
+    auto& types = get_property_types();
+    for( auto it = types.begin(); it != types.end(); )
+      {
+        if( it->name == type.name || it->value_type == type.value_type )
+          it = types.erase( it );
+        else
+          ++ it;
+      }
+    types.push_back( type );
+  }
+
+  const property_type* find_property_type( const std::type_info& value_type )
+  {
+    std::lock_guard< std::mutex > lock( property_types_mutex );
+    const std::type_index index( value_type );
+    for( const auto& type : get_property_types() )
+      if( type.value_type == index )
+        return &type;
+    return nullptr;
+  }
+
+  const property_type* find_property_type( const std::string& name )
+  {
+    std::lock_guard< std::mutex > lock( property_types_mutex );
+    for( const auto& type : get_property_types() )
+      if( type.name == name )
+        return &type;
+    return nullptr;
+  }
+
+END_MP_NAMESPACE
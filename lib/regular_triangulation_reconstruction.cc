@@ -53,33 +53,46 @@ BEGIN_MP_NAMESPACE
 
   typedef CGAL::Epick rt_kernel;
   typedef CGAL::Regular_triangulation_euclidean_traits_3< rt_kernel > rt_traits;
-  typedef Fixed_alpha_shape_vertex_base_with_info_3< median_skeleton::atom_index, rt_traits > rt_vertex_base;
-  typedef CGAL::Fixed_alpha_shape_cell_base_3< rt_traits > rt_cell_base;
-  typedef CGAL::Triangulation_data_structure_3< rt_vertex_base, rt_cell_base, CGAL::Parallel_tag > rt_datastructure;
-  typedef CGAL::Regular_triangulation_3< rt_traits, rt_datastructure > rt;
-  typedef CGAL::Fixed_alpha_shape_3< rt > fixed_alpha_shape;
 
+  /* weighted alpha shape whose vertices store the index of their atom, with
+   * the atom index type of a skeleton profile */
+  template< typename atom_index >
+  struct indexed_alpha_shape {
+    typedef Fixed_alpha_shape_vertex_base_with_info_3< atom_index, rt_traits > vertex_base;
+    typedef CGAL::Fixed_alpha_shape_cell_base_3< rt_traits > cell_base;
+    typedef CGAL::Triangulation_data_structure_3< vertex_base, cell_base, CGAL::Parallel_tag > datastructure;
+    typedef CGAL::Regular_triangulation_3< rt_traits, datastructure > triangulation;
+    typedef CGAL::Fixed_alpha_shape_3< triangulation > type;
+  };
 
+  template< typename skeleton_type >
   void regular_triangulation_reconstruction(
-      median_skeleton& output,
+      skeleton_type& output,
       const structurer::parameters& params )
   {
+    typedef typename skeleton_type::atom_index atom_index;
+    typedef typename indexed_alpha_shape< atom_index >::triangulation rt;
+    typedef typename indexed_alpha_shape< atom_index >::type fixed_alpha_shape;
+    typedef typename rt::Weighted_point weighted_point;
+    typedef typename rt::Bare_point bare_point;
+
     tbb::task_scheduler_init init;
     const auto natoms = output.get_number_of_atoms();
 
-    std::vector< rt::Weighted_point > wpoints( natoms );
-    std::vector< median_skeleton::atom_index > vinfos( natoms );
+    std::vector< weighted_point > wpoints( natoms );
+    std::vector< atom_index > vinfos( natoms );
+    const skeleton_type& constant_output = output;
     # pragma omp parallel for schedule(static)
-    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+    for( atom_index i = 0; i < natoms; ++ i )
       {
-        const auto& atom = output.get_atom_by_index( i );
-        wpoints[ i ] = rt::Weighted_point( rt::Bare_point( atom.x, atom.y, atom.z ), atom.w * atom.w );
+        const auto& atom = constant_output.get_atom_by_index( i );
+        wpoints[ i ] = weighted_point( bare_point( atom.x, atom.y, atom.z ), atom.w * atom.w );
         vinfos[ i ] = i;
       }
 
     graphics_origin::geometry::aabox bbox =  output.compute_centers_bounding_box();
     bbox.hsides += 1e-6;
-    rt::Lock_data_structure locking_datastructure(
+    typename rt::Lock_data_structure locking_datastructure(
         CGAL::Bbox_3(
             bbox.center.x - bbox.hsides.x, bbox.center.y - bbox.hsides.y, bbox.center.z - bbox.hsides.z,
             bbox.center.x + bbox.hsides.x, bbox.center.y + bbox.hsides.y, bbox.center.z + bbox.hsides.z ),
@@ -93,6 +106,13 @@ BEGIN_MP_NAMESPACE
     fixed_alpha_shape alpha_shape( regular_tetrahedrization, 0 );
     output.reserve_links( alpha_shape.number_of_finite_edges() );
 
+    /**
+     * Note: most of the facets and edges will be included in the skeleton. They
+     * are classified in parallel and staged by a topology builder, which inserts
+     * them all at once in the skeleton. Thus, threads never wait for each other
+     * to add an element.
+     */
+    basic_topology_builder< skeleton_type > builder( output );
     if( params.m_build_faces )
       {
         /**
@@ -104,53 +124,56 @@ BEGIN_MP_NAMESPACE
         auto nb_finite_facets = alpha_shape.number_of_finite_facets();
         output.reserve_faces( nb_finite_facets );
 
-        /**
-         * Note: we cannot really parallelize the process here. Indeed, most of the facets will be
-         * included in the skeleton and adding a face to the skeleton should be done in a critical
-         * section. Thus, in a parallel processing, we will spend most of the time waiting to
-         * enter in the critical section.
-         */
-        median_skeleton::atom_index indices[3];
-        for( auto fit = alpha_shape.facets_begin(), fitend = alpha_shape.facets_end();
-            fit != fitend; ++ fit )
+        const std::vector< typename fixed_alpha_shape::Facet > facets(
+            alpha_shape.facets_begin(), alpha_shape.facets_end() );
+        const size_t nfacets = facets.size();
+        # pragma omp parallel for schedule(static)
+        for( size_t f = 0; f < nfacets; ++ f )
           {
-            auto type = alpha_shape.classify( *fit );
+            const auto& facet = facets[ f ];
+            auto type = alpha_shape.classify( facet );
             if( type == fixed_alpha_shape::REGULAR || type == fixed_alpha_shape::SINGULAR )
               {
+                atom_index indices[3];
                 int j = 0;
                 for( int i = 0; i < 4; ++ i )
                   {
-                    if( i != fit->second )
+                    if( i != facet.second )
                       {
-                        indices[j] = fit->first->vertex( i )->info();
+                        indices[j] = facet.first->vertex( i )->info();
                         ++j;
                       }
                   }
-                output.add( indices[0], indices[1], indices[2] );
+                builder.add_face( indices[0], indices[1], indices[2] );
               }
           }
       }
     /**
      * Note: this section of code is always executed, because some times, there are
      * edges connected to any triangles. Thus, even if we build faces, those edges
-     * are not yet added to the skeleton. Also, if we make sure that we enter in
-     * the critical section (to add an edge), only for an edge that does not exist
-     * yet:
-     * - we already perform half of the work to check if the link exist
-     * - we perform 150% of the work when the does not exist
-     * With the overhead due to the parallel iteration of CGAL elements, we do not
-     * win anything.
+     * are not yet added to the skeleton. Links that already exist are filtered out
+     * by the commit of the builder.
      */
       {
-        for( auto eit = alpha_shape.edges_begin(), eitend = alpha_shape.edges_end();
-            eit != eitend; ++ eit )
+        const std::vector< typename fixed_alpha_shape::Edge > edges(
+            alpha_shape.edges_begin(), alpha_shape.edges_end() );
+        const size_t nedges = edges.size();
+        # pragma omp parallel for schedule(static)
+        for( size_t e = 0; e < nedges; ++ e )
           {
-            auto type = alpha_shape.classify( *eit );
+            const auto& edge = edges[ e ];
+            auto type = alpha_shape.classify( edge );
             if( type == fixed_alpha_shape::REGULAR || type == fixed_alpha_shape::SINGULAR )
               {
-                output.add( eit->first->vertex( eit->second )->info(), eit->first->vertex( eit->third )->info() );
+                builder.add_link( edge.first->vertex( edge.second )->info(), edge.first->vertex( edge.third )->info() );
               }
           }
       }
+    builder.commit();
   }
+
+  template void regular_triangulation_reconstruction(
+      median_skeleton& output, const structurer::parameters& params );
+  template void regular_triangulation_reconstruction(
+      large_median_skeleton& output, const structurer::parameters& params );
 END_MP_NAMESPACE
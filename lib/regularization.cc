@@ -6,8 +6,9 @@
 # include <omp.h>
 BEGIN_MP_NAMESPACE
 
+  template< typename skeleton_type >
   void scale_regularizer(
-    median_skeleton& skeleton,
+    skeleton_type& skeleton,
     real scale );
 
   regularizer::parameters::parameters()
@@ -15,19 +16,37 @@ BEGIN_MP_NAMESPACE
       m_scale_factor{ 1.1 }
   {}
 
-  regularizer::regularizer(
-      median_skeleton& skeleton,
-      const parameters& params )
-    : m_execution_time{ omp_get_wtime() }
+  template< typename skeleton_type >
+  static void
+  regularize(
+      skeleton_type& skeleton,
+      const regularizer::parameters& params )
   {
     switch( params.m_regularization_method )
     {
-      case parameters::SCALE_TRANSFORM:
+      case regularizer::parameters::SCALE_TRANSFORM:
         scale_regularizer( skeleton, params.m_scale_factor );
         break;
       default:
         LOG( error, "only scale transform regularization is available for the moment");
     }
+  }
+
+  regularizer::regularizer(
+      median_skeleton& skeleton,
+      const parameters& params )
+    : m_execution_time{ omp_get_wtime() }
+  {
+    regularize( skeleton, params );
+    m_execution_time = omp_get_wtime() - m_execution_time;
+  }
+
+  regularizer::regularizer(
+      large_median_skeleton& skeleton,
+      const parameters& params )
+    : m_execution_time{ omp_get_wtime() }
+  {
+    regularize( skeleton, params );
     m_execution_time = omp_get_wtime() - m_execution_time;
   }
 
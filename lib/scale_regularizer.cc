@@ -14,32 +14,45 @@ BEGIN_MP_NAMESPACE
 
   typedef CGAL::Epick rt_kernel;
   typedef CGAL::Regular_triangulation_euclidean_traits_3< rt_kernel > rt_traits;
-  typedef CGAL::Triangulation_vertex_base_with_info_3< median_skeleton::atom_index, rt_traits > rt_vertex_base;
-  typedef CGAL::Triangulation_cell_base_3< rt_traits > rt_cell_base;
-  typedef CGAL::Triangulation_data_structure_3< rt_vertex_base, rt_cell_base, CGAL::Parallel_tag > rt_datastructure;
-  typedef CGAL::Regular_triangulation_3< rt_traits, rt_datastructure > rt;
 
+  /* regular triangulation whose vertices store the index of their atom, with
+   * the atom index type of a skeleton profile */
+  template< typename atom_index >
+  struct indexed_regular_triangulation {
+    typedef CGAL::Triangulation_vertex_base_with_info_3< atom_index, rt_traits > vertex_base;
+    typedef CGAL::Triangulation_cell_base_3< rt_traits > cell_base;
+    typedef CGAL::Triangulation_data_structure_3< vertex_base, cell_base, CGAL::Parallel_tag > datastructure;
+    typedef CGAL::Regular_triangulation_3< rt_traits, datastructure > type;
+  };
+
+  template< typename skeleton_type >
   void scale_regularizer(
-      median_skeleton& skeleton,
+      skeleton_type& skeleton,
       real scale )
   {
+    typedef typename skeleton_type::atom_index atom_index;
+    typedef typename indexed_regular_triangulation< atom_index >::type rt;
+    typedef typename rt::Weighted_point weighted_point;
+    typedef typename rt::Bare_point bare_point;
+
     tbb::task_scheduler_init init;
     const auto natoms = skeleton.get_number_of_atoms();
 
-    std::vector< rt::Weighted_point > wpoints( natoms );
-    std::vector< median_skeleton::atom_index > vinfos( natoms );
+    std::vector< weighted_point > wpoints( natoms );
+    std::vector< atom_index > vinfos( natoms );
     scale *= scale;
+    const skeleton_type& constant_skeleton = skeleton;
     # pragma omp parallel for schedule(static)
-    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+    for( atom_index i = 0; i < natoms; ++ i )
       {
-        const auto& atom = skeleton.get_atom_by_index( i );
-        wpoints[ i ] = rt::Weighted_point( rt::Bare_point( atom.x, atom.y, atom.z ), scale * atom.w * atom.w );
+        const auto& atom = constant_skeleton.get_atom_by_index( i );
+        wpoints[ i ] = weighted_point( bare_point( atom.x, atom.y, atom.z ), scale * atom.w * atom.w );
         vinfos[ i ] = i;
       }
 
     graphics_origin::geometry::aabox bbox = skeleton.compute_centers_bounding_box();
     bbox.hsides += 1e-6;
-    rt::Lock_data_structure locking_datastructure(
+    typename rt::Lock_data_structure locking_datastructure(
         CGAL::Bbox_3(
             bbox.center.x - bbox.hsides.x, bbox.center.y - bbox.hsides.y, bbox.center.z - bbox.hsides.z,
             bbox.center.x + bbox.hsides.x, bbox.center.y + bbox.hsides.y, bbox.center.z + bbox.hsides.z ),
@@ -57,10 +70,13 @@ BEGIN_MP_NAMESPACE
         delete_flags[ it->info() ] = false;
       }
 
-    skeleton.remove_atoms( [&skeleton, &delete_flags]( median_skeleton::atom& e )
+    skeleton.remove_atoms( [&skeleton, &delete_flags]( typename skeleton_type::atom& e )
      {
         return delete_flags[ skeleton.get_index( e ) ];
      }, true );
   }
 
+  template void scale_regularizer( median_skeleton& skeleton, real scale );
+  template void scale_regularizer( large_median_skeleton& skeleton, real scale );
+
 END_MP_NAMESPACE
@@ -26,10 +26,11 @@ BEGIN_MP_NAMESPACE
     return result;
   }
 
+  template< typename skeleton_type >
   void delaunay_reconstruction(
-      median_skeleton& skeleton,
+      skeleton_type& skeleton,
       graphics_origin::geometry::mesh_spatial_optimization& msp,
-      std::vector< std::vector< uint32_t > >& vertex_to_atoms,
+      std::vector< std::vector< typename skeleton_type::atom_index > >& vertex_to_atoms,
       const structurer::parameters& params );
 
   static inline real
@@ -40,11 +41,13 @@ BEGIN_MP_NAMESPACE
         / (  real(2) * std::abs( diff[0] * normal[0] + diff[1] * normal[1] + diff[2] * normal[2] ));
   }
 
+  template< typename skeleton_type >
   void shrinking_ball_skeletonizer(
      graphics_origin::geometry::mesh_spatial_optimization& input,
-     median_skeleton& output,
+     skeleton_type& output,
      const skeletonizer::parameters& params )
   {
+    typedef typename skeleton_type::atom_index atom_index;
     input.build_kdtree();
     if( params.m_shrinking_ball.m_radius_method == skeletonizer::shrinking_balls_parameters::RAYTRACING )
       input.build_bvh();
@@ -56,13 +59,21 @@ BEGIN_MP_NAMESPACE
         real(2.0) * params.m_shrinking_ball.m_constant_radius_ratio *
         std::min( bbox.hsides.x, std::min( bbox.hsides.y, bbox.hsides.z ) );
 
-    std::vector< std::vector< uint32_t > > vertex_to_atoms;
+    std::vector< std::vector< atom_index > > vertex_to_atoms;
     bool keep_vertex_to_atoms = params.m_build_topology
         && (params.m_structurer_parameters.m_topology_method == structurer::parameters::DELAUNAY_RECONSTRUCTION);
 
+    // the two closest samples of each atom, to build vertex_to_atoms after the
+    // atoms are inserted concurrently
+    std::vector< std::array< uint32_t, 2 > > atom_to_vertices;
     if( keep_vertex_to_atoms )
-      vertex_to_atoms.resize( nsamples );
+      {
+        vertex_to_atoms.resize( nsamples );
+        atom_to_vertices.resize( nsamples );
+      }
 
+    // at most one atom per sample: threads insert atoms without locking
+    output.begin_concurrent_add( nsamples );
     # pragma omp parallel
     {
       graphics_origin::geometry::mesh_spatial_optimization::vertex_index indices[2];
@@ -120,25 +131,33 @@ BEGIN_MP_NAMESPACE
 
           if( std::isfinite( center.x ) && std::isfinite( center.y ) && std::isfinite( center.z ) && std::isfinite( radius ) )
             {
-              # pragma omp critical
-              {
-                if( keep_vertex_to_atoms )
-                  {
-                    auto id = output.get_number_of_atoms();
-                    vertex_to_atoms[ indices[0] ].push_back( id );
-                    vertex_to_atoms[ indices[1] ].push_back( id );
-                  }
-                output.add( median_skeleton::atom( center, radius ) );
-              }
+              auto handle = output.concurrent_add( typename skeleton_type::atom( center, radius ) );
+              if( keep_vertex_to_atoms )
+                atom_to_vertices[ output.get_index( handle ) ] = {{ uint32_t( indices[0] ), uint32_t( indices[1] ) }};
             }
         }
     }
+    output.end_concurrent_add();
 
     if( keep_vertex_to_atoms )
       {
+        const auto natoms = output.get_number_of_atoms();
+        for( atom_index id = 0; id < natoms; ++ id )
+          {
+            vertex_to_atoms[ atom_to_vertices[ id ][ 0 ] ].push_back( id );
+            vertex_to_atoms[ atom_to_vertices[ id ][ 1 ] ].push_back( id );
+          }
+        std::vector< std::array< uint32_t, 2 > >{}.swap( atom_to_vertices );
         delaunay_reconstruction( output, input, vertex_to_atoms, params.m_structurer_parameters );
       }
   }
 
+  template void shrinking_ball_skeletonizer(
+      graphics_origin::geometry::mesh_spatial_optimization& input,
+      median_skeleton& output, const skeletonizer::parameters& params );
+  template void shrinking_ball_skeletonizer(
+      graphics_origin::geometry::mesh_spatial_optimization& input,
+      large_median_skeleton& output, const skeletonizer::parameters& params );
+
 
 END_MP_NAMESPACE
@@ -6,23 +6,27 @@
 # include <omp.h>
 BEGIN_MP_NAMESPACE
 
+  template< typename skeleton_type >
   void shrinking_ball_skeletonizer(
       graphics_origin::geometry::mesh_spatial_optimization& input,
-      median_skeleton& output,
+      skeleton_type& output,
       const skeletonizer::parameters& params );
 
+  template< typename skeleton_type >
   void voronoi_ball_skeletonizer(
     graphics_origin::geometry::mesh_spatial_optimization& input,
-    median_skeleton& output,
+    skeleton_type& output,
     const skeletonizer::parameters& params );
 
+  template< typename skeleton_type >
   void polar_ball_skeletonizer(
     graphics_origin::geometry::mesh_spatial_optimization& input,
-    median_skeleton& output,
+    skeleton_type& output,
     const skeletonizer::parameters& params );
 
+  template< typename skeleton_type >
   void regular_triangulation_reconstruction(
-      median_skeleton& output,
+      skeleton_type& output,
       const structurer::parameters& params );
 
   skeletonizer::voronoi_and_polar_balls_parameters::voronoi_and_polar_balls_parameters() :
@@ -39,12 +43,14 @@ BEGIN_MP_NAMESPACE
       m_build_topology{ true }, m_structurer_parameters{}
   {}
 
-  skeletonizer::skeletonizer(
+  template< typename skeleton_type >
+  static void
+  skeletonize(
       graphics_origin::geometry::mesh& input,
-      median_skeleton& output,
-      const parameters& params )
-    : m_execution_time{ omp_get_wtime() }
+      skeleton_type& output,
+      const skeletonizer::parameters& params )
   {
+    typedef skeletonizer::parameters parameters;
     graphics_origin::geometry::mesh_spatial_optimization mso( input, false, false );
     switch( params.m_geometry_method )
     {
@@ -80,6 +86,25 @@ BEGIN_MP_NAMESPACE
             LOG( error, "cannot have a Voronoi reconstruction if the geometry method is not voronoi balls");
           }
     }
+  }
+
+  skeletonizer::skeletonizer(
+      graphics_origin::geometry::mesh& input,
+      median_skeleton& output,
+      const parameters& params )
+    : m_execution_time{ omp_get_wtime() }
+  {
+    skeletonize( input, output, params );
+    m_execution_time = omp_get_wtime() - m_execution_time;
+  }
+
+  skeletonizer::skeletonizer(
+      graphics_origin::geometry::mesh& input,
+      large_median_skeleton& output,
+      const parameters& params )
+    : m_execution_time{ omp_get_wtime() }
+  {
+    skeletonize( input, output, params );
     m_execution_time = omp_get_wtime() - m_execution_time;
   }
 
@@ -0,0 +1,92 @@
+# include "../median-path/detail/small_vector.h"
+
+BEGIN_MP_NAMESPACE
+
+  constexpr size_t small_vector_arena::min_block_size;
+  constexpr size_t small_vector_arena::max_block_size;
+  constexpr size_t small_vector_arena::slab_size;
+  constexpr size_t small_vector_arena::number_of_size_classes;
+
+  small_vector_arena::small_vector_arena()
+    : m_slab_position{ nullptr }, m_slab_remaining{ 0 }
+  {
+    m_free_lists.fill( nullptr );
+  }
+
+  small_vector_arena::~small_vector_arena()
+  {
+    for( auto slab : m_slabs )
+      ::operator delete( slab );
+  }
+
+  size_t
+  small_vector_arena::size_class( size_t bytes ) noexcept
+  {
+    size_t c = 0;
+    while( ( min_block_size << c ) < bytes )
+      ++ c;
+    return c;
+  }
+
+  size_t
+  small_vector_arena::block_size( size_t bytes ) noexcept
+  {
+    if( bytes > max_block_size )
+      return bytes;
+    return min_block_size << size_class( bytes );
+  }
+
+  void*
+  small_vector_arena::allocate( size_t bytes )
+  {
+    if( bytes > max_block_size )
+      return ::operator new( bytes );
+
+    const size_t c = size_class( bytes );
+    const size_t size = min_block_size << c;
+    std::lock_guard< std::mutex > lock( m_mutex );
+    if( m_free_lists[ c ] )
+      {
+        free_block* block = m_free_lists[ c ];
+        m_free_lists[ c ] = block->next;
+        return block;
+      }
+
+    if( m_slab_remaining < size )
+      {
+        // the end of the current slab is too small: it is left unused
+        m_slabs.reserve( m_slabs.size() + 1 );
+        m_slab_position = static_cast< unsigned char* >( ::operator new( slab_size ) );
+        m_slabs.push_back( m_slab_position );
+        m_slab_remaining = slab_size;
+      }
+    void* result = m_slab_position;
+    m_slab_position += size;
+    m_slab_remaining -= size;
+    return result;
+  }
+
+  void
+  small_vector_arena::deallocate( void* block, size_t bytes ) noexcept
+  {
+    if( bytes > max_block_size )
+      {
+        ::operator delete( block );
+        return;
+      }
+
+    const size_t c = size_class( bytes );
+    std::lock_guard< std::mutex > lock( m_mutex );
+    free_block* b = static_cast< free_block* >( block );
+    b->next = m_free_lists[ c ];
+    m_free_lists[ c ] = b;
+  }
+
+  size_t
+  small_vector_arena::get_reserved_bytes() const noexcept
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_slabs.size() * slab_size;
+  }
+
+END_MP_NAMESPACE
@@ -8,8 +8,9 @@
 # include <omp.h>
 BEGIN_MP_NAMESPACE
 
+template< typename skeleton_type >
 void regular_triangulation_reconstruction(
-    median_skeleton& output,
+    skeleton_type& output,
     const structurer::parameters& params );
 
 structurer::parameters::parameters()
@@ -18,22 +19,40 @@ structurer::parameters::parameters()
     m_neighbors_should_intersect{ true }
 {}
 
-structurer::structurer(
-    median_skeleton& skeleton,
-    const parameters& params )
-  : m_execution_time{ omp_get_wtime() }
+template< typename skeleton_type >
+static void
+structure(
+    skeleton_type& skeleton,
+    const structurer::parameters& params )
 {
   switch( params.m_topology_method )
   {
-    case parameters::WEIGHTED_ALPHA_SHAPE:
+    case structurer::parameters::WEIGHTED_ALPHA_SHAPE:
       regular_triangulation_reconstruction( skeleton, params );
       break;
-    case parameters::DELAUNAY_RECONSTRUCTION:
+    case structurer::parameters::DELAUNAY_RECONSTRUCTION:
       LOG( debug, "delaunay reconstruction not available yet");
       break;
     default:
       LOG( error, "only weighted alpha shape and delaunay reconstruction are available apart from a skeletonization.");
   }
+}
+
+structurer::structurer(
+    median_skeleton& skeleton,
+    const parameters& params )
+  : m_execution_time{ omp_get_wtime() }
+{
+  structure( skeleton, params );
+  m_execution_time = omp_get_wtime() - m_execution_time;
+}
+
+structurer::structurer(
+    large_median_skeleton& skeleton,
+    const parameters& params )
+  : m_execution_time{ omp_get_wtime() }
+{
+  structure( skeleton, params );
   m_execution_time = omp_get_wtime() - m_execution_time;
 }
 
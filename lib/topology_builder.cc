@@ -0,0 +1,82 @@
+# include "../median-path/topology_builder.h"
+
+# include <omp.h>
+
+BEGIN_MP_NAMESPACE
+
+  template< typename skeleton_type >
+  basic_topology_builder< skeleton_type >::basic_topology_builder( skeleton_type& skeleton )
+    : m_skeleton{ skeleton }, m_staging( omp_get_max_threads() )
+  {}
+
+  template< typename skeleton_type >
+  typename basic_topology_builder< skeleton_type >::staging&
+  basic_topology_builder< skeleton_type >::get_staging()
+  {
+    return m_staging[ omp_get_thread_num() ];
+  }
+
+  template< typename skeleton_type >
+  void
+  basic_topology_builder< skeleton_type >::add_link( atom_index idx1, atom_index idx2 )
+  {
+    get_staging().links.push_back( std::make_pair( idx1, idx2 ) );
+  }
+
+  template< typename skeleton_type >
+  void
+  basic_topology_builder< skeleton_type >::add_face( atom_index idx1, atom_index idx2, atom_index idx3 )
+  {
+    get_staging().faces.push_back( {{ idx1, idx2, idx3 }} );
+  }
+
+  template< typename element >
+  static std::vector< element >
+  merge( std::vector< std::vector< element > const* > const& buffers )
+  {
+    const size_t nbuffers = buffers.size();
+    std::vector< size_t > offsets( nbuffers + 1, 0 );
+    for( size_t i = 0; i < nbuffers; ++ i )
+      offsets[ i + 1 ] = offsets[ i ] + buffers[ i ]->size();
+
+    std::vector< element > result( offsets.back() );
+    # pragma omp parallel for schedule(dynamic)
+    for( size_t i = 0; i < nbuffers; ++ i )
+      std::copy( buffers[ i ]->begin(), buffers[ i ]->end(), result.begin() + offsets[ i ] );
+    return result;
+  }
+
+  template< typename skeleton_type >
+  std::pair< typename basic_topology_builder< skeleton_type >::face_index,
+             typename basic_topology_builder< skeleton_type >::link_index >
+  basic_topology_builder< skeleton_type >::commit()
+  {
+    std::pair< face_index, link_index > result{ 0, 0 };
+    const auto initial_number_of_links = m_skeleton.get_number_of_links();
+      {
+        std::vector< std::vector< std::array< atom_index, 3 > > const* > buffers;
+        for( auto& s : m_staging )
+          buffers.push_back( &s.faces );
+        auto faces = merge( buffers );
+        for( auto& s : m_staging )
+          decltype( s.faces )().swap( s.faces );
+        result.first = m_skeleton.add_faces( faces );
+      }
+      {
+        std::vector< std::vector< std::pair< atom_index, atom_index > > const* > buffers;
+        for( auto& s : m_staging )
+          buffers.push_back( &s.links );
+        auto links = merge( buffers );
+        for( auto& s : m_staging )
+          decltype( s.links )().swap( s.links );
+        m_skeleton.add_links( links );
+      }
+    // faces also create links
+    result.second = m_skeleton.get_number_of_links() - initial_number_of_links;
+    return result;
+  }
+
+  template class basic_topology_builder< median_skeleton >;
+  template class basic_topology_builder< large_median_skeleton >;
+
+END_MP_NAMESPACE
@@ -0,0 +1,309 @@
+# include "../median-path/topology_classifier.h"
+
+# include <omp.h>
+
+BEGIN_MP_NAMESPACE
+
+  template< typename skeleton_type >
+  constexpr size_t basic_topology_classifier< skeleton_type >::number_of_classes;
+
+  template< typename classifier >
+  static typename classifier::topology_class
+  get_class_of_link( uint32_t number_of_faces )
+  {
+    switch( number_of_faces )
+      {
+      case 0:  return classifier::isolated_element;
+      case 1:  return classifier::border_element;
+      case 2:  return classifier::regular_element;
+      default: return classifier::junction_element;
+      }
+  }
+
+  /* the class of an atom or a face is the most singular class of its links */
+  template< typename classifier >
+  static typename classifier::topology_class
+  merge_classes( typename classifier::topology_class current,
+    typename classifier::topology_class link_class )
+  {
+    if( current == classifier::junction_element || link_class == classifier::junction_element )
+      return classifier::junction_element;
+    if( current == classifier::border_element || link_class == classifier::border_element )
+      return classifier::border_element;
+    return current;
+  }
+
+  template< typename classifier, typename skeleton_type >
+  static typename classifier::topology_class
+  get_class_of_atom(
+    const skeleton_type& skeleton, typename skeleton_type::atom_index index,
+    const std::vector< typename classifier::topology_class >& link_classes )
+  {
+    const auto access = skeleton.unchecked();
+    const auto links = skeleton.get_atom_links( index );
+    if( links.empty() )
+      return classifier::isolated_element;
+    auto result = classifier::regular_element;
+    for( const auto& l : links )
+      result = merge_classes< classifier >( result, link_classes[ access.get_index( l.first ) ] );
+    return result;
+  }
+
+  template< typename classifier >
+  static typename classifier::topology_class
+  get_class_of_face(
+    const std::array< typename classifier::link_index, 3 >& links,
+    const std::vector< typename classifier::topology_class >& link_classes )
+  {
+    auto result = classifier::regular_element;
+    for( auto l : links )
+      result = merge_classes< classifier >( result, link_classes[ l ] );
+    return result;
+  }
+
+  /* elements are split into one block per thread. The elements of each class
+   * are counted per block, prefix sums of those counts give the position of
+   * each block in the lists, then each block is scattered in parallel */
+  template< typename topology_class, typename index, size_t nclasses >
+  static void
+  build_class_lists(
+    const std::vector< topology_class >& classes,
+    std::array< std::vector< index >, nclasses >& lists )
+  {
+    const size_t size = classes.size();
+    const size_t nblocks = std::min( size_t( omp_get_max_threads() ), size / 4096 + 1 );
+    std::vector< std::array< size_t, nclasses > > offsets( nblocks + 1 );
+    offsets[ 0 ].fill( 0 );
+
+    # pragma omp parallel for
+    for( size_t b = 0; b < nblocks; ++ b )
+      {
+        std::array< size_t, nclasses > counts;
+        counts.fill( 0 );
+        const size_t end = size * ( b + 1 ) / nblocks;
+        for( size_t i = size * b / nblocks; i < end; ++ i )
+          ++ counts[ classes[ i ] ];
+        offsets[ b + 1 ] = counts;
+      }
+
+    for( size_t b = 0; b < nblocks; ++ b )
+      for( size_t c = 0; c < nclasses; ++ c )
+        offsets[ b + 1 ][ c ] += offsets[ b ][ c ];
+    for( size_t c = 0; c < nclasses; ++ c )
+      lists[ c ].resize( offsets[ nblocks ][ c ] );
+
+    # pragma omp parallel for
+    for( size_t b = 0; b < nblocks; ++ b )
+      {
+        std::array< size_t, nclasses > positions = offsets[ b ];
+        const size_t end = size * ( b + 1 ) / nblocks;
+        for( size_t i = size * b / nblocks; i < end; ++ i )
+          lists[ classes[ i ] ][ positions[ classes[ i ] ]++ ] = index( i );
+      }
+  }
+
+  template< typename skeleton_type >
+  basic_topology_classifier< skeleton_type >::basic_topology_classifier()
+    : m_journal{ nullptr }, m_journal_epoch{ 0 }
+  {}
+
+  template< typename skeleton_type >
+  void
+  basic_topology_classifier< skeleton_type >::count(
+    const skeleton_type& skeleton,
+    std::vector< uint32_t >& atom_link_counts,
+    std::vector< uint32_t >& link_face_counts,
+    std::vector< std::array< atom_index, 2 > >& link_atoms,
+    std::vector< std::array< link_index, 3 > >& face_links ) const
+  {
+    const auto access = skeleton.unchecked();
+    const atom_index natoms = skeleton.get_number_of_atoms();
+    const link_index nlinks = skeleton.get_number_of_links();
+    const face_index nfaces = skeleton.get_number_of_faces();
+    atom_link_counts.resize( natoms );
+    link_face_counts.resize( nlinks );
+    link_atoms.resize( nlinks );
+    face_links.resize( nfaces );
+
+    # pragma omp parallel for
+    for( atom_index i = 0; i < natoms; ++ i )
+      atom_link_counts[ i ] = uint32_t( std::min< link_index >(
+        skeleton.get_number_of_links( i ), UINT32_MAX ) );
+
+    # pragma omp parallel for
+    for( link_index i = 0; i < nlinks; ++ i )
+      {
+        const auto& l = access.get_link_by_index( i );
+        link_face_counts[ i ] = uint32_t( std::min< face_index >(
+          skeleton.get_number_of_faces( i ), UINT32_MAX ) );
+        link_atoms[ i ] = {{ access.get_index( l.h1 ), access.get_index( l.h2 ) }};
+      }
+
+    # pragma omp parallel for
+    for( face_index i = 0; i < nfaces; ++ i )
+      {
+        const auto& f = access.get_face_by_index( i );
+        access.get_indices( f.links, 3, face_links[ i ].data() );
+      }
+  }
+
+  template< typename skeleton_type >
+  void
+  basic_topology_classifier< skeleton_type >::build_lists()
+  {
+    build_class_lists( m_atom_classes, m_atom_lists );
+    build_class_lists( m_link_classes, m_link_lists );
+    build_class_lists( m_face_classes, m_face_lists );
+  }
+
+  template< typename skeleton_type >
+  void
+  basic_topology_classifier< skeleton_type >::classify( const skeleton_type& skeleton )
+  {
+    m_journal = skeleton.get_change_journal();
+    m_journal_epoch = m_journal ? m_journal->get_epoch() : 0;
+    count( skeleton, m_atom_link_counts, m_link_face_counts, m_link_atoms, m_face_links );
+    const atom_index natoms = m_atom_link_counts.size();
+    const link_index nlinks = m_link_face_counts.size();
+    const face_index nfaces = m_face_links.size();
+    m_atom_classes.resize( natoms );
+    m_link_classes.resize( nlinks );
+    m_face_classes.resize( nfaces );
+
+    # pragma omp parallel for
+    for( link_index i = 0; i < nlinks; ++ i )
+      m_link_classes[ i ] = get_class_of_link< basic_topology_classifier >( m_link_face_counts[ i ] );
+
+    # pragma omp parallel for schedule(dynamic,256)
+    for( atom_index i = 0; i < natoms; ++ i )
+      m_atom_classes[ i ] = get_class_of_atom< basic_topology_classifier >( skeleton, i, m_link_classes );
+
+    # pragma omp parallel for
+    for( face_index i = 0; i < nfaces; ++ i )
+      m_face_classes[ i ] = get_class_of_face< basic_topology_classifier >( m_face_links[ i ], m_link_classes );
+
+    build_lists();
+  }
+
+  template< typename skeleton_type >
+  size_t
+  basic_topology_classifier< skeleton_type >::update( const skeleton_type& skeleton )
+  {
+    const atom_index natoms = skeleton.get_number_of_atoms();
+    const link_index nlinks = skeleton.get_number_of_links();
+    const face_index nfaces = skeleton.get_number_of_faces();
+    if( natoms != m_atom_classes.size() || nlinks != m_link_classes.size()
+        || nfaces != m_face_classes.size() )
+      {
+        classify( skeleton );
+        return size_t( natoms ) + nlinks + nfaces;
+      }
+    const change_journal* journal = skeleton.get_change_journal();
+    if( journal && journal == m_journal && journal->get_epoch() == m_journal_epoch )
+      return 0;
+    m_journal = journal;
+    m_journal_epoch = journal ? journal->get_epoch() : 0;
+
+    auto& atom_link_counts = m_next_atom_link_counts;
+    auto& link_face_counts = m_next_link_face_counts;
+    auto& link_atoms = m_next_link_atoms;
+    auto& face_links = m_next_face_links;
+    count( skeleton, atom_link_counts, link_face_counts, link_atoms, face_links );
+
+    size_t changes = 0;
+
+    /* a link is reclassified when its number of faces or its atoms changed.
+     * Its current and former atoms are then reclassified, as are atoms whose
+     * number of links changed: an atom which lost a link and gained another
+     * one has a new link, whose index had other atoms before */
+    auto& link_changed = m_link_changed;
+    link_changed.resize( nlinks );
+    # pragma omp parallel for reduction(+:changes)
+    for( link_index i = 0; i < nlinks; ++ i )
+      {
+        link_changed[ i ] = link_face_counts[ i ] != m_link_face_counts[ i ]
+                         || link_atoms[ i ] != m_link_atoms[ i ];
+        if( link_changed[ i ] )
+          {
+            const auto c = get_class_of_link< basic_topology_classifier >( link_face_counts[ i ] );
+            changes += c != m_link_classes[ i ];
+            m_link_classes[ i ] = c;
+          }
+      }
+
+    auto& atom_dirty = m_atom_dirty;
+    atom_dirty.resize( natoms );
+    # pragma omp parallel for
+    for( atom_index i = 0; i < natoms; ++ i )
+      atom_dirty[ i ] = atom_link_counts[ i ] != m_atom_link_counts[ i ];
+    for( link_index i = 0; i < nlinks; ++ i )
+      if( link_changed[ i ] )
+        {
+          atom_dirty[ link_atoms[ i ][ 0 ] ] = 1;
+          atom_dirty[ link_atoms[ i ][ 1 ] ] = 1;
+          atom_dirty[ m_link_atoms[ i ][ 0 ] ] = 1;
+          atom_dirty[ m_link_atoms[ i ][ 1 ] ] = 1;
+        }
+
+    # pragma omp parallel for schedule(dynamic,256) reduction(+:changes)
+    for( atom_index i = 0; i < natoms; ++ i )
+      if( atom_dirty[ i ] )
+        {
+          const auto c = get_class_of_atom< basic_topology_classifier >( skeleton, i, m_link_classes );
+          changes += c != m_atom_classes[ i ];
+          m_atom_classes[ i ] = c;
+        }
+
+    # pragma omp parallel for reduction(+:changes)
+    for( face_index i = 0; i < nfaces; ++ i )
+      {
+        const auto& links = face_links[ i ];
+        if( links != m_face_links[ i ]
+            || link_changed[ links[ 0 ] ] || link_changed[ links[ 1 ] ] || link_changed[ links[ 2 ] ] )
+          {
+            const auto c = get_class_of_face< basic_topology_classifier >( links, m_link_classes );
+            changes += c != m_face_classes[ i ];
+            m_face_classes[ i ] = c;
+          }
+      }
+
+    m_atom_link_counts.swap( atom_link_counts );
+    m_link_face_counts.swap( link_face_counts );
+    m_link_atoms.swap( link_atoms );
+    m_face_links.swap( face_links );
+    if( changes )
+      build_lists();
+    return changes;
+  }
+
+  template< typename skeleton_type >
+  void
+  basic_topology_classifier< skeleton_type >::clear() noexcept
+  {
+    m_atom_classes = std::vector< topology_class >();
+    m_link_classes = std::vector< topology_class >();
+    m_face_classes = std::vector< topology_class >();
+    for( size_t c = 0; c < number_of_classes; ++ c )
+      {
+        m_atom_lists[ c ] = std::vector< atom_index >();
+        m_link_lists[ c ] = std::vector< link_index >();
+        m_face_lists[ c ] = std::vector< face_index >();
+      }
+    m_atom_link_counts = std::vector< uint32_t >();
+    m_link_face_counts = std::vector< uint32_t >();
+    m_link_atoms = std::vector< std::array< atom_index, 2 > >();
+    m_face_links = std::vector< std::array< link_index, 3 > >();
+    m_next_atom_link_counts = std::vector< uint32_t >();
+    m_next_link_face_counts = std::vector< uint32_t >();
+    m_next_link_atoms = std::vector< std::array< atom_index, 2 > >();
+    m_next_face_links = std::vector< std::array< link_index, 3 > >();
+    m_link_changed = std::vector< uint8_t >();
+    m_atom_dirty = std::vector< uint8_t >();
+    m_journal = nullptr;
+    m_journal_epoch = 0;
+  }
+
+  template class basic_topology_classifier< median_skeleton >;
+  template class basic_topology_classifier< large_median_skeleton >;
+
+END_MP_NAMESPACE
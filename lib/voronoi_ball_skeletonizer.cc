@@ -16,11 +16,12 @@
 
 BEGIN_MP_NAMESPACE
 
+  template< typename skeleton_type >
   void
   delaunay_reconstruction(
-    median_skeleton& skeleton,
+    skeleton_type& skeleton,
     graphics_origin::geometry::mesh_spatial_optimization& msp,
-    std::vector< std::vector< uint32_t > >& vertex_to_atoms,
+    std::vector< std::vector< typename skeleton_type::atom_index > >& vertex_to_atoms,
     const structurer::parameters& params );
 
   // index of the mesh vertex corresponding to a DT vertex
@@ -66,7 +67,9 @@ BEGIN_MP_NAMESPACE
       return *this;
     }
     median_skeleton::atom ball;
-    median_skeleton::atom_index idx;
+    // wide enough for the atom indices of all skeleton profiles, since the
+    // balls are computed before the skeleton receives them
+    large_median_skeleton::atom_index idx;
     uint8_t status;
   };
 
@@ -214,12 +217,14 @@ BEGIN_MP_NAMESPACE
   typedef CGAL::Triangulation_data_structure_3< rt_vertex_base, rt_cell_base, CGAL::Parallel_tag > rt_datastructure;
   typedef CGAL::Regular_triangulation_3< rt_traits, rt_datastructure > rt;
 
+  template< typename skeleton_type >
   void
   powershape_structuration(
-    median_skeleton& skeleton,
+    skeleton_type& skeleton,
     dt* delaunay_tetrahedrisation,
     const structurer::parameters& params )
   {
+    typedef typename skeleton_type::atom_index atom_index;
     // Initialize a TBB scheduler for the DT construction.
     // It will automatically set the maximum number of threads to use.
     tbb::task_scheduler_init init;
@@ -267,6 +272,8 @@ BEGIN_MP_NAMESPACE
     delete[] vinfos;
 
     auto nb_finite_facets = regular_tetrahedrization.number_of_finite_facets( );
+    basic_topology_builder< skeleton_type > builder( skeleton );
+    const skeleton_type& constant_skeleton = skeleton;
     // estimation of the number of links: 3 times the estimate of the number of faces
     skeleton.reserve_links( nb_finite_facets * 1.5 );
     if( params.m_build_faces )
@@ -275,7 +282,7 @@ BEGIN_MP_NAMESPACE
         skeleton.reserve_faces( nb_finite_facets >> 1 );
         # pragma omp parallel
         {
-          median_skeleton::atom_index indices[3];
+          atom_index indices[3];
           # pragma omp single
           for( auto fit = regular_tetrahedrization.finite_facets_begin( ),
               fitend = regular_tetrahedrization.finite_facets_end( );
@@ -291,7 +298,7 @@ BEGIN_MP_NAMESPACE
                         auto& info = fit->first->vertex( i )->info( );
                         if( info->status == voronoi_ball::ATOM )
                           {
-                            indices[j] = info->idx;
+                            indices[j] = atom_index( info->idx );
                             ++j;
                           }
                       }
@@ -300,12 +307,11 @@ BEGIN_MP_NAMESPACE
                 if( j == 3 )
                   {
                     if( !params.m_neighbors_should_intersect
-                      || (skeleton.get_atom_by_index( indices[0] ).intersect( skeleton.get_atom_by_index( indices[1] ) )
-                       && skeleton.get_atom_by_index( indices[0] ).intersect( skeleton.get_atom_by_index( indices[2] ) )
-                       && skeleton.get_atom_by_index( indices[1] ).intersect( skeleton.get_atom_by_index( indices[2] ) )) )
+                      || (constant_skeleton.get_atom_by_index( indices[0] ).intersect( constant_skeleton.get_atom_by_index( indices[1] ) )
+                       && constant_skeleton.get_atom_by_index( indices[0] ).intersect( constant_skeleton.get_atom_by_index( indices[2] ) )
+                       && constant_skeleton.get_atom_by_index( indices[1] ).intersect( constant_skeleton.get_atom_by_index( indices[2] ) )) )
                       {
-                        # pragma omp critical
-                        skeleton.add( indices[0], indices[1], indices[2] );
+                        builder.add_face( indices[0], indices[1], indices[2] );
                       }
                   }
               }
@@ -325,21 +331,23 @@ BEGIN_MP_NAMESPACE
           if(    (i1->status == voronoi_ball::ATOM)
               && (i2->status == voronoi_ball::ATOM)
               && (!params.m_neighbors_should_intersect
-                  || skeleton.get_atom_by_index( i1->idx ).intersect(skeleton.get_atom_by_index( i2->idx ) )) )
+                  || constant_skeleton.get_atom_by_index( i1->idx ).intersect(constant_skeleton.get_atom_by_index( i2->idx ) )) )
             {
-              #pragma omp critical
-              skeleton.add( i1->idx, i2->idx );
+              builder.add_link( atom_index( i1->idx ), atom_index( i2->idx ) );
             }
         }
       }
+    builder.commit();
   }
 
+  template< typename skeleton_type >
   void
   voronoi_structuration(
-    median_skeleton& skeleton,
+    skeleton_type& skeleton,
     dt* delaunay_tetrahedrization,
     const structurer::parameters& params )
   {
+    typedef typename skeleton_type::atom_index atom_index;
     skeleton.reserve_links( delaunay_tetrahedrization->number_of_finite_facets( ) );
 
     if( params.m_build_faces )
@@ -382,8 +390,8 @@ BEGIN_MP_NAMESPACE
                             && vballs[i].ball.intersect(
                               vballs[i - 1].ball ) )
                           {
-                            skeleton.add( vballs[0].idx, vballs[i - 1].idx,
-                              vballs[i].idx );
+                            skeleton.add( atom_index( vballs[0].idx ), atom_index( vballs[i - 1].idx ),
+                              atom_index( vballs[i].idx ) );
                           }
                       }
                   }
@@ -392,8 +400,8 @@ BEGIN_MP_NAMESPACE
 
                     for( size_t i = 2; i < nelements; ++i )
                       {
-                        skeleton.add( vballs[0].idx, vballs[i - 1].idx,
-                          vballs[i].idx );
+                        skeleton.add( atom_index( vballs[0].idx ), atom_index( vballs[i - 1].idx ),
+                          atom_index( vballs[i].idx ) );
                       }
                   }
               }
@@ -412,16 +420,18 @@ BEGIN_MP_NAMESPACE
              && (pi2.status == voronoi_ball::ATOM)
              && (!params.m_neighbors_should_intersect
                 || pi1.ball.intersect( pi2.ball )) )
-              skeleton.add( pi1.idx, pi2.idx );
+              skeleton.add( atom_index( pi1.idx ), atom_index( pi2.idx ) );
           }
       }
   }
 
+  template< typename skeleton_type >
   void
   voronoi_ball_skeletonizer(
     graphics_origin::geometry::mesh_spatial_optimization& input,
-    median_skeleton& output, const skeletonizer::parameters& params )
+    skeleton_type& output, const skeletonizer::parameters& params )
   {
+    typedef typename skeleton_type::atom_index atom_index;
     bool keep_outside = params.m_build_topology && params.m_structurer_parameters.m_topology_method == structurer::parameters::POWERSHAPE;
 
     dt* delaunay_tetrahedrisation = build_and_classify_voronoi_balls(
@@ -430,7 +440,7 @@ BEGIN_MP_NAMESPACE
       keep_outside );
 
     // add atoms to the skeleton, mark balls for structuration, compute the radius of balls necessary for structurations
-    median_skeleton::atom_index atom_index = 0;
+    atom_index next_atom_index = 0;
     for( auto cit = delaunay_tetrahedrisation->finite_cells_begin(), citend = delaunay_tetrahedrisation->finite_cells_end();
         cit != citend; ++ cit )
       {
@@ -442,8 +452,8 @@ BEGIN_MP_NAMESPACE
                 info.ball.w = std::sqrt( info.ball.w );
                 output.add( info.ball );
                 info.status |= voronoi_ball::KEPT;
-                info.idx = atom_index;
-                ++atom_index;
+                info.idx = next_atom_index;
+                ++next_atom_index;
               }
             else if( keep_outside )
               {
@@ -465,7 +475,7 @@ BEGIN_MP_NAMESPACE
           }
         else if( params.m_structurer_parameters.m_topology_method == structurer::parameters::DELAUNAY_RECONSTRUCTION )
           {
-            std::vector< std::vector< median_skeleton::atom_index > > vertex_to_atoms(
+            std::vector< std::vector< atom_index > > vertex_to_atoms(
               input.kdtree_get_point_count( ) );
             for( auto cit = delaunay_tetrahedrisation->finite_cells_begin( ),
                 end = delaunay_tetrahedrisation->finite_cells_end( );
@@ -474,10 +484,11 @@ BEGIN_MP_NAMESPACE
                 auto& info = cit->info( );
                 if( info.status == voronoi_ball::ATOM )
                   {
-                    vertex_to_atoms[cit->vertex( 0 )->info( )].push_back( info.idx );
-                    vertex_to_atoms[cit->vertex( 1 )->info( )].push_back( info.idx );
-                    vertex_to_atoms[cit->vertex( 2 )->info( )].push_back( info.idx );
-                    vertex_to_atoms[cit->vertex( 3 )->info( )].push_back( info.idx );
+                    const atom_index index = atom_index( info.idx );
+                    vertex_to_atoms[cit->vertex( 0 )->info( )].push_back( index );
+                    vertex_to_atoms[cit->vertex( 1 )->info( )].push_back( index );
+                    vertex_to_atoms[cit->vertex( 2 )->info( )].push_back( index );
+                    vertex_to_atoms[cit->vertex( 3 )->info( )].push_back( index );
                   }
               }
 
@@ -487,11 +498,13 @@ BEGIN_MP_NAMESPACE
     delete delaunay_tetrahedrisation;
   }
 
+  template< typename skeleton_type >
   void
   polar_ball_skeletonizer(
     graphics_origin::geometry::mesh_spatial_optimization& input,
-    median_skeleton& output, const skeletonizer::parameters& params )
+    skeleton_type& output, const skeletonizer::parameters& params )
   {
+    typedef typename skeleton_type::atom_index atom_index;
     dt* delaunay_tetrahedrisation = build_and_classify_voronoi_balls( input, params.m_voronoi_ball, true );
 
     // Identify poles and mark balls for structuration.
@@ -540,7 +553,7 @@ BEGIN_MP_NAMESPACE
     }
 
     // Add atoms to skeleton.
-    median_skeleton::atom_index atom_index = 0;
+    atom_index next_atom_index = 0;
     for( auto cit = delaunay_tetrahedrisation->finite_cells_begin(), citend = delaunay_tetrahedrisation->finite_cells_end();
         cit != citend; ++ cit )
       {
@@ -550,8 +563,8 @@ BEGIN_MP_NAMESPACE
             if( info.status & voronoi_ball::INSIDE_SHAPE )
               {
                 output.add( vec3{info.ball}, std::sqrt( info.ball.w ) );
-                info.idx = atom_index;
-                ++atom_index;
+                info.idx = next_atom_index;
+                ++next_atom_index;
               }
           }
       }
@@ -566,7 +579,7 @@ BEGIN_MP_NAMESPACE
           }
         else if( params.m_structurer_parameters.m_topology_method == structurer::parameters::DELAUNAY_RECONSTRUCTION )
           {
-            std::vector< std::vector< median_skeleton::atom_index > > vertex_to_atoms(
+            std::vector< std::vector< atom_index > > vertex_to_atoms(
               input.kdtree_get_point_count( ) );
             for( auto cit = delaunay_tetrahedrisation->finite_cells_begin( ),
                 end = delaunay_tetrahedrisation->finite_cells_end( );
@@ -575,10 +588,11 @@ BEGIN_MP_NAMESPACE
                 auto& info = cit->info( );
                 if( info.status == voronoi_ball::ATOM )
                   {
-                    vertex_to_atoms[cit->vertex( 0 )->info( )].push_back( info.idx );
-                    vertex_to_atoms[cit->vertex( 1 )->info( )].push_back( info.idx );
-                    vertex_to_atoms[cit->vertex( 2 )->info( )].push_back( info.idx );
-                    vertex_to_atoms[cit->vertex( 3 )->info( )].push_back( info.idx );
+                    const atom_index index = atom_index( info.idx );
+                    vertex_to_atoms[cit->vertex( 0 )->info( )].push_back( index );
+                    vertex_to_atoms[cit->vertex( 1 )->info( )].push_back( index );
+                    vertex_to_atoms[cit->vertex( 2 )->info( )].push_back( index );
+                    vertex_to_atoms[cit->vertex( 3 )->info( )].push_back( index );
                   }
               }
 
@@ -588,4 +602,17 @@ BEGIN_MP_NAMESPACE
     delete delaunay_tetrahedrisation;
   }
 
+  template void voronoi_ball_skeletonizer(
+    graphics_origin::geometry::mesh_spatial_optimization& input,
+    median_skeleton& output, const skeletonizer::parameters& params );
+  template void voronoi_ball_skeletonizer(
+    graphics_origin::geometry::mesh_spatial_optimization& input,
+    large_median_skeleton& output, const skeletonizer::parameters& params );
+  template void polar_ball_skeletonizer(
+    graphics_origin::geometry::mesh_spatial_optimization& input,
+    median_skeleton& output, const skeletonizer::parameters& params );
+  template void polar_ball_skeletonizer(
+    graphics_origin::geometry::mesh_spatial_optimization& input,
+    large_median_skeleton& output, const skeletonizer::parameters& params );
+
 END_MP_NAMESPACE
@@ -45,34 +45,49 @@ namespace median_path {
 
   typedef CGAL::Epick rt_kernel;
   typedef CGAL::Regular_triangulation_euclidean_traits_3< rt_kernel > rt_traits;
-  typedef Fixed_alpha_shape_vertex_base_with_info_3< median_skeleton::atom_index, rt_traits > rt_vertex_base;
-  typedef CGAL::Fixed_alpha_shape_cell_base_3< rt_traits > rt_cell_base;
-  typedef CGAL::Triangulation_data_structure_3< rt_vertex_base, rt_cell_base, CGAL::Parallel_tag > rt_datastructure;
-  typedef CGAL::Regular_triangulation_3< rt_traits, rt_datastructure > rt;
-  typedef CGAL::Fixed_alpha_shape_3< rt > fixed_alpha_shape;
+
+  /* weighted alpha shape whose vertices store the index of their atom, with
+   * the atom index type of a skeleton profile */
+  template< typename atom_index >
+  struct indexed_alpha_shape {
+    typedef Fixed_alpha_shape_vertex_base_with_info_3< atom_index, rt_traits > vertex_base;
+    typedef CGAL::Fixed_alpha_shape_cell_base_3< rt_traits > cell_base;
+    typedef CGAL::Triangulation_data_structure_3< vertex_base, cell_base, CGAL::Parallel_tag > datastructure;
+    typedef CGAL::Regular_triangulation_3< rt_traits, datastructure > triangulation;
+    typedef CGAL::Fixed_alpha_shape_3< triangulation > type;
+  };
 
   namespace structurer2 {
 
-    weighted_zero_shape::weighted_zero_shape( parameters_type const& parameters, median_skeleton& result )
+    template< typename skeleton_type >
+    static void
+    build_weighted_zero_shape( weighted_zero_shape::parameters_type const& parameters, skeleton_type& result )
     {
+      typedef typename skeleton_type::atom_index atom_index;
+      typedef typename indexed_alpha_shape< atom_index >::triangulation rt;
+      typedef typename indexed_alpha_shape< atom_index >::type fixed_alpha_shape;
+      typedef typename rt::Weighted_point weighted_point;
+      typedef typename rt::Bare_point bare_point;
+
       tbb::task_scheduler_init init;
 
       // compute and store input of the regular tetrahedrization (RT)
       const auto natoms = result.get_number_of_atoms();
-      std::vector< rt::Weighted_point > wpoints( natoms );
-      std::vector< median_skeleton::atom_index > vinfos( natoms );
+      std::vector< weighted_point > wpoints( natoms );
+      std::vector< atom_index > vinfos( natoms );
+      const skeleton_type& constant_result = result;
       # pragma omp parallel for schedule(static)
-      for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      for( atom_index i = 0; i < natoms; ++ i )
         {
-          const auto& atom = result.get_atom_by_index( i );
-          wpoints[ i ] = rt::Weighted_point( rt::Bare_point( atom.x, atom.y, atom.z ), atom.w * atom.w );
+          const auto& atom = constant_result.get_atom_by_index( i );
+          wpoints[ i ] = weighted_point( bare_point( atom.x, atom.y, atom.z ), atom.w * atom.w );
           vinfos[ i ] = i;
         }
 
       // compute RT
       auto bbox = result.compute_centers_bounding_box();
       bbox.hsides += 1e-6;
-      rt::Lock_data_structure locking_datastructure(
+      typename rt::Lock_data_structure locking_datastructure(
           CGAL::Bbox_3(
               bbox.center.x - bbox.hsides.x, bbox.center.y - bbox.hsides.y, bbox.center.z - bbox.hsides.z,
               bbox.center.x + bbox.hsides.x, bbox.center.y + bbox.hsides.y, bbox.center.z + bbox.hsides.z ),
@@ -83,8 +98,8 @@ namespace median_path {
           &locking_datastructure);
 
       // explicitly release RT's input, because it is not needed anymore
-      std::vector< rt::Weighted_point >{}.swap( wpoints );
-      std::vector< median_skeleton::atom_index >{}.swap( vinfos );
+      std::vector< weighted_point >{}.swap( wpoints );
+      std::vector< atom_index >{}.swap( vinfos );
 
       // compute the weighted zero shape (W0S)
       fixed_alpha_shape alpha_shape( regular_tetrahedrization, 0 );
@@ -93,6 +108,7 @@ namespace median_path {
       // from the number of finite edges. The final number of edges will be smaller or
       // equal to that estimation.
       result.reserve_links( alpha_shape.number_of_finite_edges() );
+      basic_topology_builder< skeleton_type > builder( result );
 
       if( parameters.build_faces )
         {
@@ -101,50 +117,62 @@ namespace median_path {
           // of faces will be smaller or equal to that estimation.
           result.reserve_faces( alpha_shape.number_of_finite_facets() );
 
-          // Most of the finite facets will be included in the skeleton. Thus,
-          // if we process facets in parallel, threads will (almost) always
-          // request to enter in a critical section to do their job. This is why
-          // this step is not done in parallel (note: the VMV2016 benchmark
-          // confirmed that this step should be done sequentially).
-          median_skeleton::atom_index indices[3];
-          for( auto fit = alpha_shape.facets_begin(), fitend = alpha_shape.facets_end();
-              fit != fitend; ++ fit )
+          // Most of the finite facets will be included in the skeleton. They
+          // are classified in parallel and staged by a topology builder, which
+          // inserts them at once and also creates the links of the faces.
+          const std::vector< typename fixed_alpha_shape::Facet > facets(
+              alpha_shape.facets_begin(), alpha_shape.facets_end() );
+          const size_t nfacets = facets.size();
+          # pragma omp parallel for schedule(static)
+          for( size_t f = 0; f < nfacets; ++ f )
             {
-              auto type = alpha_shape.classify( *fit );
+              const auto& facet = facets[ f ];
+              auto type = alpha_shape.classify( facet );
               if( type == fixed_alpha_shape::REGULAR || type == fixed_alpha_shape::SINGULAR )
                 {
+                  atom_index indices[3];
                   int j = 0;
                   for( int i = 0; i < 4; ++ i )
                     {
-                      if( i != fit->second )
+                      if( i != facet.second )
                         {
-                          indices[j] = fit->first->vertex( i )->info();
+                          indices[j] = facet.first->vertex( i )->info();
                           ++j;
                         }
                     }
-                  result.add( indices[0], indices[1], indices[2] );
+                  builder.add_face( indices[0], indices[1], indices[2] );
                 }
             }
         }
 
       // Even if we build faces, some edges are not already in the skeleton
       // since they are not part of any triangle. Thus, this step should be
-      // executed in any case. If we want to do this step in parallel, most
-      // of the work will be to check if a link already exist in the skeleton.
-      // This verification is already done in the add( atom_index, atom_index )
-      // method to avoid duplicate links. Thus, in parallel we will need to
-      // perform this verification two times: one time to decide whether to
-      // enter in a critical section and one time in the add() method. Thus,
-      // a sequential processing is a better idea here.
-      for( auto eit = alpha_shape.edges_begin(), eitend = alpha_shape.edges_end();
-          eit != eitend; ++ eit )
+      // executed in any case. Links already in the skeleton are filtered out
+      // by the commit of the builder.
+      const std::vector< typename fixed_alpha_shape::Edge > edges(
+          alpha_shape.edges_begin(), alpha_shape.edges_end() );
+      const size_t nedges = edges.size();
+      # pragma omp parallel for schedule(static)
+      for( size_t e = 0; e < nedges; ++ e )
         {
-          auto type = alpha_shape.classify( *eit );
+          const auto& edge = edges[ e ];
+          auto type = alpha_shape.classify( edge );
           if( type == fixed_alpha_shape::REGULAR || type == fixed_alpha_shape::SINGULAR )
             {
-              result.add( eit->first->vertex( eit->second )->info(), eit->first->vertex( eit->third )->info() );
+              builder.add_link( edge.first->vertex( edge.second )->info(), edge.first->vertex( edge.third )->info() );
             }
         }
+      builder.commit();
+    }
+
+    weighted_zero_shape::weighted_zero_shape( parameters_type const& parameters, median_skeleton& result )
+    {
+      build_weighted_zero_shape( parameters, result );
+    }
+
+    weighted_zero_shape::weighted_zero_shape( parameters_type const& parameters, large_median_skeleton& result )
+    {
+      build_weighted_zero_shape( parameters, result );
     }
   }
 }
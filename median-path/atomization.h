@@ -72,7 +72,8 @@ namespace median_path {
       };
       struct atom_to_sampling_type {};
 
-      no_atomization( const parameters_type& parameters, const skeletonizable_shape& shape, median_skeleton& result )
+      template< typename skeleton_type >
+      no_atomization( const parameters_type& parameters, const skeletonizable_shape& shape, skeleton_type& result )
         : atom_to_sampling_property_index{0}
       {
         (void)parameters;
@@ -101,6 +102,11 @@ namespace median_path {
           const skeletonizable_shape& shape,
           median_skeleton& result );
 
+      shrinking_ball_vertex_constant_initial_radius(
+          const parameters_type& parameters,
+          const skeletonizable_shape& shape,
+          large_median_skeleton& result );
+
       parameters_type parameters;
       median_skeleton::atom_property_index atom_to_sampling_property_index;
     };
@@ -0,0 +1,59 @@
+# ifndef MEDIAN_PATH_ALIGNED_ALLOCATION_H_
+# define MEDIAN_PATH_ALIGNED_ALLOCATION_H_
+
+# include "../median_path.h"
+
+# include <cstdlib>
+# include <memory>
+# include <new>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Alignment used for buffers processed by vectorized loops.
+   *
+   * A cache line is 64 bytes on the targeted architectures, which is also
+   * the width of an AVX-512 register. Thus, aligning buffers on 64 bytes
+   * allows aligned loads and stores for SSE, AVX2 and AVX-512 code paths. */
+  static constexpr size_t simd_alignment = 64;
+
+  /**@brief Allocate an aligned buffer of elements.
+   *
+   * Allocate uninitialized memory to store the requested number of elements,
+   * with the first element aligned on the requested alignment. The memory
+   * must be released with aligned_free(). A std::bad_alloc is thrown if the
+   * allocation failed.
+   * @param number_of_elements Number of elements to store in the buffer.
+   * @param alignment Alignment of the buffer, must be a power of two multiple
+   * of sizeof(void*).
+   * @return A pointer to the allocated buffer. */
+  template< typename T >
+  T* aligned_allocate( size_t number_of_elements, size_t alignment = simd_alignment )
+  {
+    void* result = nullptr;
+    if( !number_of_elements )
+      return nullptr;
+    if( posix_memalign( &result, alignment, number_of_elements * sizeof( T ) ) )
+      throw std::bad_alloc();
+    return static_cast< T* >( result );
+  }
+
+  /**@brief Release a buffer obtained by aligned_allocate().
+   * @param buffer The buffer to release, could be nullptr. */
+  inline void aligned_free( void* buffer ) noexcept
+  {
+    std::free( buffer );
+  }
+
+  /**@brief Deleter to store aligned buffers into a std::unique_ptr. */
+  struct aligned_deleter {
+    void operator()( void* buffer ) const noexcept
+    {
+      aligned_free( buffer );
+    }
+  };
+
+  template< typename T >
+  using aligned_buffer = std::unique_ptr< T[], aligned_deleter >;
+
+END_MP_NAMESPACE
+# endif
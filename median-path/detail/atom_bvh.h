@@ -0,0 +1,181 @@
+# ifndef MEDIAN_PATH_ATOM_BVH_H_
+# define MEDIAN_PATH_ATOM_BVH_H_
+
+# include "../median_path.h"
+
+# include <atomic>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Bounding volume hierarchy over atoms.
+   *
+   * Queries like "which atoms contain this point", "which atom surface is the
+   * closest to this point" or "which atoms overlap this ball" need to scan
+   * all atoms without a spatial index. This hierarchy of axis aligned boxes
+   * answers them in logarithmic time on average.
+   *
+   * The hierarchy is a linear BVH: atom centers are sorted along a Morton
+   * curve, then the binary radix tree of the Morton codes gives the hierarchy
+   * (Karras, "Maximizing Parallelism in the Construction of BVHs, Octrees,
+   * and k-d Trees", HPG 2012). The codes, the internal nodes and the boxes
+   * are computed in parallel. There is one atom per leaf. Each node stores the
+   * box of its balls and their maximum radius.
+   *
+   * When atoms move without being added or removed, refit() updates the boxes
+   * bottom-up in parallel while keeping the hierarchy. This is cheaper than a
+   * new build, but the quality of the hierarchy decreases if atoms move a
+   * lot.
+   *
+   * Queries return the indices of atoms in the buffer the hierarchy was built
+   * from. They can be run concurrently. Batch queries are processed in
+   * parallel.
+   */
+  template< typename atom_type, typename index_type >
+  class basic_atom_bvh {
+  public:
+    typedef atom_type atom;
+    typedef index_type index;
+    typedef typename atom::value_type real_type;
+
+    /**@brief A node of the hierarchy.
+     *
+     * Internal nodes are stored first, then leaves. The leaf of the i-th atom
+     * in Morton order is the node (number of atoms - 1 + i). Children of an
+     * internal node are node indices, while both children of a leaf are the
+     * index of its atom. */
+    struct node {
+      real_type min[3];
+      real_type max[3];
+      real_type max_radius;
+      index left;
+      index right;
+    };
+
+    basic_atom_bvh();
+    basic_atom_bvh( const basic_atom_bvh& other ) = delete;
+    basic_atom_bvh& operator=( const basic_atom_bvh& other ) = delete;
+
+    /**@brief Swap the content of two hierarchies. */
+    void swap( basic_atom_bvh& other ) noexcept;
+
+    /**@brief Build the hierarchy over a buffer of atoms.
+     *
+     * @param atoms The atom buffer.
+     * @param size The number of atoms in that buffer. */
+    void build( const atom* atoms, index size );
+
+    /**@brief Update the boxes of the hierarchy after atoms have moved.
+     *
+     * The buffer must have the same atoms, in the same order, as the one
+     * used by the last build.
+     * @param atoms The atom buffer. */
+    void refit( const atom* atoms );
+
+    /**@brief Release all the memory used by the hierarchy. */
+    void release() noexcept;
+
+    /**@brief Mark the hierarchy as out of date: atoms were added, removed or
+     * reordered. The next synchronization builds a new hierarchy. */
+    inline void invalidate() noexcept
+    {
+      m_needs_build.store( true, std::memory_order_relaxed );
+    }
+
+    /**@brief Mark the boxes as out of date: atoms may have moved. The next
+     * synchronization refits the hierarchy. */
+    inline void invalidate_bounds() noexcept
+    {
+      m_needs_refit.store( true, std::memory_order_relaxed );
+    }
+
+    /**@brief Synchronize the hierarchy with an atom buffer.
+     *
+     * A new hierarchy is built if atoms were added or removed since the last
+     * synchronization, the boxes are refitted if atoms may have moved, and
+     * nothing is done otherwise.
+     * @param atoms The atom buffer.
+     * @param size The number of atoms in that buffer. */
+    void synchronize( const atom* atoms, index size );
+
+    /**@brief Number of atoms in the hierarchy. */
+    inline index size() const noexcept
+    {
+      return m_size;
+    }
+
+    /**@brief Get the nodes of the hierarchy, the root being the first one. */
+    inline const std::vector< node >& get_nodes() const noexcept
+    {
+      return m_nodes;
+    }
+
+    /**@name Queries
+     * @{ */
+    /**@brief Check if a point is inside at least one atom.
+     * @param p The point to test.
+     * @return True if the distance between p and the center of an atom is
+     * lower than its radius. */
+    bool contains( const vec3& p ) const;
+
+    /**@brief Check in parallel if points are inside at least one atom.
+     * @param points The points to test.
+     * @param number_of_points Number of points to test.
+     * @param result Receive 1 for points inside an atom, 0 otherwise. */
+    void contains( const vec3* points, size_t number_of_points, uint8_t* result ) const;
+
+    /**@brief Get the atoms containing a point.
+     * @param p The point to test.
+     * @param result Receive the indices of the atoms containing p. */
+    void get_atoms_containing( const vec3& p, std::vector< index >& result ) const;
+
+    /**@brief Find the atom whose surface is the closest to a point.
+     *
+     * The signed distance of p to the surface of an atom with center c and
+     * radius r is |p - c| - r, which is negative when p is inside the atom.
+     * This method finds the atom with the smallest signed distance.
+     * @param p The query point.
+     * @param distance Receive the signed distance to the closest surface.
+     * @return The index of the closest atom, or size() if there is no atom. */
+    index get_closest_surface( const vec3& p, real& distance ) const;
+
+    /**@brief Find in parallel the closest atom surfaces of points.
+     * @param points The query points.
+     * @param number_of_points Number of query points.
+     * @param indices Receive the index of the closest atom of each point.
+     * @param distances Receive the signed distance of each point to its
+     * closest atom surface. */
+    void get_closest_surfaces( const vec3* points, size_t number_of_points,
+      index* indices, real* distances ) const;
+
+    /**@brief Find the k atoms whose surfaces are the closest to a point.
+     * @param p The query point.
+     * @param k The number of atoms to find.
+     * @param result Receive the indices of the min(k, size()) closest atoms,
+     * sorted by increasing signed distance. */
+    void get_nearest_atoms( const vec3& p, size_t k, std::vector< index >& result ) const;
+
+    /**@brief Get the atoms overlapping a ball.
+     * @param center Center of the query ball.
+     * @param radius Radius of the query ball.
+     * @param result Receive the indices of the atoms intersecting the interior
+     * of the query ball. */
+    void get_overlapping_atoms( const vec3& center, real radius,
+      std::vector< index >& result ) const;
+    ///@}
+
+  private:
+    void compute_internal_nodes( const uint64_t* codes );
+    void compute_bounds( const atom* atoms );
+    real lower_bound( const node& n, const vec3& p ) const noexcept;
+
+    std::vector< node > m_nodes;
+    std::vector< index > m_parents;
+    const atom* m_atoms;
+    index m_size;
+    std::atomic< bool > m_needs_build;
+    std::atomic< bool > m_needs_refit;
+  };
+
+END_MP_NAMESPACE
+# endif
@@ -0,0 +1,99 @@
+# ifndef MEDIAN_PATH_ATOM_COLUMNS_H_
+# define MEDIAN_PATH_ATOM_COLUMNS_H_
+
+# include "aligned_allocation.h"
+
+# include <graphics-origin/geometry/ball.h>
+
+# include <atomic>
+# include <mutex>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Structure of arrays storage of atoms.
+   *
+   * Atoms are stored in a skeleton as an array of balls, i.e. xyzw reals
+   * interleaved. This is the layout expected by the renderers and by most
+   * algorithms, as they need the whole atom. However, passes that only need
+   * the radii or the centers load a full 32 bytes atom through the cache to
+   * use 8 or 24 bytes of it. This class stores the atoms in four separate
+   * arrays x, y, z and r. Those arrays are aligned on simd_alignment and
+   * their capacity is a multiple of the number of reals that fit in this
+   * alignment, such that vectorized loops can process them with aligned
+   * loads and without a scalar epilogue.
+   *
+   * The columns are a copy of the atom buffer. They are marked as dirty each
+   * time the atom buffer may have changed, and are synchronized on demand.
+   * Marking the columns as dirty is thread safe, and so is synchronize():
+   * concurrent readers of a skeleton can request the columns at the same
+   * time, only one of them copying the atoms.
+   *
+   * The columns have the precision of the atoms they copy: single precision
+   * atoms give columns of floats, which doubles the number of values
+   * processed by each vectorized instruction.
+   */
+  template< typename atom_type >
+  struct basic_atom_columns {
+    typedef atom_type atom;
+    typedef typename atom::value_type real_type;
+
+    basic_atom_columns();
+    ~basic_atom_columns();
+    basic_atom_columns( const basic_atom_columns& other ) = delete;
+    basic_atom_columns& operator=( const basic_atom_columns& other ) = delete;
+
+    /**@brief Swap the content of two columns.
+     *
+     * This is used to implement the move operations of a skeleton. */
+    void swap( basic_atom_columns& other ) noexcept;
+
+    /**@brief Copy atoms into the columns.
+     *
+     * The columns are resized if needed to hold all atoms, then filled in
+     * parallel. After the call, the columns are not dirty anymore.
+     * @param atoms The atom buffer to copy.
+     * @param size The number of atoms in that buffer. */
+    void assign( const atom* atoms, size_t size );
+
+    /**@brief Copy atoms into the columns if they are dirty.
+     *
+     * The copy is done under a lock, such that concurrent calls copy the
+     * atoms once and all return synchronized columns. Calls on clean columns
+     * only cost an atomic load.
+     * @param atoms The atom buffer to copy.
+     * @param size The number of atoms in that buffer. */
+    void synchronize( const atom* atoms, size_t size );
+
+    /**@brief Release all the memory used by the columns. */
+    void release() noexcept;
+
+    /**@brief Mark the columns as out of date. */
+    inline void invalidate() noexcept
+    {
+      m_dirty.store( true, std::memory_order_relaxed );
+    }
+
+    /**@brief Check if the columns need to be synchronized. */
+    inline bool is_dirty() const noexcept
+    {
+      return m_dirty.load( std::memory_order_acquire );
+    }
+
+    /**@brief Number of reals stored in simd_alignment bytes. */
+    static constexpr size_t padding = simd_alignment / sizeof( real_type );
+
+    aligned_buffer< real_type > x;
+    aligned_buffer< real_type > y;
+    aligned_buffer< real_type > z;
+    aligned_buffer< real_type > r;
+    size_t size;
+    size_t capacity;
+  private:
+    std::atomic< bool > m_dirty;
+    std::mutex m_synchronization;
+  };
+
+  typedef basic_atom_columns< graphics_origin::geometry::ball > atom_columns;
+
+END_MP_NAMESPACE
+# endif
@@ -23,13 +23,24 @@ namespace io {
       {
         return graphics_origin::tools::get_extension( filename ) == balls_format_extension;
       }
-      bool save( median_skeleton& skeleton, const std::string& filename ) override
+      bool save( const median_skeleton& skeleton, const std::string& filename ) override
+      {
+        return save_skeleton( skeleton, filename );
+      }
+
+      bool save( const large_median_skeleton& skeleton, const std::string& filename ) override
+      {
+        return save_skeleton( skeleton, filename );
+      }
+
+      template< typename skeleton_type >
+      bool save_skeleton( const skeleton_type& skeleton, const std::string& filename )
       {
         std::ofstream output( filename );
 
         output << skeleton.get_number_of_atoms() << "\n";
         output.precision( 10 );
-        skeleton.process_atoms( [&output]( median_skeleton::atom& atom )
+        skeleton.process_atoms( [&output]( const typename skeleton_type::atom& atom )
           {
             output << std::setw( 13 ) << atom.x << " "
                    << std::setw( 13 ) << atom.y << " "
@@ -50,79 +61,142 @@ namespace io {
       }
       bool load( median_skeleton& skeleton, const std::string& filename ) override
       {
-        std::ifstream input( filename );
+        return load_skeleton( skeleton, filename );
+      }
+
+      bool load( large_median_skeleton& skeleton, const std::string& filename ) override
+      {
+        return load_skeleton( skeleton, filename );
+      }
+
+      template< typename skeleton_type >
+      bool load_skeleton( skeleton_type& skeleton, const std::string& filename )
+      {
+        bool result = read_skeleton( skeleton, filename );
+        if( !result )
+          {
+            skeleton.clear( 0, 0, 0 );
+            LOG( error, "failed to load skeleton from BALLS file [" << filename << "]");
+          }
+        return result;
+      }
+
+      /* The file is mapped and split into chunks of lines. The values of the
+       * balls are a stream of numbers, regardless of the lines: the values of
+       * each chunk are counted in parallel, prefix sums of those counts give
+       * the index of the first value of each chunk, then the chunks are
+       * parsed in parallel. */
+      template< typename skeleton_type >
+      bool read_skeleton( skeleton_type& skeleton, const std::string& filename )
+      {
+        mapped_file file( filename );
+        if( !file.is_open() )
+          {
+            LOG( error, "cannot read BALLS file [" << filename << "]");
+            return false;
+          }
+        const char* cursor = file.data();
+        const char* end = cursor + file.size();
+        const char* line_begin = nullptr;
+        const char* line_end = nullptr;
         size_t lnumber = 0;
-        std::string file_line = "";
-        median_skeleton::atom_index natoms = 0;
+        typename skeleton_type::atom_index natoms = 0;
 
-        if( !get_next_relevant_line( input, lnumber, file_line ) )
+        if( !get_next_relevant_line( cursor, end, lnumber, line_begin, line_end ) )
           {
             LOG( error, "failed to get the number of atoms in BALLS file [" << filename << "]");
             return false;
           }
-        else
+        if( !parse_integer( line_begin, line_end, natoms ) )
           {
-            std::istringstream tokenizer( file_line );
-            tokenizer >> natoms;
-            if( tokenizer.fail() )
-              {
-                LOG( error, "failed to recognize the number of balls at line " << lnumber
-                     << " of file [" << filename << "]: \"" << file_line << "\"");
-                return false;
-              }
+            LOG( error, "failed to recognize the number of balls at line " << lnumber
+                 << " of file [" << filename << "]: \"" << std::string( line_begin, line_end ) << "\"");
+            return false;
           }
 
-        bool result = true;
-        std::vector< real > balls_data( natoms * 4, 0 );
-        size_t i = 0;
-        // fetch the relevant lines to fill the balls data
-        while( get_next_relevant_line( input, lnumber, file_line ) )
+        const auto chunks = split_text( cursor, end, lnumber );
+        const size_t nchunks = chunks.size();
+        std::vector< size_t > offsets( nchunks + 1, 0 );
+        # pragma omp parallel for
+        for( size_t c = 0; c < nchunks; ++ c )
           {
-            // stop when an error occurred or when we read enough data
-            if( !result || i == natoms * 4 ) break;
-            std::istringstream tokenizer( file_line );
-            // read this line
-            do
-              {
-                tokenizer >> balls_data[i];
-                if( tokenizer.eof() )
-                  {
-                    ++i;
+            const char* chunk_cursor = chunks[ c ].begin;
+            const char* token = nullptr;
+            const char* current_line_end = nullptr;
+            size_t line_number = chunks[ c ].line_number;
+            size_t count = 0;
+            while( get_next_relevant_line( chunk_cursor, chunks[ c ].end, line_number, token, current_line_end ) )
+              while( true )
+                {
+                  skip_blanks( token, current_line_end );
+                  if( token == current_line_end )
                     break;
-                  }
-                if( tokenizer.fail() )
-                  {
-                    LOG( error, "failed to read component " << i % 4 << " of atom #"
-                       << (i >> 2) << " at line " << lnumber << " \"" << file_line << "\"");
-                    result = false;
-                    break;
-                  }
-                ++ i;
-              }
-            while( 1 );
+                  token = get_token_end( token, current_line_end );
+                  ++count;
+                }
+            offsets[ c + 1 ] = count;
           }
+        for( size_t c = 0; c < nchunks; ++ c )
+          offsets[ c + 1 ] += offsets[ c ];
 
-        if( i != natoms * 4 )
+        const size_t nvalues = size_t( natoms ) * 4;
+        if( offsets[ nchunks ] < nvalues )
           {
             LOG( error, "failed to read enough data in the file to setup " << natoms << " balls");
-            result = false;
+            return false;
           }
 
-        if( result )
+        /* values after the last ball are ignored. On errors, the first one in
+         * the file is reported */
+        std::vector< vec4 > balls( natoms );
+        size_t error_line = std::numeric_limits< size_t >::max();
+        size_t error_value = 0;
+        std::string error_string;
+        # pragma omp parallel for schedule(dynamic)
+        for( size_t c = 0; c < nchunks; ++ c )
           {
-            skeleton.clear( natoms, 0, 0 );
-            for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+            if( offsets[ c ] >= nvalues )
+              continue;
+            const char* chunk_cursor = chunks[ c ].begin;
+            const char* current_line_begin = nullptr;
+            const char* current_line_end = nullptr;
+            size_t line_number = chunks[ c ].line_number;
+            size_t i = offsets[ c ];
+            while( i < nvalues && get_next_relevant_line( chunk_cursor, chunks[ c ].end,
+                line_number, current_line_begin, current_line_end ) )
               {
-                real* data = &balls_data[ 4 * i ];
-                skeleton.add( vec4{ data[0], data[1], data[2], data[3] });
+                const char* token = current_line_begin;
+                while( i < nvalues )
+                  {
+                    skip_blanks( token, current_line_end );
+                    if( token == current_line_end )
+                      break;
+                    if( !parse_real( token, current_line_end, balls[ i >> 2 ][ i & 3 ] ) )
+                      {
+                        # pragma omp critical
+                        if( line_number < error_line )
+                          {
+                            error_line = line_number;
+                            error_value = i;
+                            error_string.assign( current_line_begin, current_line_end );
+                          }
+                        i = nvalues;
+                        break;
+                      }
+                    ++i;
+                  }
               }
           }
-        else
+        if( error_line != std::numeric_limits< size_t >::max() )
           {
-            skeleton.clear( 0, 0, 0 );
-            LOG( error, "failed to load skeleton from BALLS file [" << filename << "]");
+            LOG( error, "failed to read component " << error_value % 4 << " of atom #"
+               << ( error_value >> 2 ) << " at line " << error_line << " \"" << error_string << "\"");
+            return false;
           }
-        return result;
+
+        skeleton.clear( natoms, 0, 0 );
+        skeleton.add_atoms( balls.data(), natoms );
+        return true;
       }
     };
 }
@@ -0,0 +1,218 @@
+# ifndef MEDIAN_PATH_CHANGE_JOURNAL_H_
+# define MEDIAN_PATH_CHANGE_JOURNAL_H_
+
+# include "../median_path.h"
+
+# include <algorithm>
+# include <atomic>
+# include <cstdint>
+# include <mutex>
+# include <utility>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief A range of indices [[begin, end[[. */
+  struct index_range {
+    size_t begin;
+    size_t end;
+  };
+
+  /**@brief Journal of the changes made to the elements of a skeleton.
+   *
+   * Renderers, caches or savers that mirror a skeleton can process only what
+   * changed since their last update instead of the whole skeleton. For each
+   * element type, the journal records ranges of indices:
+   * - added: indices that received a new element,
+   * - removed: indices of removed elements, at the time of their removal,
+   * - moved: indices that received an element moved from another index to
+   * keep the buffer tight, e.g. the last element after a removal,
+   * - modified: indices of elements that may have been modified through a
+   * non constant access, constant accesses being never recorded,
+   * - modified properties: ranges of property elements reported as modified
+   * by their writer, properties being accessed through raw references.
+   *
+   * A range refers to the indices at the time it was recorded. Consecutive
+   * records of adjacent or overlapping ranges are merged, and the ranges of
+   * a category are collapsed into their bounding range when they become too
+   * many, with one bounding range per property for modified properties:
+   * ranges may thus cover unchanged elements, but never miss changed
+   * ones. The indices whose content changed since the journal was cleared
+   * are given by get_dirty_ranges().
+   *
+   * Each record increments an epoch counter, which is never reset. Comparing
+   * the epoch with the one of the last update is a cheap test of changes.
+   * Records are thread safe, such that atoms modified by parallel writers
+   * are all recorded. Reading the ranges or clearing the journal must not
+   * be done while records are made. */
+  class change_journal {
+  public:
+    /**@brief Maximum number of ranges of a category before they are
+     * collapsed into one range. */
+    static constexpr size_t max_ranges = 1024;
+
+    /**@brief Changes of one element type. */
+    struct element_changes {
+      std::vector< index_range > added_ranges;
+      std::vector< index_range > removed_ranges;
+      std::vector< index_range > moved_ranges;
+      std::vector< index_range > modified_ranges;
+      /**Property index and range of modified property elements. */
+      std::vector< std::pair< size_t, index_range > > modified_property_ranges;
+
+      bool empty() const noexcept
+      {
+        return added_ranges.empty() && removed_ranges.empty() && moved_ranges.empty()
+            && modified_ranges.empty() && modified_property_ranges.empty();
+      }
+
+      void clear() noexcept
+      {
+        added_ranges.clear();
+        removed_ranges.clear();
+        moved_ranges.clear();
+        modified_ranges.clear();
+        modified_property_ranges.clear();
+      }
+    };
+
+    change_journal() noexcept
+      : m_epoch{ 0 }
+    {}
+
+    /**@brief Number of records since the creation of the journal. */
+    uint64_t get_epoch() const noexcept
+    {
+      return m_epoch.load( std::memory_order_relaxed );
+    }
+
+    /**@brief Check if no change was recorded since the last clear. */
+    bool empty() const noexcept
+    {
+      return atoms.empty() && links.empty() && faces.empty();
+    }
+
+    /**@brief Forget the recorded changes. The epoch is kept. */
+    void clear() noexcept
+    {
+      atoms.clear();
+      links.clear();
+      faces.clear();
+    }
+
+    /**@brief Record a range of indices in a category.
+     * @param ranges The ranges of the category.
+     * @param begin First index of the range.
+     * @param end End of the range. */
+    void record( std::vector< index_range >& ranges, size_t begin, size_t end )
+    {
+      m_epoch.fetch_add( 1, std::memory_order_relaxed );
+      if( begin >= end )
+        return;
+      std::lock_guard< std::mutex > lock( m_mutex );
+      if( !ranges.empty() && begin <= ranges.back().end && end >= ranges.back().begin )
+        {
+          ranges.back().begin = std::min( ranges.back().begin, begin );
+          ranges.back().end = std::max( ranges.back().end, end );
+          return;
+        }
+      if( ranges.size() == max_ranges )
+        {
+          index_range bounds = { begin, end };
+          for( const auto& r : ranges )
+            {
+              bounds.begin = std::min( bounds.begin, r.begin );
+              bounds.end = std::max( bounds.end, r.end );
+            }
+          ranges.assign( 1, bounds );
+          return;
+        }
+      ranges.push_back( { begin, end } );
+    }
+
+    /**@brief Record a range of modified elements of a property.
+     * @param changes The changes of the element type of the property.
+     * @param property The index of the property.
+     * @param begin First index of the range.
+     * @param end End of the range. */
+    void record_property( element_changes& changes, size_t property, size_t begin, size_t end )
+    {
+      m_epoch.fetch_add( 1, std::memory_order_relaxed );
+      if( begin >= end )
+        return;
+      std::lock_guard< std::mutex > lock( m_mutex );
+      auto& ranges = changes.modified_property_ranges;
+      if( !ranges.empty() && ranges.back().first == property
+          && begin <= ranges.back().second.end && end >= ranges.back().second.begin )
+        {
+          ranges.back().second.begin = std::min( ranges.back().second.begin, begin );
+          ranges.back().second.end = std::max( ranges.back().second.end, end );
+          return;
+        }
+      if( ranges.size() == max_ranges )
+        {
+          // one bounding range per property
+          std::vector< std::pair< size_t, index_range > > bounds( 1, { property, { begin, end } } );
+          for( const auto& r : ranges )
+            {
+              auto b = std::find_if( bounds.begin(), bounds.end(),
+                [&r]( const std::pair< size_t, index_range >& p ){ return p.first == r.first; } );
+              if( b == bounds.end() )
+                bounds.push_back( r );
+              else
+                {
+                  b->second.begin = std::min( b->second.begin, r.second.begin );
+                  b->second.end = std::max( b->second.end, r.second.end );
+                }
+            }
+          // the range just recorded stays the last one, such that the next
+          // records of this property are merged into it
+          std::rotate( bounds.begin(), bounds.begin() + 1, bounds.end() );
+          ranges.swap( bounds );
+          return;
+        }
+      ranges.push_back( { property, { begin, end } } );
+    }
+
+    /**@brief Compute the indices whose element changed since the last clear.
+     *
+     * Those are the indices of added, moved and modified elements that are
+     * still in the buffer, i.e. below its current size. Removed elements
+     * beyond the current size are not in the result: a mirror only has to
+     * be truncated to the current size.
+     * @param changes The changes of an element type.
+     * @param size The current number of elements of that type.
+     * @param result Receive the sorted and disjoint dirty ranges. */
+    static void get_dirty_ranges( const element_changes& changes, size_t size,
+      std::vector< index_range >& result )
+    {
+      result.clear();
+      for( auto ranges : { &changes.added_ranges, &changes.moved_ranges, &changes.modified_ranges } )
+        for( const auto& r : *ranges )
+          if( r.begin < size )
+            result.push_back( { r.begin, std::min( r.end, size ) } );
+      std::sort( result.begin(), result.end(),
+        []( const index_range& a, const index_range& b ){ return a.begin < b.begin; } );
+
+      size_t n = 0;
+      for( size_t i = 0; i < result.size(); ++ i )
+        {
+          if( n && result[i].begin <= result[n - 1].end )
+            result[n - 1].end = std::max( result[n - 1].end, result[i].end );
+          else
+            result[n++] = result[i];
+        }
+      result.resize( n );
+    }
+
+    element_changes atoms;
+    element_changes links;
+    element_changes faces;
+
+  private:
+    std::atomic< uint64_t > m_epoch;
+    std::mutex m_mutex;
+  };
+
+END_MP_NAMESPACE
+# endif
@@ -0,0 +1,71 @@
+# ifndef MEDIAN_PATH_CHECK_POLICIES_H_
+# define MEDIAN_PATH_CHECK_POLICIES_H_
+
+# include "../median_path.h"
+
+# ifdef MP_SKELETON_NO_CHECK
+#  define MP_SKELETON_NO_INDEX_CHECK
+#  define MP_SKELETON_NO_HANDLE_CHECK
+#  define MP_SKELETON_NO_POINTER_CHECK
+# endif
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Check policy validating every index and handle.
+   *
+   * A check policy tells which arguments of element accesses are validated.
+   * It is a template parameter of the skeleton element accessors (see
+   * basic_median_skeleton::access()), such that the same translation unit can
+   * use checked calls at API boundaries and unchecked ones in inner loops.
+   * Failed checks throw the same exceptions as the skeleton methods. */
+  struct checked_policy {
+    static constexpr bool check_indices = true;
+    static constexpr bool check_handles = true;
+  };
+
+  /**@brief Check policy validating nothing.
+   *
+   * Accesses are then a few loads, without branches. Invalid arguments lead
+   * to undefined behaviors instead of exceptions. */
+  struct unchecked_policy {
+    static constexpr bool check_indices = false;
+    static constexpr bool check_handles = false;
+  };
+
+  /**@brief Check policy of the skeleton methods.
+   *
+   * This policy follows the MP_SKELETON_NO_INDEX_CHECK and
+   * MP_SKELETON_NO_HANDLE_CHECK symbols. */
+  struct default_check_policy {
+# ifdef MP_SKELETON_NO_INDEX_CHECK
+    static constexpr bool check_indices = false;
+# else
+    static constexpr bool check_indices = true;
+# endif
+# ifdef MP_SKELETON_NO_HANDLE_CHECK
+    static constexpr bool check_handles = false;
+# else
+    static constexpr bool check_handles = true;
+# endif
+  };
+
+  /**@brief Number of elements ahead of which batch accesses prefetch the
+   * handle entries. */
+  static constexpr size_t access_prefetch_distance = 16;
+
+  /**@brief Hint the processor to fetch a memory location in the cache.
+   *
+   * This is a no-op for compilers without a prefetch builtin. An invalid
+   * address is harmless.
+   * @param address The memory location that will be read soon. */
+  inline void prefetch_for_read( const void* address ) noexcept
+  {
+# if defined( __GNUC__ ) || defined( __clang__ )
+    __builtin_prefetch( address, 0, 3 );
+# else
+    (void)address;
+# endif
+  }
+
+END_MP_NAMESPACE
+# endif
@@ -0,0 +1,105 @@
+# ifndef MEDIAN_PATH_COMPACTION_H_
+# define MEDIAN_PATH_COMPACTION_H_
+
+# include "parallel_algorithms.h"
+
+# include <cstdint>
+# include <utility>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Plan of the removal of elements from a tight buffer.
+   *
+   * Elements to remove are flagged in flags. Then, build() computes by
+   * parallel prefix sums over the flags:
+   * - the indices of the removed elements, in increasing order,
+   * - the moves that make the buffer tight again, from sources to targets.
+   *
+   * When the order of the remaining elements does not matter, the remaining
+   * elements after new_size fill the holes before new_size, the last ones
+   * first as in a sequential removal. Sources and targets are then disjoint
+   * and the moves can be done in parallel. When the order is preserved, each
+   * remaining element after the first hole is shifted down. The moves must
+   * then be done in increasing order.
+   *
+   * The buffers are kept between two removals to avoid allocations. */
+  template< typename index >
+  struct compaction_plan {
+    compaction_plan()
+      : number_of_removed{ 0 }, number_of_moves{ 0 }, new_size{ 0 },
+        preserve_order{ false }
+    {}
+
+    /**@brief Set all flags to false for a buffer of the given size. */
+    void reset( index size )
+    {
+      flags.resize( size );
+      uint8_t* f = flags.data();
+      # pragma omp parallel for
+      for( index i = 0; i < size; ++ i )
+        f[ i ] = 0;
+    }
+
+    /**@brief Compute the removed indices and the moves from the flags.
+     * @param preserve_order Keep the relative order of remaining elements. */
+    void build( bool preserve_order )
+    {
+      const index size = flags.size();
+      const uint8_t* f = flags.data();
+      this->preserve_order = preserve_order;
+      if( removed.size() < size )
+        {
+          removed.resize( size );
+          sources.resize( size );
+          targets.resize( size );
+        }
+
+      number_of_removed = parallel_select( index( 0 ), size,
+          [f]( index i ){ return f[ i ] != 0; }, removed.data() );
+      new_size = size - number_of_removed;
+      number_of_moves = 0;
+      if( !number_of_removed )
+        return;
+
+      index* t = targets.data();
+      if( preserve_order )
+        {
+          const index first = removed[ 0 ];
+          number_of_moves = parallel_select( first, size,
+              [f]( index i ){ return !f[ i ]; }, sources.data() );
+          # pragma omp parallel for
+          for( index k = 0; k < number_of_moves; ++ k )
+            t[ k ] = first + k;
+        }
+      else
+        {
+          /* the holes to fill are the removed indices before new_size: the
+           * first hole gets the last remaining element, the second hole the
+           * one before, and so on */
+          number_of_moves = parallel_select( new_size, size,
+              [f]( index i ){ return !f[ i ]; }, sources.data() );
+          const index* r = removed.data();
+          index* s = sources.data();
+          const index n = number_of_moves;
+          # pragma omp parallel for
+          for( index k = 0; k < n / 2; ++ k )
+            std::swap( s[ k ], s[ n - 1 - k ] );
+          # pragma omp parallel for
+          for( index k = 0; k < n; ++ k )
+            t[ k ] = r[ k ];
+        }
+    }
+
+    std::vector< uint8_t > flags;
+    std::vector< index > removed;
+    std::vector< index > sources;
+    std::vector< index > targets;
+    index number_of_removed;
+    index number_of_moves;
+    index new_size;
+    bool preserve_order;
+  };
+
+END_MP_NAMESPACE
+# endif
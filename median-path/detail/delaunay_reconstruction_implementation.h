@@ -11,7 +11,7 @@ namespace median_path {
 
     namespace {
 
-      template< typename atomizer_type >
+      template< typename atomizer_type, typename skeleton_type >
 # ifdef MP_USE_CONCEPTS
         requires Atomizer<atomizer_type>()
 # endif
@@ -20,8 +20,8 @@ namespace median_path {
 
         vertex_to_atoms_helper(
             atomizer_type& atomizer,
-            skeletonizable_shape& shape,
-            median_skeleton& result )
+            const skeletonizable_shape& shape,
+            skeleton_type& result )
         {
           static_assert(
               implementation_required<atomizer_type>::value,
@@ -32,32 +32,33 @@ namespace median_path {
         const_iterator end( uint32_t vertex_index ) const;
       };
 
-      template<>
-      struct vertex_to_atoms_helper<atomizer::shrinking_ball_vertex_constant_initial_radius> {
+      template< typename skeleton_type >
+      struct vertex_to_atoms_helper<atomizer::shrinking_ball_vertex_constant_initial_radius, skeleton_type> {
 
         typedef atomizer::shrinking_ball_vertex_constant_initial_radius atomizer_type;
         typedef atomizer_type::atom_to_sampling_type atom_to_sampling_type;
-        typedef std::vector<median_skeleton::atom_index>::const_iterator const_iterator;
+        typedef typename skeleton_type::atom_index atom_index;
+        typedef typename std::vector<atom_index>::const_iterator const_iterator;
 
         vertex_to_atoms_helper(
             atomizer_type& atomizer,
-            skeletonizable_shape& shape,
-            median_skeleton& result )
-          : storage( shape.n_vertices() * 2, median_skeleton::null_atom_index )
+            const skeletonizable_shape& shape,
+            skeleton_type& result )
+          : storage( shape.n_vertices() * 2, skeleton_type::null_atom_index )
         {
           const auto natoms = result.get_number_of_atoms();
           auto& sampling_property = result.get_atom_property( atomizer.atom_to_sampling_property_index );
-          for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+          for( atom_index i = 0; i < natoms; ++ i )
             {
-              auto& sampling = sampling_property.get<atom_to_sampling_type>( i );
+              auto& sampling = sampling_property.template get<atom_to_sampling_type>( i );
 
               size_t j = sampling[0] << 1;
-              if( storage[j] != median_skeleton::null_atom_index )
+              if( storage[j] != skeleton_type::null_atom_index )
                 ++j;
               storage[j] = i;
 
               j = sampling[1] << 1;
-              if( storage[j] != median_skeleton::null_atom_index )
+              if( storage[j] != skeleton_type::null_atom_index )
                 ++j;
               storage[j] = i;
             }
@@ -71,19 +72,19 @@ namespace median_path {
           return storage.begin() + ((vertex_index+1)<<1);
         }
 
-        std::vector< median_skeleton::atom_index > storage;
+        std::vector< atom_index > storage;
       };
     }
 
 
-    template< typename atomizer_type >
+    template< typename atomizer_type, typename skeleton_type >
 # ifdef MP_USE_CONCEPTS
         requires Atomizer<atomizer_type>()
 # endif
     delaunay_reconstruction::delaunay_reconstruction(
         parameters_type const& parameters,
         skeletonizable_shape const& shape,
-        atomizer_type& atomizer, median_skeleton& result )
+        atomizer_type& atomizer, skeleton_type& result )
     {
       static_assert(
           std::is_same<
@@ -91,8 +92,9 @@ namespace median_path {
             atomizer::vertex_sampling >::value,
           "delaunay reconstruction can only be applied on a vertex sampling atomizer");
 
+      typedef typename skeleton_type::atom_index atom_index;
       typedef CGAL::Epick dt_kernel;
-      typedef CGAL::Triangulation_vertex_base_with_info_2< median_skeleton::atom_index, dt_kernel > dt_vertex_base;
+      typedef CGAL::Triangulation_vertex_base_with_info_2< atom_index, dt_kernel > dt_vertex_base;
       typedef CGAL::Triangulation_face_base_2< dt_kernel > dt_face_base;
       typedef CGAL::Triangulation_data_structure_2< dt_vertex_base, dt_face_base > dt_datastructure;
       typedef CGAL::Delaunay_triangulation_2< dt_kernel, dt_datastructure > dt;
@@ -139,14 +141,16 @@ namespace median_path {
        * We will spend most, if not all, the time waiting for a critical
        * section. Thus, no parallelization here. */
 
-      vertex_to_atoms_helper<atomizer_type> helper( atomizer, shape, result );
+      vertex_to_atoms_helper<atomizer_type, skeleton_type> helper( atomizer, shape, result );
       graphics_origin::geometry::mesh_point_converter<vec3> point_converter;
       graphics_origin::geometry::mesh_normal_converter<vec3> normal_converter;
       const auto ntriangles = shape.n_faces();
+      basic_topology_builder< skeleton_type > builder( result );
+      const skeleton_type& constant_skeleton = result;
       # pragma omp parallel
       {
-        std::vector< median_skeleton::atom_index > indices;
-        median_skeleton::atom_index face[3];
+        std::vector< atom_index > indices;
+        atom_index face[3];
 
         # pragma omp for
         for( uint32_t i = 0; i < ntriangles; ++ i )
@@ -180,9 +184,9 @@ namespace median_path {
 
             for( auto begin = indices.begin(); begin != last; ++ begin )
               {
-                vec3 p = vec3{ result.get_atom_by_index( *begin ) };
+                vec3 p = vec3{ constant_skeleton.get_atom_by_index( *begin ) };
                 p -= dot( normal, p - p0 );
-                triangulation.insert( dt::Point( dot( p, e01 ), dot( p, other ) ) )->info() = *begin;
+                triangulation.insert( typename dt::Point( dot( p, e01 ), dot( p, other ) ) )->info() = *begin;
               }
             indices.resize( 0 ); // to be reused at the next iteration
 
@@ -198,9 +202,9 @@ namespace median_path {
 
                     if( parameters.neighbors_must_intersect )
                       {
-                        const auto& atom0 = result.get_atom_by_index( face[0] );
-                        const auto& atom1 = result.get_atom_by_index( face[1] );
-                        const auto& atom2 = result.get_atom_by_index( face[2] );
+                        const auto& atom0 = constant_skeleton.get_atom_by_index( face[0] );
+                        const auto& atom1 = constant_skeleton.get_atom_by_index( face[1] );
+                        const auto& atom2 = constant_skeleton.get_atom_by_index( face[2] );
 
                         if( !atom0.intersect( atom1 ) || !atom0.intersect( atom2 ) || !atom1.intersect( atom2 ) )
                           {
@@ -208,8 +212,7 @@ namespace median_path {
                           }
                       }
 
-                    # pragma omp critical
-                    result.add( face[0], face[1], face[2] );
+                    builder.add_face( face[0], face[1], face[2] );
                   }
               }
 
@@ -228,14 +231,14 @@ namespace median_path {
                   }
 
                 if( parameters.neighbors_must_intersect &&
-                    !result.get_atom_by_index( face[0] ).intersect( result.get_atom_by_index( face[1 ] ) ) )
+                    !constant_skeleton.get_atom_by_index( face[0] ).intersect( constant_skeleton.get_atom_by_index( face[1 ] ) ) )
                   continue;
 
-                # pragma omp critical
-                result.add( face[0], face[1] );
+                builder.add_link( face[0], face[1] );
               }
           } // end of parallel for
       } // end of parallel region
+      builder.commit();
     }
 
   } // end of structurer namespace
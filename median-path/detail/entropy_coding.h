@@ -0,0 +1,455 @@
+# ifndef MEDIAN_PATH_ENTROPY_CODING_H_
+# define MEDIAN_PATH_ENTROPY_CODING_H_
+
+# include "../median_path.h"
+
+# include <cstdint>
+# include <cstring>
+# include <vector>
+
+# if defined( __GNUC__ ) && defined( __x86_64__ )
+#   define MP_RANS_AVX2
+#   include <immintrin.h>
+# endif
+
+BEGIN_MP_NAMESPACE
+
+  /**************************************************************************
+   * Integer and entropy coding used by compact file formats:               *
+   *  - zigzag coding maps signed deltas to small unsigned integers,        *
+   *  - varints store unsigned integers on 7 bits per byte, the high bit    *
+   *  telling if another byte follows,                                      *
+   *  - an order 0 rANS coder compresses byte streams (J. Duda, "Asymmetric *
+   *  numeral systems", 2013). States are renormalized by 16 bits words,    *
+   *  such that a decoded symbol needs at most one read. Symbol i is coded  *
+   *  by state i % rans_states, and the states share one stream of words.   *
+   *  Decoding is driven by a table giving, for each slot of the scale, its *
+   *  symbol, frequency and offset. With AVX2, eight states are decoded per *
+   *  vector and eight vectors are in flight per iteration, which hides the *
+   *  latency of table gathers and multiplications (F. Giesen,              *
+   *  "Interleaved entropy coders", 2014).                                  *
+   **************************************************************************/
+
+  inline uint64_t zigzag_encode( int64_t value ) noexcept
+  {
+    return ( uint64_t( value ) << 1 ) ^ uint64_t( value >> 63 );
+  }
+
+  inline int64_t zigzag_decode( uint64_t value ) noexcept
+  {
+    return int64_t( value >> 1 ) ^ -int64_t( value & 1 );
+  }
+
+  inline void write_varint( std::vector< uint8_t >& output, uint64_t value )
+  {
+    while( value >= 0x80 )
+      {
+        output.push_back( uint8_t( value | 0x80 ) );
+        value >>= 7;
+      }
+    output.push_back( uint8_t( value ) );
+  }
+
+  /**@brief Maximum number of bytes of a 64 bits varint. */
+  static constexpr size_t max_varint_bytes = 10;
+
+  /**@brief Read a varint and advance the cursor.
+   * @return False if the varint is truncated or longer than 64 bits. */
+  inline bool read_varint( const uint8_t*& cursor, const uint8_t* end, uint64_t& value ) noexcept
+  {
+    value = 0;
+    for( unsigned shift = 0; shift < 64 && cursor != end; shift += 7 )
+      {
+        const uint8_t byte = *cursor++;
+        value |= uint64_t( byte & 0x7f ) << shift;
+        if( !( byte & 0x80 ) )
+          return true;
+      }
+    return false;
+  }
+
+  static constexpr uint32_t rans_scale_bits = 12;
+  static constexpr uint32_t rans_scale = uint32_t(1) << rans_scale_bits;
+  static constexpr uint32_t rans_lower_bound = uint32_t(1) << 16;
+  static constexpr uint32_t rans_states = 64;
+
+  /**@brief Frequencies of the 256 byte values, normalized to rans_scale.
+   *
+   * Every byte value present in the data has a frequency of at least one. */
+  struct rans_frequencies {
+    uint16_t frequencies[ 256 ];
+    uint16_t starts[ 256 ];
+
+    void normalize( const uint8_t* data, size_t size )
+    {
+      uint64_t counts[ 256 ] = {};
+      for( size_t i = 0; i < size; ++ i )
+        ++ counts[ data[ i ] ];
+
+      uint32_t sum = 0;
+      int most_frequent = 0;
+      for( int s = 0; s < 256; ++ s )
+        {
+          uint64_t f = counts[ s ] * rans_scale / ( size ? size : 1 );
+          if( counts[ s ] && !f )
+            f = 1;
+          frequencies[ s ] = uint16_t( f );
+          sum += uint32_t( f );
+          if( counts[ s ] > counts[ most_frequent ] )
+            most_frequent = s;
+        }
+      // symbols raised to a frequency of one are paid by the largest ones
+      while( sum > rans_scale )
+        {
+          int largest = 0;
+          for( int s = 1; s < 256; ++ s )
+            if( frequencies[ s ] > frequencies[ largest ] )
+              largest = s;
+          -- frequencies[ largest ];
+          -- sum;
+        }
+      frequencies[ most_frequent ] += uint16_t( rans_scale - sum );
+      compute_starts();
+    }
+
+    void compute_starts() noexcept
+    {
+      uint32_t start = 0;
+      for( int s = 0; s < 256; ++ s )
+        {
+          starts[ s ] = uint16_t( start );
+          start += frequencies[ s ];
+        }
+    }
+  };
+
+  inline void rans_encode_symbol( uint32_t& state, uint8_t*& cursor, uint32_t start, uint32_t frequency ) noexcept
+  {
+    // 2^20 * frequency does not fit in 32 bits when a symbol owns the scale
+    const uint64_t upper_bound = uint64_t( ( rans_lower_bound >> rans_scale_bits ) << 16 ) * frequency;
+    if( state >= upper_bound )
+      {
+        cursor -= 2;
+        cursor[ 0 ] = uint8_t( state );
+        cursor[ 1 ] = uint8_t( state >> 8 );
+        state >>= 16;
+      }
+    state = ( ( state / frequency ) << rans_scale_bits ) + ( state % frequency ) + start;
+  }
+
+  inline void rans_flush( uint32_t state, uint8_t*& cursor ) noexcept
+  {
+    cursor -= 4;
+    cursor[ 0 ] = uint8_t( state );
+    cursor[ 1 ] = uint8_t( state >> 8 );
+    cursor[ 2 ] = uint8_t( state >> 16 );
+    cursor[ 3 ] = uint8_t( state >> 24 );
+  }
+
+  inline uint32_t rans_read_state( const uint8_t* cursor ) noexcept
+  {
+    return uint32_t( cursor[ 0 ] ) | uint32_t( cursor[ 1 ] ) << 8
+         | uint32_t( cursor[ 2 ] ) << 16 | uint32_t( cursor[ 3 ] ) << 24;
+  }
+
+  /**@brief Decoding table of a rANS stream.
+   *
+   * Each slot of the scale gives its symbol (8 bits), the frequency of its
+   * symbol minus one (12 bits) and its offset from the start of its symbol
+   * (12 bits), such that a symbol is decoded by one lookup. */
+  struct rans_decoding_table {
+    uint32_t slots[ rans_scale ];
+
+    void build( const rans_frequencies& table ) noexcept
+    {
+      for( int s = 0; s < 256; ++ s )
+        for( uint32_t j = 0; j < table.frequencies[ s ]; ++ j )
+          slots[ table.starts[ s ] + j ] = uint32_t( s ) | ( table.frequencies[ s ] - 1u ) << 8 | j << 20;
+    }
+
+    uint8_t decode( uint32_t& state ) const noexcept
+    {
+      const uint32_t slot = slots[ state & ( rans_scale - 1 ) ];
+      state = ( ( ( slot >> 8 ) & 0xfff ) + 1 ) * ( state >> rans_scale_bits ) + ( slot >> 20 );
+      return uint8_t( slot );
+    }
+  };
+
+# ifdef MP_RANS_AVX2
+  inline bool rans_has_avx2() noexcept
+  {
+    static const bool result = ( __builtin_cpu_init(), __builtin_cpu_supports( "avx2" ) );
+    return result;
+  }
+
+  /* For each mask of four lanes to renormalize, the shuffle moving the next
+   * 16 bits words of the stream to those lanes, and the number of bytes
+   * read. */
+  struct rans_renormalization_table {
+    uint8_t shuffles[ 16 ][ 16 ];
+    uint8_t sizes[ 16 ];
+
+    rans_renormalization_table() noexcept
+    {
+      for( int m = 0; m < 16; ++ m )
+        {
+          uint8_t words = 0;
+          for( int lane = 0; lane < 4; ++ lane )
+            {
+              const bool read = ( m >> lane ) & 1;
+              shuffles[ m ][ 4 * lane     ] = read ? uint8_t( 2 * words     ) : 0x80;
+              shuffles[ m ][ 4 * lane + 1 ] = read ? uint8_t( 2 * words + 1 ) : 0x80;
+              shuffles[ m ][ 4 * lane + 2 ] = 0x80;
+              shuffles[ m ][ 4 * lane + 3 ] = 0x80;
+              words += read;
+            }
+          sizes[ m ] = uint8_t( 2 * words );
+        }
+    }
+  };
+
+  /* Decode the symbols [index, size[ while a whole iteration of the states
+   * can read its words, and advance index and cursor accordingly. The
+   * states are vectors of eight lanes: lanes k of vector v is the state
+   * 8 * v + k. */
+  __attribute__(( target( "avx2" ) ))
+  inline void rans_decode_avx2( const rans_decoding_table& table, uint32_t* states,
+    const uint8_t*& cursor, const uint8_t* end, uint8_t* output, size_t& index, size_t size )
+  {
+    static const rans_renormalization_table renormalization;
+    static_assert( rans_states % 32 == 0, "states are decoded by groups of four vectors" );
+    constexpr uint32_t nvectors = rans_states / 8;
+
+    const int* const slots = reinterpret_cast< const int* >( table.slots );
+    const __m256i scale_mask = _mm256_set1_epi32( rans_scale - 1 );
+    const __m256i byte_mask = _mm256_set1_epi32( 0xff );
+    const __m256i one = _mm256_set1_epi32( 1 );
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i interleave = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+
+    __m256i x[ nvectors ];
+    for( uint32_t v = 0; v < nvectors; ++ v )
+      x[ v ] = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( states + 8 * v ) );
+
+    const uint8_t* in = cursor;
+    size_t i = index;
+    // an iteration reads at most one word per state, by loads of 8 bytes
+    for( ; i + rans_states <= size && end - in >= int( 2 * rans_states ); i += rans_states )
+      {
+        __m256i symbols[ nvectors ];
+        for( uint32_t v = 0; v < nvectors; ++ v )
+          {
+            const __m256i slot = _mm256_i32gather_epi32( slots, _mm256_and_si256( x[ v ], scale_mask ), 4 );
+            const __m256i frequency = _mm256_add_epi32( _mm256_and_si256( _mm256_srli_epi32( slot, 8 ), scale_mask ), one );
+            x[ v ] = _mm256_add_epi32(
+              _mm256_mullo_epi32( frequency, _mm256_srli_epi32( x[ v ], rans_scale_bits ) ),
+              _mm256_srli_epi32( slot, 20 ) );
+            symbols[ v ] = _mm256_and_si256( slot, byte_mask );
+          }
+
+        // packs interleave the 128 bits halves, the permutation restores the order
+        for( uint32_t v = 0; v < nvectors; v += 4 )
+          {
+            const __m256i bytes = _mm256_packus_epi16(
+              _mm256_packus_epi32( symbols[ v     ], symbols[ v + 1 ] ),
+              _mm256_packus_epi32( symbols[ v + 2 ], symbols[ v + 3 ] ) );
+            _mm256_storeu_si256( reinterpret_cast< __m256i* >( output + i + 8 * v ),
+              _mm256_permutevar8x32_epi32( bytes, interleave ) );
+          }
+
+        for( uint32_t v = 0; v < nvectors; ++ v )
+          {
+            const __m256i read = _mm256_cmpeq_epi32( _mm256_srli_epi32( x[ v ], 16 ), zero );
+            const int mask = _mm256_movemask_ps( _mm256_castsi256_ps( read ) );
+            const __m128i low = _mm_shuffle_epi8(
+              _mm_loadl_epi64( reinterpret_cast< const __m128i* >( in ) ),
+              _mm_loadu_si128( reinterpret_cast< const __m128i* >( renormalization.shuffles[ mask & 15 ] ) ) );
+            in += renormalization.sizes[ mask & 15 ];
+            const __m128i high = _mm_shuffle_epi8(
+              _mm_loadl_epi64( reinterpret_cast< const __m128i* >( in ) ),
+              _mm_loadu_si128( reinterpret_cast< const __m128i* >( renormalization.shuffles[ mask >> 4 ] ) ) );
+            in += renormalization.sizes[ mask >> 4 ];
+            x[ v ] = _mm256_or_si256(
+              _mm256_blendv_epi8( x[ v ], _mm256_slli_epi32( x[ v ], 16 ), read ),
+              _mm256_inserti128_si256( _mm256_castsi128_si256( low ), high, 1 ) );
+          }
+      }
+
+    for( uint32_t v = 0; v < nvectors; ++ v )
+      _mm256_storeu_si256( reinterpret_cast< __m256i* >( states + 8 * v ), x[ v ] );
+    cursor = in;
+    index = i;
+  }
+# endif
+
+  /**@brief Compress a byte stream and append it to an output.
+   *
+   * The compressed stream is made of the number of bytes of the data (four
+   * bytes), and if the data is not empty, of a bitmap of the byte values
+   * present in the data (32 bytes), of their frequencies (two bytes each),
+   * of the number of coded bytes (four bytes) and of the coded bytes. If a
+   * single byte value is present, there is no coded byte. All integers are
+   * little endian.
+   * @param data The bytes to compress.
+   * @param size The number of bytes, below 2^32.
+   * @param output The vector receiving the compressed stream. */
+  inline void rans_compress( const uint8_t* data, size_t size, std::vector< uint8_t >& output )
+  {
+    auto write_uint = [&output]( uint32_t value, int bytes )
+      {
+        for( int b = 0; b < bytes; ++ b )
+          output.push_back( uint8_t( value >> ( 8 * b ) ) );
+      };
+    write_uint( uint32_t( size ), 4 );
+    if( !size )
+      return;
+
+    rans_frequencies table;
+    table.normalize( data, size );
+    uint8_t bitmap[ 32 ] = {};
+    for( int s = 0; s < 256; ++ s )
+      if( table.frequencies[ s ] )
+        bitmap[ s >> 3 ] |= uint8_t( 1 << ( s & 7 ) );
+    output.insert( output.end(), bitmap, bitmap + 32 );
+    for( int s = 0; s < 256; ++ s )
+      if( table.frequencies[ s ] )
+        write_uint( table.frequencies[ s ], 2 );
+
+    // a symbol that owns the scale leaves the states unchanged: nothing is coded
+    if( table.frequencies[ data[ 0 ] ] == rans_scale )
+      {
+        write_uint( 0, 4 );
+        return;
+      }
+
+    // symbols are encoded backward, such that they are decoded forward
+    std::vector< uint8_t > buffer( 2 * size + 4 * rans_states );
+    uint8_t* const end = buffer.data() + buffer.size();
+    uint8_t* cursor = end;
+    uint32_t states[ rans_states ];
+    for( auto& state : states )
+      state = rans_lower_bound;
+    for( size_t i = size; i-- > 0; )
+      {
+        const uint8_t s = data[ i ];
+        rans_encode_symbol( states[ i & ( rans_states - 1 ) ], cursor, table.starts[ s ], table.frequencies[ s ] );
+      }
+    for( uint32_t k = rans_states; k-- > 0; )
+      rans_flush( states[ k ], cursor );
+
+    write_uint( uint32_t( end - cursor ), 4 );
+    output.insert( output.end(), cursor, end );
+  }
+
+  /**@brief Decompress a stream produced by rans_compress().
+   *
+   * The number of bytes of the data is read from the stream, and a coded
+   * stream of a few bytes can describe any number of repeated bytes. This
+   * number is thus checked against a bound known by the caller before the
+   * output is allocated.
+   * @param cursor The start of the compressed stream, advanced to its end.
+   * @param end The end of the available bytes.
+   * @param max_size The maximum number of decompressed bytes expected.
+   * @param output The vector receiving the decompressed bytes.
+   * @return False if the stream is corrupted, truncated or decompresses to
+   * more than max_size bytes. */
+  inline bool rans_decompress( const uint8_t*& cursor, const uint8_t* end, size_t max_size, std::vector< uint8_t >& output )
+  {
+    auto read_uint = [&cursor, end]( uint32_t& value, int bytes )
+      {
+        if( end - cursor < bytes )
+          return false;
+        value = 0;
+        for( int b = 0; b < bytes; ++ b )
+          value |= uint32_t( *cursor++ ) << ( 8 * b );
+        return true;
+      };
+    uint32_t size = 0;
+    if( !read_uint( size, 4 ) || size > max_size )
+      return false;
+    output.resize( size );
+    if( !size )
+      return true;
+
+    if( end - cursor < 32 )
+      return false;
+    const uint8_t* bitmap = cursor;
+    cursor += 32;
+    rans_frequencies frequencies;
+    uint32_t sum = 0;
+    int last_symbol = 0;
+    for( int s = 0; s < 256; ++ s )
+      {
+        uint32_t f = 0;
+        if( ( bitmap[ s >> 3 ] >> ( s & 7 ) ) & 1 )
+          {
+            if( !read_uint( f, 2 ) || !f )
+              return false;
+            last_symbol = s;
+          }
+        frequencies.frequencies[ s ] = uint16_t( f );
+        sum += f;
+      }
+    if( sum != rans_scale )
+      return false;
+    frequencies.compute_starts();
+
+    uint32_t coded_size = 0;
+    if( !read_uint( coded_size, 4 ) )
+      return false;
+    if( frequencies.frequencies[ last_symbol ] == rans_scale )
+      {
+        std::memset( output.data(), last_symbol, size );
+        return !coded_size;
+      }
+    if( coded_size < 4 * rans_states || uint64_t( end - cursor ) < coded_size )
+      return false;
+    const uint8_t* input = cursor;
+    const uint8_t* const input_end = cursor + coded_size;
+    cursor = input_end;
+
+    uint32_t x[ rans_states ];
+    for( uint32_t k = 0; k < rans_states; ++ k, input += 4 )
+      x[ k ] = rans_read_state( input );
+
+    rans_decoding_table table;
+    table.build( frequencies );
+    uint8_t* out = output.data();
+    size_t i = 0;
+# ifdef MP_RANS_AVX2
+    if( rans_has_avx2() )
+      rans_decode_avx2( table, x, input, input_end, out, i, size );
+# endif
+
+    /* each state reads at most one word per symbol: bounds are only checked
+     * near the end of the input, and renormalizations are branchless
+     * before */
+    for( ; i + rans_states <= size && input_end - input >= int( 2 * rans_states ); i += rans_states )
+      for( uint32_t k = 0; k < rans_states; ++ k )
+        {
+          out[ i + k ] = table.decode( x[ k ] );
+          const uint32_t word = uint32_t( input[ 0 ] ) | uint32_t( input[ 1 ] ) << 8;
+          const uint32_t read = x[ k ] < rans_lower_bound;
+          x[ k ] = ( x[ k ] << ( read << 4 ) ) | ( word & ( 0u - read ) );
+          input += 2 * read;
+        }
+    for( ; i < size; ++ i )
+      {
+        uint32_t& state = x[ i & ( rans_states - 1 ) ];
+        out[ i ] = table.decode( state );
+        if( state < rans_lower_bound )
+          {
+            if( input_end - input < 2 )
+              return false;
+            state = ( state << 16 ) | uint32_t( input[ 0 ] ) | uint32_t( input[ 1 ] ) << 8;
+            input += 2;
+          }
+      }
+    for( uint32_t k = 0; k < rans_states; ++ k )
+      if( x[ k ] != rans_lower_bound )
+        return false;
+    return input == input_end;
+  }
+
+END_MP_NAMESPACE
+# endif
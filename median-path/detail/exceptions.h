@@ -186,6 +186,13 @@ BEGIN_MP_NAMESPACE
     {}
   };
 
+  struct skeleton_property_not_copyable : public std::runtime_error {
+    skeleton_property_not_copyable( const std::string& file, size_t line )
+      : std::runtime_error( "cannot copy a property whose type is not copy assignable at line "
+      + std::to_string( line ) + " of file " + file )
+    {}
+  };
+
 # define MP_THROW_EXCEPTION( name ) \
   throw name( __FILE__, __LINE__ )
 
@@ -0,0 +1,75 @@
+# ifndef MEDIAN_PATH_GROWTH_POLICY_H_
+# define MEDIAN_PATH_GROWTH_POLICY_H_
+
+# include "../median_path.h"
+
+# include <algorithm>
+# include <cstddef>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Policy to compute the new capacity of a full buffer.
+   *
+   * A geometric growth multiplies the capacity by a factor, which gives an
+   * amortized constant time insertion at the cost of up to factor times the
+   * needed memory. A capped growth is geometric, but never adds more than a
+   * maximum number of elements at once, which bounds the memory overhead of
+   * very large buffers. An exact growth gives the required capacity, which is
+   * meant for buffers whose final size is known, e.g. when loading a file.
+   *
+   * In all cases, the capacity increases at least by min_increment, unless
+   * the growth is exact. The default policy doubles the capacity, with a
+   * minimum increment of 10 elements. */
+  struct growth_policy {
+    enum kind_type { geometric, capped, exact };
+
+    growth_policy() noexcept
+      : kind{ geometric }, factor{ 2.0 }, min_increment{ 10 }, max_increment{ 0 }
+    {}
+
+    static growth_policy make_geometric( double factor = 2.0, size_t min_increment = 10 ) noexcept
+    {
+      growth_policy result;
+      result.factor = factor;
+      result.min_increment = min_increment;
+      return result;
+    }
+
+    static growth_policy make_capped( size_t max_increment, double factor = 2.0, size_t min_increment = 10 ) noexcept
+    {
+      growth_policy result = make_geometric( factor, min_increment );
+      result.kind = capped;
+      result.max_increment = max_increment;
+      return result;
+    }
+
+    static growth_policy make_exact() noexcept
+    {
+      growth_policy result;
+      result.kind = exact;
+      result.min_increment = 0;
+      return result;
+    }
+
+    /**@brief Compute the new capacity of a buffer.
+     * @param capacity The current capacity.
+     * @param required The minimum capacity needed.
+     * @return A capacity greater or equal to required. */
+    size_t next_capacity( size_t capacity, size_t required ) const noexcept
+    {
+      if( kind == exact )
+        return required;
+      size_t increment = std::max( size_t( capacity * ( factor - 1.0 ) ), min_increment );
+      if( kind == capped )
+        increment = std::max( std::min( increment, max_increment ), min_increment );
+      return std::max( required, capacity + increment );
+    }
+
+    kind_type kind;
+    double factor;
+    size_t min_increment;
+    size_t max_increment;
+  };
+
+END_MP_NAMESPACE
+# endif
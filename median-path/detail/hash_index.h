@@ -0,0 +1,182 @@
+# ifndef MEDIAN_PATH_HASH_INDEX_H_
+# define MEDIAN_PATH_HASH_INDEX_H_
+
+# include "../median_path.h"
+
+# include <algorithm>
+# include <array>
+# include <cstdint>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Open addressing hash table from a tuple of indices to a value.
+   *
+   * This table is used to find in constant time an element of a skeleton
+   * given the atoms it connects. Keys are fixed size tuples of integers, that
+   * should be canonical (e.g. sorted) since two permutations of the same key
+   * are different keys. Collisions are resolved by linear probing, and
+   * removed entries are marked as deleted until the next rehash.
+   *
+   * The load factor, including deleted entries, is kept below 70%. The
+   * capacity is always a power of two. None of the methods is thread safe,
+   * except find() that can be called concurrently with other find(). */
+  template< typename key_element, size_t n, typename value_type >
+  class hash_index {
+  public:
+    typedef std::array< key_element, n > key_type;
+
+    hash_index()
+      : m_size{ 0 }, m_deleted{ 0 }
+    {}
+
+    /**@brief Remove all entries, while keeping the memory. */
+    void clear()
+    {
+      std::fill( m_states.begin(), m_states.end(), uint8_t( EMPTY ) );
+      m_size = 0;
+      m_deleted = 0;
+    }
+
+    /**@brief Make room for a number of entries without rehashing. */
+    void reserve( size_t number_of_entries )
+    {
+      if( ( number_of_entries + m_deleted ) * 10 > m_states.size() * 7 )
+        rehash( number_of_entries );
+    }
+
+    size_t size() const noexcept
+    {
+      return m_size;
+    }
+
+    /**@brief Find the value associated to a key.
+     * @return A pointer to the value, or nullptr if the key is not found. */
+    const value_type* find( const key_type& key ) const noexcept
+    {
+      if( m_states.empty() )
+        return nullptr;
+      const size_t mask = m_states.size() - 1;
+      for( size_t i = hash( key ) & mask; ; i = ( i + 1 ) & mask )
+        {
+          if( m_states[ i ] == EMPTY )
+            return nullptr;
+          if( m_states[ i ] == FULL && m_keys[ i ] == key )
+            return &m_values[ i ];
+        }
+    }
+
+    /**@brief Insert a key and its value.
+     * @return false if the key was already present, in which case its value is
+     * not modified. */
+    bool insert( const key_type& key, const value_type& value )
+    {
+      if( ( m_size + m_deleted + 1 ) * 10 > m_states.size() * 7 )
+        rehash( 2 * ( m_size + 1 ) );
+
+      const size_t mask = m_states.size() - 1;
+      size_t slot = m_states.size();
+      for( size_t i = hash( key ) & mask; ; i = ( i + 1 ) & mask )
+        {
+          if( m_states[ i ] == EMPTY )
+            {
+              if( slot == m_states.size() )
+                slot = i;
+              break;
+            }
+          if( m_states[ i ] == DELETED )
+            {
+              if( slot == m_states.size() )
+                slot = i;
+            }
+          else if( m_keys[ i ] == key )
+            return false;
+        }
+
+      if( m_states[ slot ] == DELETED )
+        -- m_deleted;
+      m_states[ slot ] = FULL;
+      m_keys[ slot ] = key;
+      m_values[ slot ] = value;
+      ++ m_size;
+      return true;
+    }
+
+    /**@brief Remove a key.
+     * @return false if the key was not found. */
+    bool erase( const key_type& key ) noexcept
+    {
+      if( m_states.empty() )
+        return false;
+      const size_t mask = m_states.size() - 1;
+      for( size_t i = hash( key ) & mask; ; i = ( i + 1 ) & mask )
+        {
+          if( m_states[ i ] == EMPTY )
+            return false;
+          if( m_states[ i ] == FULL && m_keys[ i ] == key )
+            {
+              m_states[ i ] = DELETED;
+              -- m_size;
+              ++ m_deleted;
+              return true;
+            }
+        }
+    }
+
+  private:
+    enum : uint8_t { EMPTY = 0, FULL = 1, DELETED = 2 };
+
+    static size_t hash( const key_type& key ) noexcept
+    {
+      uint64_t h = 0;
+      for( auto k : key )
+        h = ( h ^ uint64_t( k ) ) * 0x9E3779B97F4A7C15ull;
+      // finalizer of splitmix64, to spread the bits over the lower ones
+      h ^= h >> 30;
+      h *= 0xBF58476D1CE4E5B9ull;
+      h ^= h >> 27;
+      h *= 0x94D049BB133111EBull;
+      h ^= h >> 31;
+      return h;
+    }
+
+    /* Rebuild the table with enough room for the given number of entries, which
+     * also drops the deleted entries. */
+    void rehash( size_t number_of_entries )
+    {
+      number_of_entries = std::max( number_of_entries, m_size );
+      size_t capacity = 16;
+      while( capacity * 7 < number_of_entries * 10 )
+        capacity <<= 1;
+
+      std::vector< key_type > keys( capacity );
+      std::vector< value_type > values( capacity );
+      std::vector< uint8_t > states( capacity, uint8_t( EMPTY ) );
+      keys.swap( m_keys );
+      values.swap( m_values );
+      states.swap( m_states );
+
+      const size_t mask = capacity - 1;
+      for( size_t j = 0; j < states.size(); ++ j )
+        {
+          if( states[ j ] != FULL )
+            continue;
+          size_t i = hash( keys[ j ] ) & mask;
+          while( m_states[ i ] != EMPTY )
+            i = ( i + 1 ) & mask;
+          m_states[ i ] = FULL;
+          m_keys[ i ] = keys[ j ];
+          m_values[ i ] = values[ j ];
+        }
+      m_deleted = 0;
+    }
+
+    std::vector< key_type > m_keys;
+    std::vector< value_type > m_values;
+    std::vector< uint8_t > m_states;
+    size_t m_size;
+    size_t m_deleted;
+  };
+
+END_MP_NAMESPACE
+# endif
@@ -7,6 +7,17 @@
 # include "../io.h"
 # include <fstream>
 # include <algorithm>
+# include <cstdlib>
+# include <cstring>
+# include <limits>
+# include <vector>
+
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+# include <omp.h>
 
 BEGIN_MP_NAMESPACE
 
@@ -59,5 +70,359 @@ BEGIN_MP_NAMESPACE
     while( line.empty() );
     return true;
   }
+
+  /**@brief Read only memory mapping of a whole file.
+   *
+   * Loaders parse the mapped bytes in place instead of copying the file
+   * through a stream. The mapping is advised to be read sequentially and is
+   * released at the destruction. */
+  class mapped_file {
+  public:
+    explicit mapped_file( const std::string& filename )
+      : m_data{ nullptr }, m_size{ 0 }
+    {
+      const int fd = ::open( filename.c_str(), O_RDONLY );
+      if( fd < 0 )
+        return;
+      struct stat file_status;
+      if( !::fstat( fd, &file_status ) && file_status.st_size > 0 )
+        {
+          void* data = ::mmap( nullptr, file_status.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+          if( data != MAP_FAILED )
+            {
+              ::madvise( data, file_status.st_size, MADV_SEQUENTIAL );
+              m_data = static_cast< const char* >( data );
+              m_size = file_status.st_size;
+            }
+        }
+      ::close( fd );
+    }
+
+    ~mapped_file()
+    {
+      if( m_data )
+        ::munmap( const_cast< char* >( m_data ), m_size );
+    }
+
+    mapped_file( const mapped_file& ) = delete;
+    mapped_file& operator=( const mapped_file& ) = delete;
+
+    /**@brief Check if the file is mapped. Empty files are never mapped. */
+    bool is_open() const noexcept
+    {
+      return m_data != nullptr;
+    }
+
+    const char* data() const noexcept
+    {
+      return m_data;
+    }
+
+    size_t size() const noexcept
+    {
+      return m_size;
+    }
+
+  private:
+    const char* m_data;
+    size_t m_size;
+  };
+
+  inline bool is_blank( char c ) noexcept
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  /**@brief Get the next relevant line of a skeleton file in memory.
+   *
+   * This is the equivalent of get_next_relevant_line() for mapped files: a
+   * line is relevant if it is not empty once the comment and the leading and
+   * trailing spaces are removed. No memory is allocated, the line being
+   * given by pointers into the file.
+   * @param cursor Position of the next line to read, updated to the position
+   * of the line after the relevant line found.
+   * @param end End of the text.
+   * @param line_number Number of the last line read, updated to the number of
+   * the relevant line found.
+   * @param line_begin Receive the beginning of the relevant line.
+   * @param line_end Receive the end of the relevant line.
+   * @return True if another relevant line is found. */
+  inline bool
+  get_next_relevant_line( const char*& cursor, const char* end, size_t& line_number,
+    const char*& line_begin, const char*& line_end )
+  {
+    while( cursor < end )
+      {
+        const char* eol = static_cast< const char* >( std::memchr( cursor, '\n', end - cursor ) );
+        if( !eol )
+          eol = end;
+        line_begin = cursor;
+        cursor = eol == end ? end : eol + 1;
+        ++line_number;
+
+        // remove a comment, which starts by the sequence "//"
+        line_end = line_begin;
+        while( line_end < eol && !( line_end[0] == '/' && line_end + 1 < eol && line_end[1] == '/' ) )
+          ++line_end;
+
+        // remove leading and trailing spaces
+        while( line_begin < line_end && is_blank( *line_begin ) )
+          ++line_begin;
+        while( line_end > line_begin && is_blank( line_end[-1] ) )
+          --line_end;
+        if( line_begin != line_end )
+          return true;
+      }
+    return false;
+  }
+
+  /**@brief A part of a text file made of whole lines. */
+  struct text_chunk {
+    const char* begin;
+    const char* end;
+    /**Number of the line before the chunk. */
+    size_t line_number;
+  };
+
+  /**@brief Minimum number of bytes of a text chunk. */
+  static constexpr size_t text_chunk_min_size = size_t(1) << 20;
+
+  /**@brief Split a text into chunks of whole lines, to parse them in
+   * parallel.
+   *
+   * There are about eight chunks per thread, each chunk having at least
+   * text_chunk_min_size bytes, except the last one. The number of lines
+   * before each chunk is computed in parallel, such that parsers can report
+   * line numbers.
+   * @param begin Beginning of the text, at the beginning of a line.
+   * @param end End of the text.
+   * @param line_number Number of the line before the text. */
+  inline std::vector< text_chunk >
+  split_text( const char* begin, const char* end, size_t line_number )
+  {
+    const size_t size = end - begin;
+    const size_t nchunks = std::max( size_t( 1 ),
+      std::min( size / text_chunk_min_size, 8 * size_t( omp_get_max_threads() ) ) );
+    std::vector< text_chunk > chunks;
+    chunks.reserve( nchunks );
+    const char* chunk_begin = begin;
+    for( size_t c = 1; c <= nchunks && chunk_begin < end; ++ c )
+      {
+        const char* chunk_end = c == nchunks ? end : std::max( chunk_begin, begin + size * c / nchunks );
+        if( chunk_end < end )
+          {
+            const char* eol = static_cast< const char* >( std::memchr( chunk_end, '\n', end - chunk_end ) );
+            chunk_end = eol ? eol + 1 : end;
+          }
+        chunks.push_back( { chunk_begin, chunk_end, 0 } );
+        chunk_begin = chunk_end;
+      }
+
+    std::vector< size_t > lines( chunks.size() );
+    # pragma omp parallel for
+    for( size_t c = 0; c < chunks.size(); ++ c )
+      lines[ c ] = std::count( chunks[ c ].begin, chunks[ c ].end, '\n' );
+    for( auto& chunk : chunks )
+      {
+        chunk.line_number = line_number;
+        line_number += lines[ &chunk - chunks.data() ];
+      }
+    return chunks;
+  }
+
+  /**@brief Skip the spaces before a token of a relevant line. */
+  inline void skip_blanks( const char*& cursor, const char* end ) noexcept
+  {
+    while( cursor < end && is_blank( *cursor ) )
+      ++cursor;
+  }
+
+  /**@brief Get the end of the token starting at a position. */
+  inline const char* get_token_end( const char* cursor, const char* end ) noexcept
+  {
+    while( cursor < end && !is_blank( *cursor ) )
+      ++cursor;
+    return cursor;
+  }
+
+  /**@brief Parse an unsigned integer token of a relevant line.
+   *
+   * Leading spaces are skipped. The token must end at a space or at the end
+   * of the line.
+   * @param cursor Position in the line, updated to the end of the token.
+   * @param end End of the line.
+   * @param value Receive the parsed value.
+   * @return True if the token is a valid integer for the type of value. */
+  template< typename integer >
+  bool parse_integer( const char*& cursor, const char* end, integer& value ) noexcept
+  {
+    skip_blanks( cursor, end );
+    const char* token_end = get_token_end( cursor, end );
+    if( cursor < token_end && *cursor == '+' )
+      ++cursor;
+    if( cursor == token_end )
+      return false;
+    uint64_t result = 0;
+    for( ; cursor < token_end; ++ cursor )
+      {
+        const unsigned digit = unsigned( *cursor ) - unsigned( '0' );
+        if( digit > 9 || result > ( std::numeric_limits< uint64_t >::max() - digit ) / 10 )
+          return false;
+        result = result * 10 + digit;
+      }
+    if( result > uint64_t( std::numeric_limits< integer >::max() ) )
+      return false;
+    value = integer( result );
+    return true;
+  }
+
+  /**@brief Parse a real number token of a relevant line.
+   *
+   * Leading spaces are skipped. The token must end at a space or at the end
+   * of the line. Decimal numbers with at most 19 significant digits and a
+   * small exponent, i.e. all numbers written by the savers, are converted
+   * exactly with a single multiplication or division by a power of ten.
+   * Other tokens (more digits, large exponents, infinities) are converted
+   * by std::strtod. Unlike streams, the parsing does not depend on a locale.
+   * @param cursor Position in the line, updated to the end of the token.
+   * @param end End of the line.
+   * @param value Receive the parsed value.
+   * @return True if the token is a valid real number. */
+  inline bool parse_real( const char*& cursor, const char* end, real& value )
+  {
+    static const double powers_of_ten[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    skip_blanks( cursor, end );
+    const char* token_begin = cursor;
+    const char* token_end = get_token_end( cursor, end );
+    if( cursor == token_end )
+      return false;
+
+    const char* p = cursor;
+    const bool negative = *p == '-';
+    if( *p == '-' || *p == '+' )
+      ++p;
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool has_digits = false;
+    for( ; p < token_end && unsigned( *p - '0' ) <= 9; ++ p, has_digits = true )
+      {
+        if( digits < 19 )
+          {
+            mantissa = mantissa * 10 + unsigned( *p - '0' );
+            digits += mantissa != 0;
+          }
+        else
+          ++exponent;
+      }
+    if( p < token_end && *p == '.' )
+      for( ++ p; p < token_end && unsigned( *p - '0' ) <= 9; ++ p, has_digits = true )
+        if( digits < 19 )
+          {
+            mantissa = mantissa * 10 + unsigned( *p - '0' );
+            digits += mantissa != 0;
+            --exponent;
+          }
+    if( has_digits && p < token_end && ( *p == 'e' || *p == 'E' ) )
+      {
+        ++p;
+        const bool negative_exponent = p < token_end && *p == '-';
+        if( p < token_end && ( *p == '-' || *p == '+' ) )
+          ++p;
+        int e = 0;
+        const char* exponent_begin = p;
+        for( ; p < token_end && unsigned( *p - '0' ) <= 9; ++ p )
+          e = std::min( e * 10 + int( *p - '0' ), 100000 );
+        if( p == exponent_begin )
+          has_digits = false;
+        exponent += negative_exponent ? -e : e;
+      }
+
+    if( has_digits && p == token_end && mantissa < ( uint64_t(1) << 53 )
+        && exponent >= -22 && exponent <= 22 )
+      {
+        double result = double( mantissa );
+        result = exponent < 0 ? result / powers_of_ten[ -exponent ] : result * powers_of_ten[ exponent ];
+        value = real( negative ? -result : result );
+        cursor = token_end;
+        return true;
+      }
+
+    // slow path: the token is copied to be null terminated
+    const std::string token( token_begin, token_end );
+    char* parsed_end = nullptr;
+    const double result = std::strtod( token.c_str(), &parsed_end );
+    if( parsed_end != token.c_str() + token.size() )
+      return false;
+    value = real( result );
+    cursor = token_end;
+    return true;
+  }
+
+  /**@brief Number of elements whose atom handles are resolved in one batch
+   * by savers. */
+  static constexpr size_t saver_batch_size = 256;
+
+  /**@brief Process the atom indices of all links of a skeleton, in order.
+   *
+   * Links of a valid skeleton only refer to valid atoms. Thus, the atom
+   * handles are resolved without checks, by batches of saver_batch_size
+   * links, instead of one checked call per handle.
+   * @param skeleton The skeleton to process.
+   * @param function Function called with the indices of the two atoms of
+   * each link. */
+  template< typename skeleton_type, typename link_function >
+  void
+  process_link_atom_indices( const skeleton_type& skeleton, link_function&& function )
+  {
+    const auto access = skeleton.unchecked();
+    const size_t nlinks = skeleton.get_number_of_links();
+    typename skeleton_type::atom_handle handles[ 2 * saver_batch_size ];
+    typename skeleton_type::atom_index indices[ 2 * saver_batch_size ];
+    for( size_t begin = 0; begin < nlinks; begin += saver_batch_size )
+      {
+        const size_t n = std::min( saver_batch_size, nlinks - begin );
+        for( size_t k = 0; k < n; ++ k )
+          {
+            const auto& l = access.get_link_by_index( begin + k );
+            handles[ 2 * k     ] = l.h1;
+            handles[ 2 * k + 1 ] = l.h2;
+          }
+        access.get_indices( handles, 2 * n, indices );
+        for( size_t k = 0; k < n; ++ k )
+          function( indices[ 2 * k ], indices[ 2 * k + 1 ] );
+      }
+  }
+
+  /**@brief Process the atom indices of all faces of a skeleton, in order.
+   * @see process_link_atom_indices
+   * @param skeleton The skeleton to process.
+   * @param function Function called with the indices of the three atoms of
+   * each face. */
+  template< typename skeleton_type, typename face_function >
+  void
+  process_face_atom_indices( const skeleton_type& skeleton, face_function&& function )
+  {
+    const auto access = skeleton.unchecked();
+    const size_t nfaces = skeleton.get_number_of_faces();
+    typename skeleton_type::atom_handle handles[ 3 * saver_batch_size ];
+    typename skeleton_type::atom_index indices[ 3 * saver_batch_size ];
+    for( size_t begin = 0; begin < nfaces; begin += saver_batch_size )
+      {
+        const size_t n = std::min( saver_batch_size, nfaces - begin );
+        for( size_t k = 0; k < n; ++ k )
+          {
+            const auto& f = access.get_face_by_index( begin + k );
+            handles[ 3 * k     ] = f.atoms[ 0 ];
+            handles[ 3 * k + 1 ] = f.atoms[ 1 ];
+            handles[ 3 * k + 2 ] = f.atoms[ 2 ];
+          }
+        access.get_indices( handles, 3 * n, indices );
+        for( size_t k = 0; k < n; ++ k )
+          function( indices[ 3 * k ], indices[ 3 * k + 1 ], indices[ 3 * k + 2 ] );
+      }
+  }
 END_MP_NAMESPACE
 # endif
@@ -6,6 +6,7 @@
 
 # include "../io.h"
 # include "io_utilities.h"
+# include "../property_types.h"
 
 # include <graphics-origin/tools/filesystem.h>
 # include <graphics-origin/tools/log.h>
@@ -21,9 +22,13 @@ namespace io {
 
   static const std::string median_format_extension = ".median";
 
+  template< typename skeleton_type >
   struct median_reader_handler
-    : public rapidjson::BaseReaderHandler< rapidjson::UTF8<>, median_reader_handler >
+    : public rapidjson::BaseReaderHandler< rapidjson::UTF8<>, median_reader_handler< skeleton_type > >
   {
+    typedef typename rapidjson::UTF8<>::Ch Ch;
+    typedef typename skeleton_type::atom_index atom_index;
+
     struct status {
       uint32_t expect_object_start      : 1;
       uint32_t expect_name_or_object_end: 1;
@@ -35,35 +40,146 @@ namespace io {
       uint32_t reading_atom_properties  : 1;
       uint32_t reading_link_properties  : 1;
       uint32_t reading_face_properties  : 1;
+      uint32_t reading_property         : 1;
+      uint32_t reading_property_indices : 1;
+      uint32_t reading_property_values  : 1;
 
       status()
         : expect_object_start{1},
           expect_name_or_object_end{0},
           reading_header{0},
           reading_atoms{0}, reading_links{0}, reading_faces{0},
-          reading_atom_properties{0}, reading_link_properties{0}, reading_face_properties{0}
+          reading_atom_properties{0}, reading_link_properties{0}, reading_face_properties{0},
+          reading_property{0}, reading_property_indices{0}, reading_property_values{0}
       {}
     };
 
-    median_skeleton& m_skeleton;
+    enum property_key : uint8_t { no_key, name_key, type_key, storage_key };
+
+    skeleton_type& m_skeleton;
     status m_status;
     uint8_t m_atom_index;
-    median_skeleton::atom m_atom;
+    typename skeleton_type::atom m_atom;
     uint8_t m_link_index;
-    median_skeleton::atom_index m_link[2];
+    atom_index m_link[2];
     uint8_t m_face_index;
-    median_skeleton::atom_index m_face[3];
-
-    median_reader_handler( median_skeleton& skeleton )
+    atom_index m_face[3];
+    // links and faces are inserted in bulk once their array is read
+    std::vector< std::pair< atom_index, atom_index > > m_links;
+    std::vector< std::array< atom_index, 3 > > m_faces;
+    // property being read, m_property is null if the property is skipped
+    property_key m_property_key;
+    std::string m_property_name;
+    std::string m_property_type_name;
+    std::string m_property_storage;
+    std::vector< uint64_t > m_property_indices;
+    const property_type* m_property_type;
+    base_property_buffer* m_property;
+    uint64_t m_property_size;
+    uint64_t m_property_value_index;
+
+    median_reader_handler( skeleton_type& skeleton )
       : m_skeleton{ skeleton }, m_status{},
         m_atom_index{0},
         m_link_index{0}, m_link{ 0, 0 },
-        m_face_index{0}, m_face{ 0, 0, 0 }
+        m_face_index{0}, m_face{ 0, 0, 0 },
+        m_property_key{ no_key },
+        m_property_type{ nullptr }, m_property{ nullptr },
+        m_property_size{0}, m_property_value_index{0}
     {}
 
+    /* find the property to fill, or create it, once its name, type and
+     * storage are known */
+    bool begin_property_values()
+    {
+      m_status.reading_property_values = 1;
+      m_property_value_index = 0;
+      m_property = nullptr;
+      m_property_type = find_property_type( m_property_type_name );
+      if( !m_property_type )
+        {
+          LOG( debug, "property \"" << m_property_name << "\" is not loaded: type \"" << m_property_type_name << "\" is not registered");
+          return true;
+        }
+
+      const auto storage = m_property_storage == "paged" ? base_property_buffer::paged
+        : ( m_property_storage == "sparse" ? base_property_buffer::sparse : base_property_buffer::dense );
+      if( m_status.reading_atom_properties )
+        {
+          m_property_size = m_skeleton.get_number_of_atoms();
+          m_property = m_skeleton.is_an_atom_property_name( m_property_name )
+            ? &m_skeleton.get_atom_property( m_property_name )
+            : &m_skeleton.add_atom_property( m_property_type->create( m_property_name, storage ) );
+        }
+      else if( m_status.reading_link_properties )
+        {
+          m_property_size = m_skeleton.get_number_of_links();
+          m_property = m_skeleton.is_an_link_property_name( m_property_name )
+            ? &m_skeleton.get_link_property( m_property_name )
+            : &m_skeleton.add_link_property( m_property_type->create( m_property_name, storage ) );
+        }
+      else
+        {
+          m_property_size = m_skeleton.get_number_of_faces();
+          m_property = m_skeleton.is_an_face_property_name( m_property_name )
+            ? &m_skeleton.get_face_property( m_property_name )
+            : &m_skeleton.add_face_property( m_property_type->create( m_property_name, storage ) );
+        }
+
+      if( std::type_index( m_property->get_value_type() ) != m_property_type->value_type )
+        {
+          LOG( error, "property \"" << m_property_name << "\" is not loaded: an existing property with that name has another type");
+          m_property = nullptr;
+        }
+      return true;
+    }
+
+    template< typename number >
+    bool property_number( number n )
+    {
+      if( m_status.reading_property_indices )
+        {
+          m_property_indices.push_back( uint64_t( n ) );
+          return true;
+        }
+      if( !m_status.reading_property_values || !m_property )
+        return true;
+
+      const size_t ncomponents = m_property_type->number_of_components;
+      const uint64_t k = m_property_value_index ++;
+      uint64_t element = k / ncomponents;
+      if( !m_property_indices.empty() )
+        element = element < m_property_indices.size() ? m_property_indices[ element ] : m_property_size;
+      if( element >= m_property_size )
+        {
+          LOG( error, "too many values for property \"" << m_property_name << "\"");
+          return false;
+        }
+
+      property_component value;
+      switch( m_property_type->kind )
+        {
+        case component_kind::real_component:
+          value.real_value = double( n );
+          break;
+        case component_kind::signed_component:
+          value.signed_value = int64_t( n );
+          break;
+        case component_kind::unsigned_component:
+          value.unsigned_value = uint64_t( n );
+          break;
+        }
+      m_property_type->set( *m_property, element, k % ncomponents, value );
+      return true;
+    }
+
 
     bool Null()
     {
+      // files without properties have null property lists
+      m_status.reading_atom_properties = 0;
+      m_status.reading_link_properties = 0;
+      m_status.reading_face_properties = 0;
       return true;
     }
     bool Bool(bool b)
@@ -74,6 +190,8 @@ namespace io {
     }
     bool Int(int i)
     {
+      if( m_status.reading_property )
+        return property_number( i );
       if( m_status.reading_header )
         {
           if( m_status.reading_atoms )
@@ -84,11 +202,13 @@ namespace io {
           else if( m_status.reading_links )
             {
               m_skeleton.reserve_links( i );
+              m_links.reserve( i );
               m_status.reading_links = 0;
             }
           else if( m_status.reading_faces )
             {
               m_skeleton.reserve_faces( i );
+              m_faces.reserve( i );
               m_status.reading_faces = 0;
             }
         }
@@ -99,7 +219,7 @@ namespace io {
               m_link[ m_link_index ] = i;
               if( m_link_index == 1 )
                 {
-                  m_skeleton.add( m_link[0], m_link[1] );
+                  m_links.push_back( std::make_pair( m_link[0], m_link[1] ) );
                   m_link_index = 0;
                 }
               else m_link_index = 1;
@@ -109,7 +229,7 @@ namespace io {
               m_face[ m_face_index ] = i;
               if( m_face_index == 2 )
                 {
-                  m_skeleton.add( m_face[0], m_face[1], m_face[2] );
+                  m_faces.push_back( {{ m_face[0], m_face[1], m_face[2] }} );
                   m_face_index = 0;
                 }
               else ++ m_face_index;
@@ -119,6 +239,8 @@ namespace io {
     }
     bool Uint(unsigned i)
     {
+      if( m_status.reading_property )
+        return property_number( i );
       if( m_status.reading_header )
         {
           if( m_status.reading_atoms )
@@ -129,11 +251,13 @@ namespace io {
           else if( m_status.reading_links )
             {
               m_skeleton.reserve_links( i );
+              m_links.reserve( i );
               m_status.reading_links = 0;
             }
           else if( m_status.reading_faces )
             {
               m_skeleton.reserve_faces( i );
+              m_faces.reserve( i );
               m_status.reading_faces = 0;
             }
         }
@@ -144,7 +268,7 @@ namespace io {
               m_link[ m_link_index ] = i;
               if( m_link_index == 1 )
                 {
-                  m_skeleton.add( m_link[0], m_link[1] );
+                  m_links.push_back( std::make_pair( m_link[0], m_link[1] ) );
                   m_link_index = 0;
                 }
               else m_link_index = 1;
@@ -154,7 +278,7 @@ namespace io {
               m_face[ m_face_index ] = i;
               if( m_face_index == 2 )
                 {
-                  m_skeleton.add( m_face[0], m_face[1], m_face[2] );
+                  m_faces.push_back( {{ m_face[0], m_face[1], m_face[2] }} );
                   m_face_index = 0;
                 }
               else ++ m_face_index;
@@ -164,6 +288,8 @@ namespace io {
     }
     bool Int64(int64_t i)
     {
+      if( m_status.reading_property )
+        return property_number( i );
       if( m_status.reading_header )
         {
           if( m_status.reading_atoms )
@@ -174,11 +300,13 @@ namespace io {
           else if( m_status.reading_links )
             {
               m_skeleton.reserve_links( i );
+              m_links.reserve( i );
               m_status.reading_links = 0;
             }
           else if( m_status.reading_faces )
             {
               m_skeleton.reserve_faces( i );
+              m_faces.reserve( i );
               m_status.reading_faces = 0;
             }
         }
@@ -189,7 +317,7 @@ namespace io {
               m_link[ m_link_index ] = i;
               if( m_link_index == 1 )
                 {
-                  m_skeleton.add( m_link[0], m_link[1] );
+                  m_links.push_back( std::make_pair( m_link[0], m_link[1] ) );
                   m_link_index = 0;
                 }
               else m_link_index = 1;
@@ -199,7 +327,7 @@ namespace io {
               m_face[ m_face_index ] = i;
               if( m_face_index == 2 )
                 {
-                  m_skeleton.add( m_face[0], m_face[1], m_face[2] );
+                  m_faces.push_back( {{ m_face[0], m_face[1], m_face[2] }} );
                   m_face_index = 0;
                 }
               else ++ m_face_index;
@@ -209,6 +337,8 @@ namespace io {
     }
     bool Uint64(uint64_t i)
     {
+      if( m_status.reading_property )
+        return property_number( i );
       if( m_status.reading_header )
         {
           if( m_status.reading_atoms )
@@ -219,11 +349,13 @@ namespace io {
           else if( m_status.reading_links )
             {
               m_skeleton.reserve_links( i );
+              m_links.reserve( i );
               m_status.reading_links = 0;
             }
           else if( m_status.reading_faces )
             {
               m_skeleton.reserve_faces( i );
+              m_faces.reserve( i );
               m_status.reading_faces = 0;
             }
         }
@@ -234,7 +366,7 @@ namespace io {
               m_link[ m_link_index ] = i;
               if( m_link_index == 1 )
                 {
-                  m_skeleton.add( m_link[0], m_link[1] );
+                  m_links.push_back( std::make_pair( m_link[0], m_link[1] ) );
                   m_link_index = 0;
                 }
               else m_link_index = 1;
@@ -244,7 +376,7 @@ namespace io {
               m_face[ m_face_index ] = i;
               if( m_face_index == 2 )
                 {
-                  m_skeleton.add( m_face[0], m_face[1], m_face[2] );
+                  m_faces.push_back( {{ m_face[0], m_face[1], m_face[2] }} );
                   m_face_index = 0;
                 }
               else ++ m_face_index;
@@ -254,6 +386,8 @@ namespace io {
     }
     bool Double(double d)
     {
+      if( m_status.reading_property )
+        return property_number( d );
       if( !m_status.reading_header && m_status.reading_atoms )
         {
           m_atom[ m_atom_index ] = d;
@@ -269,9 +403,17 @@ namespace io {
 
     bool String(const Ch* str, rapidjson::SizeType length, bool copy)
     {
-      (void)str;
-      (void)length;
       (void)copy;
+      if( m_status.reading_property )
+        {
+          if( m_property_key == name_key )
+            m_property_name.assign( str, length );
+          else if( m_property_key == type_key )
+            m_property_type_name.assign( str, length );
+          else if( m_property_key == storage_key )
+            m_property_storage.assign( str, length );
+          m_property_key = no_key;
+        }
       return true;
     }
 
@@ -286,6 +428,18 @@ namespace io {
           m_status.expect_name_or_object_end = 1;
           return true;
         }
+      if( !m_status.reading_property &&
+          ( m_status.reading_atom_properties || m_status.reading_link_properties || m_status.reading_face_properties ) )
+        {
+          m_status.reading_property = 1;
+          m_property_key = no_key;
+          m_property_name.clear();
+          m_property_type_name.clear();
+          m_property_storage.clear();
+          m_property_indices.clear();
+          m_property = nullptr;
+          return true;
+        }
       LOG( error, "unexpected start of object");
       return false;
     }
@@ -293,6 +447,11 @@ namespace io {
     bool EndObject(rapidjson::SizeType memberCount)
     {
       (void)memberCount;
+      if( m_status.reading_property )
+        {
+          m_status.reading_property = 0;
+          return true;
+        }
       if( m_status.expect_name_or_object_end )
         {
           if(m_status.reading_header )
@@ -306,6 +465,21 @@ namespace io {
     {
       (void)copy;
       std::string s( str, length );
+      if( m_status.reading_property )
+        {
+          m_property_key = no_key;
+          if( s == "name" )
+            m_property_key = name_key;
+          else if( s == "type" )
+            m_property_key = type_key;
+          else if( s == "storage" )
+            m_property_key = storage_key;
+          else if( s == "indices" )
+            m_status.reading_property_indices = 1;
+          else if( s == "values" )
+            return begin_property_values();
+          return true;
+        }
       if( s == "header" )
         {
           m_status.reading_header = 1;
@@ -317,6 +491,12 @@ namespace io {
         m_status.reading_links = 1;
       else if( s == "faces" )
         m_status.reading_faces = 1;
+      else if( !m_status.reading_header )
+        {
+          m_status.reading_atom_properties = s == "atom_properties";
+          m_status.reading_link_properties = s == "link_properties";
+          m_status.reading_face_properties = s == "face_properties";
+        }
       return true;
     }
 
@@ -327,7 +507,29 @@ namespace io {
     bool EndArray(rapidjson::SizeType elementCount)
     {
       (void)elementCount;
-      if( !m_status.reading_header )
+      if( m_status.reading_property_indices )
+        m_status.reading_property_indices = 0;
+      else if( m_status.reading_property_values )
+        {
+          m_status.reading_property_values = 0;
+          const uint64_t expected = m_property_type
+            ? m_property_type->number_of_components
+              * ( m_property_indices.empty() ? m_property_size : m_property_indices.size() )
+            : 0;
+          if( m_property && m_property_value_index != expected )
+            {
+              LOG( error, "property \"" << m_property_name << "\" has " << m_property_value_index
+                   << " values instead of " << expected );
+              return false;
+            }
+        }
+      else if( m_status.reading_atom_properties || m_status.reading_link_properties || m_status.reading_face_properties )
+        {
+          m_status.reading_atom_properties = 0;
+          m_status.reading_link_properties = 0;
+          m_status.reading_face_properties = 0;
+        }
+      else if( !m_status.reading_header )
         {
           if( m_status.reading_atoms )
             {
@@ -345,6 +547,8 @@ namespace io {
                   LOG( error, "unfinished link");
                   return false;
                 }
+              m_skeleton.add_links( m_links );
+              decltype( m_links )().swap( m_links );
               m_status.reading_links = 0;
             }
           else if( m_status.reading_faces )
@@ -354,6 +558,8 @@ namespace io {
                   LOG( error, "unfinished face");
                   return false;
                 }
+              m_skeleton.add_faces( m_faces );
+              decltype( m_faces )().swap( m_faces );
               m_status.reading_faces = 0;
             }
         }
@@ -371,12 +577,23 @@ namespace io {
     }
 
     bool load( median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    bool load( large_median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    template< typename skeleton_type >
+    bool load_skeleton( skeleton_type& skeleton, const std::string& filename )
     {
       std::FILE* pfile = std::fopen( filename.c_str(), "r" );
       char buffer[ 65536 ];
       rapidjson::FileReadStream rs( pfile, buffer, sizeof(buffer) );
       rapidjson::Reader reader;
-      median_reader_handler handler(skeleton);
+      median_reader_handler< skeleton_type > handler(skeleton);
 
       bool result = reader.Parse( rs, handler );
 
@@ -402,7 +619,18 @@ namespace io {
       return graphics_origin::tools::get_extension( filename ) == median_format_extension;
     }
 
-    bool save( median_skeleton& skeleton, const std::string& filename ) override
+    bool save( const median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    bool save( const large_median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    template< typename skeleton_type >
+    bool save_skeleton( const skeleton_type& skeleton, const std::string& filename )
     {
       std::FILE* pfile = std::fopen( filename.c_str(), "w" );
       char buffer[ 65536 ];
@@ -428,8 +656,9 @@ namespace io {
       return true;
     }
 
+    template< typename skeleton_type >
     void write_header(
-        median_skeleton& skeleton,
+        const skeleton_type& skeleton,
         json_writer& writer )
     {
       writer.Key( "header" );
@@ -462,15 +691,16 @@ namespace io {
       writer.EndObject();
     }
 
+    template< typename skeleton_type >
     void write_atoms(
-        median_skeleton& skeleton,
+        const skeleton_type& skeleton,
         json_writer& writer )
     {
       writer.Key( "atoms" );
       writer.StartArray();
 
         skeleton.process_atoms(
-            [&writer]( median_skeleton::atom& a )
+            [&writer]( const typename skeleton_type::atom& a )
             {
               writer.Double( a.x );
               writer.Double( a.y );
@@ -481,64 +711,156 @@ namespace io {
       writer.EndArray();
     }
 
+    template< typename skeleton_type >
     void write_links(
-        median_skeleton& skeleton,
+        const skeleton_type& skeleton,
         json_writer& writer )
     {
       writer.Key( "links" );
       writer.StartArray();
 
-        skeleton.process_links(
-            [&writer,&skeleton]( median_skeleton::link& l )
+        process_link_atom_indices( skeleton,
+            [&writer]( typename skeleton_type::atom_index i1, typename skeleton_type::atom_index i2 )
             {
-              writer.Uint64( skeleton.get_index( l.h1 ) );
-              writer.Uint64( skeleton.get_index( l.h2 ) );
-            }, false );
+              writer.Uint64( i1 );
+              writer.Uint64( i2 );
+            } );
 
       writer.EndArray();
     }
 
+    template< typename skeleton_type >
     void write_faces(
-        median_skeleton& skeleton,
+        const skeleton_type& skeleton,
         json_writer& writer )
     {
       writer.Key( "faces" );
       writer.StartArray();
 
-        skeleton.process_faces(
-            [&writer,&skeleton]( median_skeleton::face& f )
+        process_face_atom_indices( skeleton,
+            [&writer]( typename skeleton_type::atom_index i1, typename skeleton_type::atom_index i2,
+                       typename skeleton_type::atom_index i3 )
             {
-              writer.Uint64( skeleton.get_index( f.atoms[0] ) );
-              writer.Uint64( skeleton.get_index( f.atoms[1] ) );
-              writer.Uint64( skeleton.get_index( f.atoms[2] ) );
-            }, false );
+              writer.Uint64( i1 );
+              writer.Uint64( i2 );
+              writer.Uint64( i3 );
+            } );
 
       writer.EndArray();
     }
 
+    template< typename skeleton_type >
     void write_atom_properties(
-        median_skeleton& skeleton,
+        const skeleton_type& skeleton,
         json_writer& writer )
     {
       writer.Key( "atom_properties" );
-      writer.Null();
-      (void)skeleton;
+      writer.StartArray();
+        for( uint64_t i = 0; i < skeleton.get_number_of_atom_properties(); ++ i )
+          write_property(
+            skeleton.get_atom_property( typename skeleton_type::atom_property_index( i + atom_faces_property_index + 1 ) ),
+            skeleton.get_number_of_atoms(), writer );
+      writer.EndArray();
     }
+    template< typename skeleton_type >
     void write_link_properties(
-        median_skeleton& skeleton,
+        const skeleton_type& skeleton,
         json_writer& writer )
     {
       writer.Key( "link_properties" );
-      writer.Null();
-      (void)skeleton;
+      writer.StartArray();
+        for( uint64_t i = 0; i < skeleton.get_number_of_link_properties(); ++ i )
+          write_property(
+            skeleton.get_link_property( typename skeleton_type::link_property_index( i + link_faces_property_index + 1 ) ),
+            skeleton.get_number_of_links(), writer );
+      writer.EndArray();
     }
+    template< typename skeleton_type >
     void write_face_properties(
-        median_skeleton& skeleton,
+        const skeleton_type& skeleton,
         json_writer& writer )
     {
       writer.Key( "face_properties" );
-      writer.Null();
-      (void)skeleton;
+      writer.StartArray();
+        for( uint64_t i = 0; i < skeleton.get_number_of_face_properties(); ++ i )
+          write_property(
+            skeleton.get_face_property( typename skeleton_type::face_property_index( i ) ),
+            skeleton.get_number_of_faces(), writer );
+      writer.EndArray();
+    }
+
+    /* a property is an object with its name, the name of its type and its
+     * storage, followed by the flat array of the components of its elements.
+     * Paged and sparse properties also have the array of the indices of
+     * their allocated elements, and only those elements are written.
+     * Properties whose type is not registered are not saved. */
+    void write_property(
+        const base_property_buffer& property,
+        uint64_t number_of_elements,
+        json_writer& writer )
+    {
+      const property_type* type = find_property_type( property.get_value_type() );
+      if( !type )
+        {
+          LOG( debug, "property \"" << property.m_name << "\" is not saved: its type is not registered");
+          return;
+        }
+      writer.StartObject();
+
+        writer.Key( "name" );
+        writer.String( property.m_name.c_str(), rapidjson::SizeType( property.m_name.size() ) );
+
+        writer.Key( "type" );
+        writer.String( type->name.c_str(), rapidjson::SizeType( type->name.size() ) );
+
+        writer.Key( "storage" );
+        writer.String( property.m_storage == base_property_buffer::paged ? "paged"
+                     : property.m_storage == base_property_buffer::sparse ? "sparse" : "dense" );
+
+        // paged and sparse properties only save their allocated elements
+        std::vector< uint64_t > elements;
+        if( property.m_storage != base_property_buffer::dense )
+          {
+            writer.Key( "indices" );
+            writer.StartArray();
+              for( uint64_t e = 0; e < number_of_elements; ++ e )
+                if( property.is_allocated( e ) )
+                  {
+                    elements.push_back( e );
+                    writer.Uint64( e );
+                  }
+            writer.EndArray();
+          }
+        else
+          {
+            elements.resize( number_of_elements );
+            for( uint64_t e = 0; e < number_of_elements; ++ e )
+              elements[ e ] = e;
+          }
+
+        writer.Key( "values" );
+        writer.StartArray();
+          const size_t ncomponents = type->number_of_components;
+          for( auto e : elements )
+            for( size_t c = 0; c < ncomponents; ++ c )
+              {
+                const property_component value = type->get( property, e, c );
+                switch( type->kind )
+                  {
+                  case component_kind::real_component:
+                    writer.Double( value.real_value );
+                    break;
+                  case component_kind::signed_component:
+                    writer.Int64( value.signed_value );
+                    break;
+                  case component_kind::unsigned_component:
+                    writer.Uint64( value.unsigned_value );
+                    break;
+                  }
+              }
+        writer.EndArray();
+
+      writer.EndObject();
     }
 
   };
@@ -4,32 +4,326 @@ static const uint8_t atom_links_property_index = 0;
 static const uint8_t atom_faces_property_index = 1;
 static const uint8_t link_faces_property_index = 0;
 
-template< typename atom_processer >
+mps_template_parameters
+template< typename check_policy >
+  const typename mps_type::atom&
+  mps_type::element_access< check_policy >::get(
+    atom_handle handle ) const
+  {
+    return get_atom_by_index( get_index( handle ) );
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  const typename mps_type::atom&
+  mps_type::element_access< check_policy >::get_atom_by_index(
+    atom_index index ) const
+  {
+    const auto& impl = *m_skeleton.m_impl;
+    if( check_policy::check_indices && index >= impl.m_atoms_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
+    return impl.m_atoms[ index ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::atom_index
+  mps_type::element_access< check_policy >::get_index(
+    atom_handle handle ) const
+  {
+    const auto& impl = *m_skeleton.m_impl;
+    if( check_policy::check_handles && handle.index >= impl.m_atoms_capacity )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_handle );
+    const auto& entry = impl.m_atom_handles[ handle.index ];
+    if( check_policy::check_handles
+        && ( entry.status != datastructure::STATUS_ALLOCATED || entry.counter != handle.counter ) )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_handle );
+    return entry.atom_index;
+  }
+
+mps_template_parameters
+template< typename check_policy >
   void
-  median_skeleton::process_atoms(
-    atom_processer&& function, bool parallel )
+  mps_type::element_access< check_policy >::get_indices(
+    const atom_handle* handles, size_t number_of_handles, atom_index* indices ) const
   {
-    if( parallel )
+    const auto entries = m_skeleton.m_impl->m_atom_handles.get();
+    const size_t prefetched = number_of_handles > access_prefetch_distance
+        ? number_of_handles - access_prefetch_distance : 0;
+    for( size_t i = 0; i < prefetched; ++ i )
       {
-# pragma omp parallel for schedule(dynamic)
-        for( atom_index i = 0; i < m_impl->m_atoms_size; ++i )
-          {
-            function( m_impl->m_atoms[i] );
-          }
+        prefetch_for_read( entries + handles[ i + access_prefetch_distance ].index );
+        indices[ i ] = get_index( handles[ i ] );
       }
-    else
+    for( size_t i = prefetched; i < number_of_handles; ++ i )
+      indices[ i ] = get_index( handles[ i ] );
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  const typename mps_type::link&
+  mps_type::element_access< check_policy >::get(
+    link_handle handle ) const
+  {
+    return m_skeleton.m_impl->m_links[ get_index( handle ) ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  const typename mps_type::link&
+  mps_type::element_access< check_policy >::get_link_by_index(
+    link_index index ) const
+  {
+    const auto& impl = *m_skeleton.m_impl;
+    if( check_policy::check_indices && index >= impl.m_links_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_link_index );
+    return impl.m_links[ index ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::link_index
+  mps_type::element_access< check_policy >::get_index(
+    link_handle handle ) const
+  {
+    const auto& impl = *m_skeleton.m_impl;
+    if( check_policy::check_handles && handle.index >= impl.m_links_capacity )
+      MP_THROW_EXCEPTION( skeleton_invalid_link_handle );
+    const auto& entry = impl.m_link_handles[ handle.index ];
+    if( check_policy::check_handles
+        && ( entry.status != datastructure::STATUS_ALLOCATED || entry.counter != handle.counter ) )
+      MP_THROW_EXCEPTION( skeleton_invalid_link_handle );
+    return entry.link_index;
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  void
+  mps_type::element_access< check_policy >::get_indices(
+    const link_handle* handles, size_t number_of_handles, link_index* indices ) const
+  {
+    const auto entries = m_skeleton.m_impl->m_link_handles.get();
+    const size_t prefetched = number_of_handles > access_prefetch_distance
+        ? number_of_handles - access_prefetch_distance : 0;
+    for( size_t i = 0; i < prefetched; ++ i )
       {
-        for( atom_index i = 0; i < m_impl->m_atoms_size; ++i )
-          {
-            function( m_impl->m_atoms[i] );
-          }
+        prefetch_for_read( entries + handles[ i + access_prefetch_distance ].index );
+        indices[ i ] = get_index( handles[ i ] );
       }
+    for( size_t i = prefetched; i < number_of_handles; ++ i )
+      indices[ i ] = get_index( handles[ i ] );
   }
 
+mps_template_parameters
+template< typename check_policy >
+  const typename mps_type::face&
+  mps_type::element_access< check_policy >::get(
+    face_handle handle ) const
+  {
+    return m_skeleton.m_impl->m_faces[ get_index( handle ) ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  const typename mps_type::face&
+  mps_type::element_access< check_policy >::get_face_by_index(
+    face_index index ) const
+  {
+    const auto& impl = *m_skeleton.m_impl;
+    if( check_policy::check_indices && index >= impl.m_faces_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_face_index );
+    return impl.m_faces[ index ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::face_index
+  mps_type::element_access< check_policy >::get_index(
+    face_handle handle ) const
+  {
+    const auto& impl = *m_skeleton.m_impl;
+    if( check_policy::check_handles && handle.index >= impl.m_faces_capacity )
+      MP_THROW_EXCEPTION( skeleton_invalid_face_handle );
+    const auto& entry = impl.m_face_handles[ handle.index ];
+    if( check_policy::check_handles
+        && ( entry.status != datastructure::STATUS_ALLOCATED || entry.counter != handle.counter ) )
+      MP_THROW_EXCEPTION( skeleton_invalid_face_handle );
+    return entry.face_index;
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  void
+  mps_type::element_access< check_policy >::get_indices(
+    const face_handle* handles, size_t number_of_handles, face_index* indices ) const
+  {
+    const auto entries = m_skeleton.m_impl->m_face_handles.get();
+    const size_t prefetched = number_of_handles > access_prefetch_distance
+        ? number_of_handles - access_prefetch_distance : 0;
+    for( size_t i = 0; i < prefetched; ++ i )
+      {
+        prefetch_for_read( entries + handles[ i + access_prefetch_distance ].index );
+        indices[ i ] = get_index( handles[ i ] );
+      }
+    for( size_t i = prefetched; i < number_of_handles; ++ i )
+      indices[ i ] = get_index( handles[ i ] );
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::atom&
+  mps_type::mutable_element_access< check_policy >::get(
+    atom_handle handle ) const
+  {
+    return get_atom_by_index( this->get_index( handle ) );
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::atom&
+  mps_type::mutable_element_access< check_policy >::get_atom_by_index(
+    atom_index index ) const
+  {
+    auto& skeleton = m_mutable_skeleton;
+    if( check_policy::check_indices && index >= skeleton.m_impl->m_atoms_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_atom_index );
+    skeleton.m_atom_columns.invalidate();
+    skeleton.m_atom_bvh.invalidate_bounds();
+    if( skeleton.m_change_journal )
+      skeleton.m_change_journal->record(
+        skeleton.m_change_journal->atoms.modified_ranges, index, index + 1 );
+    return skeleton.m_impl->m_atoms[ index ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::link&
+  mps_type::mutable_element_access< check_policy >::get(
+    link_handle handle ) const
+  {
+    return m_mutable_skeleton.m_impl->m_links[ this->get_index( handle ) ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::link&
+  mps_type::mutable_element_access< check_policy >::get_link_by_index(
+    link_index index ) const
+  {
+    auto& impl = *m_mutable_skeleton.m_impl;
+    if( check_policy::check_indices && index >= impl.m_links_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_link_index );
+    return impl.m_links[ index ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::face&
+  mps_type::mutable_element_access< check_policy >::get(
+    face_handle handle ) const
+  {
+    return m_mutable_skeleton.m_impl->m_faces[ this->get_index( handle ) ];
+  }
+
+mps_template_parameters
+template< typename check_policy >
+  typename mps_type::face&
+  mps_type::mutable_element_access< check_policy >::get_face_by_index(
+    face_index index ) const
+  {
+    auto& impl = *m_mutable_skeleton.m_impl;
+    if( check_policy::check_indices && index >= impl.m_faces_size )
+      MP_THROW_EXCEPTION( skeleton_invalid_face_index );
+    return impl.m_faces[ index ];
+  }
+
+mps_template_parameters
+template< typename atom_processer >
+  void
+  mps_type::process_atoms(
+    atom_processer&& function, bool parallel )
+  {
+    parallel_options options;
+    options.parallel = parallel;
+    process_atoms( std::forward< atom_processer >( function ), options );
+  }
+
+mps_template_parameters
+template< typename atom_processer >
+  void
+  mps_type::process_atoms(
+    atom_processer&& function, const parallel_options& options )
+  {
+    process_atom_chunks(
+      [&function]( atom_index begin, atom_index end, atom* atoms )
+      {
+        for( atom_index i = begin; i < end; ++ i )
+          call_element_function( function, i, atoms[ i - begin ], 0 );
+      }, options );
+  }
+
+mps_template_parameters
+template< typename atom_chunk_processer >
+  void
+  mps_type::process_atom_chunks(
+    atom_chunk_processer&& function, const parallel_options& options )
+  {
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate_bounds();
+    if( m_change_journal )
+      m_change_journal->record( m_change_journal->atoms.modified_ranges, 0, m_impl->m_atoms_size );
+    atom* atoms = m_impl->m_atoms.get();
+    parallel_for_chunks( atom_index( 0 ), m_impl->m_atoms_size,
+      [&function, atoms]( atom_index begin, atom_index end )
+      {
+        function( begin, end, atoms + begin );
+      }, options );
+  }
+
+mps_template_parameters
+template< typename atom_processer >
+  void
+  mps_type::process_atoms(
+    atom_processer&& function, bool parallel ) const
+  {
+    parallel_options options;
+    options.parallel = parallel;
+    process_atoms( std::forward< atom_processer >( function ), options );
+  }
+
+mps_template_parameters
+template< typename atom_processer >
+  void
+  mps_type::process_atoms(
+    atom_processer&& function, const parallel_options& options ) const
+  {
+    process_atom_chunks(
+      [&function]( atom_index begin, atom_index end, const atom* atoms )
+      {
+        for( atom_index i = begin; i < end; ++ i )
+          call_element_function( function, i, atoms[ i - begin ], 0 );
+      }, options );
+  }
+
+mps_template_parameters
+template< typename atom_chunk_processer >
+  void
+  mps_type::process_atom_chunks(
+    atom_chunk_processer&& function, const parallel_options& options ) const
+  {
+    const atom* atoms = m_impl->m_atoms.get();
+    parallel_for_chunks( atom_index( 0 ), m_impl->m_atoms_size,
+      [&function, atoms]( atom_index begin, atom_index end )
+      {
+        function( begin, end, atoms + begin );
+      }, options );
+  }
+
+mps_template_parameters
 template< typename atom_filter >
   void
-  median_skeleton::remove_atoms(
-    atom_filter&& filter, bool parallel )
+  mps_type::remove_atoms(
+    atom_filter&& filter, bool parallel, bool preserve_order )
   {
     /* When an atom is removed:
      *   all its links and faces should be removed
@@ -38,19 +332,23 @@ template< typename atom_filter >
      *     buffer or in topology properties. Since a face is destroyed
      *     once one of its links is removed, this is sufficient to call
      *     that function.
-     *   it must be exchanged with the last atom A of the tight buffer
-     *     - its handle will not be valid anymore
-     *     - the handle of A need to point to the new memory
-     *     - the index to handle index of A should be updated
+     *   the remaining atoms are moved to keep the buffer tight
+     *     - this is the job of compact_atoms(...), which also releases
+     *     the handles of removed atoms and updates the handles of moved
+     *     ones.
      */
 
+    thaw();
+    m_atom_columns.invalidate();
+    m_atom_bvh.invalidate();
     const atom_index atom_size = m_impl->m_atoms_size;
     /* a flag buffer is necessary if the filter function relies on reference
      * to atoms or atom index. For example, if the filter function remove
      * atoms with indices 1 and 3, with 4 atoms in total in the buffer. When
      * atom #1 is removed, the atom #3 is move into it. Thus, when the former
      * atom #3 (now #1) is tested, the filter function will not recognize it. */
-    bool* flags = new bool[atom_size];
+    m_atom_compaction.flags.resize( atom_size );
+    uint8_t* flags = m_atom_compaction.flags.data();
     if( parallel )
       {
 # pragma omp parallel for schedule(dynamic)
@@ -68,127 +366,84 @@ template< typename atom_filter >
       }
 
       {
-        const link_index link_size = m_impl->m_links_size;
-        bool* link_flags = new bool[link_size];
-# pragma omp parallel for
-        for( link_index i = 0; i < link_size; ++i )
-          link_flags[i] = false;
+        m_link_compaction.reset( m_impl->m_links_size );
+        uint8_t* link_flags = m_link_compaction.flags.data();
 # pragma omp parallel for
         for( atom_index i = 0; i < atom_size; ++i )
           {
             if( flags[i] )
               {
                 auto& alinks =
-                    m_impl->m_atom_properties[atom_links_property_index]->get
+                    m_impl->m_atom_properties[atom_links_property_index]->template get
                         < atom_links_property > (i);
                 for( auto& alink : alinks )
                   {
-                    link_flags[m_impl->m_link_handles[alink.first.index].link_index] =
-                        true;
+# pragma omp atomic write
+                    link_flags[m_impl->m_link_handles[alink.first.index].link_index] = 1;
                   }
               }
           }
-        remove_link_indices( link_flags );
+        remove_link_indices( preserve_order );
       }
 
-    /* INVARIANT:
-     * - all atoms with indices in [[0, left[[ are not removed
-     * - all atoms with indices in [[left, right[[ need to be checked
-     * - all atoms with indices in [[right, size[[ should be cleaned (all
-     * objects referring to an atom should be destroyed)
-     * Thus, in the end (i.e. when left == right ), we have:
-     * - atoms with indices in [[0,left[[ are clean and tight
-     * - atoms with indices in [[left, size[[ should be cleaned
-     * - left is the new size of atoms
-     */
-    atom_index next_free_slot = m_impl->m_atoms_next_free_handle_slot;
-    atom_index left = 0, right = atom_size;
-    while( left < right )
-      {
-        if( flags[left] )
-          {
-            // update the left_entry
-            const auto left_entry_index = m_impl->m_atom_index_to_handle_index[left];
-            auto& left_entry = m_impl->m_atom_handles[left_entry_index];
-            left_entry.next_free_index = next_free_slot;
-            left_entry.status = datastructure::STATUS_FREE;
-            next_free_slot = left_entry_index;
-
-            // look for a valid atom in the end of the buffer
-            --right;
-            while( left < right && flags[right] )
-              {
-                const auto entry_index =
-                    m_impl->m_atom_index_to_handle_index[right];
-                auto& entry = m_impl->m_atom_handles[entry_index];
-                entry.next_free_index = next_free_slot;
-                entry.status = datastructure::STATUS_FREE;
-                next_free_slot = entry_index;
-                --right;
-              }
-
-            if( left != right )
-              {
-                // move the last atom into this one to keep the buffer tight
-                m_impl->m_atoms[left] = std::move( m_impl->m_atoms[right] );
-                for( auto& property : m_impl->m_atom_properties )
-                  property->move( right, left );
-
-                const auto right_entry_index =
-                    m_impl->m_atom_index_to_handle_index[right];
-                auto& right_entry = m_impl->m_atom_handles[right_entry_index];
-                right_entry.atom_index = left;
-                m_impl->m_atom_index_to_handle_index[left] = right_entry_index;
-                ++left;
-              }
-          }
-        else
-          ++left;
-      }
-    delete[] flags;
-
-    // destroy properties of atoms in [[left, size[[
-    for( auto& property : m_impl->m_atom_properties )
-      property->destroy( left, atom_size );
-
-    m_impl->m_atoms_size = left;
-    m_impl->m_atoms_next_free_handle_slot = next_free_slot;
+    m_atom_compaction.build( preserve_order );
+    m_impl->compact_atoms( m_atom_compaction );
   }
 
+mps_template_parameters
 template< typename link_processer >
 void
-median_skeleton::process_links(
+mps_type::process_links(
   link_processer&& function, bool parallel )
 {
-  if( parallel )
+  parallel_options options;
+  options.parallel = parallel;
+  process_links( std::forward< link_processer >( function ), options );
+}
+
+mps_template_parameters
+template< typename link_processer >
+void
+mps_type::process_links(
+  link_processer&& function, const parallel_options& options )
+{
+  process_link_chunks(
+    [&function]( link_index begin, link_index end, link* links )
     {
-# pragma omp parallel for schedule(dynamic)
-      for( link_index i = 0; i < m_impl->m_links_size; ++i )
-        {
-          function( m_impl->m_links[i] );
-        }
-    }
-  else
+      for( link_index i = begin; i < end; ++ i )
+        call_element_function( function, i, links[ i - begin ], 0 );
+    }, options );
+}
+
+mps_template_parameters
+template< typename link_chunk_processer >
+void
+mps_type::process_link_chunks(
+  link_chunk_processer&& function, const parallel_options& options )
+{
+  link* links = m_impl->m_links.get();
+  parallel_for_chunks( link_index( 0 ), m_impl->m_links_size,
+    [&function, links]( link_index begin, link_index end )
     {
-      for( link_index i = 0; i < m_impl->m_links_size; ++i )
-        {
-          function( m_impl->m_links[i] );
-        }
-    }
+      function( begin, end, links + begin );
+    }, options );
 }
 
+mps_template_parameters
 template< typename link_filter >
 void
-median_skeleton::remove_links(
-  link_filter&& filter, bool parallel )
+mps_type::remove_links(
+  link_filter&& filter, bool parallel, bool preserve_order )
 {
+  thaw();
   const link_index size = m_impl->m_links_size;
   /* a flag buffer is necessary if the filter function relies on reference
    * to links or link index. For example, if the filter function remove
    * links with indices 1 and 3, with 4 links in total in the buffer. When
    * link #1 is removed, the link #3 is move into it. Thus, when the former
    * link #3 (now #1) is tested, the filter function will not recognize it. */
-  bool* flags = new bool[size];
+  m_link_compaction.flags.resize( size );
+  uint8_t* flags = m_link_compaction.flags.data();
   if( parallel )
     {
 # pragma omp parallel for schedule(dynamic)
@@ -205,43 +460,63 @@ median_skeleton::remove_links(
         }
     }
 
-  remove_link_indices( flags );
+  remove_link_indices( preserve_order );
 }
 
+mps_template_parameters
 template< typename face_processer >
 void
-median_skeleton::process_faces(
+mps_type::process_faces(
   face_processer&& function, bool parallel )
 {
-  if( parallel )
+  parallel_options options;
+  options.parallel = parallel;
+  process_faces( std::forward< face_processer >( function ), options );
+}
+
+mps_template_parameters
+template< typename face_processer >
+void
+mps_type::process_faces(
+  face_processer&& function, const parallel_options& options )
+{
+  process_face_chunks(
+    [&function]( face_index begin, face_index end, face* faces )
     {
-# pragma omp parallel for schedule(dynamic)
-      for( face_index i = 0; i < m_impl->m_faces_size; ++i )
-        {
-          function( m_impl->m_faces[i] );
-        }
-    }
-  else
+      for( face_index i = begin; i < end; ++ i )
+        call_element_function( function, i, faces[ i - begin ], 0 );
+    }, options );
+}
+
+mps_template_parameters
+template< typename face_chunk_processer >
+void
+mps_type::process_face_chunks(
+  face_chunk_processer&& function, const parallel_options& options )
+{
+  face* faces = m_impl->m_faces.get();
+  parallel_for_chunks( face_index( 0 ), m_impl->m_faces_size,
+    [&function, faces]( face_index begin, face_index end )
     {
-      for( face_index i = 0; i < m_impl->m_faces_size; ++i )
-        {
-          function( m_impl->m_faces[i] );
-        }
-    }
+      function( begin, end, faces + begin );
+    }, options );
 }
 
+mps_template_parameters
 template< typename face_filter >
 void
-median_skeleton::remove_faces(
-  face_filter&& filter, bool parallel )
+mps_type::remove_faces(
+  face_filter&& filter, bool parallel, bool preserve_order )
 {
+  thaw();
   const face_index size = m_impl->m_faces_size;
   /* a flag buffer is necessary if the filter function relies on reference
    * to faces or face index. For example, if the filter function remove
    * faces with indices 1 and 3, with 4 faces in total in the buffer. When
    * face #1 is removed, the face #3 is move into it. Thus, when the former
    * face #3 (now #1) is tested, the filter function will not recognize it. */
-  bool* flags = new bool[size];
+  m_face_compaction.flags.resize( size );
+  uint8_t* flags = m_face_compaction.flags.data();
   if( parallel )
     {
 # pragma omp parallel for schedule(dynamic)
@@ -258,23 +533,91 @@ median_skeleton::remove_faces(
         }
     }
 
-  remove_faces_indices( flags );
+  remove_faces_indices( preserve_order );
 }
 
+mps_template_parameters
 template< typename atom_property >
-base_property_buffer& median_skeleton::add_atom_property( const std::string& name )
+base_property_buffer& mps_type::add_atom_property( const std::string& name,
+  base_property_buffer::storage_type storage )
 {
-  return *m_impl->add_atom_property<atom_property>( name );
+  return *m_impl->template add_atom_property<atom_property>( name, storage );
 }
+mps_template_parameters
 template< typename link_property >
-base_property_buffer& median_skeleton::add_link_property( const std::string& name )
+base_property_buffer& mps_type::add_link_property( const std::string& name,
+  base_property_buffer::storage_type storage )
 {
-  return *m_impl->add_link_property<link_property>( name );
+  return *m_impl->template add_link_property<link_property>( name, storage );
 }
+mps_template_parameters
 template< typename face_property >
-base_property_buffer& median_skeleton::add_face_property( const std::string& name )
+base_property_buffer& mps_type::add_face_property( const std::string& name,
+  base_property_buffer::storage_type storage )
+{
+  return *m_impl->template add_face_property<face_property>( name, storage );
+}
+
+mps_template_parameters
+template< typename other_profile >
+mps_type::basic_median_skeleton(
+  const basic_median_skeleton< other_profile >& other )
+  : basic_median_skeleton{}
+{
+  assign( other );
+}
+
+mps_template_parameters
+template< typename other_profile >
+void
+mps_type::assign(
+  const basic_median_skeleton< other_profile >& other )
 {
-  return *m_impl->add_face_property<face_property>( name );
+  typedef typename basic_median_skeleton< other_profile >::atom other_atom;
+  const auto natoms = other.get_number_of_atoms();
+  const auto nlinks = other.get_number_of_links();
+  const auto nfaces = other.get_number_of_faces();
+  clear( natoms, nlinks, nfaces );
+  set_atom_layout( other.get_atom_layout() == other.structure_of_arrays
+    ? structure_of_arrays : array_of_structures );
+
+  // handles are created in order, such that atoms keep their indices
+  for( size_t i = 0; i < natoms; ++ i )
+    m_impl->create_atom();
+  const other_atom* source = other.m_impl->m_atoms.get();
+  atom* target = m_impl->m_atoms.get();
+# pragma omp parallel for
+  for( size_t i = 0; i < natoms; ++ i )
+    {
+      const other_atom& a = source[ i ];
+      target[ i ] = atom{ vec3{ a.x, a.y, a.z }, real( a.w ) };
+    }
+
+  std::vector< std::pair< atom_index, atom_index > > links( nlinks );
+  // handles of a valid skeleton need no check
+  const auto other_access = other.unchecked();
+# pragma omp parallel for
+  for( size_t i = 0; i < nlinks; ++ i )
+    {
+      const auto& l = other_access.get_link_by_index( i );
+      links[ i ].first  = other_access.get_index( l.h1 );
+      links[ i ].second = other_access.get_index( l.h2 );
+    }
+  add_links( links );
+
+  std::vector< std::array< atom_index, 3 > > faces( nfaces );
+# pragma omp parallel for
+  for( size_t i = 0; i < nfaces; ++ i )
+    {
+      const auto& f = other_access.get_face_by_index( i );
+      faces[ i ][ 0 ] = other_access.get_index( f.atoms[ 0 ] );
+      faces[ i ][ 1 ] = other_access.get_index( f.atoms[ 1 ] );
+      faces[ i ][ 2 ] = other_access.get_index( f.atoms[ 2 ] );
+    }
+  add_faces( faces );
 }
 
 }
+# undef mps_template_parameters
+# undef mps_type
+# undef mps_definition
@@ -10,7 +10,9 @@
 # include <graphics-origin/tools/filesystem.h>
 # include <graphics-origin/tools/log.h>
 
+# include <array>
 # include <iomanip>
+# include <sstream>
 
 BEGIN_MP_NAMESPACE
   namespace io {
@@ -23,13 +25,24 @@ BEGIN_MP_NAMESPACE
       {
         return graphics_origin::tools::get_extension( filename ) == moff_format_extension;
       }
-      bool save( median_skeleton& skeleton, const std::string& filename ) override
+      bool save( const median_skeleton& skeleton, const std::string& filename ) override
+      {
+        return save_skeleton( skeleton, filename );
+      }
+
+      bool save( const large_median_skeleton& skeleton, const std::string& filename ) override
+      {
+        return save_skeleton( skeleton, filename );
+      }
+
+      template< typename skeleton_type >
+      bool save_skeleton( const skeleton_type& skeleton, const std::string& filename )
       {
         std::ofstream output( filename );
 
         output << "MOFF " << skeleton.get_number_of_atoms() << " " << skeleton.get_number_of_faces() << "\n";
         output.precision( 10 );
-        skeleton.process_atoms( [&output]( median_skeleton::atom& atom )
+        skeleton.process_atoms( [&output]( const typename skeleton_type::atom& atom )
           {
             output << std::setw( 13 ) << atom.x << " "
                    << std::setw( 13 ) << atom.y << " "
@@ -38,13 +51,12 @@ BEGIN_MP_NAMESPACE
           }
         , false );
 
-        skeleton.process_faces( [&output,&skeleton]( median_skeleton::face& face )
+        process_face_atom_indices( skeleton,
+          [&output]( typename skeleton_type::atom_index i1, typename skeleton_type::atom_index i2,
+                     typename skeleton_type::atom_index i3 )
           {
-            output << "3 " << skeleton.get_index( face.atoms[0] ) << " "
-                << skeleton.get_index( face.atoms[1] ) << " "
-                << skeleton.get_index( face.atoms[2] ) << "\n";
-          }
-        , false );
+            output << "3 " << i1 << " " << i2 << " " << i3 << "\n";
+          } );
 
         output.close();
         return true;
@@ -59,134 +71,205 @@ BEGIN_MP_NAMESPACE
       }
       bool load( median_skeleton& skeleton, const std::string& filename ) override
       {
-        std::ifstream input( filename );
-        size_t lnumber = 0;
+        return load_skeleton( skeleton, filename );
+      }
+
+      bool load( large_median_skeleton& skeleton, const std::string& filename ) override
+      {
+        return load_skeleton( skeleton, filename );
+      }
 
+      template< typename skeleton_type >
+      bool load_skeleton( skeleton_type& skeleton, const std::string& filename )
+      {
         bool result = true;
-        if( !read_header( input, lnumber, skeleton )
-          ||!read_atoms( input, lnumber, skeleton )
-          ||!read_faces( input, lnumber, skeleton ))
+        mapped_file file( filename );
+        if( !file.is_open() )
+          {
+            LOG( error, "cannot read MOFF file [" << filename << "]");
+            result = false;
+          }
+        else
+          {
+            const char* cursor = file.data();
+            size_t lnumber = 0;
+            typename skeleton_type::atom_index natoms = 0;
+            typename skeleton_type::face_index nfaces = 0;
+            result = read_header( cursor, file.data() + file.size(), lnumber, natoms, nfaces )
+                  && read_elements( skeleton, cursor, file.data() + file.size(), lnumber, natoms, nfaces );
+          }
+        if( !result )
           {
             skeleton.clear(0,0,0);
             LOG( error, "failed to load skeleton from MOFF file [" << filename << "]");
-            result = false;
           }
-        input.close();
         return result;
       }
 
-      bool read_header( std::ifstream& input, size_t& lnumber, median_skeleton& skeleton )
+      /* the scale at the end of the header is optional, as the saver does
+       * not write it */
+      template< typename atom_index, typename face_index >
+      bool read_header( const char*& cursor, const char* end, size_t& lnumber,
+        atom_index& natoms, face_index& nfaces )
       {
-        std::string header_line;
-        if( !get_next_relevant_line( input, lnumber, header_line ) )
+        const char* line_begin = nullptr;
+        const char* line_end = nullptr;
+        if( !get_next_relevant_line( cursor, end, lnumber, line_begin, line_end ) )
           return false;
 
-        std::istringstream tokenizer( header_line );
-        std::string magic_word;
+        const char* token = line_begin;
+        skip_blanks( token, line_end );
+        const char* magic_end = get_token_end( token, line_end );
+        const std::string magic_word( token, magic_end );
+        token = magic_end;
         real scale = 0;
-        median_skeleton::atom_index natoms = 0;
-        median_skeleton::face_index nfaces = 0;
-
-        tokenizer >> magic_word >> natoms >> nfaces >> scale;
-        if( tokenizer.fail() )
+        if( !parse_integer( token, line_end, natoms ) || !parse_integer( token, line_end, nfaces )
+          || ( skip_blanks( token, line_end ), token != line_end && !parse_real( token, line_end, scale ) ) )
           {
-            LOG( error, "line " << lnumber << " \"" << header_line << "\" is not a valid MOFF header");
+            LOG( error, "line " << lnumber << " \"" << std::string( line_begin, line_end ) << "\" is not a valid MOFF header");
             return false;
           }
         if( magic_word != "MOFF" )
           {
-            LOG( error, "wrong magic word in MOFF header at line " << lnumber << " \"" << header_line << "\"");
+            LOG( error, "wrong magic word in MOFF header at line " << lnumber << " \"" << std::string( line_begin, line_end ) << "\"");
             return false;
           }
-        skeleton.clear( natoms, natoms * 3, nfaces );
         return true;
       }
 
-      bool read_atoms( std::ifstream& input, size_t& lnumber, median_skeleton& skeleton )
+      /* The file is split into chunks of lines. The relevant lines of each
+       * chunk are counted in parallel, prefix sums of those counts give the
+       * index of the first relevant line of each chunk, i.e. whether it
+       * describes an atom or a face, then the chunks are parsed in parallel.
+       * Each chunk converts its polygons into links and triangles, which are
+       * added in bulk in the order of the file. */
+      template< typename skeleton_type >
+      bool read_elements( skeleton_type& skeleton, const char* cursor, const char* end, size_t lnumber,
+        typename skeleton_type::atom_index natoms, typename skeleton_type::face_index nfaces )
       {
-        auto natoms = skeleton.get_atoms_capacity();
-        std::string vertex_string;
-        vec4 ball;
-        for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+        typedef typename skeleton_type::atom_index atom_index;
+        const auto chunks = split_text( cursor, end, lnumber );
+        const size_t nchunks = chunks.size();
+        std::vector< size_t > offsets( nchunks + 1, 0 );
+        # pragma omp parallel for
+        for( size_t c = 0; c < nchunks; ++ c )
           {
-            if( !get_next_relevant_line( input, lnumber, vertex_string ) )
-              {
-                LOG( error, "failed to get a relevant line for atom #" << i );
-                return false;
-              }
-            std::istringstream tokenizer( vertex_string );
-            tokenizer >> ball.x >> ball.y >> ball.z >> ball.w;
-            if( tokenizer.fail() )
-              {
-                LOG( error, "something went wrong at line " << lnumber << " when reading atom #" << i << " from \"" << vertex_string << "\"");
-                return false;
-              }
-            skeleton.add( ball );
+            const char* chunk_cursor = chunks[ c ].begin;
+            const char* line_begin = nullptr;
+            const char* line_end = nullptr;
+            size_t line_number = chunks[ c ].line_number;
+            size_t count = 0;
+            while( get_next_relevant_line( chunk_cursor, chunks[ c ].end, line_number, line_begin, line_end ) )
+              ++count;
+            offsets[ c + 1 ] = count;
           }
-        return true;
-      }
+        for( size_t c = 0; c < nchunks; ++ c )
+          offsets[ c + 1 ] += offsets[ c ];
 
-      bool read_faces( std::ifstream& input, size_t& lnumber, median_skeleton& skeleton )
-      {
-        auto nfaces = skeleton.get_faces_capacity();
-        std::string face_string;
-        std::vector< median_skeleton::atom_index > indices;
-        median_skeleton::atom_index number_of_indices = 0;
-
-        for( median_skeleton::face_index i = 0; i < nfaces; ++ i )
+        const size_t nlines = size_t( natoms ) + size_t( nfaces );
+        if( offsets[ nchunks ] < nlines )
           {
-            indices.clear();
-            number_of_indices = 0;
-
-            if( !get_next_relevant_line( input, lnumber, face_string ) )
-              {
-                LOG( error, "failed to get a relevant line for face #" << i );
-                return false;
-              }
-
-            std::istringstream tokenizer( face_string );
-            tokenizer >> number_of_indices;
-            indices.resize( number_of_indices );
-            for( median_skeleton::atom_index j = 0; j < number_of_indices ; ++ j )
-              {
-                tokenizer >> indices[ j ];
-              }
+            if( offsets[ nchunks ] < natoms )
+              LOG( error, "failed to get a relevant line for atom #" << offsets[ nchunks ] );
+            else
+              LOG( error, "failed to get a relevant line for face #" << offsets[ nchunks ] - natoms );
+            return false;
+          }
 
-            if( tokenizer.fail() )
-              {
-                LOG( error, "something went wrong at line " << lnumber
-                     << " when reading face #" << i << " from \""
-                     << face_string << "\"");
-                return false;
-              }
-            if( number_of_indices > 1 )
+        std::vector< vec4 > balls( natoms );
+        std::vector< std::vector< std::pair< atom_index, atom_index > > > chunk_links( nchunks );
+        std::vector< std::vector< std::array< atom_index, 3 > > > chunk_faces( nchunks );
+        size_t error_line = std::numeric_limits< size_t >::max();
+        std::string error_message;
+        # pragma omp parallel for schedule(dynamic)
+        for( size_t c = 0; c < nchunks; ++ c )
+          {
+            const char* chunk_cursor = chunks[ c ].begin;
+            const char* line_begin = nullptr;
+            const char* line_end = nullptr;
+            size_t line_number = chunks[ c ].line_number;
+            std::vector< atom_index > indices;
+            auto& links = chunk_links[ c ];
+            auto& faces = chunk_faces[ c ];
+            std::ostringstream error;
+            for( size_t i = offsets[ c ]; i < nlines
+                && get_next_relevant_line( chunk_cursor, chunks[ c ].end, line_number, line_begin, line_end ); ++ i )
               {
-                auto last_index = indices.back();
-                if( last_index >= skeleton.get_number_of_atoms() )
+                const char* token = line_begin;
+                if( i < natoms )
                   {
-                    LOG( error, "wrong atom index " << last_index << " at line "
-                        << lnumber << " when reading face #" << i << " from \""
-                        << face_string << "\"");
-                    return false;
+                    vec4& ball = balls[ i ];
+                    if( !parse_real( token, line_end, ball.x ) || !parse_real( token, line_end, ball.y )
+                      ||!parse_real( token, line_end, ball.z ) || !parse_real( token, line_end, ball.w ) )
+                      error << "something went wrong at line " << line_number << " when reading atom #" << i
+                            << " from \"" << std::string( line_begin, line_end ) << "\"";
                   }
-                auto force_index = last_index;
-                for( auto& current_index: indices )
+                else if( !read_face( token, line_end, natoms, indices, links, faces ) )
+                  error << "something went wrong at line " << line_number << " when reading face #" << i - natoms
+                        << " from \"" << std::string( line_begin, line_end ) << "\"";
+                if( error.tellp() > 0 )
                   {
-                    if( current_index >= skeleton.get_number_of_atoms() )
-                      {
-                        LOG( error, "wrong atom index " << current_index << " at line "
-                            << lnumber << " when reading face #" << i << " from \""
-                            << face_string << "\"");
-                        return false;
-                      }
-                    skeleton.add( current_index, last_index );
-                    if( current_index != force_index && last_index != force_index )
+                    # pragma omp critical
+                    if( line_number < error_line )
                       {
-                        skeleton.add( current_index, force_index );
-                        skeleton.add( current_index, force_index, last_index );
+                        error_line = line_number;
+                        error_message = error.str();
                       }
-                    last_index = current_index;
+                    break;
+                  }
+              }
+          }
+        if( error_line != std::numeric_limits< size_t >::max() )
+          {
+            LOG( error, error_message );
+            return false;
+          }
+
+        std::vector< std::pair< atom_index, atom_index > > links;
+        std::vector< std::array< atom_index, 3 > > faces;
+        for( size_t c = 0; c < nchunks; ++ c )
+          {
+            links.insert( links.end(), chunk_links[ c ].begin(), chunk_links[ c ].end() );
+            faces.insert( faces.end(), chunk_faces[ c ].begin(), chunk_faces[ c ].end() );
+            chunk_links[ c ] = std::vector< std::pair< atom_index, atom_index > >();
+            chunk_faces[ c ] = std::vector< std::array< atom_index, 3 > >();
+          }
+
+        skeleton.clear( natoms, natoms * 3, nfaces );
+        skeleton.add_atoms( balls.data(), natoms );
+        skeleton.add_links( links );
+        skeleton.add_faces( faces );
+        return true;
+      }
+
+      /* a polygon is triangulated as a fan around its last atom */
+      template< typename atom_index >
+      bool read_face( const char* token, const char* line_end, atom_index natoms,
+        std::vector< atom_index >& indices,
+        std::vector< std::pair< atom_index, atom_index > >& links,
+        std::vector< std::array< atom_index, 3 > >& faces )
+      {
+        atom_index number_of_indices = 0;
+        if( !parse_integer( token, line_end, number_of_indices )
+          || size_t( number_of_indices ) > size_t( line_end - token ) )
+          return false;
+        indices.resize( number_of_indices );
+        for( auto& index : indices )
+          if( !parse_integer( token, line_end, index ) || index >= natoms )
+            return false;
+        if( number_of_indices > 1 )
+          {
+            auto last_index = indices.back();
+            const auto force_index = last_index;
+            for( auto current_index : indices )
+              {
+                links.push_back( std::make_pair( current_index, last_index ) );
+                if( current_index != force_index && last_index != force_index )
+                  {
+                    links.push_back( std::make_pair( current_index, force_index ) );
+                    faces.push_back( {{ current_index, force_index, last_index }} );
                   }
+                last_index = current_index;
               }
           }
         return true;
@@ -0,0 +1,453 @@
+# ifndef MEDIAN_PATH_MPACK_FORMAT_H_
+# define MEDIAN_PATH_MPACK_FORMAT_H_
+
+# include "../io.h"
+# include "io_utilities.h"
+# include "entropy_coding.h"
+# include "parallel_algorithms.h"
+# include "space_filling_curves.h"
+
+# include <graphics-origin/tools/filesystem.h>
+# include <graphics-origin/tools/log.h>
+
+# include <algorithm>
+# include <array>
+# include <cmath>
+# include <cstdio>
+# include <cstring>
+# include <limits>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+namespace io {
+
+  static const std::string mpack_format_extension = ".mpack";
+
+  /* A .mpack file is a compact and lossy archive of the atoms and of the
+   * topology of a skeleton, without properties:
+   * - a header of 128 bytes (mpack_header), giving the numbers of elements,
+   * the number of bits of quantization and the range of each quantized
+   * component,
+   * - the blocks of atoms, then the blocks of links and the blocks of faces.
+   *
+   * Atoms are sorted along a Hilbert curve. Their coordinates and radii are
+   * quantized on quantization_bits bits relatively to their range, and
+   * consecutive atoms are delta coded. Links and faces use the new atom
+   * indices: links are stored as their smallest atom index, sorted and delta
+   * coded, and the difference to their other atom index. Faces are rotated
+   * to start with their smallest atom index, then coded in the same way.
+   * Only the links without faces are stored, the others being created with
+   * the faces when the archive is loaded.
+   *
+   * Each block codes up to mpack_block_size consecutive elements, deltas
+   * starting from zero in each block. A block is its size in bytes (four
+   * bytes) followed by one rANS compressed stream of the zigzag varints of
+   * its elements, component after component, such that a decoding table is
+   * built once per block. Blocks are thus encoded and decoded in parallel. */
+  static const char mpack_magic[ 8 ] = { 'M', 'P', 'A', 'C', 'K', '\r', '\n', '\x1a' };
+  static constexpr uint32_t mpack_version = 2;
+  static constexpr size_t mpack_block_size = size_t(1) << 16;
+
+  struct mpack_header {
+    char magic[ 8 ];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t quantization_bits;
+    uint32_t reserved_flags;
+    uint64_t number_of_atoms;
+    uint64_t number_of_links;
+    uint64_t number_of_faces;
+    uint64_t number_of_stored_links;
+    /* minimum and extent of x, y, z and radii */
+    double minimum[ 4 ];
+    double extent[ 4 ];
+    uint64_t reserved;
+  };
+  static_assert( sizeof( mpack_header ) == 128, "unexpected size of .mpack header" );
+
+  /* encode the elements [begin, end[ of an array of n components per
+   * element in one block. The first delta_components components are delta
+   * coded, the others being already small. */
+  template< size_t n, typename value_type >
+  void encode_mpack_block( const std::array< value_type, n >* elements, size_t begin, size_t end,
+    size_t delta_components, std::vector< uint8_t >& block )
+  {
+    block.assign( 4, 0 );
+    std::vector< uint8_t > stream;
+    for( size_t c = 0; c < n; ++ c )
+      {
+        int64_t previous = 0;
+        for( size_t i = begin; i < end; ++ i )
+          {
+            const int64_t value = int64_t( elements[ i ][ c ] );
+            write_varint( stream, zigzag_encode( value - previous ) );
+            if( c < delta_components )
+              previous = value;
+          }
+      }
+    rans_compress( stream.data(), stream.size(), block );
+    const uint32_t size = uint32_t( block.size() - 4 );
+    for( int b = 0; b < 4; ++ b )
+      block[ b ] = uint8_t( size >> ( 8 * b ) );
+  }
+
+  /* decode a block of count elements encoded by encode_mpack_block. The
+   * stream has at most one varint per component of each element. */
+  template< size_t n, typename value_type >
+  bool decode_mpack_block( const uint8_t* data, const uint8_t* end, size_t count,
+    size_t delta_components, std::array< value_type, n >* elements )
+  {
+    std::vector< uint8_t > stream;
+    if( !rans_decompress( data, end, n * count * max_varint_bytes, stream ) )
+      return false;
+    const uint8_t* cursor = stream.data();
+    const uint8_t* const stream_end = cursor + stream.size();
+    for( size_t c = 0; c < n; ++ c )
+      {
+        int64_t value = 0;
+        for( size_t i = 0; i < count; ++ i )
+          {
+            uint64_t delta;
+            if( !read_varint( cursor, stream_end, delta ) )
+              return false;
+            value = ( c < delta_components ? value : 0 ) + zigzag_decode( delta );
+            elements[ i ][ c ] = value_type( value );
+          }
+      }
+    return cursor == stream_end && data == end;
+  }
+
+  struct mpack_saver
+    : public saver {
+    bool can_save_to( const std::string& filename ) override
+    {
+      return graphics_origin::tools::get_extension( filename ) == mpack_format_extension;
+    }
+    bool save( const median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    bool save( const large_median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    template< typename skeleton_type >
+    bool save_skeleton( const skeleton_type& skeleton, const std::string& filename )
+    {
+      typedef typename skeleton_type::atom_index atom_index;
+      const auto access = skeleton.unchecked();
+      const size_t natoms = skeleton.get_number_of_atoms();
+
+      mpack_header header;
+      std::memset( &header, 0, sizeof( header ) );
+      std::memcpy( header.magic, mpack_magic, sizeof( mpack_magic ) );
+      header.version = mpack_version;
+      header.header_size = sizeof( mpack_header );
+      header.quantization_bits = get_archive_quantization_bits();
+      header.number_of_atoms = natoms;
+      header.number_of_links = skeleton.get_number_of_links();
+      header.number_of_faces = skeleton.get_number_of_faces();
+
+      // range of each component
+      double minimum[ 4 ], maximum[ 4 ];
+      for( int c = 0; c < 4; ++ c )
+        {
+          minimum[ c ] = natoms ? std::numeric_limits< double >::max() : 0;
+          maximum[ c ] = natoms ? std::numeric_limits< double >::lowest() : 0;
+        }
+      for( size_t i = 0; i < natoms; ++ i )
+        {
+          const auto& a = access.get_atom_by_index( atom_index( i ) );
+          for( int c = 0; c < 4; ++ c )
+            {
+              minimum[ c ] = std::min( minimum[ c ], double( a[ c ] ) );
+              maximum[ c ] = std::max( maximum[ c ], double( a[ c ] ) );
+            }
+        }
+      for( int c = 0; c < 4; ++ c )
+        {
+          header.minimum[ c ] = minimum[ c ];
+          header.extent[ c ] = maximum[ c ] - minimum[ c ];
+        }
+
+      /* atoms along a Hilbert curve of their bounding cube: sources gives
+       * the former index of each new index and targets the new index of
+       * each former index */
+      std::vector< atom_index > sources( natoms ), targets( natoms );
+      {
+        const double cube = std::max( std::max( header.extent[ 0 ], header.extent[ 1 ] ), header.extent[ 2 ] );
+        const double inverse_cube = cube > 0 ? 1.0 / cube : 0.0;
+        std::vector< std::pair< uint64_t, atom_index > > keys( natoms );
+        # pragma omp parallel for
+        for( size_t i = 0; i < natoms; ++ i )
+          {
+            const auto& a = access.get_atom_by_index( atom_index( i ) );
+            keys[ i ].first = hilbert_code(
+              real( ( a.x - minimum[ 0 ] ) * inverse_cube ),
+              real( ( a.y - minimum[ 1 ] ) * inverse_cube ),
+              real( ( a.z - minimum[ 2 ] ) * inverse_cube ) );
+            keys[ i ].second = atom_index( i );
+          }
+        parallel_sort( keys.begin(), keys.end() );
+        # pragma omp parallel for
+        for( size_t i = 0; i < natoms; ++ i )
+          {
+            sources[ i ] = keys[ i ].second;
+            targets[ keys[ i ].second ] = atom_index( i );
+          }
+      }
+
+      std::vector< std::array< uint32_t, 4 > > atoms( natoms );
+      {
+        const double max_value = double( ( uint64_t(1) << header.quantization_bits ) - 1 );
+        double scales[ 4 ];
+        for( int c = 0; c < 4; ++ c )
+          scales[ c ] = header.extent[ c ] > 0 ? max_value / header.extent[ c ] : 0.0;
+        # pragma omp parallel for
+        for( size_t i = 0; i < natoms; ++ i )
+          {
+            const auto& a = access.get_atom_by_index( sources[ i ] );
+            for( int c = 0; c < 4; ++ c )
+              atoms[ i ][ c ] = uint32_t( std::min( max_value,
+                std::floor( ( double( a[ c ] ) - minimum[ c ] ) * scales[ c ] + 0.5 ) ) );
+          }
+      }
+
+      std::vector< std::array< uint64_t, 2 > > links;
+      typename skeleton_type::link_index link = 0;
+      process_link_atom_indices( skeleton,
+        [&]( atom_index i1, atom_index i2 )
+        {
+          if( !skeleton.get_number_of_faces( link ++ ) )
+            {
+              const uint64_t a = targets[ i1 ], b = targets[ i2 ];
+              links.push_back( {{ std::min( a, b ), std::max( a, b ) }} );
+            }
+        } );
+      header.number_of_stored_links = links.size();
+      parallel_sort( links.begin(), links.end() );
+      for( auto& l : links )
+        l[ 1 ] -= l[ 0 ];
+
+      std::vector< std::array< uint64_t, 3 > > faces;
+      faces.reserve( header.number_of_faces );
+      process_face_atom_indices( skeleton,
+        [&]( atom_index i1, atom_index i2, atom_index i3 )
+        {
+          std::array< uint64_t, 3 > f = {{ targets[ i1 ], targets[ i2 ], targets[ i3 ] }};
+          std::rotate( f.begin(), std::min_element( f.begin(), f.end() ), f.end() );
+          faces.push_back( f );
+        } );
+      parallel_sort( faces.begin(), faces.end() );
+      for( auto& f : faces )
+        {
+          f[ 1 ] -= f[ 0 ];
+          f[ 2 ] -= f[ 0 ];
+        }
+
+      std::FILE* pfile = std::fopen( filename.c_str(), "wb" );
+      if( !pfile )
+        {
+          LOG( error, "cannot open MPACK file [" << filename << "] for writing");
+          return false;
+        }
+      std::fwrite( &header, sizeof( header ), 1, pfile );
+      write_blocks( atoms, 4, pfile );
+      write_blocks( links, 1, pfile );
+      write_blocks( faces, 1, pfile );
+
+      const bool result = !std::ferror( pfile );
+      if( std::fclose( pfile ) || !result )
+        {
+          LOG( error, "failed to write skeleton to MPACK file [" << filename << "]");
+          return false;
+        }
+      return true;
+    }
+
+  private:
+    template< size_t n, typename value_type >
+    static void write_blocks( const std::vector< std::array< value_type, n > >& elements,
+      size_t delta_components, std::FILE* pfile )
+    {
+      const size_t nblocks = ( elements.size() + mpack_block_size - 1 ) / mpack_block_size;
+      std::vector< std::vector< uint8_t > > blocks( nblocks );
+      # pragma omp parallel for schedule(dynamic)
+      for( size_t b = 0; b < nblocks; ++ b )
+        encode_mpack_block( elements.data(), b * mpack_block_size,
+          std::min( elements.size(), ( b + 1 ) * mpack_block_size ), delta_components, blocks[ b ] );
+      for( const auto& block : blocks )
+        std::fwrite( block.data(), 1, block.size(), pfile );
+    }
+  };
+
+  struct mpack_loader
+    : public loader {
+    bool can_load_from( const std::string& filename ) override
+    {
+      return graphics_origin::tools::get_extension( filename ) == mpack_format_extension;
+    }
+    bool load( median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    bool load( large_median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    template< typename skeleton_type >
+    bool load_skeleton( skeleton_type& skeleton, const std::string& filename )
+    {
+      mapped_file file( filename );
+      if( !file.is_open() || file.size() < sizeof( mpack_header ) )
+        {
+          LOG( error, "cannot map MPACK file [" << filename << "] or the file is too small");
+          return false;
+        }
+
+      bool result = false;
+      try
+        {
+          result = read_skeleton( skeleton, reinterpret_cast< const uint8_t* >( file.data() ), file.size() );
+        }
+      catch( const std::exception& e )
+        {
+          LOG( error, e.what() );
+          result = false;
+        }
+
+      if( !result )
+        {
+          skeleton.clear( 0, 0, 0 );
+          LOG( error, "failed to load skeleton from MPACK file [" << filename << "]");
+        }
+      return result;
+    }
+
+  private:
+    template< typename skeleton_type >
+    static bool read_skeleton( skeleton_type& skeleton, const uint8_t* data, size_t size )
+    {
+      typedef typename skeleton_type::atom_index atom_index;
+      typedef typename skeleton_type::link_index link_index;
+      typedef typename skeleton_type::face_index face_index;
+
+      mpack_header header;
+      std::memcpy( &header, data, sizeof( header ) );
+      if( std::memcmp( header.magic, mpack_magic, sizeof( mpack_magic ) ) )
+        {
+          LOG( error, "wrong magic word in MPACK header");
+          return false;
+        }
+      if( header.version != mpack_version || header.header_size < sizeof( mpack_header )
+          || header.header_size > size || !header.quantization_bits || header.quantization_bits > 32 )
+        {
+          LOG( error, "unsupported MPACK header (version " << header.version << ")");
+          return false;
+        }
+      if( header.number_of_atoms > std::numeric_limits< atom_index >::max()
+          || header.number_of_links > std::numeric_limits< link_index >::max()
+          || header.number_of_faces > std::numeric_limits< face_index >::max()
+          || header.number_of_stored_links > header.number_of_links
+          || header.number_of_links - header.number_of_stored_links > 3 * header.number_of_faces
+          || header.number_of_atoms > size || header.number_of_stored_links > size || header.number_of_faces > size )
+        {
+          LOG( error, "the MPACK file has too many elements for this skeleton type");
+          return false;
+        }
+
+      const uint8_t* cursor = data + header.header_size;
+      const uint8_t* const end = data + size;
+      std::vector< std::array< uint32_t, 4 > > atoms( header.number_of_atoms );
+      std::vector< std::array< uint64_t, 2 > > links( header.number_of_stored_links );
+      std::vector< std::array< uint64_t, 3 > > faces( header.number_of_faces );
+      if( !read_blocks( cursor, end, 4, atoms ) || !read_blocks( cursor, end, 1, links )
+          || !read_blocks( cursor, end, 1, faces ) )
+        {
+          LOG( error, "corrupted MPACK blocks");
+          return false;
+        }
+
+      const size_t natoms = atoms.size();
+      std::vector< vec4 > balls( natoms );
+      {
+        const double max_value = double( ( uint64_t(1) << header.quantization_bits ) - 1 );
+        double steps[ 4 ];
+        for( int c = 0; c < 4; ++ c )
+          steps[ c ] = header.extent[ c ] / max_value;
+        # pragma omp parallel for
+        for( size_t i = 0; i < natoms; ++ i )
+          for( int c = 0; c < 4; ++ c )
+            balls[ i ][ c ] = real( header.minimum[ c ] + atoms[ i ][ c ] * steps[ c ] );
+      }
+
+      /* indices are restored and checked in parallel, add_links() and
+       * add_faces() throwing on invalid indices */
+      const size_t nlinks = links.size(), nfaces = faces.size();
+      std::vector< std::pair< atom_index, atom_index > > skeleton_links( nlinks );
+      std::vector< std::array< atom_index, 3 > > skeleton_faces( nfaces );
+      # pragma omp parallel for
+      for( size_t i = 0; i < nlinks; ++ i )
+        skeleton_links[ i ] = std::make_pair( atom_index( links[ i ][ 0 ] ),
+          atom_index( std::min< uint64_t >( links[ i ][ 0 ] + links[ i ][ 1 ], natoms ) ) );
+      # pragma omp parallel for
+      for( size_t i = 0; i < nfaces; ++ i )
+        skeleton_faces[ i ] = {{ atom_index( faces[ i ][ 0 ] ),
+          atom_index( std::min< uint64_t >( faces[ i ][ 0 ] + faces[ i ][ 1 ], natoms ) ),
+          atom_index( std::min< uint64_t >( faces[ i ][ 0 ] + faces[ i ][ 2 ], natoms ) ) }};
+
+      skeleton.clear( atom_index( natoms ), link_index( header.number_of_links ), face_index( nfaces ) );
+      skeleton.add_atoms( balls.data(), atom_index( natoms ) );
+      skeleton.add_links( skeleton_links );
+      skeleton.add_faces( skeleton_faces );
+      if( skeleton.get_number_of_links() != header.number_of_links
+          || skeleton.get_number_of_faces() != header.number_of_faces )
+        {
+          LOG( error, "the numbers of elements read do not match the MPACK header");
+          return false;
+        }
+      return true;
+    }
+
+    /* block bounds are found by a scan of block sizes, then blocks are
+     * decoded in parallel */
+    template< size_t n, typename value_type >
+    static bool read_blocks( const uint8_t*& cursor, const uint8_t* end,
+      size_t delta_components, std::vector< std::array< value_type, n > >& elements )
+    {
+      const size_t nblocks = ( elements.size() + mpack_block_size - 1 ) / mpack_block_size;
+      std::vector< std::pair< const uint8_t*, const uint8_t* > > blocks( nblocks );
+      for( size_t b = 0; b < nblocks; ++ b )
+        {
+          if( end - cursor < 4 )
+            return false;
+          uint32_t block_size = 0;
+          for( int k = 0; k < 4; ++ k )
+            block_size |= uint32_t( cursor[ k ] ) << ( 8 * k );
+          cursor += 4;
+          if( uint64_t( end - cursor ) < block_size )
+            return false;
+          blocks[ b ] = std::make_pair( cursor, cursor + block_size );
+          cursor += block_size;
+        }
+
+      bool result = true;
+      # pragma omp parallel for schedule(dynamic) reduction(&&:result)
+      for( size_t b = 0; b < nblocks; ++ b )
+        {
+          const size_t begin = b * mpack_block_size;
+          const size_t count = std::min( elements.size(), begin + mpack_block_size ) - begin;
+          result = decode_mpack_block( blocks[ b ].first, blocks[ b ].second, count,
+            delta_components, elements.data() + begin ) && result;
+        }
+      return result;
+    }
+  };
+
+}
+END_MP_NAMESPACE
+# endif
@@ -0,0 +1,574 @@
+# ifndef MEDIAN_PATH_MSKEL_FORMAT_H_
+# define MEDIAN_PATH_MSKEL_FORMAT_H_
+
+# include "../io.h"
+# include "io_utilities.h"
+
+# include <graphics-origin/tools/filesystem.h>
+# include <graphics-origin/tools/log.h>
+
+# include <array>
+# include <cstdio>
+# include <cstring>
+# include <limits>
+# include <memory>
+# include <type_traits>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+namespace io {
+
+  static const std::string mskel_format_extension = ".mskel";
+
+  /* A .mskel file is a binary and little endian image of a skeleton:
+   * - a header of 64 bytes (mskel_header),
+   * - sections, made of a section header of 32 bytes (mskel_section_header),
+   * the name of the section, and the data of the section.
+   * Section headers and section data start at offsets that are multiples of
+   * mskel_alignment, gaps being filled with zeros. Sections are, in order:
+   * - the atoms, as four doubles per atom,
+   * - the links, as two atom indices per link,
+   * - the faces, as three atom indices per face,
+   * - the properties, as raw copies of dense property buffers.
+   * Atom indices take index_size bytes, i.e. 4 bytes if the atom indices
+   * fit in 32 bits and 8 bytes otherwise. A loader can thus map the file
+   * and read the sections in place. */
+  static const char mskel_magic[ 8 ] = { 'M', 'S', 'K', 'E', 'L', '\r', '\n', '\x1a' };
+  static constexpr uint32_t mskel_version = 1;
+  static constexpr uint64_t mskel_alignment = 64;
+  /* number of elements written per chunk, and size of the stream buffer */
+  static constexpr size_t mskel_chunk_size = size_t(1) << 16;
+  static constexpr size_t mskel_stream_buffer_size = size_t(1) << 22;
+
+  enum mskel_section_type : uint32_t {
+    mskel_atoms_section = 1,
+    mskel_links_section,
+    mskel_faces_section,
+    mskel_atom_property_section,
+    mskel_link_property_section,
+    mskel_face_property_section
+  };
+
+  /* value type of property sections whose elements are copied bytes */
+  static constexpr uint32_t mskel_raw_value_type = 0;
+
+  struct mskel_header {
+    char magic[ 8 ];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t index_size;
+    uint32_t number_of_sections;
+    uint64_t number_of_atoms;
+    uint64_t number_of_links;
+    uint64_t number_of_faces;
+    uint64_t reserved[ 2 ];
+  };
+  static_assert( sizeof( mskel_header ) == 64, "unexpected size of .mskel header" );
+
+  struct mskel_section_header {
+    uint32_t type;
+    uint32_t element_size;
+    uint64_t number_of_elements;
+    uint64_t data_size;
+    uint32_t name_size;
+    uint32_t value_type;
+  };
+  static_assert( sizeof( mskel_section_header ) == 32, "unexpected size of .mskel section header" );
+
+  inline uint64_t mskel_align( uint64_t offset ) noexcept
+  {
+    return ( offset + mskel_alignment - 1 ) & ~( mskel_alignment - 1 );
+  }
+
+  inline bool is_little_endian_host() noexcept
+  {
+    const uint16_t value = 1;
+    unsigned char first_byte = 0;
+    std::memcpy( &first_byte, &value, 1 );
+    return first_byte == 1;
+  }
+
+  /* a property is saved if it is a user property whose dense buffer can be
+   * copied with memcpy */
+  inline bool is_mskel_property( const base_property_buffer& property ) noexcept
+  {
+    return property.m_storage == base_property_buffer::dense
+        && property.is_trivially_copyable()
+        && property.m_buffer;
+  }
+
+  struct mskel_saver
+    : public saver {
+    bool can_save_to( const std::string& filename ) override
+    {
+      return graphics_origin::tools::get_extension( filename ) == mskel_format_extension;
+    }
+    bool save( const median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    bool save( const large_median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    struct property_section {
+      mskel_section_type type;
+      const base_property_buffer* property;
+      uint64_t number_of_elements;
+    };
+
+    template< typename skeleton_type >
+    bool save_skeleton( const skeleton_type& skeleton, const std::string& filename )
+    {
+      if( !is_little_endian_host() )
+        {
+          LOG( error, "cannot save skeleton to MSKEL file [" << filename << "]: the host is not little endian");
+          return false;
+        }
+
+      std::vector< property_section > properties;
+      for( uint64_t i = 0; i < skeleton.get_number_of_atom_properties(); ++ i )
+        add_property( properties, mskel_atom_property_section,
+          skeleton.get_atom_property( typename skeleton_type::atom_property_index( i + atom_faces_property_index + 1 ) ),
+          skeleton.get_number_of_atoms() );
+      for( uint64_t i = 0; i < skeleton.get_number_of_link_properties(); ++ i )
+        add_property( properties, mskel_link_property_section,
+          skeleton.get_link_property( typename skeleton_type::link_property_index( i + link_faces_property_index + 1 ) ),
+          skeleton.get_number_of_links() );
+      for( uint64_t i = 0; i < skeleton.get_number_of_face_properties(); ++ i )
+        add_property( properties, mskel_face_property_section,
+          skeleton.get_face_property( typename skeleton_type::face_property_index( i ) ),
+          skeleton.get_number_of_faces() );
+
+      std::FILE* pfile = std::fopen( filename.c_str(), "wb" );
+      if( !pfile )
+        {
+          LOG( error, "cannot open MSKEL file [" << filename << "] for writing");
+          return false;
+        }
+      std::unique_ptr< char[] > stream_buffer( new char[ mskel_stream_buffer_size ] );
+      std::setvbuf( pfile, stream_buffer.get(), _IOFBF, mskel_stream_buffer_size );
+
+      mskel_header header;
+      std::memset( &header, 0, sizeof( header ) );
+      std::memcpy( header.magic, mskel_magic, sizeof( mskel_magic ) );
+      header.version = mskel_version;
+      header.header_size = sizeof( mskel_header );
+      header.index_size = uint64_t( skeleton.get_number_of_atoms() ) <= std::numeric_limits< uint32_t >::max() ? 4 : 8;
+      header.number_of_sections = 3 + uint32_t( properties.size() );
+      header.number_of_atoms = skeleton.get_number_of_atoms();
+      header.number_of_links = skeleton.get_number_of_links();
+      header.number_of_faces = skeleton.get_number_of_faces();
+      uint64_t offset = 0;
+      write( pfile, offset, &header, sizeof( header ) );
+
+      write_atoms( skeleton, pfile, offset );
+      if( header.index_size == 4 )
+        write_topology< uint32_t >( skeleton, pfile, offset );
+      else
+        write_topology< uint64_t >( skeleton, pfile, offset );
+      for( auto& p : properties )
+        {
+          write_section_header( pfile, offset, p.type, p.property->m_sizeof_element,
+            p.number_of_elements, p.property->m_name );
+          write( pfile, offset, p.property->m_buffer, p.property->m_sizeof_element * p.number_of_elements );
+          pad( pfile, offset );
+        }
+
+      const bool result = !std::ferror( pfile );
+      if( std::fclose( pfile ) || !result )
+        {
+          LOG( error, "failed to write skeleton to MSKEL file [" << filename << "]");
+          return false;
+        }
+      return true;
+    }
+
+  private:
+    static void add_property( std::vector< property_section >& properties,
+      mskel_section_type type, const base_property_buffer& property, uint64_t number_of_elements )
+    {
+      if( is_mskel_property( property ) )
+        properties.push_back( { type, &property, number_of_elements } );
+      else
+        LOG( debug, "property \"" << property.m_name << "\" is not saved in MSKEL file: only dense and trivially copyable properties are");
+    }
+
+    static void write( std::FILE* pfile, uint64_t& offset, const void* data, size_t size )
+    {
+      if( size )
+        std::fwrite( data, 1, size, pfile );
+      offset += size;
+    }
+
+    static void pad( std::FILE* pfile, uint64_t& offset )
+    {
+      static const char zeros[ mskel_alignment ] = {};
+      write( pfile, offset, zeros, mskel_align( offset ) - offset );
+    }
+
+    static void write_section_header( std::FILE* pfile, uint64_t& offset,
+      mskel_section_type type, size_t element_size, uint64_t number_of_elements,
+      const std::string& name )
+    {
+      mskel_section_header section;
+      section.type = type;
+      section.element_size = uint32_t( element_size );
+      section.number_of_elements = number_of_elements;
+      section.data_size = element_size * number_of_elements;
+      section.name_size = uint32_t( name.size() );
+      section.value_type = mskel_raw_value_type;
+      pad( pfile, offset );
+      write( pfile, offset, &section, sizeof( section ) );
+      write( pfile, offset, name.data(), name.size() );
+      pad( pfile, offset );
+    }
+
+    template< typename skeleton_type >
+    static void write_atoms( const skeleton_type& skeleton, std::FILE* pfile, uint64_t& offset )
+    {
+      write_section_header( pfile, offset, mskel_atoms_section, 4 * sizeof( double ),
+        skeleton.get_number_of_atoms(), "atoms" );
+
+      std::unique_ptr< double[] > values( new double[ 4 * mskel_chunk_size ] );
+      parallel_options options;
+      options.grain_size = mskel_chunk_size;
+      options.parallel = false;
+      skeleton.process_atom_chunks(
+        [&]( typename skeleton_type::atom_index begin, typename skeleton_type::atom_index end,
+             const typename skeleton_type::atom* atoms )
+        {
+          const size_t n = end - begin;
+          for( size_t i = 0; i < n; ++ i )
+            {
+              values[ 4 * i     ] = atoms[ i ].x;
+              values[ 4 * i + 1 ] = atoms[ i ].y;
+              values[ 4 * i + 2 ] = atoms[ i ].z;
+              values[ 4 * i + 3 ] = atoms[ i ].w;
+            }
+          write( pfile, offset, values.get(), 4 * n * sizeof( double ) );
+        }, options );
+      pad( pfile, offset );
+    }
+
+    template< typename index_type, typename skeleton_type >
+    static void write_topology( const skeleton_type& skeleton, std::FILE* pfile, uint64_t& offset )
+    {
+      std::vector< index_type > indices;
+      indices.reserve( 3 * mskel_chunk_size );
+
+      write_section_header( pfile, offset, mskel_links_section, 2 * sizeof( index_type ),
+        skeleton.get_number_of_links(), "links" );
+      process_link_atom_indices( skeleton,
+        [&]( typename skeleton_type::atom_index i1, typename skeleton_type::atom_index i2 )
+        {
+          indices.push_back( index_type( i1 ) );
+          indices.push_back( index_type( i2 ) );
+          if( indices.size() == 2 * mskel_chunk_size )
+            {
+              write( pfile, offset, indices.data(), indices.size() * sizeof( index_type ) );
+              indices.clear();
+            }
+        } );
+      write( pfile, offset, indices.data(), indices.size() * sizeof( index_type ) );
+      indices.clear();
+      pad( pfile, offset );
+
+      write_section_header( pfile, offset, mskel_faces_section, 3 * sizeof( index_type ),
+        skeleton.get_number_of_faces(), "faces" );
+      process_face_atom_indices( skeleton,
+        [&]( typename skeleton_type::atom_index i1, typename skeleton_type::atom_index i2,
+             typename skeleton_type::atom_index i3 )
+        {
+          indices.push_back( index_type( i1 ) );
+          indices.push_back( index_type( i2 ) );
+          indices.push_back( index_type( i3 ) );
+          if( indices.size() == 3 * mskel_chunk_size )
+            {
+              write( pfile, offset, indices.data(), indices.size() * sizeof( index_type ) );
+              indices.clear();
+            }
+        } );
+      write( pfile, offset, indices.data(), indices.size() * sizeof( index_type ) );
+      pad( pfile, offset );
+    }
+  };
+
+  struct mskel_loader
+    : public loader {
+    bool can_load_from( const std::string& filename ) override
+    {
+      return graphics_origin::tools::get_extension( filename ) == mskel_format_extension;
+    }
+    bool load( median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    bool load( large_median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return load_skeleton( skeleton, filename );
+    }
+
+    template< typename skeleton_type >
+    bool load_skeleton( skeleton_type& skeleton, const std::string& filename )
+    {
+      if( !is_little_endian_host() )
+        {
+          LOG( error, "cannot load skeleton from MSKEL file [" << filename << "]: the host is not little endian");
+          return false;
+        }
+
+      mapped_file file( filename );
+      if( !file.is_open() || file.size() < sizeof( mskel_header ) )
+        {
+          LOG( error, "cannot map MSKEL file [" << filename << "] or the file is too small");
+          return false;
+        }
+
+      bool result = false;
+      try
+        {
+          result = read_skeleton( skeleton, reinterpret_cast< const unsigned char* >( file.data() ), file.size() );
+        }
+      catch( const std::exception& e )
+        {
+          LOG( error, e.what() );
+          result = false;
+        }
+
+      if( !result )
+        {
+          skeleton.clear( 0, 0, 0 );
+          LOG( error, "failed to load skeleton from MSKEL file [" << filename << "]");
+        }
+      return result;
+    }
+
+  private:
+    template< typename skeleton_type >
+    static bool read_skeleton( skeleton_type& skeleton, const unsigned char* data, size_t size )
+    {
+      typedef typename skeleton_type::atom_index atom_index;
+      typedef typename skeleton_type::link_index link_index;
+      typedef typename skeleton_type::face_index face_index;
+
+      mskel_header header;
+      std::memcpy( &header, data, sizeof( header ) );
+      if( std::memcmp( header.magic, mskel_magic, sizeof( mskel_magic ) ) )
+        {
+          LOG( error, "wrong magic word in MSKEL header");
+          return false;
+        }
+      if( header.version != mskel_version || header.header_size < sizeof( mskel_header )
+          || header.header_size > size || ( header.index_size != 4 && header.index_size != 8 ) )
+        {
+          LOG( error, "unsupported MSKEL header (version " << header.version << ")");
+          return false;
+        }
+      if( header.number_of_atoms > std::numeric_limits< atom_index >::max()
+          || header.number_of_links > std::numeric_limits< link_index >::max()
+          || header.number_of_faces > std::numeric_limits< face_index >::max() )
+        {
+          LOG( error, "the MSKEL file has too many elements for this skeleton type");
+          return false;
+        }
+
+      skeleton.clear( atom_index( header.number_of_atoms ), link_index( header.number_of_links ),
+        face_index( header.number_of_faces ) );
+
+      uint64_t offset = mskel_align( header.header_size );
+      for( uint32_t s = 0; s < header.number_of_sections; ++ s )
+        {
+          mskel_section_header section;
+          if( offset > size || size - offset < sizeof( section ) )
+            {
+              LOG( error, "MSKEL section #" << s << " is out of the file");
+              return false;
+            }
+          std::memcpy( &section, data + offset, sizeof( section ) );
+          const uint64_t name_offset = offset + sizeof( section );
+          if( section.name_size > size - name_offset )
+            {
+              LOG( error, "name of MSKEL section #" << s << " is out of the file");
+              return false;
+            }
+          const std::string name( reinterpret_cast< const char* >( data + name_offset ), section.name_size );
+          const uint64_t data_offset = mskel_align( name_offset + section.name_size );
+          if( data_offset > size || section.data_size > size - data_offset
+              || section.number_of_elements > size
+              || section.data_size != uint64_t( section.element_size ) * section.number_of_elements )
+            {
+              LOG( error, "data of MSKEL section \"" << name << "\" is out of the file or inconsistent");
+              return false;
+            }
+          const unsigned char* section_data = data + data_offset;
+
+          bool section_read = true;
+          switch( section.type )
+          {
+            case mskel_atoms_section:
+              section_read = read_atoms( skeleton, header, section, section_data );
+              break;
+            case mskel_links_section:
+              section_read = header.index_size == 4
+                ? read_links< uint32_t >( skeleton, header, section, section_data )
+                : read_links< uint64_t >( skeleton, header, section, section_data );
+              break;
+            case mskel_faces_section:
+              section_read = header.index_size == 4
+                ? read_faces< uint32_t >( skeleton, header, section, section_data )
+                : read_faces< uint64_t >( skeleton, header, section, section_data );
+              break;
+            case mskel_atom_property_section:
+              read_property( skeleton.get_number_of_atoms(), section, name, section_data,
+                skeleton.get_number_of_atom_properties(),
+                [&skeleton]( uint64_t i ) -> base_property_buffer&
+                {
+                  return skeleton.get_atom_property(
+                    typename skeleton_type::atom_property_index( i + atom_faces_property_index + 1 ) );
+                } );
+              break;
+            case mskel_link_property_section:
+              read_property( skeleton.get_number_of_links(), section, name, section_data,
+                skeleton.get_number_of_link_properties(),
+                [&skeleton]( uint64_t i ) -> base_property_buffer&
+                {
+                  return skeleton.get_link_property(
+                    typename skeleton_type::link_property_index( i + link_faces_property_index + 1 ) );
+                } );
+              break;
+            case mskel_face_property_section:
+              read_property( skeleton.get_number_of_faces(), section, name, section_data,
+                skeleton.get_number_of_face_properties(),
+                [&skeleton]( uint64_t i ) -> base_property_buffer&
+                {
+                  return skeleton.get_face_property( typename skeleton_type::face_property_index( i ) );
+                } );
+              break;
+            default:
+              LOG( debug, "unknown MSKEL section \"" << name << "\" of type " << section.type << " is skipped");
+          }
+          if( !section_read )
+            return false;
+          offset = mskel_align( data_offset + section.data_size );
+        }
+
+      if( skeleton.get_number_of_atoms() != header.number_of_atoms
+          || skeleton.get_number_of_links() != header.number_of_links
+          || skeleton.get_number_of_faces() != header.number_of_faces )
+        {
+          LOG( error, "the numbers of elements read do not match the MSKEL header");
+          return false;
+        }
+      return true;
+    }
+
+    template< typename skeleton_type >
+    static bool read_atoms( skeleton_type& skeleton, const mskel_header& header,
+      const mskel_section_header& section, const unsigned char* data )
+    {
+      typedef typename skeleton_type::atom_index atom_index;
+      if( section.element_size != 4 * sizeof( double ) || section.number_of_elements != header.number_of_atoms
+          || skeleton.get_number_of_atoms() )
+        {
+          LOG( error, "wrong MSKEL atom section");
+          return false;
+        }
+      const atom_index natoms = atom_index( section.number_of_elements );
+
+      /* sections are aligned in the file, and thus in the mapping: balls
+       * stored as doubles are read in place */
+      if( std::is_same< real, double >::value && sizeof( vec4 ) == 4 * sizeof( double ) )
+        {
+          skeleton.add_atoms( reinterpret_cast< const vec4* >( data ), natoms );
+          return true;
+        }
+      std::unique_ptr< vec4[] > balls( new vec4[ natoms ] );
+      # pragma omp parallel for
+      for( atom_index i = 0; i < natoms; ++ i )
+        {
+          double values[ 4 ];
+          std::memcpy( values, data + 4 * sizeof( double ) * i, sizeof( values ) );
+          balls[ i ] = vec4{ real( values[ 0 ] ), real( values[ 1 ] ), real( values[ 2 ] ), real( values[ 3 ] ) };
+        }
+      skeleton.add_atoms( balls.get(), natoms );
+      return true;
+    }
+
+    template< typename index_type, typename skeleton_type >
+    static bool read_links( skeleton_type& skeleton, const mskel_header& header,
+      const mskel_section_header& section, const unsigned char* data )
+    {
+      typedef typename skeleton_type::atom_index atom_index;
+      if( section.element_size != 2 * sizeof( index_type ) || section.number_of_elements != header.number_of_links
+          || skeleton.get_number_of_links() )
+        {
+          LOG( error, "wrong MSKEL link section");
+          return false;
+        }
+      const index_type* indices = reinterpret_cast< const index_type* >( data );
+      const size_t nlinks = section.number_of_elements;
+      std::vector< std::pair< atom_index, atom_index > > links( nlinks );
+      # pragma omp parallel for
+      for( size_t i = 0; i < nlinks; ++ i )
+        links[ i ] = std::make_pair( atom_index( indices[ 2 * i ] ), atom_index( indices[ 2 * i + 1 ] ) );
+      skeleton.add_links( links );
+      return true;
+    }
+
+    template< typename index_type, typename skeleton_type >
+    static bool read_faces( skeleton_type& skeleton, const mskel_header& header,
+      const mskel_section_header& section, const unsigned char* data )
+    {
+      typedef typename skeleton_type::atom_index atom_index;
+      if( section.element_size != 3 * sizeof( index_type ) || section.number_of_elements != header.number_of_faces
+          || skeleton.get_number_of_faces() )
+        {
+          LOG( error, "wrong MSKEL face section");
+          return false;
+        }
+      const index_type* indices = reinterpret_cast< const index_type* >( data );
+      const size_t nfaces = section.number_of_elements;
+      std::vector< std::array< atom_index, 3 > > faces( nfaces );
+      # pragma omp parallel for
+      for( size_t i = 0; i < nfaces; ++ i )
+        faces[ i ] = {{ atom_index( indices[ 3 * i ] ), atom_index( indices[ 3 * i + 1 ] ),
+                        atom_index( indices[ 3 * i + 2 ] ) }};
+      skeleton.add_faces( faces );
+      return true;
+    }
+
+    /* the elements of a property section are copied in the user property
+     * with the same name, if this property has the same element size and can
+     * be copied with memcpy. Other property sections are skipped. */
+    template< typename property_getter >
+    static void read_property( uint64_t number_of_elements, const mskel_section_header& section,
+      const std::string& name, const unsigned char* data,
+      uint64_t number_of_properties, property_getter&& get_property )
+    {
+      if( section.number_of_elements != number_of_elements )
+        {
+          LOG( debug, "MSKEL property \"" << name << "\" is skipped: wrong number of elements");
+          return;
+        }
+      for( uint64_t i = 0; i < number_of_properties; ++ i )
+        {
+          base_property_buffer& property = get_property( i );
+          if( property.m_name != name )
+            continue;
+          if( property.m_sizeof_element == section.element_size && is_mskel_property( property ) )
+            std::memcpy( property.m_buffer, data, section.data_size );
+          else
+            LOG( debug, "MSKEL property \"" << name << "\" is skipped: the skeleton property cannot receive it");
+          return;
+        }
+      LOG( debug, "MSKEL property \"" << name << "\" is skipped: the skeleton has no such property");
+    }
+  };
+
+}
+END_MP_NAMESPACE
+# endif
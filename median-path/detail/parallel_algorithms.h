@@ -0,0 +1,354 @@
+# ifndef MEDIAN_PATH_PARALLEL_ALGORITHMS_H_
+# define MEDIAN_PATH_PARALLEL_ALGORITHMS_H_
+
+# include "../median_path.h"
+
+# include <algorithm>
+# include <atomic>
+# include <cstdint>
+# include <cstring>
+# include <functional>
+# include <iterator>
+# include <memory>
+# include <vector>
+# include <omp.h>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Sort a range in parallel.
+   *
+   * The range is split into one chunk per thread. Each chunk is sorted by
+   * std::sort, then chunks are merged pairwise with std::inplace_merge, with
+   * the merges of a round running in parallel. As std::sort, this sort is not
+   * stable.
+   * @param first Beginning of the range to sort.
+   * @param last End of the range to sort.
+   * @param comp Comparison function object. */
+  template< typename random_iterator, typename compare >
+  void parallel_sort( random_iterator first, random_iterator last, compare comp )
+  {
+    typedef typename std::iterator_traits< random_iterator >::difference_type difference;
+    const difference size = std::distance( first, last );
+    const difference nchunks = std::min( difference( omp_get_max_threads() ), size / 1024 + 1 );
+    if( nchunks < 2 )
+      {
+        std::sort( first, last, comp );
+        return;
+      }
+
+    # pragma omp parallel for
+    for( difference i = 0; i < nchunks; ++ i )
+      std::sort( first + size * i / nchunks, first + size * ( i + 1 ) / nchunks, comp );
+
+    for( difference width = 1; width < nchunks; width *= 2 )
+      {
+        # pragma omp parallel for
+        for( difference i = 0; i < nchunks - width; i += 2 * width )
+          {
+            const difference middle = std::min( i + width, nchunks );
+            const difference end = std::min( i + 2 * width, nchunks );
+            std::inplace_merge(
+                first + size * i / nchunks,
+                first + size * middle / nchunks,
+                first + size * end / nchunks, comp );
+          }
+      }
+  }
+
+  template< typename random_iterator >
+  void parallel_sort( random_iterator first, random_iterator last )
+  {
+    parallel_sort( first, last,
+      std::less< typename std::iterator_traits< random_iterator >::value_type >() );
+  }
+
+  /**@brief Select in parallel the indices satisfying a predicate.
+   *
+   * The indices i of [[first, last[[ such that predicate(i) is true are
+   * written in increasing order to output. The range is split into one block
+   * per thread. The selected indices of each block are counted in parallel,
+   * a prefix sum of those counts gives the position of each block in the
+   * output, then each block is written in parallel.
+   * @param first First index to test.
+   * @param last End of the indices to test.
+   * @param predicate Function object telling if an index is selected.
+   * @param output Destination, with room for last - first indices.
+   * @return The number of selected indices. */
+  template< typename index, typename predicate_type >
+  index parallel_select( index first, index last, predicate_type&& predicate, index* output )
+  {
+    const size_t size = last - first;
+    const size_t nblocks = std::min( size_t( omp_get_max_threads() ), size / 4096 + 1 );
+    std::vector< index > offsets( nblocks + 1, 0 );
+
+    # pragma omp parallel for
+    for( size_t b = 0; b < nblocks; ++ b )
+      {
+        index count = 0;
+        const index end = first + size * ( b + 1 ) / nblocks;
+        for( index i = first + size * b / nblocks; i < end; ++ i )
+          if( predicate( i ) )
+            ++ count;
+        offsets[ b + 1 ] = count;
+      }
+
+    for( size_t b = 0; b < nblocks; ++ b )
+      offsets[ b + 1 ] += offsets[ b ];
+
+    # pragma omp parallel for
+    for( size_t b = 0; b < nblocks; ++ b )
+      {
+        index* out = output + offsets[ b ];
+        const index end = first + size * ( b + 1 ) / nblocks;
+        for( index i = first + size * b / nblocks; i < end; ++ i )
+          if( predicate( i ) )
+            *out++ = i;
+      }
+    return offsets[ nblocks ];
+  }
+
+  /**@brief Replace in parallel the elements of a range by their inclusive
+   * prefix sums.
+   *
+   * The range is split into one block per thread. The sum of each block is
+   * computed in parallel, a sequential prefix sum of those block sums gives
+   * the offset of each block, then each block is scanned in parallel starting
+   * from its offset.
+   * @param first Beginning of the range to scan.
+   * @param last End of the range to scan. */
+  template< typename random_iterator >
+  void parallel_inclusive_scan( random_iterator first, random_iterator last )
+  {
+    typedef typename std::iterator_traits< random_iterator >::difference_type difference;
+    typedef typename std::iterator_traits< random_iterator >::value_type value;
+    const difference size = std::distance( first, last );
+    const difference nblocks = std::min( difference( omp_get_max_threads() ), size / 4096 + 1 );
+    std::vector< value > offsets( nblocks + 1, value( 0 ) );
+
+    # pragma omp parallel for
+    for( difference b = 0; b < nblocks; ++ b )
+      {
+        value sum = value( 0 );
+        const random_iterator end = first + size * ( b + 1 ) / nblocks;
+        for( random_iterator it = first + size * b / nblocks; it != end; ++ it )
+          sum += *it;
+        offsets[ b + 1 ] = sum;
+      }
+
+    for( difference b = 0; b < nblocks; ++ b )
+      offsets[ b + 1 ] += offsets[ b ];
+
+    # pragma omp parallel for
+    for( difference b = 0; b < nblocks; ++ b )
+      {
+        value sum = offsets[ b ];
+        const random_iterator end = first + size * ( b + 1 ) / nblocks;
+        for( random_iterator it = first + size * b / nblocks; it != end; ++ it )
+          *it = sum += *it;
+      }
+  }
+
+  /**@brief Copy a block of memory in parallel.
+   *
+   * The block is split into one chunk per thread, each chunk being copied by
+   * std::memcpy. Small blocks are copied by a single memcpy.
+   * @param destination Beginning of the destination.
+   * @param source Beginning of the source, which must not overlap the
+   * destination.
+   * @param bytes Number of bytes to copy. */
+  inline void parallel_memcpy( void* destination, const void* source, size_t bytes )
+  {
+    const size_t nchunks = std::min( size_t( omp_get_max_threads() ), bytes / ( 1 << 20 ) + 1 );
+    if( nchunks < 2 )
+      {
+        if( bytes )
+          std::memcpy( destination, source, bytes );
+        return;
+      }
+
+    unsigned char* d = static_cast< unsigned char* >( destination );
+    const unsigned char* s = static_cast< const unsigned char* >( source );
+    # pragma omp parallel for
+    for( size_t i = 0; i < nchunks; ++ i )
+      {
+        const size_t begin = bytes * i / nchunks;
+        const size_t end = bytes * ( i + 1 ) / nchunks;
+        std::memcpy( d + begin, s + begin, end - begin );
+      }
+  }
+
+  /**@brief Scheduling of the chunks of a parallel loop.
+   *
+   * - static_schedule: chunks are distributed round-robin once, without
+   * synchronization. This is the best choice for uniform costs.
+   * - dynamic_schedule: each thread takes the next chunk from a shared
+   * counter when it is done with its current one.
+   * - work_stealing_schedule: each thread starts with a contiguous range of
+   * chunks, which keeps neighbor chunks on the same thread. A thread whose
+   * range is empty steals the second half of the largest remaining range.
+   * This is the best choice for irregular costs with a spatial locality. */
+  enum loop_schedule {
+    static_schedule,
+    dynamic_schedule,
+    work_stealing_schedule
+  };
+
+  /**@brief Options of a chunked loop. */
+  struct parallel_options {
+    /**Scheduling of the chunks. */
+    loop_schedule schedule = dynamic_schedule;
+    /**Number of indices per chunk, or 0 for an automatic grain size. */
+    size_t grain_size = 0;
+    /**A flag to activate a parallel processing. Chunks are processed in
+     * increasing order otherwise. */
+    bool parallel = true;
+  };
+
+  /**@brief Get the grain size used by a chunked loop.
+   *
+   * The automatic grain size gives about eight chunks per thread, such that
+   * the load can be balanced, with at least 64 indices per chunk to amortize
+   * the scheduling.
+   * @param size Number of indices of the loop.
+   * @param grain_size The requested grain size, 0 for an automatic one. */
+  inline size_t get_grain_size( size_t size, size_t grain_size ) noexcept
+  {
+    if( grain_size )
+      return grain_size;
+    return std::max( size_t( 64 ), size / ( 8 * size_t( omp_get_max_threads() ) ) + 1 );
+  }
+
+  /**@brief Call a per element function, with the index of the element if
+   * the function accepts it.
+   *
+   * The function is called as function( i, e ) if this is a valid call, and
+   * as function( e ) otherwise. The last argument selects the first overload
+   * when both are viable; callers pass 0. */
+  template< typename element_function, typename index, typename element >
+  inline auto call_element_function( element_function& function, index i, element& e, int )
+    -> decltype( function( i, e ), void() )
+  {
+    function( i, e );
+  }
+
+  template< typename element_function, typename index, typename element >
+  inline void call_element_function( element_function& function, index i, element& e, long )
+  {
+    (void)i;
+    function( e );
+  }
+
+  /**@brief Process the indices of a range by chunks.
+   *
+   * The range [[first, last[[ is split into chunks of grain_size consecutive
+   * indices, the last one being smaller. The function is called once per
+   * chunk, with the first and the end index of the chunk, such that cheap
+   * per element processing does not pay a scheduling cost per element and
+   * can be vectorized.
+   * @param first First index of the range.
+   * @param last End of the range.
+   * @param function Function object called as function(begin, end).
+   * @param options Scheduling, grain size and parallelism of the loop. */
+  template< typename index, typename chunk_function >
+  void parallel_for_chunks( index first, index last, chunk_function&& function,
+    const parallel_options& options = parallel_options() )
+  {
+    if( last <= first )
+      return;
+    const size_t size = last - first;
+    const size_t grain = get_grain_size( size, options.grain_size );
+    const size_t nchunks = ( size + grain - 1 ) / grain;
+    auto process_chunk = [&]( size_t c )
+      {
+        const index begin = first + index( c * grain );
+        const index end = c + 1 == nchunks ? last : index( begin + grain );
+        function( begin, end );
+      };
+
+    if( !options.parallel || nchunks == 1 )
+      {
+        for( size_t c = 0; c < nchunks; ++ c )
+          process_chunk( c );
+      }
+    else if( options.schedule == static_schedule )
+      {
+        # pragma omp parallel for schedule(static,1)
+        for( size_t c = 0; c < nchunks; ++ c )
+          process_chunk( c );
+      }
+    else if( options.schedule == dynamic_schedule || nchunks > UINT32_MAX )
+      {
+        # pragma omp parallel for schedule(dynamic)
+        for( size_t c = 0; c < nchunks; ++ c )
+          process_chunk( c );
+      }
+    else
+      {
+        /* each range of chunks is packed in a word, begin in the low bits and
+         * end in the high bits, such that the owner and the thieves update it
+         * by compare and swap. Ranges are padded to 64 bytes, such that two
+         * ranges of an array never share a cache line: over-aligned types are
+         * not supported by new before C++17. */
+        struct chunk_range {
+          std::atomic< uint64_t > bounds;
+          char padding[ 64 - sizeof( std::atomic< uint64_t > ) ];
+        };
+        static_assert( sizeof( chunk_range ) == 64, "a range should fill a cache line" );
+        const size_t nthreads = std::min( size_t( omp_get_max_threads() ), nchunks );
+        std::unique_ptr< chunk_range[] > ranges( new chunk_range[ nthreads ] );
+        for( size_t t = 0; t < nthreads; ++ t )
+          ranges[ t ].bounds.store(
+              uint64_t( nchunks * t / nthreads ) | uint64_t( nchunks * ( t + 1 ) / nthreads ) << 32,
+              std::memory_order_relaxed );
+
+        # pragma omp parallel num_threads( nthreads )
+        {
+          const size_t t = omp_get_thread_num();
+          auto& own = ranges[ t ].bounds;
+          while( true )
+            {
+              // take the first chunk of its own range
+              uint64_t bounds = own.load( std::memory_order_acquire );
+              uint32_t begin = uint32_t( bounds ), end = uint32_t( bounds >> 32 );
+              if( begin < end )
+                {
+                  if( own.compare_exchange_weak( bounds, bounds + 1, std::memory_order_acq_rel ) )
+                    process_chunk( begin );
+                  continue;
+                }
+
+              // steal the second half of the largest range
+              size_t victim = nthreads;
+              uint32_t largest = 0;
+              for( size_t v = 0; v < nthreads; ++ v )
+                {
+                  const uint64_t b = ranges[ v ].bounds.load( std::memory_order_relaxed );
+                  const uint32_t remaining = uint32_t( b >> 32 ) - std::min( uint32_t( b ), uint32_t( b >> 32 ) );
+                  if( remaining > largest )
+                    {
+                      largest = remaining;
+                      victim = v;
+                    }
+                }
+              if( victim == nthreads )
+                break;
+
+              bounds = ranges[ victim ].bounds.load( std::memory_order_acquire );
+              begin = uint32_t( bounds );
+              end = uint32_t( bounds >> 32 );
+              if( begin >= end )
+                continue;
+              const uint32_t middle = end - ( end - begin + 1 ) / 2;
+              if( ranges[ victim ].bounds.compare_exchange_strong( bounds,
+                    uint64_t( begin ) | uint64_t( middle ) << 32, std::memory_order_acq_rel ) )
+                {
+                  // only this thread refills its empty range
+                  own.store( uint64_t( middle ) | uint64_t( end ) << 32, std::memory_order_release );
+                }
+            }
+        }
+      }
+  }
+
+END_MP_NAMESPACE
+# endif
@@ -0,0 +1,92 @@
+# ifndef MEDIAN_PATH_RELOCATABLE_BUFFER_H_
+# define MEDIAN_PATH_RELOCATABLE_BUFFER_H_
+
+# include "../median_path.h"
+
+# include <algorithm>
+# include <cstdlib>
+# include <memory>
+# include <new>
+# include <type_traits>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Tell if objects of a type can be moved to another address by a
+   * raw copy of their bytes, the source being then forgotten.
+   *
+   * This is true for trivially copyable types, and could be specialized for
+   * other types that do not store pointers to themselves. */
+  template< typename T >
+  struct is_trivially_relocatable
+    : std::integral_constant< bool, std::is_trivially_copyable< T >::value >
+  {};
+
+  /**@brief Deleter of buffers allocated by std::malloc(). */
+  struct free_deleter {
+    void operator()( void* buffer ) const noexcept
+    {
+      std::free( buffer );
+    }
+  };
+
+  /**@brief A buffer of elements allocated by the C allocator.
+   *
+   * Elements must be trivially destructible, since the buffer does not know
+   * how many elements it holds. */
+  template< typename T >
+  using relocatable_buffer = std::unique_ptr< T[], free_deleter >;
+
+  /**@brief Change the capacity of a relocatable buffer.
+   *
+   * Elements in [[0, min( old_capacity, new_capacity )[[ are kept, and new
+   * elements are default constructed. When elements are trivially relocatable,
+   * the buffer is resized by std::realloc(): this may extend the buffer in
+   * place, and for large buffers the C library remaps the pages (e.g. mremap
+   * on Linux) instead of copying them. Otherwise, a new buffer is allocated
+   * and elements are moved into it. A std::bad_alloc is thrown if the
+   * allocation failed, in which case the buffer is not modified.
+   * @param buffer The buffer to resize, could be empty.
+   * @param old_capacity Current number of elements in the buffer.
+   * @param new_capacity Requested number of elements. */
+  template< typename T >
+  void resize_relocatable_buffer( relocatable_buffer< T >& buffer,
+    size_t old_capacity, size_t new_capacity )
+  {
+    static_assert( std::is_trivially_destructible< T >::value,
+      "The elements of a relocatable buffer must be trivially destructible" );
+    if( !new_capacity )
+      {
+        buffer.reset();
+        return;
+      }
+
+    if( is_trivially_relocatable< T >::value )
+      {
+        T* data = static_cast< T* >( std::realloc( buffer.get(), new_capacity * sizeof( T ) ) );
+        if( !data )
+          throw std::bad_alloc();
+        buffer.release();
+        buffer.reset( data );
+        # pragma omp parallel for
+        for( size_t i = old_capacity; i < new_capacity; ++ i )
+          new ( data + i ) T();
+      }
+    else
+      {
+        T* data = static_cast< T* >( std::malloc( new_capacity * sizeof( T ) ) );
+        if( !data )
+          throw std::bad_alloc();
+        const size_t kept = std::min( old_capacity, new_capacity );
+        # pragma omp parallel for
+        for( size_t i = 0; i < new_capacity; ++ i )
+          {
+            new ( data + i ) T();
+            if( i < kept )
+              data[ i ] = std::move( buffer[ i ] );
+          }
+        buffer.reset( data );
+      }
+  }
+
+END_MP_NAMESPACE
+# endif
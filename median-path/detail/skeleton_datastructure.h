@@ -3,20 +3,28 @@
 
 # include "../median_path.h"
 # include "exceptions.h"
+# include "aligned_allocation.h"
+# include "change_journal.h"
+# include "check_policies.h"
+# include "compaction.h"
+# include "growth_policy.h"
+# include "parallel_algorithms.h"
+# include "relocatable_buffer.h"
 
 # include <graphics-origin/geometry/vec.h>
 # include <graphics-origin/geometry/ball.h>
 
+# include <algorithm>
+# include <atomic>
+# include <cstring>
 # include <memory>
+# include <mutex>
+# include <shared_mutex>
 # include <type_traits>
+# include <typeinfo>
+# include <unordered_map>
 # include <vector>
 
-# ifdef MP_SKELETON_NO_CHECK
-#  define MP_SKELETON_NO_INDEX_CHECK
-#  define MP_SKELETON_NO_HANDLE_CHECK
-#  define MP_SKELETON_NO_POINTER_CHECK
-# endif
-
 namespace median_path {
   /**************************************************************************
    * ELEMENT DATA TYPES:                                                    *
@@ -28,17 +36,72 @@ namespace median_path {
    *     c) move an element inside the property buffer                      *
    *     d) destroy a particular element in the buffer                      *
    *     e) destroy a range of particular elements in the buffer            *
+   *  - one virtual function to access elements of paged and sparse        *
+   *  properties, dense properties being accessed directly                  *
    **************************************************************************/
   struct base_property_buffer {
-    base_property_buffer( size_t size, const std::string& name ) :
-      m_sizeof_element{ size }, m_name{ name }, m_buffer{ nullptr }
+    /**@brief How the elements of a property are stored.
+     *
+     * - dense: one contiguous buffer of capacity elements, the default.
+     * - paged: pages of elements allocated at their first access. Pages
+     * covering only default elements are not allocated.
+     * - sparse: a hash map storing only the elements that were accessed. This
+     * is meant for annotations of a few percent of the elements. */
+    enum storage_type { dense, paged, sparse };
+
+    base_property_buffer( size_t size, const std::string& name, storage_type storage = dense ) :
+      m_sizeof_element{ size }, m_name{ name }, m_buffer{ nullptr }, m_storage{ storage }
     {}
 
     virtual ~base_property_buffer(){};
 
+    /**@brief Access to the property of an element.
+     *
+     * For paged and sparse properties, the element is allocated if needed.
+     * Allocations from different threads are safe, but the reference
+     * returned for a sparse property must not be used while elements of
+     * this property are moved or destroyed. */
     template< typename T >
     inline T& get( size_t index );
 
+    /**@brief Read the property of an element.
+     *
+     * Nothing is allocated: an element of a paged or sparse property that
+     * is not allocated is read as the default value of the property. Reads
+     * of a sparse property from different threads share its lock. */
+    template< typename T >
+    inline const T& get( size_t index ) const;
+
+    /**@brief Check if the property of an element has been allocated.
+     *
+     * An element not allocated has the default value of the property. */
+    virtual bool is_allocated( size_t index ) const
+    {
+      (void)index;
+      return m_buffer != nullptr;
+    }
+
+    /**@brief Number of bytes allocated to store the elements. */
+    virtual size_t get_allocated_bytes( size_t current_capacity ) const
+    {
+      return m_buffer ? current_capacity * m_sizeof_element : 0;
+    }
+
+    /**@brief Get the type of the elements.
+     *
+     * Savers use it to find how to serialize the property (see
+     * property_types.h). */
+    virtual const std::type_info& get_value_type() const noexcept = 0;
+
+    /**@brief Check if the elements are trivially copyable.
+     *
+     * The elements of a dense property of such a type can then be copied
+     * from and to m_buffer with memcpy, e.g. by binary savers and loaders. */
+    virtual bool is_trivially_copyable() const noexcept
+    {
+      return false;
+    }
+
     void clear( size_t current_capacity )
     {
       destroy( 0, current_capacity );
@@ -52,12 +115,47 @@ namespace median_path {
 
     virtual void destroy( size_t from, size_t end ) = 0;
 
+    /**@brief Permute the elements of the property.
+     *
+     * After the call, the element at index i is the former element at index
+     * sources[i], for i in [[0, size[[. The inverse permutation is given by
+     * targets, i.e. targets[sources[i]] == i. Elements are moved in parallel.
+     * @param sources The index of the former element of each index.
+     * @param targets The new index of each former element.
+     * @param size The number of elements to permute.
+     * @param current_capacity The capacity of the property. */
+    virtual void permute( const size_t* sources, const size_t* targets,
+      size_t size, size_t current_capacity ) = 0;
+
+    /**@brief Create a copy of the property.
+     *
+     * The copy has the same name and storage, the given capacity, and the
+     * first size elements of this property. Elements are copied in parallel,
+     * with memcpy for trivially copyable types. If the type of the property
+     * is not copy assignable, a skeleton_property_not_copyable exception is
+     * thrown.
+     * @param size The number of elements to copy.
+     * @param current_capacity The capacity of the copy. */
+    virtual std::unique_ptr< base_property_buffer > clone(
+      size_t size, size_t current_capacity ) const = 0;
+
     const size_t m_sizeof_element;
     const std::string m_name;
     unsigned char* m_buffer;
+    const storage_type m_storage;
+
+  protected:
+    /* Address of an element for paged and sparse properties */
+    virtual void* element( size_t index ) = 0;
+    virtual const void* element( size_t index ) const = 0;
   };
 
-  template< typename T >
+  /**@brief Property buffer of elements of type T.
+   *
+   * The generic buffer allocates its elements with new[] and moves them one
+   * by one. Trivially copyable types, which are the most common properties
+   * (e.g. scalars, labels or fixed size arrays), use the specialization below. */
+  template< typename T, bool is_trivial = std::is_trivially_copyable< T >::value >
   struct derived_property_buffer
     : public base_property_buffer {
 
@@ -71,13 +169,156 @@ namespace median_path {
 
 
     derived_property_buffer( const std::string& name );
+    const std::type_info& get_value_type() const noexcept override
+    {
+      return typeid( value_type );
+    }
     void destroy( size_t index ) override;
     void destroy( size_t from, size_t end ) override;
     void resize( size_t old_capacity, size_t new_capacity ) override;
     void move( size_t from, size_t to ) override;
+    void permute( const size_t* sources, const size_t* targets,
+      size_t size, size_t current_capacity ) override;
+    std::unique_ptr< base_property_buffer > clone(
+      size_t size, size_t current_capacity ) const override;
     ~derived_property_buffer();
+  protected:
+    void* element( size_t index ) override;
+    const void* element( size_t index ) const override;
   };
 
+  /**@brief Property buffer of trivially copyable elements.
+   *
+   * Elements are stored in a buffer aligned on simd_alignment, such that the
+   * property can be processed by vectorized loops. A resize allocates a new
+   * buffer and copies the kept elements with a single memcpy, while destroyed
+   * elements are reset with a memset when the type is trivially default
+   * constructible. */
+  template< typename T >
+  struct derived_property_buffer< T, true >
+    : public base_property_buffer {
+
+    typedef T  value_type;
+    typedef T* pointer_type;
+
+    static_assert( std::is_default_constructible< value_type >::value,
+       "The property is not default constructible");
+
+    derived_property_buffer( const std::string& name );
+    const std::type_info& get_value_type() const noexcept override
+    {
+      return typeid( value_type );
+    }
+    bool is_trivially_copyable() const noexcept override
+    {
+      return true;
+    }
+    void destroy( size_t index ) override;
+    void destroy( size_t from, size_t end ) override;
+    void resize( size_t old_capacity, size_t new_capacity ) override;
+    void move( size_t from, size_t to ) override;
+    void permute( const size_t* sources, const size_t* targets,
+      size_t size, size_t current_capacity ) override;
+    std::unique_ptr< base_property_buffer > clone(
+      size_t size, size_t current_capacity ) const override;
+    ~derived_property_buffer();
+  protected:
+    void* element( size_t index ) override;
+    const void* element( size_t index ) const override;
+  };
+
+
+  /**@brief Property buffer allocating its elements by pages.
+   *
+   * Pages of page_size elements are allocated when one of their elements is
+   * accessed, and released when all their elements are destroyed at once,
+   * e.g. by a clear or a removal of the last elements. Thus, a property set
+   * on a small region of the elements only costs the pages of that region.
+   * The table of pages is resized with the capacity, but pages are never
+   * copied. */
+  template< typename T >
+  struct paged_property_buffer
+    : public base_property_buffer {
+
+    typedef T  value_type;
+    typedef T* pointer_type;
+    static constexpr size_t page_shift = 10;
+    static constexpr size_t page_size = size_t(1) << page_shift;
+
+    static_assert( std::is_default_constructible< value_type >::value,
+       "The property is not default constructible");
+    static_assert( std::is_move_assignable< value_type >::value,
+       "The property is not move assignable");
+
+    paged_property_buffer( const std::string& name );
+    const std::type_info& get_value_type() const noexcept override
+    {
+      return typeid( value_type );
+    }
+    bool is_allocated( size_t index ) const override;
+    size_t get_allocated_bytes( size_t current_capacity ) const override;
+    void destroy( size_t index ) override;
+    void destroy( size_t from, size_t end ) override;
+    void resize( size_t old_capacity, size_t new_capacity ) override;
+    void move( size_t from, size_t to ) override;
+    void permute( const size_t* sources, const size_t* targets,
+      size_t size, size_t current_capacity ) override;
+    std::unique_ptr< base_property_buffer > clone(
+      size_t size, size_t current_capacity ) const override;
+    ~paged_property_buffer();
+  protected:
+    void* element( size_t index ) override;
+    const void* element( size_t index ) const override;
+  private:
+    std::unique_ptr< std::atomic< pointer_type >[] > m_pages;
+    size_t m_number_of_pages;
+    size_t m_capacity;
+  };
+
+  /**@brief Property buffer storing its elements in a hash map.
+   *
+   * Only the elements accessed by the non constant get() are stored, the
+   * others having the default value. The map is protected by a shared
+   * mutex, such that elements can be accessed and moved from different
+   * threads, and that concurrent reads do not wait for each other. */
+  template< typename T >
+  struct sparse_property_buffer
+    : public base_property_buffer {
+
+    typedef T  value_type;
+
+    static_assert( std::is_default_constructible< value_type >::value,
+       "The property is not default constructible");
+    static_assert( std::is_move_assignable< value_type >::value,
+       "The property is not move assignable");
+
+    sparse_property_buffer( const std::string& name );
+    const std::type_info& get_value_type() const noexcept override
+    {
+      return typeid( value_type );
+    }
+    bool is_allocated( size_t index ) const override;
+    size_t get_allocated_bytes( size_t current_capacity ) const override;
+    void destroy( size_t index ) override;
+    void destroy( size_t from, size_t end ) override;
+    void resize( size_t old_capacity, size_t new_capacity ) override;
+    void move( size_t from, size_t to ) override;
+    void permute( const size_t* sources, const size_t* targets,
+      size_t size, size_t current_capacity ) override;
+    std::unique_ptr< base_property_buffer > clone(
+      size_t size, size_t current_capacity ) const override;
+  protected:
+    void* element( size_t index ) override;
+    const void* element( size_t index ) const override;
+  private:
+    mutable std::shared_timed_mutex m_mutex;
+    std::unordered_map< size_t, value_type > m_elements;
+  };
+
+  /**@brief Create a property buffer of a given storage. */
+  template< typename T >
+  std::unique_ptr< base_property_buffer > make_property_buffer(
+    const std::string& name, base_property_buffer::storage_type storage );
 
   /**
    * Design thoughts:
@@ -130,7 +371,8 @@ namespace median_path {
   template<
     typename atom_handle_type, uint8_t atom_handle_index_bits,
     typename link_handle_type, uint8_t link_handle_index_bits,
-    typename face_handle_type, uint8_t face_handle_index_bits >
+    typename face_handle_type, uint8_t face_handle_index_bits,
+    typename atom_type = GO_NAMESPACE::geometry::ball >
   struct skeleton_datastructure {
 
     /**************************************************************************
@@ -250,20 +492,20 @@ namespace median_path {
 
     /**************************************************************************
      * ELEMENT TYPES:                                                         *
-     *  - an atom is a ball                                                   *
+     *  - an atom is a ball, by default in double precision                   *
      *  - a link is a pair of atom handles                                    *
      *  - a face is a 3-cycle of links along with their atom handles          *
      **************************************************************************/
-    typedef GO_NAMESPACE::geometry::ball atom;
+    typedef atom_type atom;
     struct link {
       link();
-      link& operator=( link&& other );
+      link& operator=( link&& other ) = default;
       atom_handle h1;
       atom_handle h2;
     };
     struct face {
       face();
-      face& operator=( face&& other );
+      face& operator=( face&& other ) = default;
       atom_handle atoms[ 3 ];
       link_handle links[ 3 ];
     };
@@ -305,6 +547,15 @@ namespace median_path {
     void grow_links( link_handle_type new_capacity );
     void grow_faces( face_handle_type new_capacity );
 
+    /**Those three methods reduce the capacity of the buffers to the smallest
+     * capacity that keeps all elements and all allocated handles, i.e. the
+     * maximum of the number of elements and of the highest allocated handle
+     * index plus one. Handles of removed elements beyond that capacity are
+     * forgotten, and may be valid again after the buffers grow back. */
+    void shrink_atoms();
+    void shrink_links();
+    void shrink_faces();
+
     /**************************************************************************
      * ELEMENT CREATION & REMOVAL:                                            *
      * create new elements or delete existing ones. All creation methods may  *
@@ -324,6 +575,31 @@ namespace median_path {
      */
     std::pair< face_handle, face& > create_face();
 
+    /**************************************************************************
+     * CONCURRENT ATOM CREATION:                                              *
+     * create atoms from several threads at once. The room and the handle     *
+     * slots of the new atoms are taken beforehand, such that the creation    *
+     * itself only needs an atomic increment. Only the creation method is     *
+     * thread safe, and no other modification must happen between the begin  *
+     * and the end of a concurrent creation.                                  *
+     **************************************************************************/
+    /**Prepare the creation of at most the requested number of atoms. This may
+     * grow the atom buffers and thus may throw. */
+    void begin_concurrent_atom_creation( atom_handle_type number_of_atoms );
+    /**Create a new atom. This method is thread safe. If more atoms than
+     * requested are created, an exception is thrown.
+     * @return A pair with the handle of the new atom and a reference to it.
+     */
+    std::pair< atom_handle, atom& > create_atom_concurrently();
+    /**Make the created atoms part of the tight buffer and give back the
+     * unused handle slots. */
+    void end_concurrent_atom_creation();
+    /**Create a number of atoms at once, at consecutive indices. The handle
+     * entries are filled in parallel, and the new atoms are left
+     * uninitialized. This may grow the atom buffers and thus may throw.
+     * @return The index of the first created atom. */
+    atom_handle_type create_atoms( atom_handle_type number_of_atoms );
+
     /**For those three methods, if the handle is valid, the corresponding
      * element is removed. When the handle is invalid, an exception is
      * thrown. */
@@ -346,6 +622,37 @@ namespace median_path {
     void remove_link_by_index( link_index index );
     void remove_face_by_index( face_index index );
 
+    /**Those three methods permute the elements, such that the element at
+     * index i is the former element at index sources[i]. Handle entries are
+     * updated, thus handles remain valid, and properties are permuted in
+     * parallel. Topology stored in properties refers to handles and thus
+     * remains valid. */
+    void permute_atoms( const atom_handle_type* sources );
+    void permute_links( const link_handle_type* sources );
+    void permute_faces( const face_handle_type* sources );
+
+    /**Those three methods replace the elements, the handle entries and the
+     * properties of this data structure by a copy of those of another one.
+     * Buffers are copied in parallel with memcpy. The first
+     * kept_properties properties are not copied, but cleared: they must
+     * exist in both data structures, the caller being responsible to fill
+     * them. The other properties of this data structure are replaced by
+     * clones of the properties of the other one. Those methods throw if a
+     * cloned property is not copy assignable. */
+    void copy_atoms( const skeleton_datastructure& other, size_t kept_properties );
+    void copy_links( const skeleton_datastructure& other, size_t kept_properties );
+    void copy_faces( const skeleton_datastructure& other, size_t kept_properties );
+
+    /**Those three methods remove all the elements flagged in a compaction
+     * plan whose build() method was called. The handle entries of removed
+     * elements are released, remaining elements and their properties are
+     * moved in parallel according to the plan, and the properties of the end
+     * of the buffer are destroyed. Topology stored in properties is not
+     * updated: this is the job of the caller. */
+    void compact_atoms( const compaction_plan< atom_handle_type >& plan );
+    void compact_links( const compaction_plan< link_handle_type >& plan );
+    void compact_faces( const compaction_plan< face_handle_type >& plan );
+
     /**************************************************************************
      * ACCESS ELEMENTS, HANDLES AND INDICES:                                  *
      * access to elements, get their handles and their indices. If index,     *
@@ -388,13 +695,23 @@ namespace median_path {
      * - skeleton_link_property_already_exist
      * - skeleton_face_property_already_exist */
     template< typename T >
-    base_property_buffer* add_atom_property( const std::string& name );
+    base_property_buffer* add_atom_property( const std::string& name,
+      base_property_buffer::storage_type storage = base_property_buffer::dense );
 
     template< typename T >
-    base_property_buffer* add_link_property( const std::string& name );
+    base_property_buffer* add_link_property( const std::string& name,
+      base_property_buffer::storage_type storage = base_property_buffer::dense );
 
     template< typename T >
-    base_property_buffer* add_face_property( const std::string& name );
+    base_property_buffer* add_face_property( const std::string& name,
+      base_property_buffer::storage_type storage = base_property_buffer::dense );
+
+    /**Add a property buffer created elsewhere, e.g. by a loader knowing the
+     * type of the property only at run time. The same exceptions are thrown
+     * as with the methods above. */
+    base_property_buffer* add_atom_property( std::unique_ptr< base_property_buffer > property );
+    base_property_buffer* add_link_property( std::unique_ptr< base_property_buffer > property );
+    base_property_buffer* add_face_property( std::unique_ptr< base_property_buffer > property );
 
     /**Iterates over the properties to delete the one with the same name. It
      * is thus a O(n) time complexity for n stored properties. Since the
@@ -433,24 +750,27 @@ namespace median_path {
     void remove_link_property( base_property_buffer& property );
     void remove_face_property( base_property_buffer& property );
 
-    std::unique_ptr<atom[]> m_atoms;
-    std::unique_ptr<atom_handle_type[]> m_atom_index_to_handle_index;
-    std::unique_ptr<atom_handle_entry[]> m_atom_handles;
+    relocatable_buffer<atom> m_atoms;
+    relocatable_buffer<atom_handle_type> m_atom_index_to_handle_index;
+    relocatable_buffer<atom_handle_entry> m_atom_handles;
     std::vector< std::unique_ptr<base_property_buffer> > m_atom_properties;
 
-    std::unique_ptr<link[]> m_links;
-    std::unique_ptr<link_handle_type[]> m_link_index_to_handle_index;
-    std::unique_ptr<link_handle_entry[]> m_link_handles;
+    relocatable_buffer<link> m_links;
+    relocatable_buffer<link_handle_type> m_link_index_to_handle_index;
+    relocatable_buffer<link_handle_entry> m_link_handles;
     std::vector< std::unique_ptr<base_property_buffer> > m_link_properties;
 
-    std::unique_ptr<face[]> m_faces;
-    std::unique_ptr<face_handle_type[]> m_face_index_to_handle_index;
-    std::unique_ptr<face_handle_entry[]> m_face_handles;
+    relocatable_buffer<face> m_faces;
+    relocatable_buffer<face_handle_type> m_face_index_to_handle_index;
+    relocatable_buffer<face_handle_entry> m_face_handles;
     std::vector< std::unique_ptr<base_property_buffer> > m_face_properties;
 
     atom_handle_type m_atoms_capacity;
     atom_handle_type m_atoms_size;
     atom_handle_type m_atoms_next_free_handle_slot;
+    std::unique_ptr<atom_handle_type[]> m_atoms_reserved_handle_slots;
+    atom_handle_type m_atoms_reserved;
+    std::atomic< atom_handle_type > m_atoms_concurrently_created;
 
     link_handle_type m_links_capacity;
     link_handle_type m_links_size;
@@ -459,19 +779,27 @@ namespace median_path {
     face_handle_type m_faces_capacity;
     face_handle_type m_faces_size;
     face_handle_type m_faces_next_free_handle_slot;
+
+    /**Policy used to grow full buffers when an element is created. */
+    growth_policy m_growth_policy;
+    /**Journal receiving the changes of elements, or nullptr. It is owned
+     * by the skeleton. */
+    change_journal* m_journal;
   };
 
 # define dts_template_parameters                               \
  template<                                                     \
    typename atom_handle_type, uint8_t atom_handle_index_bits,  \
    typename link_handle_type, uint8_t link_handle_index_bits,  \
-   typename face_handle_type, uint8_t face_handle_index_bits >
+   typename face_handle_type, uint8_t face_handle_index_bits,  \
+   typename atom_type >
 
 # define dts_type                                              \
   skeleton_datastructure<                                      \
   atom_handle_type, atom_handle_index_bits,                    \
   link_handle_type, link_handle_index_bits,                    \
-  face_handle_type, face_handle_index_bits>
+  face_handle_type, face_handle_index_bits,                    \
+  atom_type>
 
 # define dts_definition(ret_type)                              \
   dts_template_parameters                                      \
@@ -3,8 +3,10 @@
       m_links{ nullptr }, m_link_index_to_handle_index{ nullptr }, m_link_handles{ nullptr },
       m_faces{ nullptr }, m_face_index_to_handle_index{ nullptr }, m_face_handles{ nullptr },
       m_atoms_capacity{ 0 }, m_atoms_size{ 0 }, m_atoms_next_free_handle_slot{ 0 },
+      m_atoms_reserved_handle_slots{ nullptr }, m_atoms_reserved{ 0 }, m_atoms_concurrently_created{ 0 },
       m_links_capacity{ 0 }, m_links_size{ 0 }, m_links_next_free_handle_slot{ 0 },
-      m_faces_capacity{ 0 }, m_faces_size{ 0 }, m_faces_next_free_handle_slot{ 0 }
+      m_faces_capacity{ 0 }, m_faces_size{ 0 }, m_faces_next_free_handle_slot{ 0 },
+      m_journal{ nullptr }
   {}
 
   dts_definition()::skeleton_datastructure( atom_handle_type nb_atoms, link_handle_type nb_links, face_handle_type nb_faces )
@@ -12,8 +14,10 @@
 	  m_links{ nullptr }, m_link_index_to_handle_index{ nullptr }, m_link_handles{ nullptr },
 	  m_faces{ nullptr }, m_face_index_to_handle_index{ nullptr }, m_face_handles{ nullptr },
 	  m_atoms_capacity{ 0 }, m_atoms_size{ 0 }, m_atoms_next_free_handle_slot{ 0 },
+	  m_atoms_reserved_handle_slots{ nullptr }, m_atoms_reserved{ 0 }, m_atoms_concurrently_created{ 0 },
 	  m_links_capacity{ 0 }, m_links_size{ 0 }, m_links_next_free_handle_slot{ 0 },
-	  m_faces_capacity{ 0 }, m_faces_size{ 0 }, m_faces_next_free_handle_slot{ 0 }
+	  m_faces_capacity{ 0 }, m_faces_size{ 0 }, m_faces_next_free_handle_slot{ 0 },
+	  m_journal{ nullptr }
   {
     if( nb_atoms )
 	  grow_atoms( nb_atoms );
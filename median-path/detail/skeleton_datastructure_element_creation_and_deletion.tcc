@@ -1,25 +1,29 @@
   template<
       typename atom_handle_type, uint8_t atom_handle_index_bits,
       typename link_handle_type, uint8_t link_handle_index_bits,
-      typename face_handle_type, uint8_t face_handle_index_bits >
+      typename face_handle_type, uint8_t face_handle_index_bits,
+      typename atom_type >
   std::pair<
     typename skeleton_datastructure<
       atom_handle_type, atom_handle_index_bits,
       link_handle_type, link_handle_index_bits,
-      face_handle_type, face_handle_index_bits>::atom_handle,
+      face_handle_type, face_handle_index_bits,
+      atom_type>::atom_handle,
     typename skeleton_datastructure<
       atom_handle_type, atom_handle_index_bits,
       link_handle_type, link_handle_index_bits,
-      face_handle_type, face_handle_index_bits>::atom& >
+      face_handle_type, face_handle_index_bits,
+      atom_type>::atom& >
   skeleton_datastructure<
     atom_handle_type, atom_handle_index_bits,
     link_handle_type, link_handle_index_bits,
-    face_handle_type, face_handle_index_bits>::create_atom()
+    face_handle_type, face_handle_index_bits,
+    atom_type>::create_atom()
   {
     if( m_atoms_size == m_atoms_capacity )
-        grow_atoms( std::min(
+        grow_atoms( atom_handle_type( std::min< size_t >(
           max_atom_handle_index,
-          m_atoms_capacity + std::max( m_atoms_capacity, atom_handle_type{10} ) ) );
+          m_growth_policy.next_capacity( m_atoms_capacity, m_atoms_capacity + 1 ) ) ) );
 
     /* fetch the handle entry */
     const auto handle_index = m_atoms_next_free_handle_slot;
@@ -39,6 +43,8 @@
     std::pair< atom_handle, atom& > result = {
         atom_handle( handle_index, entry->counter ),
         m_atoms[ m_atoms_size ] };
+    if( m_journal )
+      m_journal->record( m_journal->atoms.added_ranges, m_atoms_size, m_atoms_size + 1 );
     /* update this */
     ++m_atoms_size;
     return result;
@@ -47,25 +53,29 @@
   template<
         typename atom_handle_type, uint8_t atom_handle_index_bits,
         typename link_handle_type, uint8_t link_handle_index_bits,
-        typename face_handle_type, uint8_t face_handle_index_bits >
+        typename face_handle_type, uint8_t face_handle_index_bits,
+        typename atom_type >
     std::pair<
       typename skeleton_datastructure<
         atom_handle_type, atom_handle_index_bits,
         link_handle_type, link_handle_index_bits,
-        face_handle_type, face_handle_index_bits>::link_handle,
+        face_handle_type, face_handle_index_bits,
+        atom_type>::link_handle,
       typename skeleton_datastructure<
         atom_handle_type, atom_handle_index_bits,
         link_handle_type, link_handle_index_bits,
-        face_handle_type, face_handle_index_bits>::link& >
+        face_handle_type, face_handle_index_bits,
+        atom_type>::link& >
     skeleton_datastructure<
       atom_handle_type, atom_handle_index_bits,
       link_handle_type, link_handle_index_bits,
-      face_handle_type, face_handle_index_bits>::create_link()
+      face_handle_type, face_handle_index_bits,
+      atom_type>::create_link()
     {
       if( m_links_size == m_links_capacity )
-        grow_links( std::min(
+        grow_links( link_handle_type( std::min< size_t >(
           max_link_handle_index,
-          m_links_capacity + std::max( m_links_capacity, link_handle_type{10} ) ) );
+          m_growth_policy.next_capacity( m_links_capacity, m_links_capacity + 1 ) ) ) );
       /* fetch the handle entry */
       const auto handle_index = m_links_next_free_handle_slot;
       auto entry = m_link_handles.get() + handle_index;
@@ -83,6 +93,8 @@
       std::pair< link_handle, link& > result = {
           link_handle( handle_index, entry->counter ),
           m_links[ m_links_size ] };
+      if( m_journal )
+        m_journal->record( m_journal->links.added_ranges, m_links_size, m_links_size + 1 );
       /* update this */
       ++m_links_size;
       return result;
@@ -91,25 +103,29 @@
     template<
         typename atom_handle_type, uint8_t atom_handle_index_bits,
         typename link_handle_type, uint8_t link_handle_index_bits,
-        typename face_handle_type, uint8_t face_handle_index_bits >
+        typename face_handle_type, uint8_t face_handle_index_bits,
+        typename atom_type >
     std::pair<
       typename skeleton_datastructure<
         atom_handle_type, atom_handle_index_bits,
         link_handle_type, link_handle_index_bits,
-        face_handle_type, face_handle_index_bits>::face_handle,
+        face_handle_type, face_handle_index_bits,
+        atom_type>::face_handle,
       typename skeleton_datastructure<
         atom_handle_type, atom_handle_index_bits,
         link_handle_type, link_handle_index_bits,
-        face_handle_type, face_handle_index_bits>::face& >
+        face_handle_type, face_handle_index_bits,
+        atom_type>::face& >
     skeleton_datastructure<
       atom_handle_type, atom_handle_index_bits,
       link_handle_type, link_handle_index_bits,
-      face_handle_type, face_handle_index_bits>::create_face()
+      face_handle_type, face_handle_index_bits,
+      atom_type>::create_face()
     {
       if( m_faces_size == m_faces_capacity )
-        grow_faces( std::min(
+        grow_faces( face_handle_type( std::min< size_t >(
           max_face_handle_index,
-          m_faces_capacity + std::max( m_faces_capacity, face_handle_type{10} ) ) );
+          m_growth_policy.next_capacity( m_faces_capacity, m_faces_capacity + 1 ) ) ) );
       /* fetch the handle entry */
       const auto handle_index = m_faces_next_free_handle_slot;
       auto entry = m_face_handles.get() + handle_index;
@@ -127,12 +143,121 @@
       std::pair< face_handle, face& > result = {
           face_handle( handle_index, entry->counter ),
           m_faces[ m_faces_size ] };
+      if( m_journal )
+        m_journal->record( m_journal->faces.added_ranges, m_faces_size, m_faces_size + 1 );
       /* update this */
 
       ++m_faces_size;
       return result;
     }
 
+    dts_definition(void)::begin_concurrent_atom_creation( atom_handle_type number_of_atoms )
+    {
+      if( m_atoms_size + number_of_atoms > m_atoms_capacity )
+        grow_atoms( m_atoms_size + number_of_atoms );
+
+      /* pop the handle slots from the free list */
+      m_atoms_reserved_handle_slots = std::make_unique<atom_handle_type[]>( number_of_atoms );
+      for( atom_handle_type i = 0; i < number_of_atoms; ++ i )
+        {
+          m_atoms_reserved_handle_slots[ i ] = m_atoms_next_free_handle_slot;
+          m_atoms_next_free_handle_slot = m_atom_handles[ m_atoms_next_free_handle_slot ].next_free_index;
+        }
+      m_atoms_reserved = number_of_atoms;
+      m_atoms_concurrently_created.store( 0, std::memory_order_relaxed );
+    }
+
+    template<
+        typename atom_handle_type, uint8_t atom_handle_index_bits,
+        typename link_handle_type, uint8_t link_handle_index_bits,
+        typename face_handle_type, uint8_t face_handle_index_bits,
+        typename atom_type >
+    std::pair<
+      typename skeleton_datastructure<
+        atom_handle_type, atom_handle_index_bits,
+        link_handle_type, link_handle_index_bits,
+        face_handle_type, face_handle_index_bits,
+        atom_type>::atom_handle,
+      typename skeleton_datastructure<
+        atom_handle_type, atom_handle_index_bits,
+        link_handle_type, link_handle_index_bits,
+        face_handle_type, face_handle_index_bits,
+        atom_type>::atom& >
+    skeleton_datastructure<
+      atom_handle_type, atom_handle_index_bits,
+      link_handle_type, link_handle_index_bits,
+      face_handle_type, face_handle_index_bits,
+      atom_type>::create_atom_concurrently()
+    {
+      const auto slot = m_atoms_concurrently_created.fetch_add( 1, std::memory_order_relaxed );
+      if( slot >= m_atoms_reserved )
+        MP_THROW_EXCEPTION( skeleton_atom_buffer_overflow );
+
+      /* the handle entry and the element are owned by this thread */
+      const auto handle_index = m_atoms_reserved_handle_slots[ slot ];
+      const auto atom_index = m_atoms_size + slot;
+      auto entry = m_atom_handles.get() + handle_index;
+
+      /* update the entry */
+      ++entry->counter;
+      if( entry->counter > max_atom_handle_counter )
+        entry->counter = 0;
+      entry->atom_index = atom_index;
+      entry->next_free_index = 0;
+      entry->status = STATUS_ALLOCATED;
+      /* map the element index to the handle entry */
+      m_atom_index_to_handle_index[ atom_index ] = handle_index;
+      return {
+          atom_handle( handle_index, entry->counter ),
+          m_atoms[ atom_index ] };
+    }
+
+    dts_definition(void)::end_concurrent_atom_creation()
+    {
+      const auto created = std::min( m_atoms_reserved,
+          m_atoms_concurrently_created.load( std::memory_order_relaxed ) );
+
+      /* give back the unused slots in reverse order to restore the free list */
+      for( atom_handle_type i = m_atoms_reserved; i > created; -- i )
+        {
+          const auto handle_index = m_atoms_reserved_handle_slots[ i - 1 ];
+          m_atom_handles[ handle_index ].next_free_index = m_atoms_next_free_handle_slot;
+          m_atoms_next_free_handle_slot = handle_index;
+        }
+
+      if( m_journal )
+        m_journal->record( m_journal->atoms.added_ranges, m_atoms_size, m_atoms_size + created );
+      m_atoms_size += created;
+      m_atoms_reserved = 0;
+      m_atoms_reserved_handle_slots.reset( nullptr );
+      m_atoms_concurrently_created.store( 0, std::memory_order_relaxed );
+    }
+
+    dts_definition(atom_handle_type)::create_atoms( atom_handle_type number_of_atoms )
+    {
+      const atom_handle_type first = m_atoms_size;
+      begin_concurrent_atom_creation( number_of_atoms );
+
+      /* slot i receives the index first + i, so the order is deterministic */
+      # pragma omp parallel for
+      for( atom_handle_type i = 0; i < number_of_atoms; ++ i )
+        {
+          const auto handle_index = m_atoms_reserved_handle_slots[ i ];
+          auto entry = m_atom_handles.get() + handle_index;
+          ++entry->counter;
+          if( entry->counter > max_atom_handle_counter )
+            entry->counter = 0;
+          entry->atom_index = first + i;
+          entry->next_free_index = 0;
+          entry->status = STATUS_ALLOCATED;
+          m_atom_index_to_handle_index[ first + i ] = handle_index;
+        }
+
+      m_atoms_concurrently_created.store( number_of_atoms, std::memory_order_relaxed );
+      end_concurrent_atom_creation();
+      return first;
+    }
+
 
     dts_definition(void)::remove( atom_handle h )
     {
@@ -153,9 +278,14 @@
       entry->status = STATUS_FREE;
       m_atoms_next_free_handle_slot = h.index;
 
+      if( m_journal )
+        m_journal->record( m_journal->atoms.removed_ranges, index, index + 1 );
+
       // move the last atom into this one to keep the buffer tight
       if( --m_atoms_size && index != m_atoms_size )
         {
+          if( m_journal )
+            m_journal->record( m_journal->atoms.moved_ranges, index, index + 1 );
           // move the atom itself
           m_atoms[ index ] = std::move( m_atoms[ m_atoms_size ] );
 
@@ -200,9 +330,14 @@
       entry->status = STATUS_FREE;
       m_links_next_free_handle_slot = h.index;
 
+      if( m_journal )
+        m_journal->record( m_journal->links.removed_ranges, index, index + 1 );
+
       // move the last link into this one to keep the buffer tight
       if( --m_links_size && index != m_links_size )
         {
+          if( m_journal )
+            m_journal->record( m_journal->links.moved_ranges, index, index + 1 );
           // move the link itself
           m_links[ index ] = std::move( m_links[ m_links_size ] );
           m_links[ m_links_size ] = std::move(link{});
@@ -247,9 +382,14 @@
       entry->status = STATUS_FREE;
       m_faces_next_free_handle_slot = h.index;
 
+      if( m_journal )
+        m_journal->record( m_journal->faces.removed_ranges, index, index + 1 );
+
       // move the last face into this one to keep the buffer tight
       if( --m_faces_size && index != m_faces_size )
         {
+          if( m_journal )
+            m_journal->record( m_journal->faces.moved_ranges, index, index + 1 );
           // move the face itself
           m_faces[ index ] = std::move( m_faces[ m_faces_size ] );
           m_faces[ m_faces_size ] = std::move(face{});
@@ -290,9 +430,14 @@
           m_atoms_next_free_handle_slot = entry_index;
         }
 
+        if( m_journal )
+          m_journal->record( m_journal->atoms.removed_ranges, index, index + 1 );
+
         // move the last atom into this one to keep the buffer tight
         if( --m_atoms_size && index != m_atoms_size )
           {
+            if( m_journal )
+              m_journal->record( m_journal->atoms.moved_ranges, index, index + 1 );
             // move the atom itself
             m_atoms[ index ] = std::move( m_atoms[ m_atoms_size ] );
 
@@ -332,9 +477,14 @@
           m_links_next_free_handle_slot = entry_index;
         }
 
+        if( m_journal )
+          m_journal->record( m_journal->links.removed_ranges, index, index + 1 );
+
         // move the last link into this one to keep the buffer tight
         if( --m_links_size && index != m_links_size )
           {
+            if( m_journal )
+              m_journal->record( m_journal->links.moved_ranges, index, index + 1 );
             // move the link itself
             m_links[ index ] = std::move( m_links[ m_links_size ] );
             m_links[ m_links_size ] = std::move(link{});
@@ -376,9 +526,14 @@
           m_faces_next_free_handle_slot = entry_index;
         }
 
+        if( m_journal )
+          m_journal->record( m_journal->faces.removed_ranges, index, index + 1 );
+
         // move the last face into this one to keep the buffer tight
         if( --m_faces_size && index != m_faces_size )
           {
+            if( m_journal )
+              m_journal->record( m_journal->faces.moved_ranges, index, index + 1 );
             // move the face itself
             m_faces[ index ] = std::move( m_faces[ m_faces_size ] );
             m_faces[ m_faces_size ] = std::move(face{});
@@ -404,6 +559,405 @@
           }
     }
 
+    dts_definition(void)::compact_atoms( const compaction_plan< atom_handle_type >& plan )
+    {
+      const atom_handle_type size = m_atoms_size;
+      const atom_handle_type nremoved = plan.number_of_removed;
+      if( !nremoved )
+        return;
+      const atom_handle_type* removed = plan.removed.data();
+      const atom_handle_type* sources = plan.sources.data();
+      const atom_handle_type* targets = plan.targets.data();
+      const atom_handle_type nmoves = plan.number_of_moves;
+
+      /* release the entries of removed atoms, chained in increasing index order,
+       * before the moves overwrite the atom --> handle mapping */
+      # pragma omp parallel for
+      for( atom_handle_type k = 0; k < nremoved; ++ k )
+        {
+          auto& entry = m_atom_handles[ m_atom_index_to_handle_index[ removed[ k ] ] ];
+          entry.next_free_index = k + 1 < nremoved
+              ? m_atom_index_to_handle_index[ removed[ k + 1 ] ]
+              : m_atoms_next_free_handle_slot;
+          entry.status = STATUS_FREE;
+        }
+      m_atoms_next_free_handle_slot = m_atom_index_to_handle_index[ removed[ 0 ] ];
+
+      if( plan.preserve_order )
+        {
+          /* moves are done in increasing order, but each buffer, i.e. the
+           * atoms with their handles and every property, is processed by a
+           * different thread */
+          const size_t nbuffers = m_atom_properties.size() + 1;
+          # pragma omp parallel for schedule(dynamic)
+          for( size_t b = 0; b < nbuffers; ++ b )
+            {
+              if( b + 1 == nbuffers )
+                {
+                  for( atom_handle_type k = 0; k < nmoves; ++ k )
+                    {
+                      m_atoms[ targets[ k ] ] = std::move( m_atoms[ sources[ k ] ] );
+                      const auto entry_index = m_atom_index_to_handle_index[ sources[ k ] ];
+                      m_atom_handles[ entry_index ].atom_index = targets[ k ];
+                      m_atom_index_to_handle_index[ targets[ k ] ] = entry_index;
+                    }
+                }
+              else
+                {
+                  auto& property = *m_atom_properties[ b ];
+                  for( atom_handle_type k = 0; k < nmoves; ++ k )
+                    property.move( sources[ k ], targets[ k ] );
+                }
+            }
+        }
+      else
+        {
+          // sources and targets are disjoint
+          # pragma omp parallel for
+          for( atom_handle_type k = 0; k < nmoves; ++ k )
+            {
+              m_atoms[ targets[ k ] ] = std::move( m_atoms[ sources[ k ] ] );
+              for( auto& property : m_atom_properties )
+                property->move( sources[ k ], targets[ k ] );
+              const auto entry_index = m_atom_index_to_handle_index[ sources[ k ] ];
+              m_atom_handles[ entry_index ].atom_index = targets[ k ];
+              m_atom_index_to_handle_index[ targets[ k ] ] = entry_index;
+            }
+        }
+
+      // destroy properties of atoms in [[new_size, size[[
+      # pragma omp parallel for schedule(dynamic)
+      for( size_t b = 0; b < m_atom_properties.size(); ++ b )
+        m_atom_properties[ b ]->destroy( plan.new_size, size );
+      m_atoms_size = plan.new_size;
+      if( m_journal )
+        {
+          for( atom_handle_type k = 0; k < nremoved; ++ k )
+            m_journal->record( m_journal->atoms.removed_ranges, removed[ k ], removed[ k ] + 1 );
+          for( atom_handle_type k = 0; k < nmoves; ++ k )
+            m_journal->record( m_journal->atoms.moved_ranges, targets[ k ], targets[ k ] + 1 );
+        }
+    }
+
+    dts_definition(void)::compact_links( const compaction_plan< link_handle_type >& plan )
+    {
+      const link_handle_type size = m_links_size;
+      const link_handle_type nremoved = plan.number_of_removed;
+      if( !nremoved )
+        return;
+      const link_handle_type* removed = plan.removed.data();
+      const link_handle_type* sources = plan.sources.data();
+      const link_handle_type* targets = plan.targets.data();
+      const link_handle_type nmoves = plan.number_of_moves;
+
+      /* release the entries of removed links, chained in increasing index order,
+       * before the moves overwrite the link --> handle mapping */
+      # pragma omp parallel for
+      for( link_handle_type k = 0; k < nremoved; ++ k )
+        {
+          auto& entry = m_link_handles[ m_link_index_to_handle_index[ removed[ k ] ] ];
+          entry.next_free_index = k + 1 < nremoved
+              ? m_link_index_to_handle_index[ removed[ k + 1 ] ]
+              : m_links_next_free_handle_slot;
+          entry.status = STATUS_FREE;
+        }
+      m_links_next_free_handle_slot = m_link_index_to_handle_index[ removed[ 0 ] ];
+
+      if( plan.preserve_order )
+        {
+          /* moves are done in increasing order, but each buffer, i.e. the
+           * links with their handles and every property, is processed by a
+           * different thread */
+          const size_t nbuffers = m_link_properties.size() + 1;
+          # pragma omp parallel for schedule(dynamic)
+          for( size_t b = 0; b < nbuffers; ++ b )
+            {
+              if( b + 1 == nbuffers )
+                {
+                  for( link_handle_type k = 0; k < nmoves; ++ k )
+                    {
+                      m_links[ targets[ k ] ] = std::move( m_links[ sources[ k ] ] );
+                      const auto entry_index = m_link_index_to_handle_index[ sources[ k ] ];
+                      m_link_handles[ entry_index ].link_index = targets[ k ];
+                      m_link_index_to_handle_index[ targets[ k ] ] = entry_index;
+                    }
+                }
+              else
+                {
+                  auto& property = *m_link_properties[ b ];
+                  for( link_handle_type k = 0; k < nmoves; ++ k )
+                    property.move( sources[ k ], targets[ k ] );
+                }
+            }
+        }
+      else
+        {
+          // sources and targets are disjoint
+          # pragma omp parallel for
+          for( link_handle_type k = 0; k < nmoves; ++ k )
+            {
+              m_links[ targets[ k ] ] = std::move( m_links[ sources[ k ] ] );
+              for( auto& property : m_link_properties )
+                property->move( sources[ k ], targets[ k ] );
+              const auto entry_index = m_link_index_to_handle_index[ sources[ k ] ];
+              m_link_handles[ entry_index ].link_index = targets[ k ];
+              m_link_index_to_handle_index[ targets[ k ] ] = entry_index;
+            }
+        }
+
+      // destroy properties of links in [[new_size, size[[
+      # pragma omp parallel for schedule(dynamic)
+      for( size_t b = 0; b < m_link_properties.size(); ++ b )
+        m_link_properties[ b ]->destroy( plan.new_size, size );
+      m_links_size = plan.new_size;
+      if( m_journal )
+        {
+          for( link_handle_type k = 0; k < nremoved; ++ k )
+            m_journal->record( m_journal->links.removed_ranges, removed[ k ], removed[ k ] + 1 );
+          for( link_handle_type k = 0; k < nmoves; ++ k )
+            m_journal->record( m_journal->links.moved_ranges, targets[ k ], targets[ k ] + 1 );
+        }
+    }
+
+    dts_definition(void)::compact_faces( const compaction_plan< face_handle_type >& plan )
+    {
+      const face_handle_type size = m_faces_size;
+      const face_handle_type nremoved = plan.number_of_removed;
+      if( !nremoved )
+        return;
+      const face_handle_type* removed = plan.removed.data();
+      const face_handle_type* sources = plan.sources.data();
+      const face_handle_type* targets = plan.targets.data();
+      const face_handle_type nmoves = plan.number_of_moves;
+
+      /* release the entries of removed faces, chained in increasing index order,
+       * before the moves overwrite the face --> handle mapping */
+      # pragma omp parallel for
+      for( face_handle_type k = 0; k < nremoved; ++ k )
+        {
+          auto& entry = m_face_handles[ m_face_index_to_handle_index[ removed[ k ] ] ];
+          entry.next_free_index = k + 1 < nremoved
+              ? m_face_index_to_handle_index[ removed[ k + 1 ] ]
+              : m_faces_next_free_handle_slot;
+          entry.status = STATUS_FREE;
+        }
+      m_faces_next_free_handle_slot = m_face_index_to_handle_index[ removed[ 0 ] ];
+
+      if( plan.preserve_order )
+        {
+          /* moves are done in increasing order, but each buffer, i.e. the
+           * faces with their handles and every property, is processed by a
+           * different thread */
+          const size_t nbuffers = m_face_properties.size() + 1;
+          # pragma omp parallel for schedule(dynamic)
+          for( size_t b = 0; b < nbuffers; ++ b )
+            {
+              if( b + 1 == nbuffers )
+                {
+                  for( face_handle_type k = 0; k < nmoves; ++ k )
+                    {
+                      m_faces[ targets[ k ] ] = std::move( m_faces[ sources[ k ] ] );
+                      const auto entry_index = m_face_index_to_handle_index[ sources[ k ] ];
+                      m_face_handles[ entry_index ].face_index = targets[ k ];
+                      m_face_index_to_handle_index[ targets[ k ] ] = entry_index;
+                    }
+                }
+              else
+                {
+                  auto& property = *m_face_properties[ b ];
+                  for( face_handle_type k = 0; k < nmoves; ++ k )
+                    property.move( sources[ k ], targets[ k ] );
+                }
+            }
+        }
+      else
+        {
+          // sources and targets are disjoint
+          # pragma omp parallel for
+          for( face_handle_type k = 0; k < nmoves; ++ k )
+            {
+              m_faces[ targets[ k ] ] = std::move( m_faces[ sources[ k ] ] );
+              for( auto& property : m_face_properties )
+                property->move( sources[ k ], targets[ k ] );
+              const auto entry_index = m_face_index_to_handle_index[ sources[ k ] ];
+              m_face_handles[ entry_index ].face_index = targets[ k ];
+              m_face_index_to_handle_index[ targets[ k ] ] = entry_index;
+            }
+        }
+
+      // destroy properties of faces in [[new_size, size[[
+      # pragma omp parallel for schedule(dynamic)
+      for( size_t b = 0; b < m_face_properties.size(); ++ b )
+        m_face_properties[ b ]->destroy( plan.new_size, size );
+      m_faces_size = plan.new_size;
+      if( m_journal )
+        {
+          for( face_handle_type k = 0; k < nremoved; ++ k )
+            m_journal->record( m_journal->faces.removed_ranges, removed[ k ], removed[ k ] + 1 );
+          for( face_handle_type k = 0; k < nmoves; ++ k )
+            m_journal->record( m_journal->faces.moved_ranges, targets[ k ], targets[ k ] + 1 );
+        }
+    }
+
+    dts_definition(void)::copy_atoms( const skeleton_datastructure& other, size_t kept_properties )
+    {
+      clear_atoms( 0 );
+      if( other.m_atoms_capacity > m_atoms_capacity )
+        grow_atoms( other.m_atoms_capacity );
+
+      const atom_handle_type size = other.m_atoms_size;
+      parallel_memcpy( m_atoms.get(), other.m_atoms.get(), size * sizeof( atom ) );
+      parallel_memcpy( m_atom_index_to_handle_index.get(), other.m_atom_index_to_handle_index.get(),
+        size * sizeof( atom_handle_type ) );
+      /* entries after the capacity of the other data structure are free and
+       * chained in increasing order, as are the last free entries of the
+       * other data structure */
+      parallel_memcpy( m_atom_handles.get(), other.m_atom_handles.get(),
+        other.m_atoms_capacity * sizeof( atom_handle_entry ) );
+      m_atoms_size = size;
+      m_atoms_next_free_handle_slot = other.m_atoms_next_free_handle_slot;
+      if( m_journal )
+        m_journal->record( m_journal->atoms.added_ranges, 0, size );
+
+      m_atom_properties.resize( kept_properties );
+      for( size_t i = kept_properties; i < other.m_atom_properties.size(); ++ i )
+        m_atom_properties.push_back( other.m_atom_properties[ i ]->clone( size, m_atoms_capacity ) );
+    }
+
+    dts_definition(void)::copy_links( const skeleton_datastructure& other, size_t kept_properties )
+    {
+      clear_links( 0 );
+      if( other.m_links_capacity > m_links_capacity )
+        grow_links( other.m_links_capacity );
+
+      const link_handle_type size = other.m_links_size;
+      parallel_memcpy( m_links.get(), other.m_links.get(), size * sizeof( link ) );
+      parallel_memcpy( m_link_index_to_handle_index.get(), other.m_link_index_to_handle_index.get(),
+        size * sizeof( link_handle_type ) );
+      /* entries after the capacity of the other data structure are free and
+       * chained in increasing order, as are the last free entries of the
+       * other data structure */
+      parallel_memcpy( m_link_handles.get(), other.m_link_handles.get(),
+        other.m_links_capacity * sizeof( link_handle_entry ) );
+      m_links_size = size;
+      m_links_next_free_handle_slot = other.m_links_next_free_handle_slot;
+      if( m_journal )
+        m_journal->record( m_journal->links.added_ranges, 0, size );
+
+      m_link_properties.resize( kept_properties );
+      for( size_t i = kept_properties; i < other.m_link_properties.size(); ++ i )
+        m_link_properties.push_back( other.m_link_properties[ i ]->clone( size, m_links_capacity ) );
+    }
+
+    dts_definition(void)::copy_faces( const skeleton_datastructure& other, size_t kept_properties )
+    {
+      clear_faces( 0 );
+      if( other.m_faces_capacity > m_faces_capacity )
+        grow_faces( other.m_faces_capacity );
+
+      const face_handle_type size = other.m_faces_size;
+      parallel_memcpy( m_faces.get(), other.m_faces.get(), size * sizeof( face ) );
+      parallel_memcpy( m_face_index_to_handle_index.get(), other.m_face_index_to_handle_index.get(),
+        size * sizeof( face_handle_type ) );
+      /* entries after the capacity of the other data structure are free and
+       * chained in increasing order, as are the last free entries of the
+       * other data structure */
+      parallel_memcpy( m_face_handles.get(), other.m_face_handles.get(),
+        other.m_faces_capacity * sizeof( face_handle_entry ) );
+      m_faces_size = size;
+      m_faces_next_free_handle_slot = other.m_faces_next_free_handle_slot;
+      if( m_journal )
+        m_journal->record( m_journal->faces.added_ranges, 0, size );
+
+      m_face_properties.resize( kept_properties );
+      for( size_t i = kept_properties; i < other.m_face_properties.size(); ++ i )
+        m_face_properties.push_back( other.m_face_properties[ i ]->clone( size, m_faces_capacity ) );
+    }
+
+    dts_definition(void)::permute_atoms( const atom_handle_type* sources )
+    {
+      const atom_handle_type size = m_atoms_size;
+      std::vector< size_t > from( size ), to( size );
+      std::vector< atom > atoms( size );
+      std::vector< atom_handle_type > handle_indices( size );
+      # pragma omp parallel for
+      for( atom_handle_type i = 0; i < size; ++ i )
+        {
+          from[ i ] = sources[ i ];
+          to[ sources[ i ] ] = i;
+          atoms[ i ] = std::move( m_atoms[ sources[ i ] ] );
+          handle_indices[ i ] = m_atom_index_to_handle_index[ sources[ i ] ];
+        }
+      // update the handle --> atom and atom --> handle mappings
+      # pragma omp parallel for
+      for( atom_handle_type i = 0; i < size; ++ i )
+        {
+          m_atoms[ i ] = std::move( atoms[ i ] );
+          m_atom_index_to_handle_index[ i ] = handle_indices[ i ];
+          m_atom_handles[ handle_indices[ i ] ].atom_index = i;
+        }
+      for( auto& property : m_atom_properties )
+        property->permute( from.data(), to.data(), size, m_atoms_capacity );
+      if( m_journal )
+        m_journal->record( m_journal->atoms.moved_ranges, 0, size );
+    }
+
+    dts_definition(void)::permute_links( const link_handle_type* sources )
+    {
+      const link_handle_type size = m_links_size;
+      std::vector< size_t > from( size ), to( size );
+      std::vector< link > links( size );
+      std::vector< link_handle_type > handle_indices( size );
+      # pragma omp parallel for
+      for( link_handle_type i = 0; i < size; ++ i )
+        {
+          from[ i ] = sources[ i ];
+          to[ sources[ i ] ] = i;
+          links[ i ] = std::move( m_links[ sources[ i ] ] );
+          handle_indices[ i ] = m_link_index_to_handle_index[ sources[ i ] ];
+        }
+      // update the handle --> link and link --> handle mappings
+      # pragma omp parallel for
+      for( link_handle_type i = 0; i < size; ++ i )
+        {
+          m_links[ i ] = std::move( links[ i ] );
+          m_link_index_to_handle_index[ i ] = handle_indices[ i ];
+          m_link_handles[ handle_indices[ i ] ].link_index = i;
+        }
+      for( auto& property : m_link_properties )
+        property->permute( from.data(), to.data(), size, m_links_capacity );
+      if( m_journal )
+        m_journal->record( m_journal->links.moved_ranges, 0, size );
+    }
+
+    dts_definition(void)::permute_faces( const face_handle_type* sources )
+    {
+      const face_handle_type size = m_faces_size;
+      std::vector< size_t > from( size ), to( size );
+      std::vector< face > faces( size );
+      std::vector< face_handle_type > handle_indices( size );
+      # pragma omp parallel for
+      for( face_handle_type i = 0; i < size; ++ i )
+        {
+          from[ i ] = sources[ i ];
+          to[ sources[ i ] ] = i;
+          faces[ i ] = std::move( m_faces[ sources[ i ] ] );
+          handle_indices[ i ] = m_face_index_to_handle_index[ sources[ i ] ];
+        }
+      // update the handle --> face and face --> handle mappings
+      # pragma omp parallel for
+      for( face_handle_type i = 0; i < size; ++ i )
+        {
+          m_faces[ i ] = std::move( faces[ i ] );
+          m_face_index_to_handle_index[ i ] = handle_indices[ i ];
+          m_face_handles[ handle_indices[ i ] ].face_index = i;
+        }
+      for( auto& property : m_face_properties )
+        property->permute( from.data(), to.data(), size, m_faces_capacity );
+      if( m_journal )
+        m_journal->record( m_journal->faces.moved_ranges, 0, size );
+    }
+
     dts_definition(void)::remove( atom& e )
     {
   # ifndef MP_SKELETON_NO_POINTER_CHECK
@@ -425,9 +979,14 @@
         m_atoms_next_free_handle_slot = entry_index;
       }
 
+      if( m_journal )
+        m_journal->record( m_journal->atoms.removed_ranges, index, index + 1 );
+
       // move the last atom into this one to keep the buffer tight
       if( --m_atoms_size && index != m_atoms_size )
         {
+          if( m_journal )
+            m_journal->record( m_journal->atoms.moved_ranges, index, index + 1 );
           // move the atom itself
           e = std::move( m_atoms[ m_atoms_size ] );
 
@@ -473,9 +1032,14 @@
         m_links_next_free_handle_slot = entry_index;
       }
 
+      if( m_journal )
+        m_journal->record( m_journal->links.removed_ranges, index, index + 1 );
+
       // move the last link into this one to keep the buffer tight
       if( --m_links_size && index != m_links_size )
         {
+          if( m_journal )
+            m_journal->record( m_journal->links.moved_ranges, index, index + 1 );
           // move the link itself
           e = std::move( m_links[ m_links_size ] );
           m_links[ m_links_size ] = std::move(link{});
@@ -522,9 +1086,14 @@
         m_faces_next_free_handle_slot = entry_index;
       }
 
+      if( m_journal )
+        m_journal->record( m_journal->faces.removed_ranges, index, index + 1 );
+
       // move the last face into this one to keep the buffer tight
       if( --m_faces_size && index != m_faces_size )
         {
+          if( m_journal )
+            m_journal->record( m_journal->faces.moved_ranges, index, index + 1 );
           // move the face itself
           e = std::move( m_faces[ m_faces_size ] );
           m_faces[ m_faces_size ] = std::move(face{});
@@ -2,51 +2,66 @@
     : h1{}, h2{}
   {}
 
-  dts_definition(typename dts_type::link&)::link::operator =(link&& other )
-  {
-    h1 = other.h1;
-    h2 = other.h2;
-    return *this;
-  }
-
   dts_definition()::face::face()
     : atoms{ atom_handle{}, atom_handle{}, atom_handle{} },
       links{ link_handle{}, link_handle{}, link_handle{} }
   {}
 
-  dts_definition(typename dts_type::face&)::face::operator =(face&& other )
+  template< typename T >
+  inline T& base_property_buffer::get(size_t index )
   {
-    atoms[0] = other.atoms[0];
-    atoms[1] = other.atoms[1];
-    atoms[2] = other.atoms[2];
-
-    links[0] = other.links[0];
-    links[1] = other.links[1];
-    links[2] = other.links[2];
-
-    return *this;
+    if( m_storage == dense )
+      return reinterpret_cast< T* >( m_buffer )[ index ];
+    return *static_cast< T* >( element( index ) );
   }
 
   template< typename T >
-  inline T& base_property_buffer::get(size_t index )
+  inline const T& base_property_buffer::get( size_t index ) const
   {
-    return reinterpret_cast< T* >( m_buffer )[ index ];
+    if( m_storage == dense )
+      return reinterpret_cast< const T* >( m_buffer )[ index ];
+    return *static_cast< const T* >( element( index ) );
   }
 
+  /* Copy of property elements, which throws for types that are not copy
+   * assignable. check() must be called before copies done in parallel, since
+   * exceptions cannot leave a parallel region. */
+  template< typename T, bool copyable = std::is_copy_assignable< T >::value >
+  struct property_copier {
+    static void check() {}
+    static void copy( const T* first, size_t size, T* output )
+    {
+      std::copy( first, first + size, output );
+    }
+  };
+
   template< typename T >
-  derived_property_buffer<T>::derived_property_buffer( const std::string& name )
+  struct property_copier< T, false > {
+    static void check()
+    {
+      MP_THROW_EXCEPTION( skeleton_property_not_copyable );
+    }
+    static void copy( const T* first, size_t size, T* output )
+    {
+      (void)first; (void)size; (void)output;
+      check();
+    }
+  };
+
+  template< typename T, bool is_trivial >
+  derived_property_buffer<T,is_trivial>::derived_property_buffer( const std::string& name )
     : base_property_buffer( sizeof( value_type ), name )
   {}
 
 
-  template< typename T >
-  void derived_property_buffer<T>::destroy( size_t index )
+  template< typename T, bool is_trivial >
+  void derived_property_buffer<T,is_trivial>::destroy( size_t index )
   {
     reinterpret_cast< pointer_type >( base_property_buffer::m_buffer )[ index ] = std::move( value_type() );
   }
 
-  template< typename T >
-  void derived_property_buffer<T>::destroy( size_t from, size_t end )
+  template< typename T, bool is_trivial >
+  void derived_property_buffer<T,is_trivial>::destroy( size_t from, size_t end )
   {
     auto start = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer ) + from,
           last = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer ) + end;
@@ -57,13 +72,14 @@
       }
   }
 
-  template< typename T >
-  void derived_property_buffer<T>::resize( size_t old_capacity, size_t new_capacity )
+  template< typename T, bool is_trivial >
+  void derived_property_buffer<T,is_trivial>::resize( size_t old_capacity, size_t new_capacity )
   {
     if( old_capacity )
       {
         auto new_buffer = new value_type[ new_capacity ];
-        for( size_t i = 0; i < old_capacity; ++ i )
+        const size_t kept = std::min( old_capacity, new_capacity );
+        for( size_t i = 0; i < kept; ++ i )
           {
             new_buffer[ i ] = std::move( reinterpret_cast< pointer_type >( base_property_buffer::m_buffer )[ i ] );
           }
@@ -72,12 +88,14 @@
       }
     else
       {
+        // the buffer could be an empty array if the capacity was shrunk to zero
+        delete[] reinterpret_cast< pointer_type >( base_property_buffer::m_buffer );
         base_property_buffer::m_buffer = reinterpret_cast< unsigned char* >( new value_type[ new_capacity ] );
       }
   }
 
-  template< typename T >
-  void derived_property_buffer<T>::move( size_t from, size_t to )
+  template< typename T, bool is_trivial >
+  void derived_property_buffer<T,is_trivial>::move( size_t from, size_t to )
   {
     // copy to destination thanks to a move operator
     reinterpret_cast< pointer_type >( base_property_buffer::m_buffer )[ to ] =
@@ -86,8 +104,478 @@
     reinterpret_cast< pointer_type >( base_property_buffer::m_buffer )[ from ] = std::move( value_type() );
   }
 
-  template<typename T>
-  derived_property_buffer<T>::~derived_property_buffer()
+  template< typename T, bool is_trivial >
+  void derived_property_buffer<T,is_trivial>::permute( const size_t* sources, const size_t* targets,
+    size_t size, size_t current_capacity )
+  {
+    (void)targets;
+    auto old_buffer = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer );
+    auto new_buffer = new value_type[ current_capacity ];
+    # pragma omp parallel for
+    for( size_t i = 0; i < size; ++ i )
+      new_buffer[ i ] = std::move( old_buffer[ sources[ i ] ] );
+    delete[] old_buffer;
+    base_property_buffer::m_buffer = reinterpret_cast< unsigned char* >( new_buffer );
+  }
+
+  template< typename T, bool is_trivial >
+  std::unique_ptr< base_property_buffer > derived_property_buffer<T,is_trivial>::clone(
+    size_t size, size_t current_capacity ) const
+  {
+    property_copier< value_type >::check();
+    std::unique_ptr< derived_property_buffer > result( new derived_property_buffer( m_name ) );
+    result->resize( 0, current_capacity );
+    auto source = reinterpret_cast< const value_type* >( base_property_buffer::m_buffer );
+    auto destination = reinterpret_cast< pointer_type >( result->m_buffer );
+    # pragma omp parallel for
+    for( size_t i = 0; i < size; ++ i )
+      property_copier< value_type >::copy( source + i, 1, destination + i );
+    return result;
+  }
+
+  template< typename T, bool is_trivial >
+  derived_property_buffer<T,is_trivial>::~derived_property_buffer()
   {
     delete[] reinterpret_cast<T*>( base_property_buffer::m_buffer );
   }
+
+  template< typename T, bool is_trivial >
+  void* derived_property_buffer<T,is_trivial>::element( size_t index )
+  {
+    return reinterpret_cast< pointer_type >( base_property_buffer::m_buffer ) + index;
+  }
+
+  template< typename T, bool is_trivial >
+  const void* derived_property_buffer<T,is_trivial>::element( size_t index ) const
+  {
+    return reinterpret_cast< const value_type* >( base_property_buffer::m_buffer ) + index;
+  }
+
+  /* Reset elements of a trivially copyable type to their default value. For
+   * trivially default constructible types, value initialization gives zero
+   * bytes: a memset is enough. */
+  template< typename T >
+  inline void reset_trivial_elements( T* first, T* last )
+  {
+    if( std::is_trivially_default_constructible< T >::value )
+      std::memset( static_cast< void* >( first ), 0, ( last - first ) * sizeof( T ) );
+    else
+      std::fill( first, last, T() );
+  }
+
+  template< typename T >
+  derived_property_buffer<T,true>::derived_property_buffer( const std::string& name )
+    : base_property_buffer( sizeof( value_type ), name )
+  {}
+
+  template< typename T >
+  void derived_property_buffer<T,true>::destroy( size_t index )
+  {
+    auto buffer = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer );
+    reset_trivial_elements( buffer + index, buffer + index + 1 );
+  }
+
+  template< typename T >
+  void derived_property_buffer<T,true>::destroy( size_t from, size_t end )
+  {
+    auto buffer = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer );
+    if( from < end )
+      reset_trivial_elements( buffer + from, buffer + end );
+  }
+
+  template< typename T >
+  void derived_property_buffer<T,true>::resize( size_t old_capacity, size_t new_capacity )
+  {
+    auto old_buffer = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer );
+    auto new_buffer = aligned_allocate< value_type >( new_capacity );
+    const size_t kept = std::min( old_capacity, new_capacity );
+    if( kept )
+      std::memcpy( static_cast< void* >( new_buffer ), old_buffer, kept * sizeof( value_type ) );
+    if( kept < new_capacity )
+      reset_trivial_elements( new_buffer + kept, new_buffer + new_capacity );
+    aligned_free( old_buffer );
+    base_property_buffer::m_buffer = reinterpret_cast< unsigned char* >( new_buffer );
+  }
+
+  template< typename T >
+  void derived_property_buffer<T,true>::move( size_t from, size_t to )
+  {
+    auto buffer = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer );
+    std::memcpy( static_cast< void* >( buffer + to ), buffer + from, sizeof( value_type ) );
+    reset_trivial_elements( buffer + from, buffer + from + 1 );
+  }
+
+  template< typename T >
+  void derived_property_buffer<T,true>::permute( const size_t* sources, const size_t* targets,
+    size_t size, size_t current_capacity )
+  {
+    (void)targets;
+    auto old_buffer = reinterpret_cast< pointer_type >( base_property_buffer::m_buffer );
+    auto new_buffer = aligned_allocate< value_type >( current_capacity );
+    # pragma omp parallel for
+    for( size_t i = 0; i < size; ++ i )
+      std::memcpy( static_cast< void* >( new_buffer + i ), old_buffer + sources[ i ], sizeof( value_type ) );
+    if( size < current_capacity )
+      reset_trivial_elements( new_buffer + size, new_buffer + current_capacity );
+    aligned_free( old_buffer );
+    base_property_buffer::m_buffer = reinterpret_cast< unsigned char* >( new_buffer );
+  }
+
+  template< typename T >
+  std::unique_ptr< base_property_buffer > derived_property_buffer<T,true>::clone(
+    size_t size, size_t current_capacity ) const
+  {
+    std::unique_ptr< derived_property_buffer > result( new derived_property_buffer( m_name ) );
+    auto buffer = aligned_allocate< value_type >( current_capacity );
+    parallel_memcpy( buffer, base_property_buffer::m_buffer, size * sizeof( value_type ) );
+    if( size < current_capacity )
+      reset_trivial_elements( buffer + size, buffer + current_capacity );
+    result->m_buffer = reinterpret_cast< unsigned char* >( buffer );
+    return result;
+  }
+
+  template< typename T >
+  derived_property_buffer<T,true>::~derived_property_buffer()
+  {
+    aligned_free( base_property_buffer::m_buffer );
+  }
+
+  template< typename T >
+  void* derived_property_buffer<T,true>::element( size_t index )
+  {
+    return reinterpret_cast< pointer_type >( base_property_buffer::m_buffer ) + index;
+  }
+
+  template< typename T >
+  const void* derived_property_buffer<T,true>::element( size_t index ) const
+  {
+    return reinterpret_cast< const value_type* >( base_property_buffer::m_buffer ) + index;
+  }
+
+  template< typename T >
+  constexpr size_t paged_property_buffer<T>::page_shift;
+
+  template< typename T >
+  constexpr size_t paged_property_buffer<T>::page_size;
+
+  template< typename T >
+  paged_property_buffer<T>::paged_property_buffer( const std::string& name )
+    : base_property_buffer( sizeof( value_type ), name, paged ),
+      m_number_of_pages{ 0 }, m_capacity{ 0 }
+  {}
+
+  template< typename T >
+  bool paged_property_buffer<T>::is_allocated( size_t index ) const
+  {
+    return ( index >> page_shift ) < m_number_of_pages
+        && m_pages[ index >> page_shift ].load( std::memory_order_acquire );
+  }
+
+  template< typename T >
+  size_t paged_property_buffer<T>::get_allocated_bytes( size_t current_capacity ) const
+  {
+    (void)current_capacity;
+    size_t result = 0;
+    for( size_t i = 0; i < m_number_of_pages; ++ i )
+      if( m_pages[ i ].load( std::memory_order_relaxed ) )
+        result += page_size * sizeof( value_type );
+    return result;
+  }
+
+  template< typename T >
+  void* paged_property_buffer<T>::element( size_t index )
+  {
+    auto& slot = m_pages[ index >> page_shift ];
+    pointer_type page = slot.load( std::memory_order_acquire );
+    if( !page )
+      {
+        // several threads could allocate the same page, only one wins
+        pointer_type new_page = new value_type[ page_size ]();
+        if( slot.compare_exchange_strong( page, new_page, std::memory_order_acq_rel ) )
+          page = new_page;
+        else
+          delete[] new_page;
+      }
+    return page + ( index & ( page_size - 1 ) );
+  }
+
+  template< typename T >
+  const void* paged_property_buffer<T>::element( size_t index ) const
+  {
+    static const value_type default_value{};
+    const value_type* page = ( index >> page_shift ) < m_number_of_pages
+        ? m_pages[ index >> page_shift ].load( std::memory_order_acquire ) : nullptr;
+    return page ? page + ( index & ( page_size - 1 ) ) : &default_value;
+  }
+
+  template< typename T >
+  void paged_property_buffer<T>::destroy( size_t index )
+  {
+    pointer_type page = m_pages[ index >> page_shift ].load( std::memory_order_acquire );
+    if( page )
+      page[ index & ( page_size - 1 ) ] = std::move( value_type() );
+  }
+
+  template< typename T >
+  void paged_property_buffer<T>::destroy( size_t from, size_t end )
+  {
+    while( from < end )
+      {
+        const size_t page_index = from >> page_shift;
+        const size_t page_begin = page_index << page_shift;
+        const size_t page_end = std::min( page_begin + page_size, end );
+        pointer_type page = m_pages[ page_index ].load( std::memory_order_relaxed );
+        if( page )
+          {
+            // elements after the capacity are always in their default state
+            if( from == page_begin && page_end >= std::min( page_begin + page_size, m_capacity ) )
+              {
+                delete[] page;
+                m_pages[ page_index ].store( nullptr, std::memory_order_relaxed );
+              }
+            else
+              for( size_t i = from; i < page_end; ++ i )
+                page[ i - page_begin ] = std::move( value_type() );
+          }
+        from = page_end;
+      }
+  }
+
+  template< typename T >
+  void paged_property_buffer<T>::resize( size_t old_capacity, size_t new_capacity )
+  {
+    const size_t number_of_pages = ( new_capacity + page_size - 1 ) >> page_shift;
+    if( new_capacity < old_capacity )
+      destroy( new_capacity, m_number_of_pages << page_shift );
+    if( number_of_pages != m_number_of_pages )
+      {
+        std::unique_ptr< std::atomic< pointer_type >[] > pages(
+          number_of_pages ? new std::atomic< pointer_type >[ number_of_pages ] : nullptr );
+        const size_t kept = std::min( number_of_pages, m_number_of_pages );
+        for( size_t i = 0; i < kept; ++ i )
+          pages[ i ].store( m_pages[ i ].load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        for( size_t i = kept; i < number_of_pages; ++ i )
+          pages[ i ].store( nullptr, std::memory_order_relaxed );
+        m_pages = std::move( pages );
+        m_number_of_pages = number_of_pages;
+      }
+    m_capacity = new_capacity;
+  }
+
+  template< typename T >
+  void paged_property_buffer<T>::move( size_t from, size_t to )
+  {
+    pointer_type page = m_pages[ from >> page_shift ].load( std::memory_order_acquire );
+    if( page )
+      {
+        auto& source = page[ from & ( page_size - 1 ) ];
+        *static_cast< pointer_type >( element( to ) ) = std::move( source );
+        source = std::move( value_type() );
+      }
+    else
+      destroy( to );
+  }
+
+  template< typename T >
+  void paged_property_buffer<T>::permute( const size_t* sources, const size_t* targets,
+    size_t size, size_t current_capacity )
+  {
+    (void)targets;
+    (void)current_capacity;
+    /* each thread fills its own new pages, which are only allocated if one
+     * of their elements comes from an allocated page */
+    const size_t number_of_pages = ( size + page_size - 1 ) >> page_shift;
+    std::unique_ptr< pointer_type[] > pages( new pointer_type[ m_number_of_pages ]() );
+    # pragma omp parallel for schedule(dynamic)
+    for( size_t p = 0; p < number_of_pages; ++ p )
+      {
+        const size_t end = std::min( ( p + 1 ) << page_shift, size );
+        for( size_t i = p << page_shift; i < end; ++ i )
+          {
+            pointer_type source_page = m_pages[ sources[ i ] >> page_shift ].load( std::memory_order_relaxed );
+            if( source_page )
+              {
+                if( !pages[ p ] )
+                  pages[ p ] = new value_type[ page_size ]();
+                pages[ p ][ i & ( page_size - 1 ) ] = std::move( source_page[ sources[ i ] & ( page_size - 1 ) ] );
+              }
+          }
+      }
+    for( size_t p = 0; p < m_number_of_pages; ++ p )
+      {
+        delete[] m_pages[ p ].load( std::memory_order_relaxed );
+        m_pages[ p ].store( pages[ p ], std::memory_order_relaxed );
+      }
+  }
+
+  template< typename T >
+  std::unique_ptr< base_property_buffer > paged_property_buffer<T>::clone(
+    size_t size, size_t current_capacity ) const
+  {
+    property_copier< value_type >::check();
+    std::unique_ptr< paged_property_buffer > result( new paged_property_buffer( m_name ) );
+    result->resize( 0, current_capacity );
+    // only the allocated pages covering the copied elements are copied
+    const size_t number_of_pages = std::min( ( size + page_size - 1 ) >> page_shift,
+      std::min( m_number_of_pages, result->m_number_of_pages ) );
+    # pragma omp parallel for schedule(dynamic)
+    for( size_t p = 0; p < number_of_pages; ++ p )
+      {
+        const pointer_type page = m_pages[ p ].load( std::memory_order_relaxed );
+        if( page )
+          {
+            pointer_type copy = new value_type[ page_size ]();
+            property_copier< value_type >::copy( page,
+              std::min( page_size, size - ( p << page_shift ) ), copy );
+            result->m_pages[ p ].store( copy, std::memory_order_relaxed );
+          }
+      }
+    return result;
+  }
+
+  template< typename T >
+  paged_property_buffer<T>::~paged_property_buffer()
+  {
+    for( size_t i = 0; i < m_number_of_pages; ++ i )
+      delete[] m_pages[ i ].load( std::memory_order_relaxed );
+  }
+
+  template< typename T >
+  sparse_property_buffer<T>::sparse_property_buffer( const std::string& name )
+    : base_property_buffer( sizeof( value_type ), name, sparse )
+  {}
+
+  template< typename T >
+  bool sparse_property_buffer<T>::is_allocated( size_t index ) const
+  {
+    std::shared_lock< std::shared_timed_mutex > lock( m_mutex );
+    return m_elements.count( index ) != 0;
+  }
+
+  template< typename T >
+  size_t sparse_property_buffer<T>::get_allocated_bytes( size_t current_capacity ) const
+  {
+    (void)current_capacity;
+    std::shared_lock< std::shared_timed_mutex > lock( m_mutex );
+    // a node stores the key, the value and the next pointer, plus a bucket
+    return m_elements.size() * ( sizeof( size_t ) + sizeof( value_type ) + sizeof( void* ) )
+        + m_elements.bucket_count() * sizeof( void* );
+  }
+
+  template< typename T >
+  void* sparse_property_buffer<T>::element( size_t index )
+  {
+    {
+      std::shared_lock< std::shared_timed_mutex > lock( m_mutex );
+      auto it = m_elements.find( index );
+      if( it != m_elements.end() )
+        return &it->second;
+    }
+    std::lock_guard< std::shared_timed_mutex > lock( m_mutex );
+    // references to elements of an unordered map survive rehashing
+    return &m_elements[ index ];
+  }
+
+  template< typename T >
+  const void* sparse_property_buffer<T>::element( size_t index ) const
+  {
+    static const value_type default_value{};
+    std::shared_lock< std::shared_timed_mutex > lock( m_mutex );
+    auto it = m_elements.find( index );
+    return it != m_elements.end() ? &it->second : &default_value;
+  }
+
+  template< typename T >
+  void sparse_property_buffer<T>::destroy( size_t index )
+  {
+    std::lock_guard< std::shared_timed_mutex > lock( m_mutex );
+    m_elements.erase( index );
+  }
+
+  template< typename T >
+  void sparse_property_buffer<T>::destroy( size_t from, size_t end )
+  {
+    std::lock_guard< std::shared_timed_mutex > lock( m_mutex );
+    if( end - from < m_elements.size() )
+      {
+        for( ; from < end; ++ from )
+          m_elements.erase( from );
+      }
+    else
+      {
+        for( auto it = m_elements.begin(); it != m_elements.end(); )
+          {
+            if( it->first >= from && it->first < end )
+              it = m_elements.erase( it );
+            else
+              ++ it;
+          }
+      }
+  }
+
+  template< typename T >
+  void sparse_property_buffer<T>::resize( size_t old_capacity, size_t new_capacity )
+  {
+    if( new_capacity < old_capacity )
+      destroy( new_capacity, old_capacity );
+  }
+
+  template< typename T >
+  void sparse_property_buffer<T>::move( size_t from, size_t to )
+  {
+    std::lock_guard< std::shared_timed_mutex > lock( m_mutex );
+    auto it = m_elements.find( from );
+    if( it != m_elements.end() )
+      {
+        value_type& source = it->second;
+        m_elements[ to ] = std::move( source );
+        m_elements.erase( from );
+      }
+    else
+      m_elements.erase( to );
+  }
+
+  template< typename T >
+  void sparse_property_buffer<T>::permute( const size_t* sources, const size_t* targets,
+    size_t size, size_t current_capacity )
+  {
+    (void)sources;
+    (void)current_capacity;
+    std::lock_guard< std::shared_timed_mutex > lock( m_mutex );
+    std::unordered_map< size_t, value_type > elements;
+    elements.reserve( m_elements.size() );
+    for( auto& element : m_elements )
+      if( element.first < size )
+        elements[ targets[ element.first ] ] = std::move( element.second );
+    m_elements.swap( elements );
+  }
+
+  template< typename T >
+  std::unique_ptr< base_property_buffer > sparse_property_buffer<T>::clone(
+    size_t size, size_t current_capacity ) const
+  {
+    (void)current_capacity;
+    property_copier< value_type >::check();
+    std::unique_ptr< sparse_property_buffer > result( new sparse_property_buffer( m_name ) );
+    std::shared_lock< std::shared_timed_mutex > lock( m_mutex );
+    result->m_elements.reserve( m_elements.size() );
+    for( auto& element : m_elements )
+      if( element.first < size )
+        property_copier< value_type >::copy( &element.second, 1, &result->m_elements[ element.first ] );
+    return result;
+  }
+
+  template< typename T >
+  std::unique_ptr< base_property_buffer > make_property_buffer(
+    const std::string& name, base_property_buffer::storage_type storage )
+  {
+    switch( storage )
+      {
+        case base_property_buffer::paged:
+          return std::make_unique< paged_property_buffer< T > >( name );
+        case base_property_buffer::sparse:
+          return std::make_unique< sparse_property_buffer< T > >( name );
+        default:
+          return std::make_unique< derived_property_buffer< T > >( name );
+      }
+  }
@@ -9,6 +9,8 @@
 
  dts_definition(void)::clear_atoms( atom_handle_type atom_capacity )
  {
+    if( m_journal )
+      m_journal->record( m_journal->atoms.removed_ranges, 0, m_atoms_size );
    if( atom_capacity <= m_atoms_capacity )
      {
        # pragma omp parallel for
@@ -42,6 +44,8 @@
 
  dts_definition(void)::clear_links( link_handle_type link_capacity )
   {
+    if( m_journal )
+      m_journal->record( m_journal->links.removed_ranges, 0, m_links_size );
     if( link_capacity <= m_links_capacity )
       {
         # pragma omp parallel for
@@ -75,6 +79,8 @@
 
  dts_definition(void)::clear_faces( face_handle_type face_capacity )
   {
+    if( m_journal )
+      m_journal->record( m_journal->faces.removed_ranges, 0, m_faces_size );
     if( face_capacity <= m_faces_capacity )
       {
         # pragma omp parallel for
@@ -113,30 +119,11 @@
       MP_THROW_EXCEPTION( skeleton_atom_buffer_overflow );
 
     try {
-      // initialize data
-      if( !m_atoms )
-        {
-          m_atoms = std::make_unique<atom[]>( new_capacity );
-          m_atom_index_to_handle_index = std::make_unique<atom_handle_type[]>( new_capacity );
-          m_atom_handles = std::make_unique<atom_handle_entry[]>( new_capacity );
-        }
-      // resize buffers
-      else
-        {
-          auto new_element_buffer = std::make_unique<atom[]>( new_capacity );
-          auto new_element_to_handle = std::make_unique<atom_handle_type[]>( new_capacity );
-          auto new_handle_buffer = std::make_unique<atom_handle_entry[]>( new_capacity );
-          # pragma omp parallel for
-          for( atom_handle_type i = 0; i < m_atoms_capacity; ++ i )
-            {
-              new_element_buffer[ i ] = std::move( m_atoms[ i ] );
-              new_element_to_handle[ i ] = m_atom_index_to_handle_index[ i ];
-              new_handle_buffer[ i ] = m_atom_handles[ i ];
-            }
-          m_atoms = std::move(new_element_buffer);
-          m_atom_index_to_handle_index = std::move(new_element_to_handle);
-          m_atom_handles = std::move(new_handle_buffer);
-        }
+      /* buffers are resized with realloc when possible, which avoids to copy
+       * the elements for large buffers */
+      resize_relocatable_buffer( m_atoms, m_atoms_capacity, new_capacity );
+      resize_relocatable_buffer( m_atom_index_to_handle_index, m_atoms_capacity, new_capacity );
+      resize_relocatable_buffer( m_atom_handles, m_atoms_capacity, new_capacity );
     } catch( std::bad_alloc& ba ) {
       MP_THROW_EXCEPTION( skeleton_atom_buffer_overflow );
     }
@@ -162,30 +149,11 @@
       MP_THROW_EXCEPTION( skeleton_link_buffer_overflow );
 
     try {
-      // initialize data
-      if( !m_links )
-        {
-          m_links = std::make_unique<link[]>( new_capacity );
-          m_link_index_to_handle_index = std::make_unique<link_handle_type[]>( new_capacity );
-          m_link_handles = std::make_unique<link_handle_entry[]>( new_capacity );
-        }
-      // resize buffers
-      else
-        {
-          auto new_element_buffer = std::make_unique<link[]>( new_capacity );
-          auto new_element_to_handle = std::make_unique<link_handle_type[]>( new_capacity );
-          auto new_handle_buffer = std::make_unique<link_handle_entry[]>( new_capacity );
-          # pragma omp parallel for
-          for( link_handle_type i = 0; i < m_links_capacity; ++ i )
-            {
-              new_element_buffer[ i ] = std::move( m_links[ i ] );
-              new_element_to_handle[ i ] = m_link_index_to_handle_index[ i ];
-              new_handle_buffer[ i ] = m_link_handles[ i ];
-            }
-          m_links = std::move(new_element_buffer);
-          m_link_index_to_handle_index = std::move(new_element_to_handle);
-          m_link_handles = std::move(new_handle_buffer);
-        }
+      /* buffers are resized with realloc when possible, which avoids to copy
+       * the elements for large buffers */
+      resize_relocatable_buffer( m_links, m_links_capacity, new_capacity );
+      resize_relocatable_buffer( m_link_index_to_handle_index, m_links_capacity, new_capacity );
+      resize_relocatable_buffer( m_link_handles, m_links_capacity, new_capacity );
     } catch( std::bad_alloc& ba ) {
       MP_THROW_EXCEPTION( skeleton_link_buffer_overflow );
     }
@@ -210,37 +178,138 @@
       MP_THROW_EXCEPTION( skeleton_face_buffer_overflow );
 
     try {
-      // initialize data
-      if( !m_faces )
+      /* buffers are resized with realloc when possible, which avoids to copy
+       * the elements for large buffers */
+      resize_relocatable_buffer( m_faces, m_faces_capacity, new_capacity );
+      resize_relocatable_buffer( m_face_index_to_handle_index, m_faces_capacity, new_capacity );
+      resize_relocatable_buffer( m_face_handles, m_faces_capacity, new_capacity );
+    } catch( std::bad_alloc& ba ) {
+      MP_THROW_EXCEPTION( skeleton_face_buffer_overflow );
+    }
+
+    # pragma omp parallel for
+    for( size_t i = m_faces_capacity; i < new_capacity; ++ i )
+      m_face_handles[ i ].next_free_index = i + 1;
+
+    const auto nb_properties = m_face_properties.size();
+    # pragma omp parallel for
+    for( size_t i = 0; i < nb_properties; ++ i )
+      {
+        m_face_properties[i]->resize( m_faces_capacity, new_capacity );
+      }
+    m_faces_capacity = new_capacity;
+  }
+
+  dts_definition(void)::shrink_atoms()
+  {
+    // find the highest allocated handle index
+    atom_handle_type new_capacity = m_atoms_size;
+    # pragma omp parallel for reduction(max:new_capacity)
+    for( atom_handle_type i = m_atoms_size; i < m_atoms_capacity; ++ i )
+      if( m_atom_handles[ i ].status != STATUS_FREE )
+        new_capacity = std::max( new_capacity, atom_handle_type( i + 1 ) );
+    if( new_capacity == m_atoms_capacity )
+      return;
+
+    /* chain again the free handle entries below the new capacity, in
+     * increasing order, since the free list could go through entries that are
+     * released */
+    atom_handle_type next_free_slot = new_capacity;
+    for( atom_handle_type i = new_capacity; i > 0; -- i )
+      if( m_atom_handles[ i - 1 ].status == STATUS_FREE )
         {
-          m_faces = std::make_unique<face[]>( new_capacity );
-          m_face_index_to_handle_index = std::make_unique<face_handle_type[]>( new_capacity );
-          m_face_handles = std::make_unique<face_handle_entry[]>( new_capacity );
+          m_atom_handles[ i - 1 ].next_free_index = next_free_slot;
+          next_free_slot = i - 1;
         }
-      // resize buffers
-      else
+    m_atoms_next_free_handle_slot = next_free_slot;
+
+    try {
+      resize_relocatable_buffer( m_atoms, m_atoms_capacity, new_capacity );
+      resize_relocatable_buffer( m_atom_index_to_handle_index, m_atoms_capacity, new_capacity );
+      resize_relocatable_buffer( m_atom_handles, m_atoms_capacity, new_capacity );
+    } catch( std::bad_alloc& ba ) {
+      MP_THROW_EXCEPTION( skeleton_atom_buffer_overflow );
+    }
+
+    const auto nb_properties = m_atom_properties.size();
+    # pragma omp parallel for
+    for( size_t i = 0; i < nb_properties; ++ i )
+      {
+        m_atom_properties[i]->resize( m_atoms_capacity, new_capacity );
+      }
+    m_atoms_capacity = new_capacity;
+  }
+
+  dts_definition(void)::shrink_links()
+  {
+    // find the highest allocated handle index
+    link_handle_type new_capacity = m_links_size;
+    # pragma omp parallel for reduction(max:new_capacity)
+    for( link_handle_type i = m_links_size; i < m_links_capacity; ++ i )
+      if( m_link_handles[ i ].status != STATUS_FREE )
+        new_capacity = std::max( new_capacity, link_handle_type( i + 1 ) );
+    if( new_capacity == m_links_capacity )
+      return;
+
+    /* chain again the free handle entries below the new capacity, in
+     * increasing order, since the free list could go through entries that are
+     * released */
+    link_handle_type next_free_slot = new_capacity;
+    for( link_handle_type i = new_capacity; i > 0; -- i )
+      if( m_link_handles[ i - 1 ].status == STATUS_FREE )
         {
-          auto new_element_buffer = std::make_unique<face[]>( new_capacity );
-          auto new_element_to_handle = std::make_unique<face_handle_type[]>( new_capacity );
-          auto new_handle_buffer = std::make_unique<face_handle_entry[]>( new_capacity );
-          # pragma omp parallel for
-          for( face_handle_type i = 0; i < m_faces_capacity; ++ i )
-            {
-              new_element_buffer[ i ] = std::move( m_faces[ i ] );
-              new_element_to_handle[ i ] = m_face_index_to_handle_index[ i ];
-              new_handle_buffer[ i ] = m_face_handles[ i ];
-            }
-          m_faces = std::move(new_element_buffer);
-          m_face_index_to_handle_index = std::move(new_element_to_handle);
-          m_face_handles = std::move(new_handle_buffer);
+          m_link_handles[ i - 1 ].next_free_index = next_free_slot;
+          next_free_slot = i - 1;
         }
+    m_links_next_free_handle_slot = next_free_slot;
+
+    try {
+      resize_relocatable_buffer( m_links, m_links_capacity, new_capacity );
+      resize_relocatable_buffer( m_link_index_to_handle_index, m_links_capacity, new_capacity );
+      resize_relocatable_buffer( m_link_handles, m_links_capacity, new_capacity );
     } catch( std::bad_alloc& ba ) {
-      MP_THROW_EXCEPTION( skeleton_face_buffer_overflow );
+      MP_THROW_EXCEPTION( skeleton_link_buffer_overflow );
     }
 
+    const auto nb_properties = m_link_properties.size();
     # pragma omp parallel for
-    for( size_t i = m_faces_capacity; i < new_capacity; ++ i )
-      m_face_handles[ i ].next_free_index = i + 1;
+    for( size_t i = 0; i < nb_properties; ++ i )
+      {
+        m_link_properties[i]->resize( m_links_capacity, new_capacity );
+      }
+    m_links_capacity = new_capacity;
+  }
+
+  dts_definition(void)::shrink_faces()
+  {
+    // find the highest allocated handle index
+    face_handle_type new_capacity = m_faces_size;
+    # pragma omp parallel for reduction(max:new_capacity)
+    for( face_handle_type i = m_faces_size; i < m_faces_capacity; ++ i )
+      if( m_face_handles[ i ].status != STATUS_FREE )
+        new_capacity = std::max( new_capacity, face_handle_type( i + 1 ) );
+    if( new_capacity == m_faces_capacity )
+      return;
+
+    /* chain again the free handle entries below the new capacity, in
+     * increasing order, since the free list could go through entries that are
+     * released */
+    face_handle_type next_free_slot = new_capacity;
+    for( face_handle_type i = new_capacity; i > 0; -- i )
+      if( m_face_handles[ i - 1 ].status == STATUS_FREE )
+        {
+          m_face_handles[ i - 1 ].next_free_index = next_free_slot;
+          next_free_slot = i - 1;
+        }
+    m_faces_next_free_handle_slot = next_free_slot;
+
+    try {
+      resize_relocatable_buffer( m_faces, m_faces_capacity, new_capacity );
+      resize_relocatable_buffer( m_face_index_to_handle_index, m_faces_capacity, new_capacity );
+      resize_relocatable_buffer( m_face_handles, m_faces_capacity, new_capacity );
+    } catch( std::bad_alloc& ba ) {
+      MP_THROW_EXCEPTION( skeleton_face_buffer_overflow );
+    }
 
     const auto nb_properties = m_face_properties.size();
     # pragma omp parallel for
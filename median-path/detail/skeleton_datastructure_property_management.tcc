@@ -1,32 +1,50 @@
-dts_definition(template<typename T> base_property_buffer*)::add_atom_property( const std::string& name )
+dts_definition(template<typename T> base_property_buffer*)::add_atom_property( const std::string& name,
+  base_property_buffer::storage_type storage )
+{
+  return add_atom_property( make_property_buffer<T>( name, storage ) );
+}
+
+dts_definition(template<typename T> base_property_buffer*)::add_link_property( const std::string& name,
+  base_property_buffer::storage_type storage )
+{
+  return add_link_property( make_property_buffer<T>( name, storage ) );
+}
+
+dts_definition(template<typename T> base_property_buffer*)::add_face_property( const std::string& name,
+  base_property_buffer::storage_type storage )
+{
+  return add_face_property( make_property_buffer<T>( name, storage ) );
+}
+
+dts_definition(base_property_buffer*)::add_atom_property( std::unique_ptr< base_property_buffer > property )
 {
   auto end = m_atom_properties.end();
   for( auto it = m_atom_properties.begin(); it != end; ++ it )
-    if( (*it)->m_name == name )
+    if( (*it)->m_name == property->m_name )
       MP_THROW_EXCEPTION( skeleton_atom_property_already_exist );
-  m_atom_properties.push_back( std::make_unique<derived_property_buffer<T>>( name ) );
+  m_atom_properties.push_back( std::move( property ) );
   m_atom_properties.back()->resize( 0, m_atoms_capacity );
   return m_atom_properties.back().get();
 }
 
-dts_definition(template<typename T>base_property_buffer*)::add_link_property( const std::string& name )
+dts_definition(base_property_buffer*)::add_link_property( std::unique_ptr< base_property_buffer > property )
 {
   auto end = m_link_properties.end();
   for( auto it = m_link_properties.begin(); it != end; ++ it )
-    if( (*it)->m_name == name )
+    if( (*it)->m_name == property->m_name )
       MP_THROW_EXCEPTION( skeleton_link_property_already_exist );
-  m_link_properties.push_back( std::make_unique<derived_property_buffer<T>>( name ) );
+  m_link_properties.push_back( std::move( property ) );
   m_link_properties.back()->resize( 0, m_links_capacity );
   return m_link_properties.back().get();
 }
 
-dts_definition(template<typename T>base_property_buffer*)::add_face_property( const std::string& name )
+dts_definition(base_property_buffer*)::add_face_property( std::unique_ptr< base_property_buffer > property )
 {
   auto end = m_face_properties.end();
   for( auto it = m_face_properties.begin(); it != end; ++ it )
-    if( (*it)->m_name == name )
+    if( (*it)->m_name == property->m_name )
       MP_THROW_EXCEPTION( skeleton_face_property_already_exist );
-  m_face_properties.push_back( std::make_unique<derived_property_buffer<T>>( name ) );
+  m_face_properties.push_back( std::move( property ) );
   m_face_properties.back()->resize( 0, m_faces_capacity );
   return m_face_properties.back().get();
 }
@@ -0,0 +1,104 @@
+# ifndef MEDIAN_PATH_SKELETON_PROFILES_H_
+# define MEDIAN_PATH_SKELETON_PROFILES_H_
+
+# include "skeleton_datastructure.h"
+
+# include <graphics-origin/geometry/ball.h>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief A ball stored in single precision.
+   *
+   * This is the atom type of single precision skeletons: xyz for the center
+   * and w for the radius, as for graphics_origin::geometry::ball, but with
+   * gl_real components. Such an atom takes 16 bytes instead of 32 and can be
+   * sent as is to the GPU. It is built from double precision values, which
+   * are then rounded to the nearest float.
+   */
+  struct single_precision_ball
+    : public gl_vec4 {
+
+    single_precision_ball()
+      : gl_vec4{ 0, 0, 0, 0 }
+    {}
+
+    single_precision_ball( const vec3& center, const real& radius )
+      : gl_vec4{ gl_real( center.x ), gl_real( center.y ), gl_real( center.z ), gl_real( radius ) }
+    {}
+
+    explicit single_precision_ball( const vec4& b )
+      : gl_vec4{ gl_real( b.x ), gl_real( b.y ), gl_real( b.z ), gl_real( b.w ) }
+    {}
+
+    vec3 get_center() const
+    {
+      return vec3{ x, y, z };
+    }
+
+    real get_radius() const
+    {
+      return w;
+    }
+  };
+
+  /**@brief Storage profile of the default skeletons.
+   *
+   * A profile gathers the types chosen to store a skeleton: the atom type
+   * and its components, and the datastructure with its handle sizes. This
+   * profile stores atoms as double precision balls and can handle up to
+   * 2^22 atoms, 2^44 links and 2^54 faces.
+   */
+  struct default_skeleton_profile {
+    typedef GO_NAMESPACE::geometry::ball atom;
+    typedef real atom_real;
+    typedef skeleton_datastructure<
+      uint32_t, 22,
+      uint64_t, 44,
+      uint64_t, 54,
+      atom > datastructure;
+  };
+
+  /**@brief Storage profile of single precision skeletons.
+   *
+   * Atoms are stored as single_precision_ball, which halves the memory used
+   * by atoms and by their columns. Capacities are those of the default
+   * profile.
+   */
+  struct single_precision_skeleton_profile {
+    typedef single_precision_ball atom;
+    typedef gl_real atom_real;
+    typedef skeleton_datastructure<
+      uint32_t, 22,
+      uint64_t, 44,
+      uint64_t, 54,
+      atom > datastructure;
+  };
+
+  /**@brief Storage profile of large skeletons.
+   *
+   * Atoms are stored as in the default profile, but atom handles are 64 bits
+   * wide with 40 bits of index, which raises the atom capacity from 2^22 to
+   * 2^40 atoms. Link and face capacities are those of the default profile.
+   * This is the profile for atomizations of large surface samplings, which
+   * produce several atoms per sample.
+   *
+   * Atom handles and indices being twice larger, every structure that stores
+   * them grows: an atom handle entry takes 16 bytes instead of 8, a link 16
+   * bytes instead of 8, a face 48 bytes instead of 40, and an element of the
+   * faces of an atom 48 bytes instead of 40. Atoms and the elements of the
+   * links of an atom keep their size. For a skeleton with about three links
+   * and two faces per atom, this is around 100 more bytes per atom. Atom
+   * indices given to algorithms and savers are also 64 bits wide.
+   */
+  struct large_skeleton_profile {
+    typedef GO_NAMESPACE::geometry::ball atom;
+    typedef real atom_real;
+    typedef skeleton_datastructure<
+      uint64_t, 40,
+      uint64_t, 44,
+      uint64_t, 54,
+      atom > datastructure;
+  };
+
+END_MP_NAMESPACE
+# endif
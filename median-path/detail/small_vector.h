@@ -0,0 +1,286 @@
+# ifndef MEDIAN_PATH_SMALL_VECTOR_H_
+# define MEDIAN_PATH_SMALL_VECTOR_H_
+
+# include "../median_path.h"
+
+# include <algorithm>
+# include <array>
+# include <cstdint>
+# include <iterator>
+# include <mutex>
+# include <new>
+# include <type_traits>
+# include <utility>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Pool of memory blocks for the overflow of small vectors.
+   *
+   * Blocks are carved from large slabs and have a size that is a power of
+   * two, from min_block_size to max_block_size. A released block is kept in
+   * a free list of its size class to be reused by the next allocation of the
+   * same class. Requests larger than max_block_size go directly to the global
+   * allocator. The slabs are released when the arena is destroyed: all the
+   * blocks must have been released before.
+   *
+   * Allocations and deallocations are protected by a mutex, such that small
+   * vectors sharing an arena can grow from different threads. */
+  class small_vector_arena {
+  public:
+    static constexpr size_t min_block_size = 64;
+    static constexpr size_t max_block_size = 64 * 1024;
+    static constexpr size_t slab_size = 4 * max_block_size;
+
+    small_vector_arena();
+    ~small_vector_arena();
+    small_vector_arena( const small_vector_arena& other ) = delete;
+    small_vector_arena& operator=( const small_vector_arena& other ) = delete;
+
+    /**@brief Size of the block that is allocated for a request.
+     * @param bytes The number of requested bytes.
+     * @return A number of bytes greater or equal to the request. */
+    static size_t block_size( size_t bytes ) noexcept;
+
+    /**@brief Allocate a block of memory.
+     *
+     * The block is aligned for any fundamental type. A std::bad_alloc is thrown
+     * if the allocation failed.
+     * @param bytes The number of requested bytes.
+     * @return A block of at least block_size( bytes ) bytes. */
+    void* allocate( size_t bytes );
+
+    /**@brief Give back a block obtained by allocate().
+     * @param block The block to release.
+     * @param bytes The number of bytes requested when the block was allocated,
+     * or any value with the same block size. */
+    void deallocate( void* block, size_t bytes ) noexcept;
+
+    /**@brief Number of bytes taken from the global allocator for the slabs. */
+    size_t get_reserved_bytes() const noexcept;
+
+  private:
+    static constexpr size_t number_of_size_classes = 11;
+    static_assert( min_block_size << ( number_of_size_classes - 1 ) == max_block_size,
+      "The size classes do not cover all block sizes" );
+    static size_t size_class( size_t bytes ) noexcept;
+
+    struct free_block {
+      free_block* next;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector< unsigned char* > m_slabs;
+    unsigned char* m_slab_position;
+    size_t m_slab_remaining;
+    std::array< free_block*, number_of_size_classes > m_free_lists;
+  };
+
+  /**@brief A vector storing its first elements inline.
+   *
+   * Most atoms of a skeleton have a handful of links and faces. Storing them
+   * in std::vector costs one heap allocation per atom, scatters the topology
+   * in memory and makes moves of atoms more expensive. This vector stores up
+   * to inline_capacity elements in its own memory. Beyond this capacity, the
+   * elements are moved into a block of a small_vector_arena. Since the
+   * vector cannot know the arena to use when it is default constructed, the
+   * methods that can grow the vector take it as an argument. The arena that
+   * provided the block is remembered to release it.
+   *
+   * Iterators are pointers, invalidated by any growth and by moves. */
+  template< typename T, size_t inline_capacity >
+  class small_vector {
+  public:
+    static_assert( inline_capacity > 0, "A small vector needs inline storage" );
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    small_vector() noexcept
+      : m_data{ inline_data() }, m_arena{ nullptr },
+        m_size{ 0 }, m_capacity{ inline_capacity }
+    {}
+
+    small_vector( small_vector&& other ) noexcept
+      : small_vector()
+    {
+      steal( other );
+    }
+
+    small_vector& operator=( small_vector&& other ) noexcept
+    {
+      if( this != &other )
+        {
+          clear();
+          release();
+          steal( other );
+        }
+      return *this;
+    }
+
+    small_vector( const small_vector& other ) = delete;
+    small_vector& operator=( const small_vector& other ) = delete;
+
+    ~small_vector()
+    {
+      clear();
+      release();
+    }
+
+    void swap( small_vector& other ) noexcept
+    {
+      small_vector tmp( std::move( other ) );
+      other = std::move( *this );
+      *this = std::move( tmp );
+    }
+
+    size_t size() const noexcept { return m_size; }
+    size_t capacity() const noexcept { return m_capacity; }
+    bool empty() const noexcept { return !m_size; }
+    /**@brief Check if the elements are stored in the vector itself. */
+    bool is_inline() const noexcept { return m_data == inline_data(); }
+
+    T* data() noexcept { return m_data; }
+    const T* data() const noexcept { return m_data; }
+    iterator begin() noexcept { return m_data; }
+    iterator end() noexcept { return m_data + m_size; }
+    const_iterator begin() const noexcept { return m_data; }
+    const_iterator end() const noexcept { return m_data + m_size; }
+    T& operator[]( size_t i ) noexcept { return m_data[ i ]; }
+    const T& operator[]( size_t i ) const noexcept { return m_data[ i ]; }
+    T& back() noexcept { return m_data[ m_size - 1 ]; }
+    const T& back() const noexcept { return m_data[ m_size - 1 ]; }
+
+    /**@brief Make room for a number of elements.
+     * @param n The requested capacity.
+     * @param arena The arena to use if the inline storage is too small. */
+    void reserve( size_t n, small_vector_arena& arena )
+    {
+      if( n > m_capacity )
+        reallocate( n, arena );
+    }
+
+    template< typename... Args >
+    void emplace_back( small_vector_arena& arena, Args&&... args )
+    {
+      if( m_size == m_capacity )
+        reallocate( 2 * m_capacity, arena );
+      new ( m_data + m_size ) T( std::forward< Args >( args )... );
+      ++ m_size;
+    }
+
+    void push_back( const T& value, small_vector_arena& arena )
+    {
+      emplace_back( arena, value );
+    }
+
+    void push_back( T&& value, small_vector_arena& arena )
+    {
+      emplace_back( arena, std::move( value ) );
+    }
+
+    void pop_back() noexcept
+    {
+      -- m_size;
+      m_data[ m_size ].~T();
+    }
+
+    /**@brief Remove a range of elements, keeping the order of the others. */
+    iterator erase( iterator first, iterator last ) noexcept
+    {
+      iterator new_end = std::move( last, end(), first );
+      for( iterator it = new_end; it != end(); ++ it )
+        it->~T();
+      m_size = new_end - m_data;
+      return first;
+    }
+
+    /**@brief Replace the content of the vector by a range of elements. */
+    template< typename input_iterator >
+    void assign( input_iterator first, input_iterator last, small_vector_arena& arena )
+    {
+      clear();
+      reserve( std::distance( first, last ), arena );
+      for( ; first != last; ++ first, ++ m_size )
+        new ( m_data + m_size ) T( *first );
+    }
+
+    /**@brief Destroy all the elements, but keep the memory. */
+    void clear() noexcept
+    {
+      for( size_t i = 0; i < m_size; ++ i )
+        m_data[ i ].~T();
+      m_size = 0;
+    }
+
+  private:
+    T* inline_data() noexcept
+    {
+      return reinterpret_cast< T* >( &m_inline );
+    }
+
+    const T* inline_data() const noexcept
+    {
+      return reinterpret_cast< const T* >( &m_inline );
+    }
+
+    void reallocate( size_t n, small_vector_arena& arena )
+    {
+      const size_t bytes = small_vector_arena::block_size( n * sizeof( T ) );
+      T* data = static_cast< T* >( arena.allocate( bytes ) );
+      for( size_t i = 0; i < m_size; ++ i )
+        {
+          new ( data + i ) T( std::move( m_data[ i ] ) );
+          m_data[ i ].~T();
+        }
+      release();
+      m_data = data;
+      m_arena = &arena;
+      m_capacity = bytes / sizeof( T );
+    }
+
+    /* Give back the block to the arena, if any. The elements must have been
+     * destroyed before. */
+    void release() noexcept
+    {
+      if( !is_inline() )
+        {
+          m_arena->deallocate( m_data, m_capacity * sizeof( T ) );
+          m_data = inline_data();
+          m_arena = nullptr;
+          m_capacity = inline_capacity;
+        }
+    }
+
+    /* Take the elements of an other vector, this one being empty and inline. */
+    void steal( small_vector& other ) noexcept
+    {
+      if( other.is_inline() )
+        {
+          for( size_t i = 0; i < other.m_size; ++ i )
+            new ( m_data + i ) T( std::move( other.m_data[ i ] ) );
+          m_size = other.m_size;
+          other.clear();
+        }
+      else
+        {
+          m_data = other.m_data;
+          m_arena = other.m_arena;
+          m_size = other.m_size;
+          m_capacity = other.m_capacity;
+          other.m_data = other.inline_data();
+          other.m_arena = nullptr;
+          other.m_size = 0;
+          other.m_capacity = inline_capacity;
+        }
+    }
+
+    T* m_data;
+    small_vector_arena* m_arena;
+    uint32_t m_size;
+    uint32_t m_capacity;
+    typename std::aligned_storage< sizeof( T ) * inline_capacity, alignof( T ) >::type m_inline;
+  };
+
+END_MP_NAMESPACE
+# endif
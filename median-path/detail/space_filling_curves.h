@@ -0,0 +1,120 @@
+# ifndef MEDIAN_PATH_SPACE_FILLING_CURVES_H_
+# define MEDIAN_PATH_SPACE_FILLING_CURVES_H_
+
+# include "../median_path.h"
+
+# include <cstdint>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Number of bits per axis of the 64 bits space filling curve codes. */
+  static constexpr uint8_t curve_bits_per_axis = 21;
+
+  /**@brief Spread the 21 lowest bits of a value such that two zeros
+   * separate two consecutive bits. */
+  inline uint64_t spread_bits( uint64_t v ) noexcept
+  {
+    v &= 0x1fffff;
+    v = ( v | v << 32 ) & 0x1f00000000ffff;
+    v = ( v | v << 16 ) & 0x1f0000ff0000ff;
+    v = ( v | v <<  8 ) & 0x100f00f00f00f00f;
+    v = ( v | v <<  4 ) & 0x10c30c30c30c30c3;
+    v = ( v | v <<  2 ) & 0x1249249249249249;
+    return v;
+  }
+
+  /**@brief Quantize a coordinate in [0,1] on curve_bits_per_axis bits.
+   *
+   * Coordinates out of [0,1] are clamped. */
+  inline uint32_t quantize_on_curve( real t ) noexcept
+  {
+    const real scale = real( ( 1u << curve_bits_per_axis ) - 1 );
+    t = t < 0 ? 0 : ( t > 1 ? 1 : t );
+    return uint32_t( t * scale + real( 0.5 ) );
+  }
+
+  /**@brief Compute the Morton code of a point of the unit cube.
+   *
+   * The code interleaves the bits of the three quantized coordinates, x
+   * being the most significant. Sorting points by their Morton codes gives
+   * a Z-order traversal of space.
+   * @param x First coordinate, in [0,1].
+   * @param y Second coordinate, in [0,1].
+   * @param z Third coordinate, in [0,1].
+   * @return The 63 bits Morton code. */
+  inline uint64_t morton_code( real x, real y, real z ) noexcept
+  {
+    return ( spread_bits( quantize_on_curve( x ) ) << 2 )
+         | ( spread_bits( quantize_on_curve( y ) ) << 1 )
+         |   spread_bits( quantize_on_curve( z ) );
+  }
+
+  /**@brief Compute the Hilbert code of a point of the unit cube.
+   *
+   * Consecutive points along a Hilbert curve are always neighbors, while the
+   * Z-order curve makes long jumps between octants. Sorting points by their
+   * Hilbert codes thus gives a better locality than Morton codes, for a
+   * slightly more expensive code. The code is computed by the transposition
+   * algorithm of Skilling ("Programming the Hilbert curve", AIP Conference
+   * Proceedings 707, 2004).
+   * @param x First coordinate, in [0,1].
+   * @param y Second coordinate, in [0,1].
+   * @param z Third coordinate, in [0,1].
+   * @return The 63 bits Hilbert code. */
+  inline uint64_t hilbert_code( real x, real y, real z ) noexcept
+  {
+    uint32_t axes[3] = { quantize_on_curve( x ), quantize_on_curve( y ), quantize_on_curve( z ) };
+    const uint32_t most_significant_bit = 1u << ( curve_bits_per_axis - 1 );
+
+    // inverse undo excess work
+    for( uint32_t q = most_significant_bit; q > 1; q >>= 1 )
+      {
+        const uint32_t p = q - 1;
+        for( int i = 0; i < 3; ++ i )
+          {
+            if( axes[i] & q )
+              axes[0] ^= p;
+            else
+              {
+                const uint32_t t = ( axes[0] ^ axes[i] ) & p;
+                axes[0] ^= t;
+                axes[i] ^= t;
+              }
+          }
+      }
+
+    // Gray encode
+    axes[1] ^= axes[0];
+    axes[2] ^= axes[1];
+    uint32_t t = 0;
+    for( uint32_t q = most_significant_bit; q > 1; q >>= 1 )
+      if( axes[2] & q )
+        t ^= q - 1;
+    for( int i = 0; i < 3; ++ i )
+      axes[i] ^= t;
+
+    // the transposed code is interleaved as a Morton code
+    return ( spread_bits( axes[0] ) << 2 )
+         | ( spread_bits( axes[1] ) << 1 )
+         |   spread_bits( axes[2] );
+  }
+
+  /**@brief Space filling curves available to sort points. */
+  enum space_filling_curve {
+    morton_curve,
+    hilbert_curve
+  };
+
+  /**@brief Compute the code of a point of the unit cube along a curve.
+   * @param curve The space filling curve.
+   * @param x First coordinate, in [0,1].
+   * @param y Second coordinate, in [0,1].
+   * @param z Third coordinate, in [0,1].
+   * @return The 63 bits code of the point. */
+  inline uint64_t curve_code( space_filling_curve curve, real x, real y, real z ) noexcept
+  {
+    return curve == hilbert_curve ? hilbert_code( x, y, z ) : morton_code( x, y, z );
+  }
+
+END_MP_NAMESPACE
+# endif
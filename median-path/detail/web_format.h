@@ -24,7 +24,18 @@ namespace io {
     {
       return graphics_origin::tools::get_extension( filename ) == web_format_extension;
     }
-    bool save( median_skeleton& skeleton, const std::string& filename ) override
+    bool save( const median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    bool save( const large_median_skeleton& skeleton, const std::string& filename ) override
+    {
+      return save_skeleton( skeleton, filename );
+    }
+
+    template< typename skeleton_type >
+    bool save_skeleton( const skeleton_type& skeleton, const std::string& filename )
     {
       std::ofstream output( filename );
       if( !output.is_open() )
@@ -38,7 +49,7 @@ namespace io {
       const auto nlinks = skeleton.get_number_of_links();
       const auto nfaces = skeleton.get_number_of_faces();
       real min_radius = REAL_MAX, max_radius = -1.0;
-      skeleton.process_atoms( [&min_radius,&max_radius]( median_skeleton::atom& atom )
+      skeleton.process_atoms( [&min_radius,&max_radius]( const typename skeleton_type::atom& atom )
         {
           min_radius = std::min( min_radius, atom.w );
           max_radius = std::max( max_radius, atom.w );
@@ -51,28 +62,29 @@ namespace io {
           << ",\"min_radius\":" << min_radius
           << ",\"atoms\":[";
 
-      for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      for( typename skeleton_type::atom_index i = 0; i < natoms; ++ i )
         {
           const auto& atom = skeleton.get_atom_by_index( i );
           output << atom.x << ',' << atom.y << ',' << atom.z << ',' << atom.w;
           if( i + 1 < natoms ) output << ',';
         }
       output << "],\"links\":[";
-      for( median_skeleton::link_index i = 0; i < nlinks; ++ i )
+      typename skeleton_type::link_index written_links = 0;
+      process_link_atom_indices( skeleton,
+        [&]( typename skeleton_type::atom_index i1, typename skeleton_type::atom_index i2 )
         {
-          const auto& link = skeleton.get_link_by_index( i );
-          output << skeleton.get_index(link.h1) << ',' << skeleton.get_index(link.h2);
-          if( i + 1 < nlinks ) output << ',';
-        }
+          output << i1 << ',' << i2;
+          if( ++written_links < nlinks ) output << ',';
+        } );
       output << "],\"faces\":[";
-      for( median_skeleton::face_index i = 0; i < nfaces; ++ i )
+      typename skeleton_type::face_index written_faces = 0;
+      process_face_atom_indices( skeleton,
+        [&]( typename skeleton_type::atom_index i1, typename skeleton_type::atom_index i2,
+             typename skeleton_type::atom_index i3 )
         {
-          const auto& face = skeleton.get_face_by_index( i );
-          output << skeleton.get_index( face.atoms[0] ) << ','
-              << skeleton.get_index( face.atoms[1] ) << ','
-              << skeleton.get_index( face.atoms[2] );
-          if( i + 1 < nfaces ) output << ',';
-        }
+          output << i1 << ',' << i2 << ',' << i3;
+          if( ++written_faces < nfaces ) output << ',';
+        } );
       output << "]}" << std::flush;
       output.close();
       return true;
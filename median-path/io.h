@@ -6,10 +6,16 @@
 
 # include "median_path.h"
 
+# include <future>
+# include <memory>
 # include <string>
 
 BEGIN_MP_NAMESPACE
-  class median_skeleton;
+  template< typename profile > class basic_median_skeleton;
+  struct default_skeleton_profile;
+  struct large_skeleton_profile;
+  typedef basic_median_skeleton< default_skeleton_profile > median_skeleton;
+  typedef basic_median_skeleton< large_skeleton_profile > large_median_skeleton;
 
   /**@namespace io
    *
@@ -23,7 +29,19 @@ BEGIN_MP_NAMESPACE
    * data from other software. The topology of the skeleton can then be built by reconstruction
    * algorithms from this library.
    * - .web The format of skeleton that could be loaded into the web application
-   * - .median The format used by this library.
+   * - .median The format used by this library. Atom, link and face properties
+   * whose type is registered (see property_types.h) are saved with the
+   * skeleton, and created if needed when the skeleton is loaded.
+   * - .mskel A binary format, memory mapped to load large skeletons quickly.
+   * - .mpack A compact and lossy archive of atoms, links and faces, without
+   * properties. Atoms are reordered along a Hilbert curve and quantized (see
+   * set_archive_quantization_bits()), then everything is delta and entropy
+   * coded.
+   *
+   * Skeletons are loaded and saved either as median_skeleton or as
+   * large_median_skeleton. Loaders and savers of the library handle both.
+   * Loaders and savers added by users can handle only median_skeleton: the
+   * large skeleton methods then fail, and the next loader or saver is tried.
    */
   namespace io {
 
@@ -31,12 +49,24 @@ BEGIN_MP_NAMESPACE
       virtual ~loader(){}
       virtual bool can_load_from( const std::string& filename ) = 0;
       virtual bool load( median_skeleton& skeleton, const std::string& filename ) = 0;
+      virtual bool load( large_median_skeleton& skeleton, const std::string& filename )
+      {
+        (void)skeleton;
+        (void)filename;
+        return false;
+      }
     };
 
     struct saver {
       virtual ~saver(){}
       virtual bool can_save_to( const std::string& filename ) = 0;
-      virtual bool save( median_skeleton& skeleton, const std::string& filename ) = 0;
+      virtual bool save( const median_skeleton& skeleton, const std::string& filename ) = 0;
+      virtual bool save( const large_median_skeleton& skeleton, const std::string& filename )
+      {
+        (void)skeleton;
+        (void)filename;
+        return false;
+      }
     };
 
     /**@brief Check if a skeleton file can be loaded.
@@ -61,6 +91,9 @@ BEGIN_MP_NAMESPACE
      * @return Ture if the operation is successful.
      */
     bool load( median_skeleton& skeleton, const std::string& filename );
+    /**@brief Load a large skeleton from a file.
+     * @see load( median_skeleton&, const std::string& ) */
+    bool load( large_median_skeleton& skeleton, const std::string& filename );
     /**@brief Save a skeleton to a file.
      *
      * Save a skeleton to a given file.
@@ -68,7 +101,57 @@ BEGIN_MP_NAMESPACE
      * @param filename The name of the file to save the skeleton to.
      * @return True if the operation is successful.
      */
-    bool save( median_skeleton& skeleton, const std::string& filename );
+    bool save( const median_skeleton& skeleton, const std::string& filename );
+    /**@brief Save a large skeleton to a file.
+     * @see save( const median_skeleton&, const std::string& ) */
+    bool save( const large_median_skeleton& skeleton, const std::string& filename );
+    /**@brief Save a skeleton in the background.
+     *
+     * The skeleton is saved by a thread of a bounded I/O thread pool, such
+     * that the calling thread can go on, e.g. to compute the next skeleton
+     * of a batch. If the number of pending operations reached its limit (see
+     * set_async_io_limits()), this function blocks until an operation
+     * starts. The skeleton is shared with the I/O thread: it must not be
+     * modified, nor accessed by other threads, until the future is ready.
+     * @param skeleton The skeleton to save.
+     * @param filename The name of the file to save the skeleton to.
+     * @return A future that gives the result of save(), or rethrows its
+     * exceptions.
+     */
+    std::future< bool > save_async( std::shared_ptr< const median_skeleton > skeleton, const std::string& filename );
+    /**@brief Save a large skeleton in the background.
+     * @see save_async( std::shared_ptr< const median_skeleton >, const std::string& ) */
+    std::future< bool > save_async( std::shared_ptr< const large_median_skeleton > skeleton, const std::string& filename );
+    /**@brief Load a skeleton in the background.
+     *
+     * The skeleton is loaded by a thread of the I/O thread pool, with the
+     * same back-pressure as save_async(). It must not be accessed until the
+     * future is ready.
+     * @param skeleton The skeleton to load into.
+     * @param filename The name of the file describing the skeleton to load.
+     * @return A future that gives the result of load(), or rethrows its
+     * exceptions.
+     */
+    std::future< bool > load_async( std::shared_ptr< median_skeleton > skeleton, const std::string& filename );
+    /**@brief Load a large skeleton in the background.
+     * @see load_async( std::shared_ptr< median_skeleton >, const std::string& ) */
+    std::future< bool > load_async( std::shared_ptr< large_median_skeleton > skeleton, const std::string& filename );
+    /**@brief Set the limits of the I/O thread pool.
+     *
+     * By default, two threads perform asynchronous operations and four
+     * operations can wait for a thread. Threads are started on demand, and
+     * threads already started are kept when the number of threads is
+     * lowered.
+     * @param number_of_threads The maximum number of I/O threads.
+     * @param max_pending_operations The maximum number of operations waiting
+     * for a thread before save_async() and load_async() block.
+     */
+    void set_async_io_limits( size_t number_of_threads, size_t max_pending_operations );
+    /**@brief Wait for the completion of all asynchronous operations.
+     *
+     * Call it before exiting a program that does not wait for its futures:
+     * loaders and savers are released at exit. */
+    void wait_async_operations();
     /**@brief Add a loader to load more skeleton file types.
      *
      * Add a skeleton file loader to the loaders list. This function
@@ -83,6 +166,17 @@ BEGIN_MP_NAMESPACE
      * @param saver A skeleton file saver.
      */
     void add_saver( saver* svr );
+    /**@brief Set the precision of the atoms saved in .mpack archives.
+     *
+     * Atom coordinates and radii are quantized on a number of bits relatively
+     * to their range in the skeleton. The default is 16 bits, i.e. an error
+     * below 1/131070 of the range. Values are clamped to [1, 32].
+     * @param bits The number of bits per component.
+     */
+    void set_archive_quantization_bits( uint32_t bits );
+    /**@brief Get the precision of the atoms saved in .mpack archives.
+     * @see set_archive_quantization_bits() */
+    uint32_t get_archive_quantization_bits();
 
     void init_default_loaders_and_savers() __attribute__((constructor));
     void release_loaders_and_savers() __attribute__((destructor));
@@ -2,8 +2,17 @@
 # define MEDIAN_PATH_MEDIAN_SKELETON_H_
 
 # include "detail/skeleton_datastructure.h"
-
+# include "detail/skeleton_profiles.h"
+# include "detail/atom_bvh.h"
+# include "detail/atom_columns.h"
+# include "detail/change_journal.h"
+# include "detail/hash_index.h"
+# include "detail/small_vector.h"
+# include "detail/space_filling_curves.h"
+
+# include <array>
 # include <string>
+# include <vector>
 # include <stdint.h>
 
 namespace median_path {
@@ -43,6 +52,8 @@ namespace median_path {
    * - MP_SKELETON_NO_HANDLE_CHECK
    * - MP_SKELETON_NO_POINTER_CHECK
    * - MP_SKELETON_NO_CHECK (to define the three previous symbols).
+   * Checks can also be chosen per call site, whatever those symbols, with the
+   * element accessors returned by checked(), unchecked() and access().
    *
    * For each skeleton elements, you have methods to:
    * - add a new element
@@ -51,27 +62,59 @@ namespace median_path {
    * - process all elements
    * - filter elements (select which elements will be removed).
    *
+   * Atoms are always available as a tight buffer of balls. A skeleton can
+   * additionally maintain a structure of arrays copy of its atoms (see
+   * set_atom_layout()), which speeds up passes that only need the centers or
+   * the radii of atoms, like bounding box or radii computations.
+   *
+   * The non constant accesses to atoms (get(), get_atom_by_index(),
+   * process_atoms() and process_atom_chunks() on a non constant skeleton)
+   * mark the atoms as modified, which makes the structure of arrays copy and
+   * the atom hierarchy out of date. Their constant overloads only read
+   * atoms and have no side effect: code that does not modify atoms should
+   * access them through a constant skeleton.
+   *
+   * The storage types are given by a profile (see skeleton_profiles.h):
+   * - median_skeleton stores atoms in double precision. This is the skeleton
+   * used by atomizers, structurers and regularizers.
+   * - single_precision_median_skeleton stores atoms in single precision, which
+   * halves the atom memory. This is enough for visualization, export and most
+   * analyses.
+   * - large_median_skeleton stores atoms in double precision with 64 bits
+   * atom handles, for skeletons with more atoms than the other profiles can
+   * hold. Its memory overhead is detailed in large_skeleton_profile.
+   * Skeletons of different profiles are converted into each other with
+   * assign() or the converting constructor.
+   *
    * Maximum capacities:
-   *   - 2^22 atoms
+   *   - 2^22 atoms, 2^40 atoms for large_median_skeleton
    *   - 2^44 links
    *   - 2^54 faces
    */
-  class median_skeleton
+  template< typename profile >
+  class basic_median_skeleton
   {
-    typedef skeleton_datastructure< uint32_t, 22, uint64_t, 44, uint64_t, 54 > datastructure;
+    typedef typename profile::datastructure datastructure;
   public:
     ///
-    using atom = datastructure::atom;
-    using link = datastructure::link;
-    using face = datastructure::face;
+    using atom = typename datastructure::atom;
+    using link = typename datastructure::link;
+    using face = typename datastructure::face;
 
-    using atom_handle = datastructure::atom_handle;
-    using link_handle = datastructure::link_handle;
-    using face_handle = datastructure::face_handle;
+    using atom_handle = typename datastructure::atom_handle;
+    using link_handle = typename datastructure::link_handle;
+    using face_handle = typename datastructure::face_handle;
 
-    using atom_index = datastructure::atom_index;
-    using link_index = datastructure::link_index;
-    using face_index = datastructure::face_index;
+    using atom_index = typename datastructure::atom_index;
+    using link_index = typename datastructure::link_index;
+    using face_index = typename datastructure::face_index;
+
+    /**Type of the atom components.*/
+    typedef typename profile::atom_real atom_real;
+    /**Structure of arrays copy of atoms, in the precision of atoms.*/
+    typedef basic_atom_columns< atom > atom_columns;
+    /**Bounding volume hierarchy over atoms, to answer ball queries.*/
+    typedef basic_atom_bvh< atom, atom_index > atom_bvh;
 
     // Those constants represent 'not-an-index' named null_atom_index,
     // null_link_index and null_face_index.
@@ -83,6 +126,19 @@ namespace median_path {
     typedef uint32_t link_property_index;
     typedef uint32_t face_property_index;
 
+    /**@brief Layouts of the atom storage.
+     *
+     * - array_of_structures: atoms are only stored as a tight buffer of
+     * balls. This is the default.
+     * - structure_of_arrays: the skeleton also maintains aligned arrays of
+     * x, y, z and radii (see atom_columns). Geometric reductions over atoms
+     * (bounding boxes, radii, transformations) are then vectorized over those
+     * arrays. The arrays cost as much memory as the atoms. */
+    enum atom_layout {
+      array_of_structures,
+      structure_of_arrays
+    };
+
     /**@brief Map an atom to a face passing by this atom.
      *
      * Let us suppose that a face with handle f connects three links and three atoms
@@ -99,11 +155,16 @@ namespace median_path {
       face_handle face;
 
       atom_face_element(
-        datastructure::face& f, face_handle fh, ushort i );
+        typename datastructure::face& f, face_handle fh, ushort i );
       atom_face_element( );
+      atom_face_element(
+        const atom_face_element& other ) = default;
       atom_face_element(
         atom_face_element&& other );
       atom_face_element&
+      operator=(
+        const atom_face_element& other ) = default;
+      atom_face_element&
       operator=(
         atom_face_element&& other );
     };
@@ -124,19 +185,39 @@ namespace median_path {
       face_handle face;
 
       link_face_element(
-        datastructure::face& f, face_handle fh, ushort i );
+        typename datastructure::face& f, face_handle fh, ushort i );
       link_face_element( );
+      link_face_element(
+        const link_face_element& other ) = default;
       link_face_element(
         link_face_element&& other );
       link_face_element&
+      operator=(
+        const link_face_element& other ) = default;
+      link_face_element&
       operator=(
         link_face_element&& other );
     };
 
-    typedef std::vector< std::pair< link_handle, atom_handle > > atom_links_property;
-    typedef std::vector< atom_face_element > atom_faces_property;
+    typedef small_vector< std::pair< link_handle, atom_handle >, 6 > atom_links_property;
+    typedef small_vector< atom_face_element, 4 > atom_faces_property;
     typedef std::vector< link_face_element > link_faces_property;
 
+    /**@brief A contiguous range of topology elements.
+     *
+     * Such range gives a read-only access to the links or faces of an atom
+     * or to the faces of a link, whether the topology is frozen or not. It is
+     * invalidated by any modification of the skeleton. */
+    template< typename element >
+    struct element_range {
+      const element* first;
+      const element* last;
+      const element* begin() const noexcept { return first; }
+      const element* end() const noexcept { return last; }
+      size_t size() const noexcept { return last - first; }
+      bool empty() const noexcept { return first == last; }
+    };
+
     /**@name Construction & Destruction
      * @{ */
     /**@brief Build a median skeleton.
@@ -147,34 +228,41 @@ namespace median_path {
      * @param link_capacity Requested link capacity
      * @param face_capacity Requested face capacity
      */
-    median_skeleton(
-      atom_index atom_capacity = 0, uint64_t link_capacity = 0,
-      uint64_t face_capacity = 0 );
+    basic_median_skeleton(
+      atom_index atom_capacity = 0, link_index link_capacity = 0,
+      face_index face_capacity = 0 );
     /**@brief Copy constructor
      *
      * Copy a skeleton into this. This operation is very fast as it is merely
      * a swap between two pointers. At the end of the copy, the other skeleton
      * is in a undefined, but valid, state. */
-    median_skeleton(
-      median_skeleton&& other );
+    basic_median_skeleton(
+      basic_median_skeleton&& other );
     /**@brief Build from file
      *
      * Build a median skeleton from a file.
      * @param filename The path of the file describing the skeleton to build. */
-    median_skeleton(
+    basic_median_skeleton(
       const std::string& filename );
+    /**@brief Build from a skeleton of another profile.
+     *
+     * See assign().
+     * @param other The skeleton to convert. */
+    template< typename other_profile >
+    explicit basic_median_skeleton(
+      const basic_median_skeleton< other_profile >& other );
 
-    median_skeleton( const median_skeleton& other ) = delete;
+    basic_median_skeleton( const basic_median_skeleton& other ) = delete;
 
-    median_skeleton&
+    basic_median_skeleton&
     operator=(
-      median_skeleton&& other );
+      basic_median_skeleton&& other );
 
-    median_skeleton&
+    basic_median_skeleton&
     operator=(
-      const median_skeleton& other ) = delete;
+      const basic_median_skeleton& other ) = delete;
 
-    ~median_skeleton( );
+    ~basic_median_skeleton( );
     ///@}
 
     /**@name Utilities
@@ -185,7 +273,7 @@ namespace median_path {
      * requested number of atom, link and faces. The previous atom, link and
      * face properties still exist in the skeleton but are now empty. If a requested
      * capacity is smaller than the current capacity, the corresponding buffer is not
-     * shrinked.
+     * shrinked: call shrink_to_fit() to release the memory.
      * @param atom_capacity Requested atom capacity
      * @param link_capacity Requested link capacity
      * @param face_capacity Requested face capacity */
@@ -194,6 +282,97 @@ namespace median_path {
       atom_index atom_capacity = 0, link_index link_capacity = 0,
       face_index face_capacity = 0 );
 
+    /**@brief Replace this skeleton by a skeleton of another profile.
+     *
+     * Atoms are converted in parallel to the precision of this skeleton:
+     * widening single precision atoms to double precision is exact, while
+     * narrowing rounds each component to the nearest float. Atoms, links and
+     * faces keep their indices, but not their handles. User properties are
+     * not copied, and the topology of this skeleton is not frozen. Algorithms
+     * can thus compute in double precision and store their result in single
+     * precision, or the opposite.
+     * @param other The skeleton to convert. */
+    template< typename other_profile >
+    void
+    assign(
+      const basic_median_skeleton< other_profile >& other );
+
+    /**@brief Create a deep copy of this skeleton.
+     *
+     * The copy has the same atoms, links, faces and properties as this
+     * skeleton, at the same indices. Handle tables are copied too, such that
+     * the handles of this skeleton are valid handles of the copy and identify
+     * the same elements. Buffers and trivially copyable properties are copied
+     * in parallel with memcpy, topology in parallel too, such that forking a
+     * skeleton costs a fraction of a file round-trip. If a property type is
+     * not copy assignable, a skeleton_property_not_copyable exception is
+     * thrown. This method must not be called during a concurrent creation of
+     * atoms.
+     * @return The copy of this skeleton. */
+    basic_median_skeleton
+    clone() const;
+
+    /**@brief Create a copy of the atoms of this skeleton.
+     *
+     * Atoms, their handles and their properties are copied as with clone(),
+     * but the copy has no link and no face. This is the cheapest way to try
+     * geometric variants of a skeleton, e.g. different scale factors.
+     * @return The copy of the atoms of this skeleton. */
+    basic_median_skeleton
+    clone_geometry_only() const;
+
+    /**@brief Freeze the topology of this skeleton.
+     *
+     * By default, each atom stores its links and faces in its own small
+     * vectors, and each link stores its faces in its own vector. This is
+     * convenient to edit the topology, but it costs pointer chasing during
+     * traversals. This method copies all those vectors into contiguous
+     * compressed sparse row arrays (offsets and elements), built with a
+     * parallel count, prefix sums and scatter.
+     *
+     * Read-only topology queries (get_number_of_links(), get_number_of_faces(),
+     * is_a_link(), get_atom_links(), get_atom_faces(), get_link_faces()) then
+     * work on those arrays. The first method that adds or removes an element
+     * thaws the topology, so freezing is always safe. Freezing a frozen
+     * skeleton does nothing.
+     *
+     * The vectors are kept while the topology is frozen, such that the
+     * topology properties stay valid and thawing only releases the arrays.
+     * Freezing thus costs a copy of the topology, in time and in memory, and
+     * is worth it when many traversals follow it. */
+    void
+    freeze();
+
+    /**@brief Release the arrays of a frozen topology.
+     *
+     * This is called automatically before any modification of the topology,
+     * and does not allocate. Thawing a skeleton that is not frozen does
+     * nothing. */
+    void
+    thaw();
+
+    /**@brief Check if the topology of this skeleton is frozen.
+     * @return True if the topology is stored in contiguous arrays. */
+    bool
+    is_frozen() const noexcept;
+
+    /**@brief Enable or disable the hash index of links and faces.
+     *
+     * Without index, checking if a link exists scans the links of an atom and
+     * checking if a face exists scans the faces of an atom. For high-valence
+     * atoms, such as junctions of Voronoi skeletons with hundreds of links,
+     * inserting the topology becomes quadratic. When enabled, an open
+     * addressing hash index keyed on the atoms of each link and face makes
+     * those checks constant time. It is built when enabled, then maintained
+     * by every addition and removal of elements. It is disabled by default.
+     * @param enabled True to build and maintain the index. */
+    void
+    set_topology_index( bool enabled );
+
+    /**@brief Check if the hash index of links and faces is maintained. */
+    bool
+    has_topology_index() const noexcept;
+
     /**@brief Reserve place for atoms.
      *
      * Expand atom buffers to the requested capacity. If the requested capacity is smaller
@@ -227,6 +406,45 @@ namespace median_path {
     reserve_faces(
       face_index new_faces_capacity );
 
+    /**@brief Release the memory that is not used.
+     *
+     * The atom, link and face buffers are reduced to the smallest capacity
+     * that keeps all elements and all valid handles. The scratch buffers of
+     * the removal methods and the atom columns are released too. Handles of
+     * removed elements may become valid again after this call, once the
+     * buffers grow back. */
+    void
+    shrink_to_fit();
+
+    /**@brief Sort the elements along a space filling curve.
+     *
+     * Atoms are stored in the order they were produced, e.g. the cell
+     * iteration order of a triangulation, which is spatially scattered: link
+     * and face traversals then access atoms at random places in memory. This
+     * method sorts atoms along a space filling curve of their centers, then
+     * links and faces by the indices of their atoms, such that neighbor
+     * elements are close in memory. Properties are permuted with their
+     * elements, in parallel. Handles remain valid, while indices, references
+     * and pointers to elements do not. A frozen topology is thawed.
+     * @param curve The curve used to sort atoms. */
+    void
+    reorder(
+      space_filling_curve curve = hilbert_curve );
+
+    /**@brief Set the policy used to grow full buffers.
+     *
+     * This policy is used when an element is added while its buffers are
+     * full. It does not apply to reserve_atoms(), reserve_links() and
+     * reserve_faces(), which give the exact requested capacity.
+     * @param policy The new growth policy. */
+    void
+    set_growth_policy(
+      const growth_policy& policy ) noexcept;
+
+    /**@brief Get the policy used to grow full buffers. */
+    const growth_policy&
+    get_growth_policy() const noexcept;
+
     /**@brief Load a skeleton from a file.
      *
      * Load a median skeleton described by a file into this skeleton.
@@ -238,12 +456,13 @@ namespace median_path {
 
     /**@brief Save a skeleton to a file.
      *
-     * Save this skeleton to a file.
+     * Save this skeleton to a file. Savers only read the skeleton: its atom
+     * columns, hierarchy and change journal are left untouched.
      * @param filename The path of the file to write this skeleton into.
      * @return true if the save was successful */
     bool
     save(
-      const std::string& filename );
+      const std::string& filename ) const;
 
     /**@brief Get the current number of atoms
      *
@@ -340,6 +559,245 @@ namespace median_path {
     compute_minmax_radii(
       real& minr, real& maxr ) const;
 
+    /**@brief Apply a uniform scaling followed by a translation to atoms.
+     *
+     * Each atom center c becomes scale * c + translation, while each radius r
+     * becomes |scale| * r. The atom columns are updated too if the skeleton
+     * uses the structure_of_arrays layout.
+     * @param scale The scaling factor.
+     * @param translation The translation to apply after the scaling. */
+    void
+    transform(
+      real scale, const vec3& translation );
+
+    /**@brief Set the layout used to store atoms.
+     *
+     * Switching to structure_of_arrays allocates the atom columns, which are
+     * then filled the next time they are needed. Switching back to
+     * array_of_structures releases them.
+     * @param layout The new atom layout. */
+    void
+    set_atom_layout(
+      atom_layout layout );
+
+    /**@brief Get the layout used to store atoms.
+     * @return The current atom layout. */
+    atom_layout
+    get_atom_layout() const noexcept;
+
+    /**@brief Get the structure of arrays copy of the atoms.
+     *
+     * The columns are synchronized with the atom buffer if atoms may have
+     * changed since the last synchronization. Any method giving a non constant
+     * access to atoms (e.g. get(), get_atom_by_index(), process_atoms() on a
+     * non constant skeleton) marks the columns as out of date. This method can
+     * be called even if the layout is array_of_structures: the columns are
+     * then built on demand. Concurrent calls are safe, the synchronization
+     * being done under a lock by one of them, but not concurrently with a
+     * modification of the atoms.
+     * @return The synchronized atom columns. */
+    const atom_columns&
+    get_atom_columns() const;
+
+    /**@brief Get the bounding volume hierarchy over atoms.
+     *
+     * The hierarchy answers point containment, closest surface, k nearest
+     * atoms and ball overlap queries (see atom_bvh). Query results are atom
+     * indices. A new hierarchy is built if atoms were added or removed since
+     * the last call. If atoms may have moved, through any method giving a non
+     * constant access to them, the boxes of the hierarchy are refitted
+     * instead, which is also the case after a transformation. This method is
+     * not thread safe, but the queries are.
+     * @return The synchronized hierarchy. */
+    const atom_bvh&
+    get_atom_bvh() const;
+
+    /**@name Change journal
+     * @{ */
+    /**@brief Enable or disable the change journal of this skeleton.
+     *
+     * When enabled, the journal records the index ranges of added, removed,
+     * moved and modified elements (see change_journal), such that renderers,
+     * caches or savers can process only what changed since their last
+     * update. Atoms are recorded as modified by any method giving a non
+     * constant access to them. Properties are accessed through raw references,
+     * thus their modifications have to be reported by their writer with the
+     * mark_*_property_modified() methods. The journal is disabled by default:
+     * recording costs a test per operation and a few vector operations per
+     * change. Disabling the journal releases it. Copies made by clone() have
+     * no journal.
+     * @param enable True to enable the journal. */
+    void
+    set_change_journal( bool enable );
+
+    /**@brief Check if the change journal is enabled. */
+    bool
+    has_change_journal() const noexcept;
+
+    /**@brief Get the change journal.
+     * @return The journal, or nullptr if it is disabled. */
+    const change_journal*
+    get_change_journal() const noexcept;
+
+    /**@brief Forget the changes recorded by the journal, typically once a
+     * consumer is up to date. The epoch of the journal is kept. */
+    void
+    clear_change_journal() noexcept;
+
+    /**@brief Report a modification of an atom property.
+     *
+     * Nothing is done if the journal is disabled.
+     * @param property_index The index of the property.
+     * @param begin First atom index of the modified range.
+     * @param end End of the modified range. */
+    void
+    mark_atom_property_modified( size_t property_index, atom_index begin, atom_index end );
+
+    /**@brief Report a modification of a link property.
+     * @see mark_atom_property_modified */
+    void
+    mark_link_property_modified( size_t property_index, link_index begin, link_index end );
+
+    /**@brief Report a modification of a face property.
+     * @see mark_atom_property_modified */
+    void
+    mark_face_property_modified( size_t property_index, face_index begin, face_index end );
+    ///@}
+
+    /**@name Element access policies
+     * @{ */
+    /**@brief Access to skeleton elements with a check policy.
+     *
+     * The checks of the skeleton methods are toggled for a whole translation
+     * unit by the MP_SKELETON_NO_*_CHECK symbols, and those methods are not
+     * inlined. An element_access validates indices and handles according to
+     * its check_policy (see check_policies.h), with the same exceptions as
+     * the skeleton methods, and is defined in the header such that its calls
+     * are inlined. Typically, arguments are checked once at API boundaries
+     * while inner loops use unchecked() accesses. As for the skeleton
+     * methods, an element_access obtained from a constant skeleton only reads
+     * elements, without any side effect, while a mutable_element_access
+     * obtained from a non constant skeleton returns modifiable elements: its
+     * accesses to atoms mark the atom columns and hierarchy as out of date
+     * and the change journal records the atoms.
+     *
+     * The batch method get_indices() resolves many handles at once and
+     * prefetches the handle entries ahead of the resolution, which hides the
+     * latency of the random accesses to the handle tables.
+     *
+     * An element_access refers to its skeleton and must not outlive it. */
+    template< typename check_policy >
+    class element_access {
+    public:
+      explicit element_access( const basic_median_skeleton& skeleton ) noexcept
+        : m_skeleton{ skeleton }
+      {}
+
+      const atom& get( atom_handle handle ) const;
+      const link& get( link_handle handle ) const;
+      const face& get( face_handle handle ) const;
+
+      const atom& get_atom_by_index( atom_index index ) const;
+      const link& get_link_by_index( link_index index ) const;
+      const face& get_face_by_index( face_index index ) const;
+
+      atom_index get_index( atom_handle handle ) const;
+      link_index get_index( link_handle handle ) const;
+      face_index get_index( face_handle handle ) const;
+
+      /**@brief Get the indices of atoms known by their handles.
+       * @param handles The handles to resolve.
+       * @param number_of_handles Number of handles to resolve.
+       * @param indices Receive the index of each atom. */
+      void get_indices( const atom_handle* handles, size_t number_of_handles, atom_index* indices ) const;
+      /**@brief Get the indices of links known by their handles.
+       * @see get_indices(const atom_handle*,size_t,atom_index*) */
+      void get_indices( const link_handle* handles, size_t number_of_handles, link_index* indices ) const;
+      /**@brief Get the indices of faces known by their handles.
+       * @see get_indices(const atom_handle*,size_t,atom_index*) */
+      void get_indices( const face_handle* handles, size_t number_of_handles, face_index* indices ) const;
+
+    protected:
+      const basic_median_skeleton& m_skeleton;
+    };
+
+    /**@brief Access to modifiable skeleton elements with a check policy.
+     *
+     * Atoms obtained by this access are considered as modified, as with the
+     * non constant get() and get_atom_by_index() of the skeleton.
+     * @see element_access */
+    template< typename check_policy >
+    class mutable_element_access
+      : public element_access< check_policy > {
+    public:
+      explicit mutable_element_access( basic_median_skeleton& skeleton ) noexcept
+        : element_access< check_policy >{ skeleton },
+          m_mutable_skeleton{ skeleton }
+      {}
+
+      atom& get( atom_handle handle ) const;
+      link& get( link_handle handle ) const;
+      face& get( face_handle handle ) const;
+
+      atom& get_atom_by_index( atom_index index ) const;
+      link& get_link_by_index( link_index index ) const;
+      face& get_face_by_index( face_index index ) const;
+
+    private:
+      basic_median_skeleton& m_mutable_skeleton;
+    };
+
+    /**@brief Get an access to the elements of this skeleton with a check
+     * policy. */
+    template< typename check_policy >
+    element_access< check_policy >
+    access() const noexcept
+    {
+      return element_access< check_policy >( *this );
+    }
+
+    /**@brief Get an access to the modifiable elements of this skeleton with
+     * a check policy. */
+    template< typename check_policy >
+    mutable_element_access< check_policy >
+    access() noexcept
+    {
+      return mutable_element_access< check_policy >( *this );
+    }
+
+    /**@brief Get an access to the elements of this skeleton that checks
+     * nothing, e.g. skeleton.unchecked().get_atom_by_index( i ). */
+    element_access< unchecked_policy >
+    unchecked() const noexcept
+    {
+      return element_access< unchecked_policy >( *this );
+    }
+
+    /**@brief Get an access to the modifiable elements of this skeleton that
+     * checks nothing. */
+    mutable_element_access< unchecked_policy >
+    unchecked() noexcept
+    {
+      return mutable_element_access< unchecked_policy >( *this );
+    }
+
+    /**@brief Get an access to the elements of this skeleton that checks
+     * everything, whatever the MP_SKELETON_NO_*_CHECK symbols. */
+    element_access< checked_policy >
+    checked() const noexcept
+    {
+      return element_access< checked_policy >( *this );
+    }
+
+    /**@brief Get an access to the modifiable elements of this skeleton that
+     * checks everything, whatever the MP_SKELETON_NO_*_CHECK symbols. */
+    mutable_element_access< checked_policy >
+    checked() noexcept
+    {
+      return mutable_element_access< checked_policy >( *this );
+    }
+    ///@}
+
     /**@name Atom management
      * @{ */
     /**@brief Add an atom to the skeleton.
@@ -363,6 +821,62 @@ namespace median_path {
     add(
       const vec4& ball );
 
+    /**@brief Prepare a concurrent insertion of atoms.
+     *
+     * Atomizers produce atoms from many threads at once. With add(), they
+     * would have to serialize their calls. Instead, this method takes room
+     * and handle slots for at most the given number of atoms, such that
+     * concurrent_add() can then be called from several threads without any
+     * lock. The insertion is finished by end_concurrent_add(). Between those
+     * two calls, the skeleton must not be modified by other methods.
+     * Properties of the new atoms can be set concurrently as their buffers
+     * are not resized during the insertion.
+     * @param number_of_atoms Maximum number of atoms to insert. */
+    void
+    begin_concurrent_add(
+      atom_index number_of_atoms );
+    /**@brief Add an atom to the skeleton during a concurrent insertion.
+     *
+     * This method is thread safe. If more atoms than the number announced to
+     * begin_concurrent_add() are added, skeleton_atom_buffer_overflow is
+     * thrown.
+     * @param position Center of the atom to add.
+     * @param radius Radius of the atom to add.
+     * @return An atom handle that points to the newly created atom. */
+    atom_handle
+    concurrent_add(
+      const vec3& position, const real& radius );
+    /**@brief Add an atom to the skeleton during a concurrent insertion.
+     *
+     * This method is thread safe. If more atoms than the number announced to
+     * begin_concurrent_add() are added, skeleton_atom_buffer_overflow is
+     * thrown.
+     * @param ball A vec4 with xyz describing the atom center and w
+     * storing the radius.
+     * @return An atom handle that points to the newly created atom. */
+    atom_handle
+    concurrent_add(
+      const vec4& ball );
+    /**@brief Finish a concurrent insertion of atoms.
+     *
+     * After this call, the atoms inserted by concurrent_add() are counted by
+     * get_number_of_atoms() and the skeleton can be modified again. */
+    void
+    end_concurrent_add();
+
+    /**@brief Add many atoms at once.
+     *
+     * Loaders know all the atoms of a skeleton beforehand. This method
+     * creates them in one go, at consecutive indices in the order of the
+     * array, and fills the atoms and their handle entries in parallel.
+     * @param balls Array of balls, with xyz describing the atom centers and
+     * w storing the radii.
+     * @param number_of_atoms Number of balls in the array.
+     * @return The index of the first added atom. */
+    atom_index
+    add_atoms(
+      const vec4* balls, atom_index number_of_atoms );
+
     /**@brief Remove an atom know by its handle.
      *
      * Remove an atom from the skeleton. Its faces and links will
@@ -390,10 +904,22 @@ namespace median_path {
      * Access to an atom thank to its handle. If the handle is
      * incorrect, an exception is thrown. Be careful to not store this
      * reference if you plan to add/remove atoms after, since it will
-     * invalidate the reference.
+     * invalidate the reference. The atom is marked as modified: atom
+     * columns and hierarchy are out of date and the change journal records
+     * it. Use the constant overload to only read the atom.
      * @param handle Handle of the atom in the tight buffer.
      */
     atom&
+    get(
+      atom_handle handle );
+
+    /**@brief Read an atom known by an handle.
+     *
+     * This overload has no side effect and can be called concurrently.
+     * @see get(atom_handle)
+     * @param handle Handle of the atom in the tight buffer.
+     */
+    const atom&
     get(
       atom_handle handle ) const;
 
@@ -402,10 +928,21 @@ namespace median_path {
      * Access to an atom thank to its index. If the index is
      * incorrect, an exception is thrown. Be careful to not store this
      * reference if you plan to add/remove atoms after, since it will
-     * invalidate the reference.
+     * invalidate the reference. The atom is marked as modified, as with
+     * get(atom_handle).
      * @param index Index of the atom in the tight buffer.
      */
     atom&
+    get_atom_by_index(
+      atom_index index );
+
+    /**@brief Read an atom known by an index.
+     *
+     * This overload has no side effect and can be called concurrently.
+     * @see get_atom_by_index(atom_index)
+     * @param index Index of the atom in the tight buffer.
+     */
+    const atom&
     get_atom_by_index(
       atom_index index ) const;
 
@@ -418,6 +955,18 @@ namespace median_path {
     atom_index
     get_index(
       atom_handle handle ) const;
+    /**@brief Get the indices of atoms known by their handles.
+     *
+     * Handles are resolved in a batch, handle entries being prefetched
+     * ahead of the resolution. If a handle does not point to a valid atom,
+     * an exception is thrown.
+     * @param handles The handles to resolve.
+     * @param number_of_handles Number of handles to resolve.
+     * @param indices Receive the index of each atom.
+     */
+    void
+    get_indices(
+      const atom_handle* handles, size_t number_of_handles, atom_index* indices ) const;
     /**@brief Get the index of an atom known by a reference.
      *
      * Get the index of an atom known by a reference. If the reference does
@@ -478,7 +1027,8 @@ namespace median_path {
     /**@brief Apply a process function on all atoms.
      *
      * This method apply, in parallel or not, a function on each
-     * valid atom.
+     * valid atom. The function is called as function( atom ), or as
+     * function( index, atom ) if it accepts the index of the atom.
      * @param function The function to apply.
      * @param parallel A flag to activate a parallel processing.
      */
@@ -487,6 +1037,65 @@ namespace median_path {
       process_atoms(
         atom_processer&& function, bool parallel = true );
 
+    /**@brief Apply a process function on all atoms, with control on the
+     * scheduling.
+     *
+     * Atoms are processed by chunks of consecutive atoms, as specified by
+     * the options (see parallel_options), while the function is still called
+     * per atom, with or without its index.
+     * @param function The function to apply.
+     * @param options Scheduling, grain size and parallelism.
+     */
+    template< typename atom_processer >
+      void
+      process_atoms(
+        atom_processer&& function, const parallel_options& options );
+
+    /**@brief Apply a process function on blocks of atoms.
+     *
+     * Atoms are split into blocks of consecutive atoms, as specified by the
+     * options (see parallel_options), and the function is called once per
+     * block as function( begin, end, atoms ), where atoms points to the atom
+     * of index begin and the block is [[atoms, atoms + end - begin[[. Cheap
+     * functions do not pay a scheduling cost per atom and can be written as
+     * vectorized loops. Atoms are marked as modified, as with
+     * process_atoms().
+     * @param function The function to apply.
+     * @param options Scheduling, grain size and parallelism.
+     */
+    template< typename atom_chunk_processer >
+      void
+      process_atom_chunks(
+        atom_chunk_processer&& function, const parallel_options& options = parallel_options() );
+
+    /**@brief Apply a read only function on all atoms.
+     *
+     * The function receives constant atoms, and atoms are not marked as
+     * modified. This is the overload used on constant skeletons.
+     * @see process_atoms(atom_processer&&,bool) */
+    template< typename atom_processer >
+      void
+      process_atoms(
+        atom_processer&& function, bool parallel = true ) const;
+
+    /**@brief Apply a read only function on all atoms, with control on the
+     * scheduling.
+     * @see process_atoms(atom_processer&&,const parallel_options&) */
+    template< typename atom_processer >
+      void
+      process_atoms(
+        atom_processer&& function, const parallel_options& options ) const;
+
+    /**@brief Apply a read only function on blocks of atoms.
+     *
+     * The function is called as function( begin, end, atoms ) with constant
+     * atoms, which are not marked as modified.
+     * @see process_atom_chunks(atom_chunk_processer&&,const parallel_options&) */
+    template< typename atom_chunk_processer >
+      void
+      process_atom_chunks(
+        atom_chunk_processer&& function, const parallel_options& options = parallel_options() ) const;
+
     /**@brief Filter atoms according to a filter function.
      *
      * This method selects atoms to remove thanks to a filter function. The
@@ -495,11 +1104,14 @@ namespace median_path {
      * removals. This function will invalidate references and indices to atoms.
      * @param filter The filter function used to select atoms to remove.
      * @param parallel A flag to activate a parallel evaluation of the filter function.
+     * @param preserve_order A flag to keep the relative order of remaining
+     * atoms. Otherwise, atoms of the end of the buffer fill the holes, which
+     * can be done entirely in parallel.
      */
     template< typename atom_filter >
       void
       remove_atoms(
-        atom_filter&& filter, bool parallel = true );
+        atom_filter&& filter, bool parallel = true, bool preserve_order = false );
 
     /**@brief Add an atom property to this skeleton.
      *
@@ -510,10 +1122,28 @@ namespace median_path {
      * skeleton_atom_property_already_exist is thrown. You can check if a name
      * is already given thanks to the method is_an_atom_property_name().
      *
+     * A dense property allocates all its elements with the buffers, a paged
+     * property allocates pages of elements when they are accessed, while a
+     * sparse property stores only the accessed elements in a hash map. Use
+     * paged or sparse properties for annotations that concern a small part
+     * of the elements.
+     *
      * @param name Unique name that identify the new property.
+     * @param storage How the elements of the property are stored.
      * @return A reference to the newly created atom property. */
     template< typename atom_property >
-    base_property_buffer& add_atom_property( const std::string& name );
+    base_property_buffer& add_atom_property( const std::string& name,
+      base_property_buffer::storage_type storage = base_property_buffer::dense );
+
+    /**@brief Add an atom property whose buffer is already created.
+     *
+     * This is meant for loaders, which know the type of a property only at
+     * run time (see property_types.h). The buffer is sized to the capacity
+     * of the atoms. If a property already exist with the same name, the
+     * exception skeleton_atom_property_already_exist is thrown.
+     * @param property The buffer of the new property.
+     * @return A reference to the newly created atom property. */
+    base_property_buffer& add_atom_property( std::unique_ptr< base_property_buffer > property );
 
     /**@brief Check if an atom property with a particular name already exist.
      *
@@ -543,6 +1173,14 @@ namespace median_path {
      * @return The atom property with that index. */
     base_property_buffer& get_atom_property( atom_property_index index );
 
+    /**@brief Read an atom property thanks to its index.
+     *
+     * This overload has no side effect.
+     * @see get_atom_property(atom_property_index)
+     * @param index The atom property index to get.
+     * @return The atom property with that index. */
+    const base_property_buffer& get_atom_property( atom_property_index index ) const;
+
     /**@brief Get the index of an atom property.
      *
      * Get the index of an atom property. This index allows to fetch the
@@ -609,6 +1247,20 @@ namespace median_path {
     link_handle
     add(
       atom_index idx1, atom_index idx2 );
+    /**@brief Add a batch of links to the skeleton.
+     *
+     * Add links between pairs of atoms given by their indices. This is
+     * equivalent to calling add( atom_index, atom_index ) for each pair, but
+     * much faster for large batches: pairs are deduplicated in parallel, then
+     * the link buffers and the atom adjacencies are sized once and filled in
+     * a single pass. Pairs connecting the same atoms, in any order, and pairs
+     * of already existing links are ignored. If one of the atom indices is
+     * invalid, an exception is thrown and the skeleton is left unchanged.
+     * @param links The pairs of atom indices to connect.
+     * @return The number of links created. */
+    link_index
+    add_links(
+      const std::vector< std::pair< atom_index, atom_index > >& links );
     /**@brief Remove a link know by its handle.
      *
      * Remove a link from the skeleton. Its faces will
@@ -668,6 +1320,18 @@ namespace median_path {
     link_index
     get_index(
       link_handle handle ) const;
+    /**@brief Get the indices of links known by their handles.
+     *
+     * Handles are resolved in a batch, handle entries being prefetched
+     * ahead of the resolution. If a handle does not point to a valid link,
+     * an exception is thrown.
+     * @param handles The handles to resolve.
+     * @param number_of_handles Number of handles to resolve.
+     * @param indices Receive the index of each link.
+     */
+    void
+    get_indices(
+      const link_handle* handles, size_t number_of_handles, link_index* indices ) const;
     /**@brief Get the index of a link known by a reference.
      *
      * Get the index of a link known by a reference. If the reference does
@@ -707,10 +1371,42 @@ namespace median_path {
       atom_index idx1,
       atom_index idx2 ) const;
 
+    /**@brief Get the links of an atom.
+     *
+     * Get the links attached to an atom known by its index, as pairs of link
+     * handle and handle of the other atom of the link. If the index is
+     * invalid, an exception is thrown.
+     * @param index Index of the atom.
+     * @return A range over the links of the atom. */
+    element_range< std::pair< link_handle, atom_handle > >
+    get_atom_links(
+      atom_index index ) const;
+
+    /**@brief Get the faces of an atom.
+     *
+     * Get the faces passing by an atom known by its index. If the index is
+     * invalid, an exception is thrown.
+     * @param index Index of the atom.
+     * @return A range over the faces of the atom. */
+    element_range< atom_face_element >
+    get_atom_faces(
+      atom_index index ) const;
+
+    /**@brief Get the faces of a link.
+     *
+     * Get the faces passing by a link known by its index. If the index is
+     * invalid, an exception is thrown.
+     * @param index Index of the link.
+     * @return A range over the faces of the link. */
+    element_range< link_face_element >
+    get_link_faces(
+      link_index index ) const;
+
     /**@brief Apply a process function on all links.
      *
      * This method apply, in parallel or not, a function on each
-     * valid link.
+     * valid link. The function is called as function( link ), or as
+     * function( index, link ) if it accepts the index of the link.
      * @param function The function to apply.
      * @param parallel A flag to activate a parallel processing.
      */
@@ -719,6 +1415,36 @@ namespace median_path {
       process_links(
         link_processer&& function, bool parallel = true );
 
+    /**@brief Apply a process function on all links, with control on the
+     * scheduling.
+     *
+     * Links are processed by chunks of consecutive links, as specified by
+     * the options (see parallel_options), while the function is still called
+     * per link, with or without its index.
+     * @param function The function to apply.
+     * @param options Scheduling, grain size and parallelism.
+     */
+    template< typename link_processer >
+      void
+      process_links(
+        link_processer&& function, const parallel_options& options );
+
+    /**@brief Apply a process function on blocks of links.
+     *
+     * Links are split into blocks of consecutive links, as specified by the
+     * options (see parallel_options), and the function is called once per
+     * block as function( begin, end, links ), where links points to the link
+     * of index begin and the block is [[links, links + end - begin[[. Cheap
+     * functions do not pay a scheduling cost per link and can be written as
+     * vectorized loops.
+     * @param function The function to apply.
+     * @param options Scheduling, grain size and parallelism.
+     */
+    template< typename link_chunk_processer >
+      void
+      process_link_chunks(
+        link_chunk_processer&& function, const parallel_options& options = parallel_options() );
+
     /**@brief Filter links according to a filter function.
      *
      * This method select links to remove thanks to a filter function. The
@@ -726,11 +1452,12 @@ namespace median_path {
      * guarantees that the links are still stored in a tight buffer after
      * removals. This function will invalidate references and indices to links.
      * @param filter The filter function used to select links to remove.
-     * @param parallel A flag to activate a parallel evaluation of the filter function. */
+     * @param parallel A flag to activate a parallel evaluation of the filter function.
+     * @param preserve_order A flag to keep the relative order of remaining links. */
     template< typename link_filter >
       void
       remove_links(
-        link_filter&& filter, bool parallel = true );
+        link_filter&& filter, bool parallel = true, bool preserve_order = false );
 
     /**@brief Get the number of faces of an link.
      *
@@ -769,10 +1496,24 @@ namespace median_path {
      * skeleton_link_property_already_exist is thrown. You can check if a name
      * is already given thanks to the method is_an_link_property_name().
      *
+     * The storage of the property is chosen as for add_atom_property().
+     *
      * @param name Unique name that identify the new property.
+     * @param storage How the elements of the property are stored.
      * @return A reference to the newly created link property. */
     template< typename link_property >
-    base_property_buffer& add_link_property( const std::string& name );
+    base_property_buffer& add_link_property( const std::string& name,
+      base_property_buffer::storage_type storage = base_property_buffer::dense );
+
+    /**@brief Add a link property whose buffer is already created.
+     *
+     * This is meant for loaders, which know the type of a property only at
+     * run time (see property_types.h). The buffer is sized to the capacity
+     * of the links. If a property already exist with the same name, the
+     * exception skeleton_link_property_already_exist is thrown.
+     * @param property The buffer of the new property.
+     * @return A reference to the newly created link property. */
+    base_property_buffer& add_link_property( std::unique_ptr< base_property_buffer > property );
 
     /**@brief Check if an link property with a particular name already exist.
      *
@@ -802,6 +1543,14 @@ namespace median_path {
      * @return The link property with that index. */
     base_property_buffer& get_link_property( link_property_index index );
 
+    /**@brief Read a link property thanks to its index.
+     *
+     * This overload has no side effect.
+     * @see get_link_property(link_property_index)
+     * @param index The link property index to get.
+     * @return The link property with that index. */
+    const base_property_buffer& get_link_property( link_property_index index ) const;
+
     /**@brief Get the index of an link property.
      *
      * Get the index of an link property. This index allows to fetch the
@@ -874,6 +1623,22 @@ namespace median_path {
     face_handle
     add(
       atom_index idx1, atom_index idx2, atom_index idx3 );
+    /**@brief Add a batch of faces to the skeleton.
+     *
+     * Add faces between triplets of atoms given by their indices. This is
+     * equivalent to calling add( atom_index, atom_index, atom_index ) for each
+     * triplet, but much faster for large batches: the missing links are added
+     * with add_links(), triplets are deduplicated in parallel, then the face
+     * buffers and the adjacencies are sized once and filled in a single pass.
+     * Triplets connecting the same atoms, in any order, triplets of already
+     * existing faces and degenerated triplets are ignored. If one of the atom
+     * indices is invalid, an exception is thrown and the skeleton is left
+     * unchanged.
+     * @param faces The triplets of atom indices to connect.
+     * @return The number of faces created. */
+    face_index
+    add_faces(
+      const std::vector< std::array< atom_index, 3 > >& faces );
     /**@brief Remove a face know by its handle.
      *
      * Remove a face from the skeleton. Its atoms and links will be
@@ -931,6 +1696,18 @@ namespace median_path {
     face_index
     get_index(
       face_handle handle ) const;
+    /**@brief Get the indices of faces known by their handles.
+     *
+     * Handles are resolved in a batch, handle entries being prefetched
+     * ahead of the resolution. If a handle does not point to a valid face,
+     * an exception is thrown.
+     * @param handles The handles to resolve.
+     * @param number_of_handles Number of handles to resolve.
+     * @param indices Receive the index of each face.
+     */
+    void
+    get_indices(
+      const face_handle* handles, size_t number_of_handles, face_index* indices ) const;
     /**@brief Get the index of a face known by a reference.
      *
      * Get the index of a face known by a reference. If the reference does
@@ -963,7 +1740,8 @@ namespace median_path {
     /**@brief Apply a process function on all faces.
      *
      * This method apply, in parallel or not, a function on each
-     * valid face.
+     * valid face. The function is called as function( face ), or as
+     * function( index, face ) if it accepts the index of the face.
      * @param function The function to apply.
      * @param parallel A flag to activate a parallel processing.
      */
@@ -972,6 +1750,36 @@ namespace median_path {
       process_faces(
         face_processer&& function, bool parallel = true );
 
+    /**@brief Apply a process function on all faces, with control on the
+     * scheduling.
+     *
+     * Faces are processed by chunks of consecutive faces, as specified by
+     * the options (see parallel_options), while the function is still called
+     * per face, with or without its index.
+     * @param function The function to apply.
+     * @param options Scheduling, grain size and parallelism.
+     */
+    template< typename face_processer >
+      void
+      process_faces(
+        face_processer&& function, const parallel_options& options );
+
+    /**@brief Apply a process function on blocks of faces.
+     *
+     * Faces are split into blocks of consecutive faces, as specified by the
+     * options (see parallel_options), and the function is called once per
+     * block as function( begin, end, faces ), where faces points to the face
+     * of index begin and the block is [[faces, faces + end - begin[[. Cheap
+     * functions do not pay a scheduling cost per face and can be written as
+     * vectorized loops.
+     * @param function The function to apply.
+     * @param options Scheduling, grain size and parallelism.
+     */
+    template< typename face_chunk_processer >
+      void
+      process_face_chunks(
+        face_chunk_processer&& function, const parallel_options& options = parallel_options() );
+
     /**@brief Filter faces according to a filter function.
      *
      * This method select faces to remove thanks to a filter function. The
@@ -980,11 +1788,12 @@ namespace median_path {
      * removals. This function will invalidate references and indices to faces.
      * @param filter The filter function used to select faces to remove.
      * @param parallel A flag to activate a parallel evaluation of the filter function.
+     * @param preserve_order A flag to keep the relative order of remaining faces.
      */
     template< typename face_filter >
       void
       remove_faces(
-        face_filter&& filter, bool parallel = true );
+        face_filter&& filter, bool parallel = true, bool preserve_order = false );
 
 
     /**@brief Add an face property to this skeleton.
@@ -996,10 +1805,24 @@ namespace median_path {
      * skeleton_face_property_already_exist is thrown. You can check if a name
      * is already given thanks to the method is_an_face_property_name().
      *
+     * The storage of the property is chosen as for add_atom_property().
+     *
      * @param name Unique name that identify the new property.
+     * @param storage How the elements of the property are stored.
      * @return A reference to the newly created face property. */
     template< typename face_property >
-    base_property_buffer& add_face_property( const std::string& name );
+    base_property_buffer& add_face_property( const std::string& name,
+      base_property_buffer::storage_type storage = base_property_buffer::dense );
+
+    /**@brief Add a face property whose buffer is already created.
+     *
+     * This is meant for loaders, which know the type of a property only at
+     * run time (see property_types.h). The buffer is sized to the capacity
+     * of the faces. If a property already exist with the same name, the
+     * exception skeleton_face_property_already_exist is thrown.
+     * @param property The buffer of the new property.
+     * @return A reference to the newly created face property. */
+    base_property_buffer& add_face_property( std::unique_ptr< base_property_buffer > property );
 
     /**@brief Check if an face property with a particular name already exist.
      *
@@ -1029,6 +1852,14 @@ namespace median_path {
      * @return The face property with that index. */
     base_property_buffer& get_face_property( face_property_index index );
 
+    /**@brief Read a face property thanks to its index.
+     *
+     * This overload has no side effect.
+     * @see get_face_property(face_property_index)
+     * @param index The face property index to get.
+     * @return The face property with that index. */
+    const base_property_buffer& get_face_property( face_property_index index ) const;
+
     /**@brief Get the index of an face property.
      *
      * Get the index of an face property. This index allows to fetch the
@@ -1063,6 +1894,7 @@ namespace median_path {
     void remove_face_property( const std::string& name );
 
   private:
+    template< typename > friend class basic_median_skeleton;
 
     void
     remove_atom_special_properties(
@@ -1074,9 +1906,14 @@ namespace median_path {
     void
     remove_link_topology_properties(
       link_index idx, link_handle handle );
+    /**@brief Remove all links flagged in m_link_compaction.
+     *
+     * The faces of those links are removed too, and their atoms are notified
+     * they are no longer connected.
+     * @param preserve_order Keep the relative order of remaining links and faces. */
     void
     remove_link_indices(
-      bool* flags );
+      bool preserve_order );
 
     face_handle
     do_add_face(
@@ -1095,13 +1932,13 @@ namespace median_path {
     /**@brief Remove all tagged faces.
      *
      * This function guarantees to remove each face with index i such that
-     * flags[i] is true, while keeping the whole skeleton in a valid state.
-     * In particular, the face buffer remains tight, atom_faces_property
-     * and link_faces_property are updated.
-     * @param flags Identify the indices of faces to remove. */
+     * m_face_compaction.flags[i] is true, while keeping the whole skeleton in
+     * a valid state. In particular, the face buffer remains tight,
+     * atom_faces_property and link_faces_property are updated.
+     * @param preserve_order Keep the relative order of remaining faces. */
     void
     remove_faces_indices(
-      bool* flags );
+      bool preserve_order );
 
     void
     remove_link_to_face(
@@ -1113,9 +1950,65 @@ namespace median_path {
     remove_atom_to_link(
       atom_index idx, link_handle handle );
 
+    /**@brief Maintain the topology index, if any, after a change of a link or
+     * a face. Those methods do nothing if the index is disabled. */
+    void index_link( link_handle handle, const link& l );
+    void unindex_link( const link& l );
+    void index_face( face_handle handle, const face& f );
+    void unindex_face( const face& f );
+
+    /**@brief Hash index of links and faces.
+     *
+     * Keys are the sorted indices of the handles of the atoms connected by
+     * an element. Those indices do not change when atoms are moved in the
+     * tight buffer, contrary to atom indices. */
+    struct topology_index {
+      hash_index< atom_index, 2, link_handle > links;
+      hash_index< atom_index, 3, face_handle > faces;
+    };
+
+    /**@brief Compressed sparse row storage of a frozen topology.
+     *
+     * The links of the atom with index i are stored in atom_links, in the
+     * range [[atom_links_offsets[i], atom_links_offsets[i+1][[. The same
+     * scheme applies to atom faces and link faces. */
+    struct frozen_topology {
+      std::vector< link_index > atom_links_offsets;
+      std::vector< std::pair< link_handle, atom_handle > > atom_links;
+      std::vector< face_index > atom_faces_offsets;
+      std::vector< atom_face_element > atom_faces;
+      std::vector< face_index > link_faces_offsets;
+      std::vector< link_face_element > link_faces;
+    };
+
     datastructure* m_impl;
+    mutable atom_columns m_atom_columns;
+    mutable atom_bvh m_atom_bvh;
+    atom_layout m_atom_layout;
+    std::unique_ptr< frozen_topology > m_frozen;
+    std::unique_ptr< topology_index > m_topology_index;
+    std::unique_ptr< small_vector_arena > m_topology_arena;
+    std::unique_ptr< change_journal > m_change_journal;
+    /* scratch buffers of the removal methods, kept to avoid allocations */
+    compaction_plan< atom_index > m_atom_compaction;
+    compaction_plan< link_index > m_link_compaction;
+    compaction_plan< face_index > m_face_compaction;
   };
 
+  typedef basic_median_skeleton< default_skeleton_profile > median_skeleton;
+  typedef basic_median_skeleton< single_precision_skeleton_profile > single_precision_median_skeleton;
+  typedef basic_median_skeleton< large_skeleton_profile > large_median_skeleton;
+
+# define mps_template_parameters                               \
+  template< typename profile >
+
+# define mps_type                                              \
+  basic_median_skeleton< profile >
+
+# define mps_definition(ret_type)                              \
+  mps_template_parameters                                      \
+  ret_type mps_type
+
 END_MP_NAMESPACE
 # include "detail/median_skeleton.tcc"
 # endif 
@@ -16,13 +16,14 @@ namespace median_path {
 
       template<
               typename atomizer_type,
-              typename structurer_type >
+              typename structurer_type,
+              typename skeleton_type >
       no_regularization(
           const parameters_type& parameters,
           const skeletonizable_shape& shape,
           atomizer_type& atomizer,
           structurer_type& structurer,
-          median_skeleton& result )
+          skeleton_type& result )
       {
         (void)parameters;
         (void)shape;
@@ -125,7 +126,11 @@ namespace median_path {
       return result;
     }
 
-    void skeletonize( const skeletonizable_shape& shape, median_skeleton& result )
+    /**@brief Skeletonize a shape into an existing skeleton, which can be a
+     * median_skeleton or a large_median_skeleton for samplings that produce
+     * more than 2^22 atoms. */
+    template< typename skeleton_type >
+    void skeletonize( const skeletonizable_shape& shape, skeleton_type& result )
     {
       //fixme: I am a little concerned about the life extent of (potentially
       // heavy) data stored inside atomizer, structurer and regularizer. It
@@ -0,0 +1,167 @@
+# ifndef MEDIAN_PATH_PROPERTY_TYPES_H_
+# define MEDIAN_PATH_PROPERTY_TYPES_H_
+
+# include "detail/skeleton_datastructure.h"
+
+# include <array>
+# include <memory>
+# include <string>
+# include <type_traits>
+# include <typeindex>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Kind of the components of a property element. */
+  enum class component_kind : uint8_t {
+    real_component,
+    signed_component,
+    unsigned_component
+  };
+
+  /**@brief A component of a property element, whose active member is given
+   * by the component_kind of the property type. */
+  union property_component {
+    double real_value;
+    int64_t signed_value;
+    uint64_t unsigned_value;
+  };
+
+  /**@brief Description of a serializable property type.
+   *
+   * Savers do not know the types of the properties of a skeleton. The type
+   * of a property buffer is given by base_property_buffer::get_value_type(),
+   * and a registered property type tells how an element of that type is
+   * decomposed into numeric components, how those components are read and
+   * written, and how to create a property of that type when it is loaded.
+   * Each type has a unique name, which is written in the files to identify
+   * the type of a property. */
+  struct property_type {
+    /**Unique name of the type in files, e.g. "float32" or "uint32[2]". */
+    std::string name;
+    std::type_index value_type;
+    size_t number_of_components;
+    component_kind kind;
+    /**Get a component of an element. Elements not allocated by a paged or a
+     * sparse property are read as default elements. */
+    property_component (*get)( const base_property_buffer& property, size_t element, size_t component );
+    /**Set a component of an element. */
+    void (*set)( base_property_buffer& property, size_t element, size_t component, property_component value );
+    /**Create an empty property buffer of that type. */
+    std::unique_ptr< base_property_buffer > (*create)(
+      const std::string& name, base_property_buffer::storage_type storage );
+  };
+
+  /**@brief Decomposition of a property type into numeric components.
+   *
+   * This class is specialized for arithmetic types, for std::array of
+   * arithmetic types and for the vectors of graphics origin. Specialize it
+   * to register other types with register_property_type(). */
+  template< typename T, typename enable = void >
+  struct property_type_traits;
+
+  template< typename T >
+  struct property_type_traits< T, typename std::enable_if< std::is_arithmetic< T >::value >::type > {
+    typedef T component_type;
+    static constexpr size_t number_of_components = 1;
+    static component_type& component( T& value, size_t )
+    {
+      return value;
+    }
+  };
+
+  template< typename T, size_t n >
+  struct property_type_traits< std::array< T, n >, typename std::enable_if< std::is_arithmetic< T >::value >::type > {
+    typedef T component_type;
+    static constexpr size_t number_of_components = n;
+    static component_type& component( std::array< T, n >& value, size_t c )
+    {
+      return value[ c ];
+    }
+  };
+
+  template< typename vector_type, size_t n >
+  struct vector_property_type_traits {
+    typedef real component_type;
+    static constexpr size_t number_of_components = n;
+    static component_type& component( vector_type& value, size_t c )
+    {
+      return value[ c ];
+    }
+  };
+
+  template<> struct property_type_traits< vec2 > : vector_property_type_traits< vec2, 2 > {};
+  template<> struct property_type_traits< vec3 > : vector_property_type_traits< vec3, 3 > {};
+  template<> struct property_type_traits< vec4 > : vector_property_type_traits< vec4, 4 > {};
+
+  /**@brief Register a property type.
+   *
+   * The types registered by default are the arithmetic types ("int8" to
+   * "int64", "uint8" to "uint64", "float32" and "float64"), arrays of two to
+   * four such types (e.g. "uint32[2]", the type of the atom to sampling
+   * properties of atomizers) and vec2, vec3 and vec4 ("vec2" to "vec4").
+   * Registering a type or a name again replaces the previous registration,
+   * which invalidates the pointers to the replaced type. This function is
+   * thread safe.
+   * @param type The description of the type. */
+  void register_property_type( const property_type& type );
+
+  /**@brief Find a registered property type by its C++ type.
+   * @return The type, or nullptr if the type is not registered. */
+  const property_type* find_property_type( const std::type_info& value_type );
+
+  /**@brief Find a registered property type by its name.
+   * @return The type, or nullptr if no type has that name. */
+  const property_type* find_property_type( const std::string& name );
+
+  /**@brief Build the description of a property type from its traits. */
+  template< typename T >
+  property_type make_property_type( const std::string& name )
+  {
+    typedef property_type_traits< T > traits;
+    typedef typename traits::component_type component_type;
+    static_assert( std::is_arithmetic< component_type >::value,
+      "The components of a property type must be arithmetic");
+
+    property_type result{
+      name, std::type_index( typeid( T ) ), traits::number_of_components,
+      std::is_floating_point< component_type >::value ? component_kind::real_component
+        : ( std::is_signed< component_type >::value ? component_kind::signed_component
+        : component_kind::unsigned_component ),
+      nullptr, nullptr, &make_property_buffer< T > };
+
+    result.get = []( const base_property_buffer& property, size_t element, size_t component )
+      {
+        T value = property.get< T >( element );
+        const component_type c = traits::component( value, component );
+        property_component result;
+        if( std::is_floating_point< component_type >::value )
+          result.real_value = double( c );
+        else if( std::is_signed< component_type >::value )
+          result.signed_value = int64_t( c );
+        else
+          result.unsigned_value = uint64_t( c );
+        return result;
+      };
+    result.set = []( base_property_buffer& property, size_t element, size_t component, property_component value )
+      {
+        component_type& c = traits::component( property.get< T >( element ), component );
+        if( std::is_floating_point< component_type >::value )
+          c = component_type( value.real_value );
+        else if( std::is_signed< component_type >::value )
+          c = component_type( value.signed_value );
+        else
+          c = component_type( value.unsigned_value );
+      };
+    return result;
+  }
+
+  /**@brief Register a property type from its traits.
+   * @param name The unique name of the type in files. */
+  template< typename T >
+  void register_property_type( const std::string& name )
+  {
+    register_property_type( make_property_type< T >( name ) );
+  }
+
+END_MP_NAMESPACE
+# endif
@@ -22,6 +22,10 @@ public:
       median_skeleton& skeleton,
       const parameters& params = parameters() );
 
+  regularizer(
+      large_median_skeleton& skeleton,
+      const parameters& params = parameters() );
+
   const real& get_execution_time() const noexcept;
 private:
   real m_execution_time;
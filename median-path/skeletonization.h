@@ -165,6 +165,15 @@ namespace median_path {
         median_skeleton& output,
         const parameters& params = parameters() );
 
+    /**@brief Skeletonize a shape into a large skeleton.
+     *
+     * Same as above, for atomizations of large samplings that produce more
+     * than the 2^22 atoms of a median_skeleton. */
+    skeletonizer(
+        graphics_origin::geometry::mesh& input,
+        large_median_skeleton& output,
+        const parameters& params = parameters() );
+
     real get_execution_time() const noexcept;
 
   private:
@@ -2,6 +2,7 @@
 # define MEDIAN_PATH_STRUCTURATION_H_
 
 # include "atomization.h"
+# include "topology_builder.h"
 
 namespace median_path {
 
@@ -43,6 +44,10 @@ public:
       median_skeleton& skeleton,
       const parameters& params = parameters() );
 
+  structurer(
+      large_median_skeleton& skeleton,
+      const parameters& params = parameters() );
+
   const real& get_execution_time() const noexcept;
 private:
   real m_execution_time;
@@ -54,7 +59,7 @@ private:
       struct parameters_type {
         typedef no_structuration structurer_type;
       };
-      template< typename atomizer_type >
+      template< typename atomizer_type, typename skeleton_type >
 # ifdef MP_USE_CONCEPTS
         requires Atomizer<atomizer_type>()
 # endif
@@ -62,7 +67,7 @@ private:
           const parameters_type& parameters,
           const skeletonizable_shape& shape,
           atomizer_type& atomizer,
-          median_skeleton& result )
+          skeleton_type& result )
       {
         (void)parameters; (void)shape; (void)atomizer; (void)result;
       }
@@ -76,19 +81,20 @@ private:
         const bool build_faces = true;
       };
 
-      template< typename atomizer_type >
+      template< typename atomizer_type, typename skeleton_type >
 # ifdef MP_USE_CONCEPTS
         requires Atomizer<atomizer_type>()
 # endif
       weighted_zero_shape( parameters_type const& parameters,
                            skeletonizable_shape const & shape,
-                           atomizer_type& atomizer, median_skeleton& result )
+                           atomizer_type& atomizer, skeleton_type& result )
        : weighted_zero_shape( parameters, result )
      {
         (void)atomizer; (void)shape;
      }
 
       weighted_zero_shape( parameters_type const& parameters, median_skeleton& result );
+      weighted_zero_shape( parameters_type const& parameters, large_median_skeleton& result );
     };
 
     struct delaunay_reconstruction {
@@ -98,13 +104,13 @@ private:
         const bool neighbors_must_intersect = true;
       };
 
-      template< typename atomizer_type >
+      template< typename atomizer_type, typename skeleton_type >
 # ifdef MP_USE_CONCEPTS
         requires Atomizer<atomizer_type>()
 # endif
       delaunay_reconstruction( parameters_type const& parameters,
                                skeletonizable_shape const& shape,
-                               atomizer_type& atomizer, median_skeleton& result );
+                               atomizer_type& atomizer, skeleton_type& result );
     };
   }
 
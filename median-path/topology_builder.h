@@ -0,0 +1,72 @@
+# ifndef MEDIAN_PATH_TOPOLOGY_BUILDER_H_
+# define MEDIAN_PATH_TOPOLOGY_BUILDER_H_
+
+# include "median_skeleton.h"
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Build the topology of a skeleton from several threads.
+   *
+   * Structurers traverse a triangulation to find the links and faces of a
+   * skeleton. Adding them directly to the skeleton must be done in a critical
+   * section, which serializes the threads. A topology builder instead stages
+   * links and faces in one buffer per thread, where threads append them
+   * freely. Once the traversal is done, commit() merges those buffers and
+   * inserts their content in the skeleton with median_skeleton::add_faces()
+   * and median_skeleton::add_links(), which deduplicate the elements and
+   * fill the adjacency in a single pass.
+   *
+   * The staging methods can be called from an OpenMP parallel region (loops
+   * or tasks) with at most omp_get_max_threads() threads, as obtained when
+   * the builder was created. Nested parallel regions are not supported. The
+   * atoms of the skeleton must not change between the creation of the builder
+   * and the commit. */
+  template< typename skeleton_type >
+  class basic_topology_builder {
+  public:
+    typedef typename skeleton_type::atom_index atom_index;
+    typedef typename skeleton_type::link_index link_index;
+    typedef typename skeleton_type::face_index face_index;
+
+    /**@brief Create a builder for a skeleton.
+     * @param skeleton The skeleton that will receive the topology. */
+    basic_topology_builder( skeleton_type& skeleton );
+    basic_topology_builder( const basic_topology_builder& ) = delete;
+    basic_topology_builder& operator=( const basic_topology_builder& ) = delete;
+
+    /**@brief Stage a link between two atoms.
+     *
+     * This method is thread safe. */
+    void add_link( atom_index idx1, atom_index idx2 );
+
+    /**@brief Stage a face between three atoms.
+     *
+     * This method is thread safe. The links of the face are created by the
+     * commit, they do not need to be staged. */
+    void add_face( atom_index idx1, atom_index idx2, atom_index idx3 );
+
+    /**@brief Insert the staged links and faces into the skeleton.
+     *
+     * This method must be called outside of a parallel region. The staging
+     * buffers are emptied, such that the builder can be reused.
+     * @return The number of faces and links created. */
+    std::pair< face_index, link_index > commit();
+
+  private:
+    struct staging {
+      std::vector< std::pair< atom_index, atom_index > > links;
+      std::vector< std::array< atom_index, 3 > > faces;
+      // avoid false sharing between the buffer headers of two threads
+      char padding[ 64 ];
+    };
+    staging& get_staging();
+
+    skeleton_type& m_skeleton;
+    std::vector< staging > m_staging;
+  };
+
+  typedef basic_topology_builder< median_skeleton > topology_builder;
+  typedef basic_topology_builder< large_median_skeleton > large_topology_builder;
+
+END_MP_NAMESPACE
+# endif
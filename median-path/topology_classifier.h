@@ -0,0 +1,173 @@
+# ifndef MEDIAN_PATH_TOPOLOGY_CLASSIFIER_H_
+# define MEDIAN_PATH_TOPOLOGY_CLASSIFIER_H_
+
+# include "median_skeleton.h"
+
+# include <array>
+# include <vector>
+
+BEGIN_MP_NAMESPACE
+
+  /**@brief Classify the elements of a skeleton by their topology.
+   *
+   * Renderers, filters and statistics need to know which atoms are isolated
+   * or which links are on a border or at a junction of sheets. This class
+   * computes those classes once, for atoms, links and faces, such that they
+   * can share the result. The classes are:
+   * - links: isolated if they have no face, border with one face, regular
+   * with two faces and junction with more than two faces,
+   * - atoms: isolated if they have no link, junction if one of their links is
+   * a junction, border if one of their links is a border, regular otherwise,
+   * - faces: junction if one of their links is a junction, border if one of
+   * their links is a border, regular otherwise. A face is never isolated.
+   *
+   * The result is given both as a class per element index and as a compact
+   * list of element indices per class, in increasing order. Classes are
+   * computed in parallel, and the lists are filled in parallel thanks to
+   * per thread counts and prefix sums.
+   *
+   * After a modification of the skeleton, update() recomputes the number of
+   * faces of each link and the number of links of each atom, and only
+   * reclassifies the elements affected by a change. This is cheaper than a
+   * new classification when few elements changed and the numbers of
+   * elements did not change. The buffers of an update are kept for the
+   * next one, such that a classifier kept with its skeleton, e.g. by a
+   * renderer, updates without allocating. The skeleton must not be modified
+   * during a classification or an update.
+   */
+  template< typename skeleton_type >
+  class basic_topology_classifier {
+  public:
+    typedef typename skeleton_type::atom_index atom_index;
+    typedef typename skeleton_type::link_index link_index;
+    typedef typename skeleton_type::face_index face_index;
+
+    /**@brief Topological class of an element. */
+    enum topology_class : uint8_t {
+      isolated_element,
+      border_element,
+      regular_element,
+      junction_element
+    };
+    static constexpr size_t number_of_classes = 4;
+
+    basic_topology_classifier();
+
+    /**@brief Classify all the elements of a skeleton.
+     * @param skeleton The skeleton to classify. */
+    void classify( const skeleton_type& skeleton );
+
+    /**@brief Update the classification after modifications of a skeleton.
+     *
+     * If the numbers of elements changed since the last classification, all
+     * elements are classified again. Otherwise, only links whose number of
+     * faces changes their class or whose atoms changed are reclassified,
+     * with their atoms and their faces, as are atoms whose number of links
+     * changed and faces whose links changed. Index lists are rebuilt only
+     * if a class changed. If the skeleton has a change journal whose epoch
+     * did not change since the last classification or update, nothing is
+     * counted again.
+     * @param skeleton The skeleton that was classified.
+     * @return The number of elements whose class changed. */
+    size_t update( const skeleton_type& skeleton );
+
+    /**@brief Forget the classification and release the memory. */
+    void clear() noexcept;
+
+    /**@name Classes of elements
+     * @{ */
+    topology_class get_atom_class( atom_index index ) const noexcept
+    {
+      return m_atom_classes[ index ];
+    }
+
+    topology_class get_link_class( link_index index ) const noexcept
+    {
+      return m_link_classes[ index ];
+    }
+
+    topology_class get_face_class( face_index index ) const noexcept
+    {
+      return m_face_classes[ index ];
+    }
+
+    /**@brief Get the class of each atom, by atom index. */
+    const std::vector< topology_class >& get_atom_classes() const noexcept
+    {
+      return m_atom_classes;
+    }
+
+    /**@brief Get the class of each link, by link index. */
+    const std::vector< topology_class >& get_link_classes() const noexcept
+    {
+      return m_link_classes;
+    }
+
+    /**@brief Get the class of each face, by face index. */
+    const std::vector< topology_class >& get_face_classes() const noexcept
+    {
+      return m_face_classes;
+    }
+    ///@}
+
+    /**@name Index lists
+     * @{ */
+    /**@brief Get the indices of the atoms of a class, in increasing order. */
+    const std::vector< atom_index >& get_atoms( topology_class c ) const noexcept
+    {
+      return m_atom_lists[ c ];
+    }
+
+    /**@brief Get the indices of the links of a class, in increasing order. */
+    const std::vector< link_index >& get_links( topology_class c ) const noexcept
+    {
+      return m_link_lists[ c ];
+    }
+
+    /**@brief Get the indices of the faces of a class, in increasing order. */
+    const std::vector< face_index >& get_faces( topology_class c ) const noexcept
+    {
+      return m_face_lists[ c ];
+    }
+    ///@}
+
+  private:
+    void count( const skeleton_type& skeleton,
+      std::vector< uint32_t >& atom_link_counts,
+      std::vector< uint32_t >& link_face_counts,
+      std::vector< std::array< atom_index, 2 > >& link_atoms,
+      std::vector< std::array< link_index, 3 > >& face_links ) const;
+    void build_lists();
+
+    std::vector< topology_class > m_atom_classes;
+    std::vector< topology_class > m_link_classes;
+    std::vector< topology_class > m_face_classes;
+    std::array< std::vector< atom_index >, number_of_classes > m_atom_lists;
+    std::array< std::vector< link_index >, number_of_classes > m_link_lists;
+    std::array< std::vector< face_index >, number_of_classes > m_face_lists;
+
+    /* counts and incidences of the last classification, to detect the
+     * elements to reclassify during an update */
+    std::vector< uint32_t > m_atom_link_counts;
+    std::vector< uint32_t > m_link_face_counts;
+    std::vector< std::array< atom_index, 2 > > m_link_atoms;
+    std::vector< std::array< link_index, 3 > > m_face_links;
+
+    /* buffers of an update, kept to not allocate them at each update */
+    std::vector< uint32_t > m_next_atom_link_counts;
+    std::vector< uint32_t > m_next_link_face_counts;
+    std::vector< std::array< atom_index, 2 > > m_next_link_atoms;
+    std::vector< std::array< link_index, 3 > > m_next_face_links;
+    std::vector< uint8_t > m_link_changed;
+    std::vector< uint8_t > m_atom_dirty;
+
+    /* journal of the skeleton and its epoch at the last classification */
+    const change_journal* m_journal;
+    uint64_t m_journal_epoch;
+  };
+
+  typedef basic_topology_classifier< median_skeleton > topology_classifier;
+  typedef basic_topology_classifier< large_median_skeleton > large_topology_classifier;
+
+END_MP_NAMESPACE
+# endif
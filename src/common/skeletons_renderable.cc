@@ -14,6 +14,7 @@ namespace median_path {
   median_skeletons_renderable::storage::operator=( storage&& other )
   {
     skeleton = std::move( other.skeleton );
+    classifier = std::move( other.classifier );
     for( int id = 0; id < number_of_buffers; ++ id )
       buffer_ids[id] = other.buffer_ids[id];
     number_of_atoms = other.number_of_atoms;
@@ -77,6 +78,7 @@ namespace median_path {
   {
     std::vector< median_skeleton::atom_index > indices;
     std::vector<gl_vec4> colors;
+    std::vector< single_precision_ball > balls;
     std::vector< median_skeleton::atom_index > isolated;
     std::vector< median_skeleton::atom_index > borders;
     std::vector< median_skeleton::atom_index > junctions;
@@ -101,37 +103,40 @@ namespace median_path {
                   glcheck(glGenBuffers( number_of_buffers, data->buffer_ids));
                 }
 
+                /* the topology is not frozen: the classifier reads it in a
+                 * single pass, which would not pay for the copy of a freeze */
+                // read atoms through a constant reference, which does not record changes
+                const median_skeleton& skeleton = data->skeleton;
                 const median_skeleton::atom_index nbatoms = data->skeleton.get_number_of_atoms();
                 data->number_of_atoms = nbatoms;
                 int  atom_location = program->get_attribute_location( "atom" );
                 int color_location = program->get_attribute_location( "color");
 
 
+                // shaders read atoms in single precision: upload them as floats
+                balls.resize( nbatoms );
+                # pragma omp parallel for
+                for( median_skeleton::atom_index j = 0; j < nbatoms; ++ j )
+                  balls[ j ] = single_precision_ball( skeleton.get_atom_by_index( j ) );
+
                 glcheck(glBindVertexArray( data->vao ));
                   glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[balls_vbo]));
-                  glcheck(glBufferData( GL_ARRAY_BUFFER, sizeof(median_skeleton::atom) * nbatoms,
-                    &data->skeleton.get_atom_by_index( 0 ), GL_STATIC_DRAW ));
+                  glcheck(glBufferData( GL_ARRAY_BUFFER, sizeof(single_precision_ball) * nbatoms,
+                    balls.data(), GL_STATIC_DRAW ));
                   glcheck(glEnableVertexAttribArray( atom_location ));
                   glcheck(glVertexAttribPointer( atom_location,
-                    4, GL_DOUBLE, GL_FALSE,
+                    4, GL_FLOAT, GL_FALSE,
                     0, 0 ));
 
 
                   real minr, maxr;
                   data->skeleton.compute_minmax_radii( minr, maxr );
-                  isolated.resize( 0 );
+                  auto& classifier = data->classifier;
+                  classifier.update( skeleton );
                   colors.resize( nbatoms );
                   # pragma omp parallel for
                   for( median_skeleton::atom_index j = 0; j < nbatoms; ++ j )
-                    {
-                      colors[ j ] = gl_vec4(graphics_origin::get_color( data->skeleton.get_atom_by_index( j ).w, minr, maxr ), 1.0 );
-
-                      if( !data->skeleton.get_number_of_links( j ) )
-                        {
-                          # pragma omp critical
-                          isolated.push_back( j );
-                        }
-                    }
+                    colors[ j ] = gl_vec4(graphics_origin::get_color( skeleton.get_atom_by_index( j ).w, minr, maxr ), 1.0 );
                   glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[colors_vbo]));
                   glcheck(glBufferData( GL_ARRAY_BUFFER, sizeof(gl_vec4) * nbatoms, colors.data(), GL_STATIC_DRAW));
                   glcheck(glEnableVertexAttribArray( color_location ));
@@ -139,16 +144,14 @@ namespace median_path {
                     4, GL_FLOAT, GL_FALSE,
                     0, 0 ));
 
-                  data->number_of_isolated_atoms = isolated.size();
+                  const auto& isolated_atoms = classifier.get_atoms( topology_classifier::isolated_element );
+                  data->number_of_isolated_atoms = isolated_atoms.size();
                   glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[isolated_vertices_ibo]));
-                  glcheck(glBufferData( GL_ARRAY_BUFFER, data->number_of_isolated_atoms * sizeof(median_skeleton::atom_index), isolated.data(), GL_STATIC_DRAW));
+                  glcheck(glBufferData( GL_ARRAY_BUFFER, data->number_of_isolated_atoms * sizeof(median_skeleton::atom_index), isolated_atoms.data(), GL_STATIC_DRAW));
 
 
                   const median_skeleton::link_index nblinks = data->skeleton.get_number_of_links();
                   indices.resize( nblinks * 2 );
-                  isolated.resize( 0 );
-                  borders.resize( 0 );
-                  junctions.resize( 0 );
                   # pragma omp parallel for
                   for( median_skeleton::link_index j = 0; j < nblinks; ++ j )
                     {
@@ -156,32 +159,25 @@ namespace median_path {
                       size_t offset = j * 2;
                       indices[ offset    ] = data->skeleton.get_index( link.h1 );
                       indices[ offset + 1] = data->skeleton.get_index( link.h2 );
-                      auto nbfaces = data->skeleton.get_number_of_faces( j );
-                      if( !nbfaces )
-                        {
-                          #pragma omp critical
-                          {
-                            isolated.push_back( indices[ offset ] );
-                            isolated.push_back( indices[ offset + 1 ] );
-                          }
-                        }
-                      else if( nbfaces == 1 )
-                        {
-                          #pragma omp critical
-                          {
-                            borders.push_back( indices[ offset ] );
-                            borders.push_back( indices[ offset + 1 ] );
-                          }
-                        }
-                      else if( nbfaces > 2 )
+                    }
+
+                  // gather the atoms of the links of each class, in parallel
+                  // and in the order of the links
+                  auto gather_link_atoms = [&indices]( const std::vector< median_skeleton::link_index >& links,
+                      std::vector< median_skeleton::atom_index >& result )
+                    {
+                      const size_t nb = links.size();
+                      result.resize( nb * 2 );
+                      # pragma omp parallel for
+                      for( size_t k = 0; k < nb; ++ k )
                         {
-                          #pragma omp critical
-                          {
-                            junctions.push_back( indices[ offset ] );
-                            junctions.push_back( indices[ offset + 1 ] );
-                          }
+                          result[ 2 * k     ] = indices[ 2 * links[ k ]     ];
+                          result[ 2 * k + 1 ] = indices[ 2 * links[ k ] + 1 ];
                         }
-                    }
+                    };
+                  gather_link_atoms( classifier.get_links( topology_classifier::isolated_element ), isolated );
+                  gather_link_atoms( classifier.get_links( topology_classifier::border_element ), borders );
+                  gather_link_atoms( classifier.get_links( topology_classifier::junction_element ), junctions );
 
                   glcheck(glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, data->buffer_ids[links_ibo]));
                   glcheck(glBufferData( GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(median_skeleton::atom_index), indices.data(), GL_STATIC_DRAW));
@@ -278,7 +274,7 @@ namespace median_path {
               {
                 glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[balls_vbo]));
                 glcheck(glEnableVertexAttribArray( atom_location ));
-                glcheck(glVertexAttribPointer( atom_location, 4, GL_DOUBLE, GL_FALSE, 0, 0 ));
+                glcheck(glVertexAttribPointer( atom_location, 4, GL_FLOAT, GL_FALSE, 0, 0 ));
 
                 glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[colors_vbo]));
                 glcheck(glEnableVertexAttribArray( color_location ));
@@ -325,7 +321,7 @@ namespace median_path {
               {
                 glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[balls_vbo]));
                 glcheck(glEnableVertexAttribArray( ball_location ));
-                glcheck(glVertexAttribPointer( ball_location, 4, GL_DOUBLE, GL_FALSE, 0, 0 ));
+                glcheck(glVertexAttribPointer( ball_location, 4, GL_FLOAT, GL_FALSE, 0, 0 ));
 
                 glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[colors_vbo]));
                 glcheck(glEnableVertexAttribArray( color_location ));
@@ -352,7 +348,7 @@ namespace median_path {
               {
                 glcheck(glBindBuffer( GL_ARRAY_BUFFER, data->buffer_ids[balls_vbo]));
                 glcheck(glEnableVertexAttribArray( atom_location ));
-                glcheck(glVertexAttribPointer( atom_location, 4, GL_DOUBLE, GL_FALSE, 0, 0 ));
+                glcheck(glVertexAttribPointer( atom_location, 4, GL_FLOAT, GL_FALSE, 0, 0 ));
 
                 glcheck(glUniform4fv( m_border_junction_program->get_uniform_location("color"), 1, glm::value_ptr(gl_vec4{1,0,0,1.0})));
                 glcheck(glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, data->buffer_ids[border_links_ibo]));
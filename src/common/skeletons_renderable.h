@@ -5,6 +5,7 @@
 # ifndef MEDIAN_PATH_SKELETON_RENDERABLE_H_
 # define MEDIAN_PATH_SKELETON_RENDERABLE_H_
 # include "../../median-path/median_skeleton.h"
+# include "../../median-path/topology_classifier.h"
 
 # include <graphics-origin/application/renderable.h>
 # include <graphics-origin/tools/tight_buffer_manager.h>
@@ -22,6 +23,8 @@ BEGIN_MP_NAMESPACE
 
     struct storage {
       median_skeleton skeleton;
+      /* kept with the skeleton, such that an upload only updates it */
+      topology_classifier classifier;
       unsigned int buffer_ids[number_of_buffers ];
       unsigned int vao;
       median_skeleton::atom_index number_of_atoms;
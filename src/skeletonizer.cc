@@ -2,6 +2,7 @@
  *      Author: T. Delame (tdelame@gmail.com)
  */
 # include "../median-path/skeletonization.h"
+# include "../median-path/io.h"
 # include <graphics-origin/tools/filesystem.h>
 # include <graphics-origin/tools/log.h>
 
@@ -11,7 +12,10 @@
 # include <stdio.h>
 # include <stdlib.h>
 # include <unistd.h>
+# include <future>
 # include <iostream>
+# include <memory>
+# include <vector>
 
 static const std::string version_string =
     "Skeletonizer command line tool v0.1 ©2016 Thomas Delame";
@@ -230,19 +234,24 @@ int main( int argc, char* argv[] )
   try
     {
       application_parameters params( argc, argv );
+      // skeletons are saved in the background while the next mesh is skeletonized
+      std::vector< std::future< bool > > saves;
       for( auto& filename : params.input_filename )
         {
           graphics_origin::geometry::mesh input(filename);
-          median_path::median_skeleton result;
+          auto result = std::make_shared< median_path::median_skeleton >();
 
-          median_path::skeletonizer algorithm( input, result, params.skeletonizer_parameters );
+          median_path::skeletonizer algorithm( input, *result, params.skeletonizer_parameters );
 
-          result.save( params.get_output_filename( filename ) );
+          saves.push_back( median_path::io::save_async( result, params.get_output_filename( filename ) ) );
 
           std::cout<<"skeletonization of a " << input.n_vertices() << " vertices / " << input.n_faces()
-              << " faces mesh to produce a median skeleton of " << result.get_number_of_atoms() << " atoms in "
+              << " faces mesh to produce a median skeleton of " << result->get_number_of_atoms() << " atoms in "
               << algorithm.get_execution_time() << " second(s)" << std::endl;
         }
+      for( auto& save : saves )
+        if( !save.get() )
+          return_value = EXIT_FAILURE;
     }
   catch( std::exception& e )
     {
@@ -3,9 +3,24 @@
  */
 # include "test.h"
 # include "../median-path/median_skeleton.h"
+# include "../median-path/io.h"
+# include "../median-path/detail/entropy_coding.h"
 # include <graphics-origin/tools/log.h>
 
+# include <algorithm>
+# include <atomic>
+# include <chrono>
+# include <cmath>
+# include <condition_variable>
+# include <cstring>
 # include <fstream>
+# include <future>
+# include <limits>
+# include <memory>
+# include <mutex>
+# include <random>
+# include <stdexcept>
+# include <string>
 BEGIN_MP_NAMESPACE
 
   static void add_dont_throw()
@@ -250,6 +265,115 @@ BEGIN_MP_NAMESPACE
     BOOST_CHECK_EQUAL( s.get_atoms_capacity(), 200 );
   }
 
+  static void growth_policy_sets_the_new_capacity()
+  {
+    median_skeleton s( 100 );
+    for( int i = 0; i < 100; ++ i )
+      s.add( vec4{ i, i, i, i } );
+    s.add( vec4{ 100, 100, 100, 100 } );
+    BOOST_CHECK_EQUAL( s.get_atoms_capacity(), 200 );
+
+    s.set_growth_policy( growth_policy::make_exact() );
+    for( int i = 101; i < 201; ++ i )
+      s.add( vec4{ i, i, i, i } );
+    BOOST_CHECK_EQUAL( s.get_atoms_capacity(), 201 );
+
+    s.set_growth_policy( growth_policy::make_capped( 50 ) );
+    s.add( vec4{ 201, 201, 201, 201 } );
+    BOOST_CHECK_EQUAL( s.get_atoms_capacity(), 251 );
+    BOOST_CHECK_EQUAL( s.get_number_of_atoms(), 202 );
+    for( int i = 0; i < 202; ++ i )
+      REAL_CHECK_CLOSE( s.get_atom_by_index( i ).x, i, 1e-9, 1e-6 );
+  }
+
+  static void shrink_to_fit_keeps_valid_handles()
+  {
+    median_skeleton s;
+    std::vector< median_skeleton::atom_handle > handles;
+    for( int i = 0; i < 1000; ++ i )
+      handles.push_back( s.add( vec4{ i, i, i, i } ) );
+    for( int i = 0; i < 1000; ++ i )
+      if( i % 10 )
+        s.remove( handles[ i ] );
+
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), 100 );
+    s.shrink_to_fit();
+    BOOST_CHECK( s.get_atoms_capacity() < 1000 );
+    BOOST_CHECK( s.get_atoms_capacity() >= 100 );
+    for( int i = 0; i < 1000; i += 10 )
+      {
+        BOOST_REQUIRE( s.is_valid( handles[ i ] ) );
+        REAL_CHECK_CLOSE( s.get( handles[ i ] ).x, i, 1e-9, 1e-6 );
+      }
+
+    for( int i = 0; i < 1000; ++ i )
+      if( i % 10 )
+        handles[ i ] = s.add( vec4{ i, i, i, i } );
+    BOOST_CHECK_EQUAL( s.get_number_of_atoms(), 1000 );
+    for( int i = 0; i < 1000; ++ i )
+      {
+        BOOST_REQUIRE( s.is_valid( handles[ i ] ) );
+        REAL_CHECK_CLOSE( s.get( handles[ i ] ).x, i, 1e-9, 1e-6 );
+      }
+
+    s.clear();
+    s.shrink_to_fit();
+    BOOST_CHECK_EQUAL( s.get_atoms_capacity(), 0 );
+    s.add( vec4{ 1, 2, 3, 4 } );
+    BOOST_CHECK_EQUAL( s.get_number_of_atoms(), 1 );
+  }
+
+  static void sparse_and_paged_properties_follow_atoms()
+  {
+    const int n = 10000;
+    median_skeleton s( n );
+    auto& dense = s.add_atom_property< int >( "dense" );
+    auto& paged = s.add_atom_property< int >( "paged", base_property_buffer::paged );
+    auto& sparse = s.add_atom_property< std::string >( "sparse", base_property_buffer::sparse );
+    for( int i = 0; i < n; ++ i )
+      {
+        s.add( vec4{ i, i, i, i } );
+        dense.get< int >( i ) = i;
+      }
+    for( int i = 0; i < n; i += 100 )
+      sparse.get< std::string >( i ) = std::to_string( i );
+    for( int i = 5000; i < 6000; ++ i )
+      paged.get< int >( i ) = i;
+
+    BOOST_CHECK( !paged.is_allocated( 3000 ) );
+    BOOST_CHECK( !sparse.is_allocated( 3001 ) );
+    BOOST_CHECK( sparse.is_allocated( 3000 ) );
+    BOOST_CHECK( paged.get_allocated_bytes( n ) < dense.get_allocated_bytes( n ) );
+    BOOST_CHECK( sparse.get_allocated_bytes( n ) < dense.get_allocated_bytes( n ) / 4 );
+
+    s.remove_atoms( []( median_skeleton::atom& a )
+      {
+        return int( a.x ) % 3 == 0;
+      });
+
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), n - ( n + 2 ) / 3 );
+    // reads through constant properties do not allocate elements
+    const base_property_buffer& read_paged = paged;
+    const base_property_buffer& read_sparse = sparse;
+    const size_t paged_bytes = paged.get_allocated_bytes( n );
+    const size_t sparse_bytes = sparse.get_allocated_bytes( n );
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      {
+        const int value = s.get_atom_by_index( i ).x;
+        BOOST_REQUIRE_EQUAL( dense.get< int >( i ), value );
+        const bool annotated = value >= 5000 && value < 6000;
+        BOOST_REQUIRE_EQUAL( read_paged.get< int >( i ), annotated ? value : 0 );
+        BOOST_REQUIRE_EQUAL( read_sparse.get< std::string >( i ),
+          value % 100 == 0 ? std::to_string( value ) : std::string() );
+      }
+    BOOST_CHECK_EQUAL( paged.get_allocated_bytes( n ), paged_bytes );
+    BOOST_CHECK_EQUAL( sparse.get_allocated_bytes( n ), sparse_bytes );
+
+    s.clear();
+    BOOST_CHECK_EQUAL( paged.get_allocated_bytes( n ), 0 );
+    BOOST_CHECK( !sparse.is_allocated( 0 ) );
+  }
+
   static void filter_move_atoms_as_expected()
   {
     median_skeleton s( 10 );
@@ -335,6 +459,166 @@ BEGIN_MP_NAMESPACE
     BOOST_REQUIRE_EQUAL( s.get_handle(s.get_atom_by_index(4)), handles[5] );
   }
 
+  static void filter_preserves_atom_order()
+  {
+    median_skeleton s( 10 );
+    median_skeleton::atom_handle handles[10];
+    for( int i = 0; i < 10; ++ i )
+      handles[i] = s.add( vec4{ i, i, i, i } );
+    // all odd atoms are removed, the remaining ones keep their order
+    s.remove_atoms( [&s]( median_skeleton::atom& atom ){ return s.get_index( atom ) & 1; }, true, true );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), 5 );
+    for( int i = 0; i < 5; ++ i )
+      {
+        BOOST_REQUIRE( s.is_valid( handles[i * 2] ) );
+        BOOST_REQUIRE( !s.is_valid( handles[i * 2 + 1 ] ) );
+        BOOST_CHECK_EQUAL( s.get_index( handles[i * 2] ), median_skeleton::atom_index( i ) );
+        BOOST_CHECK_EQUAL( s.get_handle( s.get_atom_by_index( i ) ), handles[i * 2] );
+        REAL_CHECK_CLOSE( s.get_atom_by_index( i ).x, 2*i, 1e-9, 1e-6 );
+      }
+
+    // the handles of removed atoms are reused without reallocation
+    for( int i = 0; i < 5; ++ i )
+      s.add( vec4{ 10 + i, 0, 0, 1 } );
+    BOOST_CHECK_EQUAL( s.get_number_of_atoms(), 10 );
+    BOOST_CHECK_EQUAL( s.get_atoms_capacity(), 10 );
+    for( median_skeleton::atom_index i = 0; i < 10; ++ i )
+      BOOST_CHECK_EQUAL( s.get_index( s.get_handle( s.get_atom_by_index( i ) ) ), i );
+  }
+
+  static void both_layouts_give_the_same_reductions()
+  {
+    median_skeleton s;
+    for( int i = 0; i < 203; ++ i )
+      {
+        s.add( vec4{ i, -2 * i, 3 * i, 1 + (i % 7) } );
+      }
+
+    auto aos_box = s.compute_bounding_box();
+    auto aos_centers = s.compute_centers_bounding_box();
+    real aos_minr, aos_maxr;
+    s.compute_minmax_radii( aos_minr, aos_maxr );
+
+    s.set_atom_layout( median_skeleton::structure_of_arrays );
+    auto soa_box = s.compute_bounding_box();
+    auto soa_centers = s.compute_centers_bounding_box();
+    real soa_minr, soa_maxr;
+    s.compute_minmax_radii( soa_minr, soa_maxr );
+
+    for( int i = 0; i < 3; ++ i )
+      {
+        REAL_CHECK_CLOSE( soa_box.center[i], aos_box.center[i], 1e-9, 1e-6 );
+        REAL_CHECK_CLOSE( soa_box.hsides[i], aos_box.hsides[i], 1e-9, 1e-6 );
+        REAL_CHECK_CLOSE( soa_centers.center[i], aos_centers.center[i], 1e-9, 1e-6 );
+        REAL_CHECK_CLOSE( soa_centers.hsides[i], aos_centers.hsides[i], 1e-9, 1e-6 );
+      }
+    REAL_CHECK_CLOSE( soa_minr, aos_minr, 1e-9, 1e-6 );
+    REAL_CHECK_CLOSE( soa_maxr, aos_maxr, 1e-9, 1e-6 );
+    REAL_CHECK_CLOSE( soa_minr, 1, 1e-9, 1e-6 );
+    REAL_CHECK_CLOSE( soa_maxr, 7, 1e-9, 1e-6 );
+    // the box is a cube that contains all the atoms
+    BOOST_CHECK_EQUAL( soa_box.hsides.x, soa_box.hsides.y );
+    BOOST_CHECK_EQUAL( soa_box.hsides.x, soa_box.hsides.z );
+    for( median_skeleton::atom_index i = 0; i < 203; ++ i )
+      {
+        const auto& atom = s.get_atom_by_index( i );
+        for( int j = 0; j < 3; ++ j )
+          {
+            BOOST_CHECK_LE( soa_box.center[j] - soa_box.hsides[j], atom[j] - atom.w + 1e-9 );
+            BOOST_CHECK_GE( soa_box.center[j] + soa_box.hsides[j], atom[j] + atom.w - 1e-9 );
+          }
+      }
+    // x is minimal for the first atom and maximal for the last one
+    REAL_CHECK_CLOSE( soa_centers.center.x - soa_centers.hsides.x, 0, 1e-9, 1e-6 );
+    REAL_CHECK_CLOSE( soa_centers.center.x + soa_centers.hsides.x, 202, 1e-9, 1e-6 );
+  }
+
+  static void atom_columns_follow_atom_changes()
+  {
+    median_skeleton s;
+    s.set_atom_layout( median_skeleton::structure_of_arrays );
+    median_skeleton::atom_handle handles[10];
+    for( int i = 0; i < 10; ++ i )
+      {
+        handles[i] = s.add( vec4{ i, i, i, i + 1 } );
+      }
+    real minr, maxr;
+    s.compute_minmax_radii( minr, maxr );
+    REAL_CHECK_CLOSE( maxr, 10, 1e-9, 1e-6 );
+
+    s.get( handles[3] ).w = 20;
+    s.compute_minmax_radii( minr, maxr );
+    REAL_CHECK_CLOSE( maxr, 20, 1e-9, 1e-6 );
+
+    s.remove( handles[3] );
+    s.remove( handles[0] );
+    s.compute_minmax_radii( minr, maxr );
+    REAL_CHECK_CLOSE( minr, 2, 1e-9, 1e-6 );
+    REAL_CHECK_CLOSE( maxr, 10, 1e-9, 1e-6 );
+
+    s.transform( -2, vec3{ 1, 0, 0 } );
+    const auto& columns = s.get_atom_columns();
+    BOOST_REQUIRE_EQUAL( columns.size, s.get_number_of_atoms() );
+    BOOST_REQUIRE_EQUAL( reinterpret_cast< size_t >( columns.r.get() ) % simd_alignment, 0 );
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      {
+        const auto& atom = s.get_atom_by_index( i );
+        REAL_CHECK_CLOSE( columns.x[i], atom.x, 1e-9, 1e-6 );
+        REAL_CHECK_CLOSE( columns.y[i], atom.y, 1e-9, 1e-6 );
+        REAL_CHECK_CLOSE( columns.r[i], atom.w, 1e-9, 1e-6 );
+      }
+    s.compute_minmax_radii( minr, maxr );
+    REAL_CHECK_CLOSE( minr, 4, 1e-9, 1e-6 );
+    REAL_CHECK_CLOSE( maxr, 20, 1e-9, 1e-6 );
+  }
+
+  static void concurrent_add_keeps_handles_consistent()
+  {
+    median_skeleton s;
+    median_skeleton::atom_handle handles[10];
+    for( int i = 0; i < 10; ++ i )
+      handles[i] = s.add( vec4{ i, 0, 0, 1 } );
+    // make the free list non trivial
+    s.remove( handles[2] );
+    s.remove( handles[7] );
+
+    const int number_of_atoms = 1000;
+    std::vector< median_skeleton::atom_handle > concurrent_handles( number_of_atoms );
+    s.begin_concurrent_add( number_of_atoms + 10 );
+    # pragma omp parallel for
+    for( int i = 0; i < number_of_atoms; ++ i )
+      concurrent_handles[i] = s.concurrent_add( vec4{ i, 1, 0, i + 1 } );
+    s.end_concurrent_add();
+
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), 8 + number_of_atoms );
+    std::vector< bool > seen( s.get_number_of_atoms(), false );
+    for( int i = 0; i < number_of_atoms; ++ i )
+      {
+        BOOST_REQUIRE( s.is_valid( concurrent_handles[i] ) );
+        const auto index = s.get_index( concurrent_handles[i] );
+        BOOST_CHECK( !seen[ index ] );
+        seen[ index ] = true;
+        BOOST_CHECK_EQUAL( s.get( concurrent_handles[i] ).w, i + 1 );
+        BOOST_CHECK( s.get_handle( s.get_atom_by_index( index ) ) == concurrent_handles[i] );
+      }
+
+    // the unused slots went back to the free list
+    for( int i = 0; i < 20; ++ i )
+      BOOST_REQUIRE( s.is_valid( s.add( vec4{ 0, 0, i, 1 } ) ) );
+    BOOST_CHECK_EQUAL( s.get_number_of_atoms(), 28 + number_of_atoms );
+  }
+
+  static void concurrent_add_throws_beyond_reservation()
+  {
+    median_skeleton s;
+    s.begin_concurrent_add( 2 );
+    s.concurrent_add( vec4{ 0, 0, 0, 1 } );
+    s.concurrent_add( vec4{ 1, 0, 0, 1 } );
+    BOOST_CHECK_THROW( s.concurrent_add( vec4{ 2, 0, 0, 1 } ), skeleton_atom_buffer_overflow );
+    s.end_concurrent_add();
+    BOOST_CHECK_EQUAL( s.get_number_of_atoms(), 2 );
+  }
+
   static void load_balls_file()
   {
     median_skeleton s;
@@ -364,6 +648,664 @@ BEGIN_MP_NAMESPACE
       }
   }
 
+  static void load_moff_file()
+  {
+    {
+      std::ofstream temp( "temp.moff" );
+      temp << "MOFF 5 2 1.0 // the scale is optional\n"
+           << "0 0 0 1\n"
+           << "1 0 0 1.5e-1\n\n"
+           << "// a comment line\n"
+           << "1 1 0 .25\n"
+           << "0 1 0 1\r\n"
+           << "2 2 2 2\n"
+           << "4 0 1 2 3\n"
+           << "2 3 4 // a single link\n";
+      temp.close();
+    }
+    median_skeleton s;
+    BOOST_REQUIRE( s.load( "temp.moff" ) );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), 5 );
+    BOOST_CHECK_EQUAL( s.get_number_of_faces(), 2 );
+    BOOST_CHECK_EQUAL( s.get_number_of_links(), 6 );
+    BOOST_CHECK_EQUAL( s.get_atom_by_index( 1 ).w, 0.15 );
+    BOOST_CHECK_EQUAL( s.get_atom_by_index( 2 ).w, 0.25 );
+    BOOST_CHECK( s.is_a_link( 3, 4 ) );
+
+    BOOST_REQUIRE( s.save( "temp.moff" ) );
+    median_skeleton l;
+    BOOST_REQUIRE( l.load( "temp.moff" ) );
+    BOOST_CHECK_EQUAL( l.get_number_of_atoms(), 5 );
+    BOOST_CHECK_EQUAL( l.get_number_of_faces(), 2 );
+    BOOST_CHECK_EQUAL( l.get_atom_by_index( 1 ).w, 0.15 );
+
+    {
+      std::ofstream temp( "temp.moff" );
+      temp << "MOFF 2 1\n0 0 0 1\n1 0 0 1\n3 0 1 2\n";
+      temp.close();
+    }
+    BOOST_CHECK( !l.load( "temp.moff" ) );
+    BOOST_CHECK_EQUAL( l.get_number_of_atoms(), 0 );
+  }
+
+  static void single_precision_conversion_round_trip()
+  {
+    median_skeleton s;
+    for( int i = 0; i < 100; ++ i )
+      s.add( vec4{ i + 0.1, 2 * i, 3 * i, 1 + i * 0.25 } );
+    s.add( 0, 1 );
+    s.add( 1, 2 );
+    s.add( 0, 1, 2 );
+
+    single_precision_median_skeleton f( s );
+    BOOST_REQUIRE_EQUAL( sizeof( single_precision_median_skeleton::atom ) * 2, sizeof( median_skeleton::atom ) );
+    BOOST_REQUIRE_EQUAL( f.get_number_of_atoms(), 100 );
+    BOOST_REQUIRE_EQUAL( f.get_number_of_links(), 3 );
+    BOOST_REQUIRE_EQUAL( f.get_number_of_faces(), 1 );
+    BOOST_REQUIRE( f.is_a_link( 0, 2 ) );
+    for( int i = 0; i < 100; ++ i )
+      {
+        const auto& atom = f.get_atom_by_index( i );
+        BOOST_CHECK_EQUAL( atom.x, gl_real( i + 0.1 ) );
+        BOOST_CHECK_EQUAL( atom.w, gl_real( 1 + i * 0.25 ) );
+      }
+
+    f.set_atom_layout( single_precision_median_skeleton::structure_of_arrays );
+    auto box = f.compute_centers_bounding_box();
+    REAL_CHECK_CLOSE( box.center.x + box.hsides.x, 99.1, 1e-5, 1e-4 );
+
+    // widening is exact
+    median_skeleton d;
+    d.assign( f );
+    BOOST_REQUIRE_EQUAL( d.get_number_of_atoms(), 100 );
+    BOOST_REQUIRE_EQUAL( d.get_number_of_links(), 3 );
+    BOOST_REQUIRE_EQUAL( d.get_number_of_faces(), 1 );
+    for( int i = 0; i < 100; ++ i )
+      {
+        BOOST_CHECK_EQUAL( d.get_atom_by_index( i ).x, real( gl_real( i + 0.1 ) ) );
+        BOOST_CHECK_EQUAL( d.get_atom_by_index( i ).y, 2 * i );
+      }
+  }
+
+  static void large_skeleton_round_trip()
+  {
+    BOOST_REQUIRE_EQUAL( sizeof( large_median_skeleton::atom_index ), 8 );
+    BOOST_REQUIRE( large_median_skeleton::null_atom_index > median_skeleton::null_atom_index );
+
+    large_median_skeleton s;
+    for( int i = 0; i < 100; ++ i )
+      s.add( vec4{ i + 0.1, 2 * i, 3 * i, 1 + i * 0.25 } );
+    for( large_median_skeleton::atom_index i = 0; i + 2 < 100; ++ i )
+      s.add( i, i + 1, i + 2 );
+    s.add( large_median_skeleton::atom_index( 0 ), large_median_skeleton::atom_index( 99 ) );
+
+    BOOST_REQUIRE( s.save( "temp_large.median" ) );
+    large_median_skeleton l;
+    BOOST_REQUIRE( l.load( "temp_large.median" ) );
+    median_skeleton d;
+    BOOST_REQUIRE( d.load( "temp_large.median" ) );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_atoms(), s.get_number_of_atoms() );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_links(), s.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_faces(), s.get_number_of_faces() );
+    BOOST_REQUIRE_EQUAL( d.get_number_of_links(), s.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( d.get_number_of_faces(), s.get_number_of_faces() );
+    BOOST_CHECK( l.is_a_link( 0, 99 ) );
+    BOOST_CHECK( d.is_a_link( 0, 99 ) );
+    for( int i = 0; i < 100; ++ i )
+      {
+        BOOST_CHECK_EQUAL( l.get_atom_by_index( i ).x, s.get_atom_by_index( i ).x );
+        BOOST_CHECK_EQUAL( d.get_atom_by_index( i ).w, s.get_atom_by_index( i ).w );
+      }
+  }
+
+  static void large_skeleton_crosses_the_default_atom_capacity()
+  {
+    // one more atom than 22 bits of handle index can address
+    typedef large_median_skeleton::atom_index atom_index;
+    const atom_index natoms = ( atom_index( 1 ) << 22 ) + 16;
+    std::vector< vec4 > balls( natoms );
+    # pragma omp parallel for
+    for( int64_t i = 0; i < int64_t( natoms ); ++ i )
+      balls[ i ] = vec4{ real( i ), 0, 0, 1 };
+
+    large_median_skeleton s;
+    s.reserve_atoms( natoms );
+    const atom_index half = natoms >> 1;
+    BOOST_CHECK_EQUAL( s.add_atoms( balls.data(), half ), 0 );
+    BOOST_CHECK_EQUAL( s.add_atoms( balls.data() + half, natoms - half ), half );
+    std::vector< vec4 >{}.swap( balls );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), natoms );
+
+    const atom_index last = natoms - 1;
+    const auto last_handle = s.get_handle( s.get_atom_by_index( last ) );
+    BOOST_CHECK_EQUAL( s.get_index( last_handle ), last );
+    BOOST_CHECK_EQUAL( s.get( last_handle ).x, real( last ) );
+
+    s.add( last - 1, last );
+    s.add( atom_index( 0 ), last );
+    BOOST_CHECK( s.is_a_link( last - 1, last ) );
+    BOOST_CHECK( s.is_a_link( atom_index( 0 ), last ) );
+    BOOST_CHECK_EQUAL( s.get_number_of_links(), 2 );
+
+    // removing the first atom moves the last one, whose handle must follow
+    s.remove( s.get_handle( s.get_atom_by_index( 0 ) ) );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), last );
+    BOOST_REQUIRE( s.is_valid( last_handle ) );
+    BOOST_CHECK_EQUAL( s.get( last_handle ).x, real( last ) );
+    BOOST_CHECK_EQUAL( s.get_number_of_links(), 1 );
+    BOOST_CHECK( s.is_a_link( s.get_index( last_handle ), last - 1 ) );
+  }
+
+  static void mskel_round_trip()
+  {
+    median_skeleton s;
+    auto& radii = s.add_atom_property< float >( "radii" );
+    s.add_atom_property< int >( "paged", base_property_buffer::paged );
+    auto& lengths = s.add_link_property< double >( "lengths" );
+    for( int i = 0; i < 100; ++ i )
+      {
+        s.add( vec4{ i + 0.1, 2 * i, 3 * i, 1 + i * 0.25 } );
+        radii.get< float >( i ) = i * 0.5f;
+      }
+    for( median_skeleton::atom_index i = 0; i + 2 < 100; ++ i )
+      s.add( i, i + 1, i + 2 );
+    s.add( median_skeleton::atom_index( 0 ), median_skeleton::atom_index( 99 ) );
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      lengths.get< double >( i ) = i + 0.5;
+    BOOST_REQUIRE( s.save( "temp.mskel" ) );
+
+    median_skeleton l;
+    auto& loaded_radii = l.add_atom_property< float >( "radii" );
+    auto& loaded_lengths = l.add_link_property< double >( "lengths" );
+    BOOST_REQUIRE( l.load( "temp.mskel" ) );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_atoms(), s.get_number_of_atoms() );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_links(), s.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_faces(), s.get_number_of_faces() );
+    BOOST_CHECK( l.is_a_link( 0, 99 ) );
+    for( int i = 0; i < 100; ++ i )
+      {
+        BOOST_CHECK_EQUAL( l.get_atom_by_index( i ).x, s.get_atom_by_index( i ).x );
+        BOOST_CHECK_EQUAL( l.get_atom_by_index( i ).w, s.get_atom_by_index( i ).w );
+        BOOST_CHECK_EQUAL( loaded_radii.get< float >( i ), i * 0.5f );
+      }
+    for( median_skeleton::link_index i = 0; i < l.get_number_of_links(); ++ i )
+      BOOST_CHECK_EQUAL( loaded_lengths.get< double >( i ), i + 0.5 );
+
+    large_median_skeleton large;
+    BOOST_REQUIRE( large.load( "temp.mskel" ) );
+    BOOST_CHECK_EQUAL( large.get_number_of_faces(), s.get_number_of_faces() );
+    BOOST_CHECK( large.is_a_link( 0, 99 ) );
+  }
+
+  static void median_properties_round_trip()
+  {
+    typedef std::array< median_skeleton::atom_index, 2 > sampling;
+    median_skeleton s;
+    auto& radii = s.add_atom_property< float >( "radii" );
+    auto& samplings = s.add_atom_property< sampling >( "samplings" );
+    auto& marks = s.add_link_property< int >( "marks", base_property_buffer::sparse );
+    auto& normals = s.add_face_property< vec3 >( "normals" );
+    for( int i = 0; i < 50; ++ i )
+      {
+        s.add( vec4{ i, 2 * i, 3 * i, 1 + i * 0.25 } );
+        radii.get< float >( i ) = i * 0.5f;
+        samplings.get< sampling >( i ) = {{ median_skeleton::atom_index( i ), median_skeleton::atom_index( 2 * i ) }};
+      }
+    for( median_skeleton::atom_index i = 0; i + 2 < 50; ++ i )
+      s.add( i, i + 1, i + 2 );
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); i += 10 )
+      marks.get< int >( i ) = -int( i );
+    for( median_skeleton::face_index i = 0; i < s.get_number_of_faces(); ++ i )
+      normals.get< vec3 >( i ) = vec3{ i, 0.5, -1.0 * i };
+    BOOST_REQUIRE( s.save( "temp.median" ) );
+
+    median_skeleton l;
+    auto& existing_radii = l.add_atom_property< float >( "radii" );
+    BOOST_REQUIRE( l.load( "temp.median" ) );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_atoms(), s.get_number_of_atoms() );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_faces(), s.get_number_of_faces() );
+    BOOST_REQUIRE( l.is_an_atom_property_name( "samplings" ) );
+    BOOST_REQUIRE( l.is_an_link_property_name( "marks" ) );
+    BOOST_REQUIRE( l.is_an_face_property_name( "normals" ) );
+    BOOST_CHECK( &l.get_atom_property( "radii" ) == &existing_radii );
+    auto& loaded_samplings = l.get_atom_property( "samplings" );
+    for( int i = 0; i < 50; ++ i )
+      {
+        BOOST_CHECK_EQUAL( existing_radii.get< float >( i ), i * 0.5f );
+        BOOST_CHECK( loaded_samplings.get< sampling >( i ) == samplings.get< sampling >( i ) );
+      }
+    auto& loaded_marks = l.get_link_property( "marks" );
+    BOOST_CHECK( loaded_marks.m_storage == base_property_buffer::sparse );
+    for( median_skeleton::link_index i = 0; i < l.get_number_of_links(); ++ i )
+      {
+        BOOST_CHECK_EQUAL( loaded_marks.is_allocated( i ), i % 10 == 0 );
+        if( i % 10 == 0 )
+          BOOST_CHECK_EQUAL( loaded_marks.get< int >( i ), -int( i ) );
+      }
+    auto& loaded_normals = l.get_face_property( "normals" );
+    for( median_skeleton::face_index i = 0; i < l.get_number_of_faces(); ++ i )
+      BOOST_CHECK( loaded_normals.get< vec3 >( i ) == normals.get< vec3 >( i ) );
+  }
+
+  static void mpack_round_trip()
+  {
+    median_skeleton s;
+    std::mt19937 generator( 7 );
+    std::uniform_real_distribution< real > coordinate( -5, 5 );
+    std::uniform_real_distribution< real > radius( 0.1, 1 );
+    for( int i = 0; i < 1000; ++ i )
+      s.add( vec4{ coordinate( generator ), coordinate( generator ), coordinate( generator ), radius( generator ) } );
+    for( median_skeleton::atom_index i = 0; i + 2 < 1000; i += 2 )
+      s.add( i, i + 1, i + 2 );
+    s.add( median_skeleton::atom_index( 0 ), median_skeleton::atom_index( 999 ) );
+    BOOST_REQUIRE( s.save( "temp.mpack" ) );
+
+    median_skeleton l;
+    BOOST_REQUIRE( l.load( "temp.mpack" ) );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_atoms(), s.get_number_of_atoms() );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_links(), s.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( l.get_number_of_faces(), s.get_number_of_faces() );
+
+    /* atoms are reordered: each atom is matched to the closest loaded atom,
+     * which must be within the quantization error */
+    const real tolerance = real( 10.0 / 65535 );
+    std::vector< median_skeleton::atom_index > matches( 1000 );
+    for( median_skeleton::atom_index i = 0; i < 1000; ++ i )
+      {
+        const auto& a = s.get_atom_by_index( i );
+        real best = std::numeric_limits< real >::max();
+        for( median_skeleton::atom_index j = 0; j < 1000; ++ j )
+          {
+            const auto& b = l.get_atom_by_index( j );
+            const real d = std::max( std::max( std::abs( a.x - b.x ), std::abs( a.y - b.y ) ),
+              std::max( std::abs( a.z - b.z ), std::abs( a.w - b.w ) ) );
+            if( d < best )
+              {
+                best = d;
+                matches[ i ] = j;
+              }
+          }
+        BOOST_CHECK( best <= tolerance );
+      }
+    BOOST_CHECK( l.is_a_link( matches[ 0 ], matches[ 999 ] ) );
+    for( median_skeleton::atom_index i = 0; i + 2 < 1000; i += 2 )
+      {
+        BOOST_CHECK( l.is_a_link( matches[ i ], matches[ i + 1 ] ) );
+        BOOST_CHECK( l.is_a_link( matches[ i ], matches[ i + 2 ] ) );
+      }
+
+    large_median_skeleton large;
+    BOOST_REQUIRE( large.load( "temp.mpack" ) );
+    BOOST_CHECK_EQUAL( large.get_number_of_faces(), s.get_number_of_faces() );
+  }
+
+  static void rans_round_trip()
+  {
+    std::mt19937 generator( 11 );
+    std::geometric_distribution< int > small( 0.1 );
+    for( size_t size : { 1, 63, 64, 65, 1000, 100003 } )
+      {
+        std::vector< uint8_t > data( size ), compressed, output;
+        for( auto& byte : data )
+          byte = uint8_t( std::min( small( generator ), 255 ) );
+        rans_compress( data.data(), data.size(), compressed );
+        const uint8_t* cursor = compressed.data();
+        BOOST_REQUIRE( rans_decompress( cursor, compressed.data() + compressed.size(), size, output ) );
+        BOOST_CHECK( cursor == compressed.data() + compressed.size() );
+        BOOST_CHECK( output == data );
+      }
+
+    // a constant stream codes no symbol
+    std::vector< uint8_t > data( 100000, 42 ), compressed, output;
+    rans_compress( data.data(), data.size(), compressed );
+    BOOST_CHECK( compressed.size() < 64 );
+    const uint8_t* cursor = compressed.data();
+    BOOST_REQUIRE( rans_decompress( cursor, compressed.data() + compressed.size(), data.size(), output ) );
+    BOOST_CHECK( output == data );
+  }
+
+  static void rans_rejects_oversized_streams()
+  {
+    std::vector< uint8_t > data( 1000, 7 ), compressed, output;
+    rans_compress( data.data(), data.size(), compressed );
+    const uint8_t* cursor = compressed.data();
+    BOOST_REQUIRE( rans_decompress( cursor, compressed.data() + compressed.size(), data.size(), output ) );
+    BOOST_CHECK( output == data );
+
+    cursor = compressed.data();
+    BOOST_CHECK( !rans_decompress( cursor, compressed.data() + compressed.size(), data.size() - 1, output ) );
+
+    // a corrupted size is rejected before the output is allocated
+    std::memset( compressed.data(), 0xff, 4 );
+    cursor = compressed.data();
+    output.clear();
+    BOOST_CHECK( !rans_decompress( cursor, compressed.data() + compressed.size(), data.size(), output ) );
+    BOOST_CHECK( output.empty() );
+  }
+
+  static void async_save_and_load()
+  {
+    io::set_async_io_limits( 1, 1 );
+    std::vector< std::shared_ptr< median_skeleton > > skeletons;
+    std::vector< std::future< bool > > saved;
+    for( int k = 0; k < 4; ++ k )
+      {
+        auto s = std::make_shared< median_skeleton >();
+        for( int i = 0; i <= 10 * k; ++ i )
+          s->add( vec4{ i, k, 0, 1 } );
+        skeletons.push_back( s );
+        saved.push_back( io::save_async( s, "temp_async_" + std::to_string( k ) + ".mskel" ) );
+      }
+    for( auto& f : saved )
+      BOOST_CHECK( f.get() );
+
+    std::vector< std::shared_ptr< median_skeleton > > loaded;
+    std::vector< std::future< bool > > loads;
+    for( int k = 0; k < 4; ++ k )
+      {
+        loaded.push_back( std::make_shared< median_skeleton >() );
+        loads.push_back( io::load_async( loaded.back(), "temp_async_" + std::to_string( k ) + ".mskel" ) );
+      }
+    io::wait_async_operations();
+    for( int k = 0; k < 4; ++ k )
+      {
+        BOOST_CHECK( loads[ k ].get() );
+        BOOST_CHECK_EQUAL( loaded[ k ]->get_number_of_atoms(), skeletons[ k ]->get_number_of_atoms() );
+      }
+    BOOST_CHECK( !io::load_async( loaded[ 0 ], "temp_async_missing.mskel" ).get() );
+    io::set_async_io_limits( 2, 4 );
+  }
+
+  /* Saver of .rendezvous files: a save waits until another one is in
+   * progress, and fails if none starts before the timeout. */
+  struct rendezvous_saver : public io::saver {
+    bool can_save_to( const std::string& filename ) override
+    {
+      return filename.size() > 11 && filename.compare( filename.size() - 11, 11, ".rendezvous" ) == 0;
+    }
+    bool save( const median_skeleton& skeleton, const std::string& filename ) override
+    {
+      (void)skeleton;
+      (void)filename;
+      std::unique_lock< std::mutex > lock( mutex );
+      ++ entered;
+      arrived.notify_all();
+      return arrived.wait_for( lock, std::chrono::seconds( 10 ), [this]{ return entered >= 2; } );
+    }
+    std::mutex mutex;
+    std::condition_variable arrived;
+    int entered = 0;
+  };
+
+  /* Saver of .throwing files: a save always throws. */
+  struct throwing_saver : public io::saver {
+    bool can_save_to( const std::string& filename ) override
+    {
+      return filename.size() > 9 && filename.compare( filename.size() - 9, 9, ".throwing" ) == 0;
+    }
+    bool save( const median_skeleton& skeleton, const std::string& filename ) override
+    {
+      (void)skeleton;
+      throw std::runtime_error( "cannot save " + filename );
+    }
+  };
+
+  static void async_saves_run_concurrently()
+  {
+    io::add_saver( new rendezvous_saver );
+    io::add_saver( new throwing_saver );
+    io::set_async_io_limits( 2, 2 );
+    auto s = std::make_shared< median_skeleton >();
+    for( int i = 0; i < 10; ++ i )
+      s->add( vec4{ i, 0, 0, 1 } );
+
+    auto first = io::save_async( s, "temp_concurrent_0.rendezvous" );
+    auto second = io::save_async( s, "temp_concurrent_1.rendezvous" );
+    BOOST_CHECK( first.get() );
+    BOOST_CHECK( second.get() );
+
+    BOOST_CHECK_THROW( io::save_async( s, "temp_concurrent.throwing" ).get(), std::runtime_error );
+    BOOST_CHECK( io::save_async( s, "temp_concurrent.mskel" ).get() );
+    BOOST_CHECK( io::can_save_to( "temp_concurrent.throwing" ) );
+    io::set_async_io_limits( 2, 4 );
+  }
+
+  static void bvh_queries_match_brute_force_ones()
+  {
+    median_skeleton s;
+    std::vector< median_skeleton::atom_handle > handles;
+    std::mt19937 generator( 42 );
+    std::uniform_real_distribution< real > coordinate( -10, 10 );
+    std::uniform_real_distribution< real > radius( 0.1, 1.5 );
+    for( int i = 0; i < 500; ++ i )
+      handles.push_back( s.add( vec3{ coordinate( generator ), coordinate( generator ), coordinate( generator ) }, radius( generator ) ) );
+
+    std::vector< vec3 > points( 200 );
+    for( auto& p : points )
+      p = vec3{ coordinate( generator ), coordinate( generator ), coordinate( generator ) };
+
+    auto signed_distance = [&s]( const vec3& p, median_skeleton::atom_index i )
+      {
+        const auto& a = s.get_atom_by_index( i );
+        return glm::length( p - vec3{ a.x, a.y, a.z } ) - a.w;
+      };
+    auto check = [&]()
+      {
+        const auto& bvh = s.get_atom_bvh();
+        BOOST_REQUIRE_EQUAL( bvh.size(), s.get_number_of_atoms() );
+        std::vector< median_skeleton::atom_index > indices;
+        for( const auto& p : points )
+          {
+            std::vector< real > distances( s.get_number_of_atoms() );
+            std::vector< median_skeleton::atom_index > containing, overlapping;
+            for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+              {
+                distances[i] = signed_distance( p, i );
+                if( distances[i] < 0 )
+                  containing.push_back( i );
+                if( distances[i] < 0.5 )
+                  overlapping.push_back( i );
+              }
+            std::vector< real > sorted_distances = distances;
+            std::sort( sorted_distances.begin(), sorted_distances.end() );
+
+            BOOST_CHECK_EQUAL( bvh.contains( p ), !containing.empty() );
+            bvh.get_atoms_containing( p, indices );
+            std::sort( indices.begin(), indices.end() );
+            BOOST_CHECK( indices == containing );
+
+            real distance;
+            auto closest = bvh.get_closest_surface( p, distance );
+            REAL_CHECK_CLOSE( distance, sorted_distances[0], 1e-9, 1e-6 );
+            REAL_CHECK_CLOSE( distances[ closest ], sorted_distances[0], 1e-9, 1e-6 );
+
+            bvh.get_nearest_atoms( p, 5, indices );
+            BOOST_REQUIRE_EQUAL( indices.size(), 5 );
+            for( size_t k = 0; k < 5; ++ k )
+              REAL_CHECK_CLOSE( distances[ indices[k] ], sorted_distances[k], 1e-9, 1e-6 );
+
+            bvh.get_overlapping_atoms( p, 0.5, indices );
+            std::sort( indices.begin(), indices.end() );
+            BOOST_CHECK( indices == overlapping );
+          }
+      };
+    check();
+
+    // refit after atoms moved
+    for( int i = 0; i < 500; i += 3 )
+      s.get( handles[i] ).x += 5;
+    check();
+
+    s.transform( -0.5, vec3{ 1, 2, 3 } );
+    check();
+
+    // new build after removals
+    for( int i = 0; i < 500; i += 7 )
+      s.remove( handles[i] );
+    check();
+
+    s.clear();
+    real distance;
+    BOOST_CHECK( !s.get_atom_bvh().contains( vec3{ 0, 0, 0 } ) );
+    BOOST_CHECK_EQUAL( s.get_atom_bvh().get_closest_surface( vec3{ 0, 0, 0 }, distance ), 0 );
+  }
+
+  static void change_journal_gives_the_dirty_atoms()
+  {
+    median_skeleton s;
+    BOOST_CHECK( s.get_change_journal() == nullptr );
+    s.set_change_journal( true );
+    BOOST_REQUIRE( s.has_change_journal() );
+
+    std::vector< median_skeleton::atom_handle > handles;
+    for( int i = 0; i < 100; ++ i )
+      handles.push_back( s.add( vec3{ real(i), real(2 * i), real(3 * i) }, 1 ) );
+    const change_journal& journal = *s.get_change_journal();
+    BOOST_REQUIRE_EQUAL( journal.atoms.added_ranges.size(), 1 );
+    BOOST_CHECK_EQUAL( journal.atoms.added_ranges[0].begin, 0 );
+    BOOST_CHECK_EQUAL( journal.atoms.added_ranges[0].end, 100 );
+
+    /* a mirror of the atoms is kept up to date with the dirty ranges, the
+     * atoms being read through the columns to not mark them as modified */
+    std::vector< vec4 > mirror;
+    std::vector< index_range > dirty;
+    auto update = [&]()
+      {
+        const auto& columns = s.get_atom_columns();
+        change_journal::get_dirty_ranges( journal.atoms, s.get_number_of_atoms(), dirty );
+        mirror.resize( s.get_number_of_atoms() );
+        for( const auto& r : dirty )
+          for( size_t i = r.begin; i < r.end; ++ i )
+            mirror[i] = vec4{ columns.x[i], columns.y[i], columns.z[i], columns.r[i] };
+        s.clear_change_journal();
+        BOOST_CHECK( journal.empty() );
+        for( size_t i = 0; i < mirror.size(); ++ i )
+          BOOST_CHECK( mirror[i] == vec4( columns.x[i], columns.y[i], columns.z[i], columns.r[i] ) );
+      };
+    update();
+
+    // constant accesses are not recorded
+    auto epoch = journal.get_epoch();
+    const median_skeleton& reader = s;
+    real sum = 0;
+    for( size_t i = 0; i < handles.size(); ++ i )
+      sum += reader.get( handles[ i ] ).w + reader.get_atom_by_index( i ).w;
+    BOOST_CHECK_EQUAL( sum, 200 );
+    BOOST_CHECK_EQUAL( journal.get_epoch(), epoch );
+    BOOST_CHECK( journal.empty() );
+
+    // savers only read the skeleton
+    for( const std::string extension : { ".median", ".mskel", ".mpack", ".balls", ".moff", ".web" } )
+      BOOST_CHECK( reader.save( "temp_journal" + extension ) );
+    BOOST_CHECK_EQUAL( journal.get_epoch(), epoch );
+    BOOST_CHECK( journal.empty() );
+
+    s.get( handles[ 10 ] ).x = -1;
+    BOOST_CHECK( journal.get_epoch() > epoch );
+    s.remove( handles[ 20 ] );
+    s.add( vec3{ 1, 1, 1 }, 2 );
+    BOOST_CHECK_EQUAL( journal.atoms.removed_ranges.size(), 1 );
+    update();
+
+    s.remove_atoms( []( const median_skeleton::atom& a ){ return int( a.x ) % 3 == 0; } );
+    update();
+
+    s.transform( 2, vec3{ 1, 0, 0 } );
+    update();
+
+    // parallel writers are all recorded
+    const median_skeleton::atom_index natoms = s.get_number_of_atoms();
+    epoch = journal.get_epoch();
+    # pragma omp parallel for
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      s.get_atom_by_index( i ).w = 3;
+    BOOST_CHECK_EQUAL( journal.get_epoch(), epoch + natoms );
+    change_journal::get_dirty_ranges( journal.atoms, natoms, dirty );
+    BOOST_REQUIRE_EQUAL( dirty.size(), 1 );
+    BOOST_CHECK_EQUAL( dirty[0].begin, 0 );
+    BOOST_CHECK_EQUAL( dirty[0].end, natoms );
+    update();
+
+    s.set_change_journal( false );
+    BOOST_CHECK( s.get_change_journal() == nullptr );
+    s.add( vec3{ 1, 1, 1 }, 2 );
+  }
+
+  static void change_journal_bounds_the_property_ranges()
+  {
+    change_journal journal;
+    // scattered writes of two properties, never adjacent to the previous one
+    const size_t nwrites = 4 * change_journal::max_ranges;
+    for( size_t i = 0; i < nwrites; ++ i )
+      {
+        journal.record_property( journal.atoms, i & 1, 4 * i, 4 * i + 1 );
+        BOOST_REQUIRE( journal.atoms.modified_property_ranges.size() <= change_journal::max_ranges );
+      }
+    for( size_t i = 0; i < nwrites; ++ i )
+      {
+        bool covered = false;
+        for( const auto& r : journal.atoms.modified_property_ranges )
+          covered = covered || ( r.first == ( i & 1 ) && r.second.begin <= 4 * i && 4 * i + 1 <= r.second.end );
+        BOOST_REQUIRE( covered );
+      }
+    BOOST_CHECK_EQUAL( journal.get_epoch(), nwrites );
+  }
+
+  static void chunked_processing_visits_each_atom_once()
+  {
+    median_skeleton s;
+    const median_skeleton::atom_index natoms = 10007;
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      s.add( vec3{ real(i), 0, 0 }, 1 );
+
+    for( auto schedule : { static_schedule, dynamic_schedule, work_stealing_schedule } )
+      for( size_t grain : { size_t( 0 ), size_t( 1 ), size_t( 100 ), size_t( 20000 ) } )
+        for( bool parallel : { true, false } )
+          {
+            parallel_options options;
+            options.schedule = schedule;
+            options.grain_size = grain;
+            options.parallel = parallel;
+
+            std::vector< std::atomic< int > > visits( natoms );
+            for( auto& v : visits )
+              v.store( 0 );
+            std::atomic< bool > consistent( true );
+            s.process_atom_chunks(
+              [&]( median_skeleton::atom_index begin, median_skeleton::atom_index end,
+                   median_skeleton::atom* atoms )
+              {
+                if( begin >= end || ( grain && end - begin > grain ) )
+                  consistent = false;
+                for( median_skeleton::atom_index i = begin; i < end; ++ i )
+                  {
+                    if( atoms[ i - begin ].x != real( i ) )
+                      consistent = false;
+                    ++ visits[ i ];
+                  }
+              }, options );
+            BOOST_CHECK( consistent );
+            BOOST_CHECK( std::all_of( visits.begin(), visits.end(),
+              []( const std::atomic< int >& v ){ return v.load() == 1; } ) );
+          }
+
+    // index-aware per atom overload
+    std::atomic< bool > indices_match( true );
+    s.process_atoms( [&]( median_skeleton::atom_index i, median_skeleton::atom& a )
+      {
+        if( a.x != real( i ) )
+          indices_match = false;
+      } );
+    BOOST_CHECK( indices_match );
+
+    parallel_options options;
+    options.schedule = work_stealing_schedule;
+    options.grain_size = 7;
+    s.process_atoms( []( median_skeleton::atom& a ){ a.w = 2; }, options );
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      BOOST_CHECK_EQUAL( s.get_atom_by_index( i ).w, 2 );
+  }
+
   test_suite* atom_management_test_suite()
   {
     test_suite* suite = BOOST_TEST_SUITE( "atom_management" );
@@ -379,9 +1321,32 @@ BEGIN_MP_NAMESPACE
     ADD_TEST_CASE( remove_even_atoms_by_filter );
     ADD_TEST_CASE( process_atoms );
     ADD_TEST_CASE( memory_reused_instead_of_reallocation );
+    ADD_TEST_CASE( growth_policy_sets_the_new_capacity );
+    ADD_TEST_CASE( shrink_to_fit_keeps_valid_handles );
+    ADD_TEST_CASE( sparse_and_paged_properties_follow_atoms );
     ADD_TEST_CASE( filter_move_atoms_as_expected );
     ADD_TEST_CASE( filter_move_atoms_as_expected_with_an_initial_odd_number );
+    ADD_TEST_CASE( filter_preserves_atom_order );
+    ADD_TEST_CASE( both_layouts_give_the_same_reductions );
+    ADD_TEST_CASE( atom_columns_follow_atom_changes );
+    ADD_TEST_CASE( concurrent_add_keeps_handles_consistent );
+    ADD_TEST_CASE( concurrent_add_throws_beyond_reservation );
     ADD_TEST_CASE( load_balls_file );
+    ADD_TEST_CASE( load_moff_file );
+    ADD_TEST_CASE( single_precision_conversion_round_trip );
+    ADD_TEST_CASE( large_skeleton_round_trip );
+    ADD_TEST_CASE( large_skeleton_crosses_the_default_atom_capacity );
+    ADD_TEST_CASE( mskel_round_trip );
+    ADD_TEST_CASE( median_properties_round_trip );
+    ADD_TEST_CASE( mpack_round_trip );
+    ADD_TEST_CASE( rans_round_trip );
+    ADD_TEST_CASE( rans_rejects_oversized_streams );
+    ADD_TEST_CASE( async_save_and_load );
+    ADD_TEST_CASE( async_saves_run_concurrently );
+    ADD_TEST_CASE( bvh_queries_match_brute_force_ones );
+    ADD_TEST_CASE( change_journal_gives_the_dirty_atoms );
+    ADD_TEST_CASE( change_journal_bounds_the_property_ranges );
+    ADD_TEST_CASE( chunked_processing_visits_each_atom_once );
     return suite;
   }
 
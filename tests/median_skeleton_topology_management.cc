@@ -0,0 +1,779 @@
+# include "test.h"
+# include "../median-path/median_skeleton.h"
+# include "../median-path/topology_builder.h"
+# include "../median-path/topology_classifier.h"
+
+# include <memory>
+# include <string>
+# include <vector>
+# include <omp.h>
+
+BEGIN_MP_NAMESPACE
+
+  /* Build a strip of triangles:
+   *  0 -- 2 -- 4 -- 6
+   *  |  / |  / |  / |
+   *  1 -- 3 -- 5 -- 7
+   * plus an isolated atom #8 and an isolated link 8 -- 9.
+   */
+  static void build_strip( median_skeleton& s )
+  {
+    for( int i = 0; i < 10; ++ i )
+      s.add( vec4{ i >> 1, i & 1, 0, 1 } );
+    for( median_skeleton::atom_index i = 0; i + 2 < 8; ++ i )
+      s.add( i, i + 1, i + 2 );
+    s.add( median_skeleton::atom_index( 8 ), median_skeleton::atom_index( 9 ) );
+  }
+
+  static void freeze_keeps_the_topology()
+  {
+    median_skeleton s;
+    build_strip( s );
+    const auto nlinks = s.get_number_of_links();
+    std::vector< median_skeleton::link_index > links_per_atom;
+    std::vector< median_skeleton::face_index > faces_per_atom;
+    std::vector< median_skeleton::face_index > faces_per_link;
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      {
+        links_per_atom.push_back( s.get_number_of_links( i ) );
+        faces_per_atom.push_back( s.get_atom_faces( i ).size() );
+      }
+    for( median_skeleton::link_index i = 0; i < nlinks; ++ i )
+      faces_per_link.push_back( s.get_number_of_faces( i ) );
+
+    s.freeze();
+    BOOST_REQUIRE( s.is_frozen() );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_links(), nlinks );
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      {
+        BOOST_CHECK_EQUAL( s.get_number_of_links( i ), links_per_atom[i] );
+        BOOST_CHECK_EQUAL( s.get_atom_faces( i ).size(), faces_per_atom[i] );
+        for( auto& link : s.get_atom_links( i ) )
+          BOOST_CHECK( s.is_a_link( i, s.get_index( link.second ) ) );
+      }
+    for( median_skeleton::link_index i = 0; i < nlinks; ++ i )
+      BOOST_CHECK_EQUAL( s.get_number_of_faces( i ), faces_per_link[i] );
+
+    BOOST_CHECK( s.is_a_link( 0, 2 ) );
+    BOOST_CHECK( !s.is_a_link( 0, 3 ) );
+    BOOST_CHECK( s.is_a_link( 8, 9 ) );
+    BOOST_CHECK_EQUAL( s.get_number_of_links( median_skeleton::atom_index( 0 ) ), 2 );
+    BOOST_CHECK_EQUAL( s.get_number_of_links( median_skeleton::atom_index( 3 ) ), 4 );
+  }
+
+  static void freeze_keeps_the_topology_of_long_strips()
+  {
+    // a strip long enough for the row offsets to be scanned by several blocks
+    const int previous_threads = omp_get_max_threads();
+    omp_set_num_threads( 4 );
+    median_skeleton s;
+    const median_skeleton::atom_index natoms = 40000;
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      s.add( vec4{ i >> 1, i & 1, 0, 1 } );
+    for( median_skeleton::atom_index i = 0; i + 2 < natoms; ++ i )
+      s.add( i, i + 1, i + 2 );
+    std::vector< median_skeleton::link_index > links_per_atom;
+    std::vector< median_skeleton::face_index > faces_per_atom;
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      {
+        links_per_atom.push_back( s.get_number_of_links( i ) );
+        faces_per_atom.push_back( s.get_atom_faces( i ).size() );
+      }
+    std::vector< median_skeleton::face_index > faces_per_link;
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      faces_per_link.push_back( s.get_number_of_faces( i ) );
+
+    s.freeze();
+    omp_set_num_threads( previous_threads );
+    BOOST_REQUIRE( s.is_frozen() );
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      {
+        BOOST_REQUIRE_EQUAL( s.get_number_of_links( i ), links_per_atom[i] );
+        BOOST_REQUIRE_EQUAL( s.get_atom_faces( i ).size(), faces_per_atom[i] );
+        for( auto& link : s.get_atom_links( i ) )
+          BOOST_REQUIRE( s.is_a_link( i, s.get_index( link.second ) ) );
+      }
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      BOOST_REQUIRE_EQUAL( s.get_number_of_faces( i ), faces_per_link[i] );
+  }
+
+  static void edit_thaws_the_topology()
+  {
+    median_skeleton s;
+    build_strip( s );
+    s.freeze();
+
+    // adding a face connecting 8 and 9 to 7 thaws the topology
+    s.add( median_skeleton::atom_index( 7 ), median_skeleton::atom_index( 8 ),
+           median_skeleton::atom_index( 9 ) );
+    BOOST_REQUIRE( !s.is_frozen() );
+    BOOST_CHECK( s.is_a_link( 7, 8 ) );
+    BOOST_CHECK_EQUAL( s.get_number_of_links( median_skeleton::atom_index( 8 ) ), 2 );
+    BOOST_CHECK_EQUAL( s.get_atom_faces( 8 ).size(), 1 );
+
+    // a removal after another freeze keeps the skeleton consistent
+    s.freeze();
+    s.remove( s.get_link_by_index( 0 ) );
+    BOOST_REQUIRE( !s.is_frozen() );
+    median_skeleton::face_index face_references = 0;
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      face_references += s.get_atom_faces( i ).size();
+    BOOST_CHECK_EQUAL( face_references, 3 * s.get_number_of_faces() );
+  }
+
+  static void bulk_insertion_matches_single_insertion()
+  {
+    median_skeleton single, bulk;
+    for( int i = 0; i < 10; ++ i )
+      {
+        single.add( vec4{ i >> 1, i & 1, 0, 1 } );
+        bulk.add( vec4{ i >> 1, i & 1, 0, 1 } );
+      }
+
+    std::vector< std::array< median_skeleton::atom_index, 3 > > faces;
+    for( median_skeleton::atom_index i = 0; i + 2 < 8; ++ i )
+      {
+        single.add( i, i + 1, i + 2 );
+        faces.push_back( {{ i, i + 1, i + 2 }} );
+      }
+    // duplicates, in any order, and degenerated faces are ignored
+    faces.push_back( {{ 2, 1, 0 }} );
+    faces.push_back( {{ 1, 1, 0 }} );
+    BOOST_CHECK_EQUAL( bulk.add_faces( faces ), 6 );
+
+    std::vector< std::pair< median_skeleton::atom_index, median_skeleton::atom_index > > links =
+      { { 8, 9 }, { 9, 8 }, { 0, 1 }, { 7, 9 } };
+    single.add( median_skeleton::atom_index( 8 ), median_skeleton::atom_index( 9 ) );
+    single.add( median_skeleton::atom_index( 7 ), median_skeleton::atom_index( 9 ) );
+    BOOST_CHECK_EQUAL( bulk.add_links( links ), 2 );
+
+    BOOST_REQUIRE_EQUAL( bulk.get_number_of_links(), single.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( bulk.get_number_of_faces(), single.get_number_of_faces() );
+    for( median_skeleton::atom_index i = 0; i < bulk.get_number_of_atoms(); ++ i )
+      {
+        BOOST_CHECK_EQUAL( bulk.get_number_of_links( i ), single.get_number_of_links( i ) );
+        BOOST_CHECK_EQUAL( bulk.get_atom_faces( i ).size(), single.get_atom_faces( i ).size() );
+        for( median_skeleton::atom_index j = 0; j < bulk.get_number_of_atoms(); ++ j )
+          BOOST_CHECK_EQUAL( bulk.is_a_link( i, j ), single.is_a_link( i, j ) );
+      }
+    for( median_skeleton::link_index i = 0; i < bulk.get_number_of_links(); ++ i )
+      {
+        auto& link = bulk.get_link_by_index( i );
+        BOOST_CHECK_EQUAL(
+            bulk.get_number_of_faces( i ),
+            single.get_number_of_faces( single.get_link_by_index( i ) ) );
+        BOOST_CHECK( bulk.is_valid( link.h1 ) && bulk.is_valid( link.h2 ) );
+      }
+
+    // a second batch only adds what is missing
+    faces = { {{ 0, 1, 2 }}, {{ 7, 8, 9 }} };
+    BOOST_CHECK_EQUAL( bulk.add_faces( faces ), 1 );
+    BOOST_CHECK_EQUAL( bulk.get_number_of_faces(), 7 );
+    BOOST_CHECK_EQUAL( bulk.get_number_of_links(), single.get_number_of_links() + 1 );
+  }
+
+  static void bulk_insertion_checks_indices()
+  {
+    median_skeleton s;
+    build_strip( s );
+    const auto nlinks = s.get_number_of_links();
+    const auto nfaces = s.get_number_of_faces();
+    std::vector< std::pair< median_skeleton::atom_index, median_skeleton::atom_index > > links =
+      { { 0, 9 }, { 0, 10 } };
+    std::vector< std::array< median_skeleton::atom_index, 3 > > faces =
+      { {{ 0, 8, 9 }}, {{ 0, 1, 10 }} };
+    BOOST_CHECK_THROW( s.add_links( links ), skeleton_invalid_atom_index );
+    BOOST_CHECK_THROW( s.add_faces( faces ), skeleton_invalid_atom_index );
+    BOOST_CHECK_EQUAL( s.get_number_of_links(), nlinks );
+    BOOST_CHECK_EQUAL( s.get_number_of_faces(), nfaces );
+  }
+
+  static void topology_builder_merges_thread_buffers()
+  {
+    const median_skeleton::atom_index natoms = 2000;
+    median_skeleton single, built;
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      {
+        single.add( vec4{ i >> 1, i & 1, 0, 1 } );
+        built.add( vec4{ i >> 1, i & 1, 0, 1 } );
+      }
+    for( median_skeleton::atom_index i = 0; i + 2 < natoms; i += 2 )
+      single.add( i, i + 1, i + 2 );
+    for( median_skeleton::atom_index i = 1; i + 2 < natoms; i += 4 )
+      single.add( i, i + 2 );
+
+    topology_builder builder( built );
+    # pragma omp parallel for schedule(dynamic,7)
+    for( median_skeleton::atom_index i = 0; i < natoms; i += 2 )
+      {
+        if( i + 2 < natoms )
+          {
+            builder.add_face( i, i + 1, i + 2 );
+            // staged twice, by possibly different threads
+            builder.add_face( i + 2, i, i + 1 );
+          }
+        if( i % 4 == 0 && i + 3 < natoms )
+          builder.add_link( i + 1, i + 3 );
+      }
+    auto created = builder.commit();
+
+    BOOST_CHECK_EQUAL( created.first, single.get_number_of_faces() );
+    BOOST_CHECK_EQUAL( created.second, single.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( built.get_number_of_links(), single.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( built.get_number_of_faces(), single.get_number_of_faces() );
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      {
+        BOOST_CHECK_EQUAL( built.get_number_of_links( i ), single.get_number_of_links( i ) );
+        BOOST_CHECK_EQUAL( built.get_atom_faces( i ).size(), single.get_atom_faces( i ).size() );
+      }
+
+    // the builder is empty after a commit
+    created = builder.commit();
+    BOOST_CHECK_EQUAL( created.first, 0 );
+    BOOST_CHECK_EQUAL( created.second, 0 );
+  }
+
+  static void duplicate_faces_are_not_inserted()
+  {
+    median_skeleton s;
+    build_strip( s );
+    const auto nlinks = s.get_number_of_links();
+    const auto nfaces = s.get_number_of_faces();
+    s.add( median_skeleton::atom_index( 2 ), median_skeleton::atom_index( 0 ), median_skeleton::atom_index( 1 ) );
+    s.add( median_skeleton::atom_index( 1 ), median_skeleton::atom_index( 2 ), median_skeleton::atom_index( 0 ) );
+    s.add( median_skeleton::atom_index( 3 ), median_skeleton::atom_index( 2 ), median_skeleton::atom_index( 1 ) );
+    BOOST_CHECK_EQUAL( s.get_number_of_faces(), nfaces );
+    BOOST_CHECK_EQUAL( s.get_number_of_links(), nlinks );
+  }
+
+  /* Check that two skeletons have the same links and faces, by comparing the
+   * counts and testing every pair of atoms. */
+  static void check_same_topology( median_skeleton& indexed, median_skeleton& reference )
+  {
+    BOOST_REQUIRE_EQUAL( indexed.get_number_of_atoms(), reference.get_number_of_atoms() );
+    BOOST_REQUIRE_EQUAL( indexed.get_number_of_links(), reference.get_number_of_links() );
+    BOOST_REQUIRE_EQUAL( indexed.get_number_of_faces(), reference.get_number_of_faces() );
+    const auto natoms = reference.get_number_of_atoms();
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      for( median_skeleton::atom_index j = 0; j < natoms; ++ j )
+        if( i != j )
+          BOOST_CHECK_EQUAL( indexed.is_a_link( i, j ), reference.is_a_link( i, j ) );
+  }
+
+  static void topology_index_follows_edits()
+  {
+    median_skeleton indexed, reference;
+    indexed.set_topology_index( true );
+    BOOST_REQUIRE( indexed.has_topology_index() );
+    BOOST_REQUIRE( !reference.has_topology_index() );
+    build_strip( indexed );
+    build_strip( reference );
+    check_same_topology( indexed, reference );
+
+    // duplicates are detected by the index
+    for( median_skeleton* s : { &indexed, &reference } )
+      {
+        s->add( median_skeleton::atom_index( 4 ), median_skeleton::atom_index( 2 ), median_skeleton::atom_index( 3 ) );
+        s->add( median_skeleton::atom_index( 3 ), median_skeleton::atom_index( 2 ) );
+      }
+    check_same_topology( indexed, reference );
+
+    // removals of faces, links and atoms
+    for( median_skeleton* s : { &indexed, &reference } )
+      {
+        s->remove( s->get_handle( s->get_face_by_index( 0 ) ) );
+        s->remove( s->get_handle( s->get_link_by_index( 2 ) ) );
+        s->remove( s->get_handle( s->get_atom_by_index( 5 ) ) );
+      }
+    check_same_topology( indexed, reference );
+
+    // removals by filters, which move elements in the tight buffers
+    for( median_skeleton* s : { &indexed, &reference } )
+      {
+        s->remove_atoms( []( const median_skeleton::atom& a ) { return a.x == 0; } );
+        s->remove_links( []( const median_skeleton::link& l ) { return ( l.h1.index + l.h2.index ) % 3 == 0; }, false );
+      }
+    check_same_topology( indexed, reference );
+
+    // a removed element can be added again
+    for( median_skeleton* s : { &indexed, &reference } )
+      {
+        for( median_skeleton::atom_index i = 0; i + 2 < s->get_number_of_atoms(); ++ i )
+          s->add( i, i + 1, i + 2 );
+      }
+    check_same_topology( indexed, reference );
+
+    // the index can be built on an existing skeleton
+    reference.set_topology_index( true );
+    check_same_topology( indexed, reference );
+    indexed.set_topology_index( false );
+    BOOST_CHECK( !indexed.has_topology_index() );
+    check_same_topology( indexed, reference );
+  }
+
+  static void small_vector_overflows_into_arena()
+  {
+    small_vector_arena arena;
+    small_vector< int, 4 > v;
+    for( int i = 0; i < 4; ++ i )
+      v.push_back( i, arena );
+    BOOST_CHECK( v.is_inline() );
+    BOOST_CHECK_EQUAL( arena.get_reserved_bytes(), 0 );
+
+    v.push_back( 4, arena );
+    BOOST_REQUIRE( !v.is_inline() );
+    BOOST_CHECK_GE( v.capacity(), 5 );
+    for( int i = 0; i < 5; ++ i )
+      BOOST_CHECK_EQUAL( v[i], i );
+
+    // moves steal the block of the arena, which is reused after a release
+    small_vector< int, 4 > w( std::move( v ) );
+    BOOST_CHECK( v.empty() && v.is_inline() );
+    const int* block = w.data();
+    small_vector< int, 4 >().swap( w );
+    BOOST_CHECK( w.empty() && w.is_inline() );
+    v.reserve( 5, arena );
+    BOOST_CHECK_EQUAL( v.data(), block );
+    BOOST_CHECK_EQUAL( arena.get_reserved_bytes(), small_vector_arena::slab_size );
+  }
+
+  static void high_valence_atoms()
+  {
+    // a fan of faces around atom #0, whose links and faces overflow
+    const median_skeleton::atom_index natoms = 50;
+    median_skeleton s;
+    s.add( vec4{ 0, 0, 0, 1 } );
+    for( median_skeleton::atom_index i = 1; i < natoms; ++ i )
+      s.add( vec4{ std::cos( i ), std::sin( i ), 0, 1 } );
+    for( median_skeleton::atom_index i = 1; i + 1 < natoms; ++ i )
+      s.add( median_skeleton::atom_index( 0 ), i, i + 1 );
+    BOOST_CHECK_EQUAL( s.get_number_of_links( median_skeleton::atom_index( 0 ) ), natoms - 1 );
+    BOOST_CHECK_EQUAL( s.get_atom_faces( 0 ).size(), natoms - 2 );
+
+    s.freeze();
+    BOOST_CHECK_EQUAL( s.get_number_of_links( median_skeleton::atom_index( 0 ) ), natoms - 1 );
+    s.thaw();
+    BOOST_CHECK_EQUAL( s.get_atom_faces( 0 ).size(), natoms - 2 );
+
+    // the topology moves with its arena
+    median_skeleton moved( std::move( s ) );
+    moved.remove( moved.get_handle( moved.get_atom_by_index( 1 ) ) );
+    BOOST_CHECK_EQUAL( moved.get_number_of_links( median_skeleton::atom_index( 0 ) ), natoms - 2 );
+    BOOST_CHECK_EQUAL( moved.get_atom_faces( 0 ).size(), natoms - 3 );
+    moved.remove( moved.get_handle( moved.get_atom_by_index( 0 ) ) );
+    BOOST_CHECK_EQUAL( moved.get_number_of_links(), natoms - 3 );
+    BOOST_CHECK_EQUAL( moved.get_number_of_faces(), 0 );
+  }
+
+  /* Remove every fourth atom of a long strip of triangles, and check that
+   * the links and faces of the remaining atoms are exactly the expected ones. */
+  static void check_large_removal( bool preserve_order )
+  {
+    const median_skeleton::atom_index natoms = 20000;
+    median_skeleton s;
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      s.add( vec4{ i >> 1, i & 1, 0, 1 } );
+    std::vector< std::array< median_skeleton::atom_index, 3 > > faces;
+    for( median_skeleton::atom_index i = 0; i + 2 < natoms; ++ i )
+      faces.push_back( {{ i, i + 1, i + 2 }} );
+    s.add_faces( faces );
+
+    auto removed = []( const median_skeleton::atom& a ){ return ( int( a.x ) * 2 + int( a.y ) ) % 4 == 0; };
+    median_skeleton::link_index expected_links = 0;
+    median_skeleton::face_index expected_faces = 0;
+    for( median_skeleton::atom_index i = 0; i < natoms; ++ i )
+      {
+        if( i % 4 == 0 )
+          continue;
+        if( i + 1 < natoms && ( i + 1 ) % 4 )
+          ++ expected_links;
+        if( i + 2 < natoms && ( i + 2 ) % 4 )
+          ++ expected_links;
+        if( i + 2 < natoms && ( i + 1 ) % 4 && ( i + 2 ) % 4 )
+          ++ expected_faces;
+      }
+
+    s.remove_atoms( removed, true, preserve_order );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), natoms - natoms / 4 );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_links(), expected_links );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_faces(), expected_faces );
+
+    median_skeleton::link_index links = 0;
+    median_skeleton::face_index atom_faces = 0;
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      {
+        auto& atom = s.get_atom_by_index( i );
+        BOOST_CHECK( !removed( atom ) );
+        if( preserve_order && i )
+          BOOST_CHECK_LT( s.get_atom_by_index( i - 1 ).x * 2 + s.get_atom_by_index( i - 1 ).y, atom.x * 2 + atom.y );
+        for( auto& link : s.get_atom_links( i ) )
+          {
+            BOOST_CHECK( s.is_valid( link.first ) );
+            BOOST_CHECK( s.is_a_link( i, s.get_index( link.second ) ) );
+          }
+        links += s.get_number_of_links( i );
+        atom_faces += s.get_atom_faces( i ).size();
+      }
+    BOOST_CHECK_EQUAL( links, 2 * expected_links );
+    BOOST_CHECK_EQUAL( atom_faces, 3 * expected_faces );
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      {
+        auto& link = s.get_link_by_index( i );
+        BOOST_CHECK_EQUAL( s.get_index( s.get_handle( link ) ), i );
+        BOOST_CHECK( s.is_valid( link.h1 ) && s.is_valid( link.h2 ) );
+      }
+    for( median_skeleton::face_index i = 0; i < s.get_number_of_faces(); ++ i )
+      BOOST_CHECK_EQUAL( s.get_index( s.get_handle( s.get_face_by_index( i ) ) ), i );
+  }
+
+  static void large_removal_keeps_the_topology_consistent()
+  {
+    check_large_removal( false );
+    check_large_removal( true );
+  }
+
+  /* Sum over links of the distance between the indices of their atoms */
+  static size_t links_spread( median_skeleton& s )
+  {
+    size_t result = 0;
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      {
+        auto& link = s.get_link_by_index( i );
+        const auto a = s.get_index( link.h1 ), b = s.get_index( link.h2 );
+        result += a < b ? b - a : a - b;
+      }
+    return result;
+  }
+
+  static void check_reorder( space_filling_curve curve )
+  {
+    // a grid of 64x64 atoms, created in a scattered order
+    const int side = 64, n = side * side;
+    median_skeleton s;
+    std::vector< median_skeleton::atom_index > index_of_position( n );
+    std::vector< median_skeleton::atom_handle > handles;
+    for( int k = 0; k < n; ++ k )
+      {
+        const int position = ( k * 1237 ) % n;
+        index_of_position[ position ] = k;
+        handles.push_back( s.add( vec4{ position % side, position / side, 0, 1 } ) );
+      }
+    std::vector< std::array< median_skeleton::atom_index, 3 > > faces;
+    for( int y = 0; y + 1 < side; ++ y )
+      for( int x = 0; x + 1 < side; ++ x )
+        {
+          const auto a = index_of_position[ y * side + x ], b = index_of_position[ y * side + x + 1 ];
+          const auto c = index_of_position[ ( y + 1 ) * side + x ], d = index_of_position[ ( y + 1 ) * side + x + 1 ];
+          faces.push_back( {{ a, b, c }} );
+          faces.push_back( {{ b, d, c }} );
+        }
+    s.add_faces( faces );
+
+    auto position = []( const median_skeleton::atom& a ){ return int( a.y ) * side + int( a.x ); };
+    auto& dense = s.add_atom_property< int >( "dense" );
+    auto& paged = s.add_atom_property< int >( "paged", base_property_buffer::paged );
+    auto& sparse = s.add_atom_property< std::string >( "sparse", base_property_buffer::sparse );
+    auto& link_sums = s.add_link_property< int >( "sums" );
+    for( median_skeleton::atom_index i = 0; i < n; ++ i )
+      {
+        const int p = position( s.get_atom_by_index( i ) );
+        dense.get< int >( i ) = p;
+        if( p < 1000 )
+          paged.get< int >( i ) = p;
+        if( p % 100 == 0 )
+          sparse.get< std::string >( i ) = std::to_string( p );
+      }
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      {
+        auto& link = s.get_link_by_index( i );
+        link_sums.get< int >( i ) = position( s.get( link.h1 ) ) + position( s.get( link.h2 ) );
+      }
+    const auto nlinks = s.get_number_of_links();
+    const auto nfaces = s.get_number_of_faces();
+    const size_t spread = links_spread( s );
+
+    s.reorder( curve );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_atoms(), n );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_links(), nlinks );
+    BOOST_REQUIRE_EQUAL( s.get_number_of_faces(), nfaces );
+    BOOST_CHECK_LT( links_spread( s ) * 8, spread );
+
+    for( int k = 0; k < n; ++ k )
+      {
+        BOOST_REQUIRE( s.is_valid( handles[ k ] ) );
+        BOOST_CHECK_EQUAL( position( s.get( handles[ k ] ) ), ( k * 1237 ) % n );
+      }
+    median_skeleton::face_index atom_faces = 0;
+    for( median_skeleton::atom_index i = 0; i < n; ++ i )
+      {
+        const int p = position( s.get_atom_by_index( i ) );
+        BOOST_CHECK_EQUAL( s.get_index( s.get_handle( s.get_atom_by_index( i ) ) ), i );
+        BOOST_CHECK_EQUAL( dense.get< int >( i ), p );
+        BOOST_CHECK_EQUAL( paged.get< int >( i ), p < 1000 ? p : 0 );
+        BOOST_CHECK_EQUAL( sparse.get< std::string >( i ), p % 100 == 0 ? std::to_string( p ) : std::string() );
+        for( auto& link : s.get_atom_links( i ) )
+          BOOST_CHECK( s.is_a_link( i, s.get_index( link.second ) ) );
+        atom_faces += s.get_atom_faces( i ).size();
+      }
+    BOOST_CHECK_EQUAL( atom_faces, 3 * nfaces );
+
+    // links are sorted by their atoms
+    std::array< median_skeleton::atom_index, 2 > previous = {{ 0, 0 }};
+    for( median_skeleton::link_index i = 0; i < nlinks; ++ i )
+      {
+        auto& link = s.get_link_by_index( i );
+        BOOST_CHECK_EQUAL( s.get_index( s.get_handle( link ) ), i );
+        BOOST_CHECK_EQUAL( link_sums.get< int >( i ), position( s.get( link.h1 ) ) + position( s.get( link.h2 ) ) );
+        const auto a = s.get_index( link.h1 ), b = s.get_index( link.h2 );
+        const std::array< median_skeleton::atom_index, 2 > key = {{ std::min( a, b ), std::max( a, b ) }};
+        BOOST_CHECK( !( key < previous ) );
+        previous = key;
+      }
+    for( median_skeleton::face_index i = 0; i < nfaces; ++ i )
+      BOOST_CHECK_EQUAL( s.get_index( s.get_handle( s.get_face_by_index( i ) ) ), i );
+  }
+
+  static void reorder_keeps_handles_and_properties()
+  {
+    check_reorder( morton_curve );
+    check_reorder( hilbert_curve );
+  }
+
+  static void batch_indices_match_single_ones()
+  {
+    median_skeleton s;
+    build_strip( s );
+    std::vector< median_skeleton::atom_handle > atom_handles;
+    std::vector< median_skeleton::link_handle > link_handles;
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      {
+        auto& l = s.get_link_by_index( i );
+        atom_handles.push_back( l.h1 );
+        atom_handles.push_back( l.h2 );
+        link_handles.push_back( s.get_handle( l ) );
+      }
+
+    std::vector< median_skeleton::atom_index > checked( atom_handles.size() ), unchecked( atom_handles.size() );
+    s.get_indices( atom_handles.data(), atom_handles.size(), checked.data() );
+    s.unchecked().get_indices( atom_handles.data(), atom_handles.size(), unchecked.data() );
+    for( size_t i = 0; i < atom_handles.size(); ++ i )
+      {
+        BOOST_CHECK_EQUAL( checked[ i ], s.get_index( atom_handles[ i ] ) );
+        BOOST_CHECK_EQUAL( unchecked[ i ], checked[ i ] );
+        BOOST_CHECK_EQUAL( &s.unchecked().get( atom_handles[ i ] ), &s.get( atom_handles[ i ] ) );
+      }
+
+    std::vector< median_skeleton::link_index > link_indices( link_handles.size() );
+    s.checked().get_indices( link_handles.data(), link_handles.size(), link_indices.data() );
+    for( size_t i = 0; i < link_handles.size(); ++ i )
+      BOOST_CHECK_EQUAL( link_indices[ i ], i );
+
+    // constant accesses have no side effect, mutable ones record the atoms
+    s.set_change_journal( true );
+    const median_skeleton& reader = s;
+    const auto epoch = s.get_change_journal()->get_epoch();
+    BOOST_CHECK_EQUAL( &reader.unchecked().get_atom_by_index( 0 ), &reader.get_atom_by_index( 0 ) );
+    BOOST_CHECK_EQUAL( &reader.checked().get( atom_handles[ 1 ] ), &reader.get( atom_handles[ 1 ] ) );
+    BOOST_CHECK_EQUAL( s.get_change_journal()->get_epoch(), epoch );
+    s.unchecked().get_atom_by_index( 0 ).w = 2;
+    BOOST_CHECK_EQUAL( s.get_change_journal()->get_epoch(), epoch + 1 );
+    s.set_change_journal( false );
+
+    // checked accesses throw whatever the global check symbols
+    const auto removed = atom_handles[ 0 ];
+    s.remove( removed );
+    BOOST_CHECK_THROW( s.checked().get_index( removed ), skeleton_invalid_atom_handle );
+    BOOST_CHECK_THROW( s.get_indices( &removed, 1, checked.data() ), skeleton_invalid_atom_handle );
+    BOOST_CHECK_THROW( s.checked().get_atom_by_index( s.get_number_of_atoms() ), skeleton_invalid_atom_index );
+  }
+
+  static void check_classes( const median_skeleton& s, const topology_classifier& c )
+  {
+    typedef topology_classifier tc;
+    const auto classes_of_links = []( const tc& c,
+        const std::vector< median_skeleton::link_index >& links )
+      {
+        tc::topology_class result = links.empty() ? tc::isolated_element : tc::regular_element;
+        for( auto l : links )
+          if( c.get_link_class( l ) == tc::junction_element )
+            result = tc::junction_element;
+          else if( c.get_link_class( l ) == tc::border_element && result != tc::junction_element )
+            result = tc::border_element;
+        return result;
+      };
+
+    for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+      {
+        const auto nfaces = s.get_number_of_faces( i );
+        BOOST_CHECK_EQUAL( c.get_link_class( i ),
+          nfaces == 0 ? tc::isolated_element : nfaces == 1 ? tc::border_element
+          : nfaces == 2 ? tc::regular_element : tc::junction_element );
+      }
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      {
+        std::vector< median_skeleton::link_index > links;
+        for( const auto& l : s.get_atom_links( i ) )
+          links.push_back( s.get_index( l.first ) );
+        BOOST_CHECK_EQUAL( c.get_atom_class( i ), classes_of_links( c, links ) );
+      }
+    for( median_skeleton::face_index i = 0; i < s.get_number_of_faces(); ++ i )
+      {
+        const auto& f = s.get_face_by_index( i );
+        std::vector< median_skeleton::link_index > links;
+        for( auto l : f.links )
+          links.push_back( s.get_index( l ) );
+        BOOST_CHECK_EQUAL( c.get_face_class( i ), classes_of_links( c, links ) );
+      }
+
+    for( size_t k = 0; k < tc::number_of_classes; ++ k )
+      {
+        const auto cls = tc::topology_class( k );
+        std::vector< median_skeleton::atom_index > atoms;
+        for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+          if( c.get_atom_class( i ) == cls )
+            atoms.push_back( i );
+        BOOST_CHECK( atoms == c.get_atoms( cls ) );
+        std::vector< median_skeleton::link_index > links;
+        for( median_skeleton::link_index i = 0; i < s.get_number_of_links(); ++ i )
+          if( c.get_link_class( i ) == cls )
+            links.push_back( i );
+        BOOST_CHECK( links == c.get_links( cls ) );
+        std::vector< median_skeleton::face_index > faces;
+        for( median_skeleton::face_index i = 0; i < s.get_number_of_faces(); ++ i )
+          if( c.get_face_class( i ) == cls )
+            faces.push_back( i );
+        BOOST_CHECK( faces == c.get_faces( cls ) );
+      }
+  }
+
+  static void topology_classifier_matches_definitions()
+  {
+    median_skeleton s;
+    build_strip( s );
+    topology_classifier c;
+    c.classify( s );
+    check_classes( s, c );
+    BOOST_CHECK_EQUAL( c.get_links( topology_classifier::isolated_element ).size(), 1 );
+    BOOST_CHECK_EQUAL( c.get_links( topology_classifier::border_element ).size(), 8 );
+    BOOST_CHECK( c.get_faces( topology_classifier::junction_element ).empty() );
+    BOOST_CHECK_EQUAL( c.update( s ), 0 );
+
+    // same numbers of elements: the update is incremental. Atoms 8 and 9
+    // lose their only link
+    s.remove( s.get_link_by_index( s.get_number_of_links() - 1 ) );
+    s.add( median_skeleton::atom_index( 0 ), median_skeleton::atom_index( 3 ) );
+    BOOST_CHECK_EQUAL( c.update( s ), 2 );
+    check_classes( s, c );
+    BOOST_CHECK_EQUAL( c.get_atoms( topology_classifier::isolated_element ).size(), 2 );
+
+    // a third face on link 1 -- 2 makes it a junction
+    s.add( median_skeleton::atom_index( 1 ), median_skeleton::atom_index( 2 ), median_skeleton::atom_index( 8 ) );
+    BOOST_CHECK( c.update( s ) );
+    check_classes( s, c );
+    BOOST_CHECK_EQUAL( c.get_links( topology_classifier::junction_element ).size(), 1 );
+    BOOST_CHECK_EQUAL( c.get_faces( topology_classifier::junction_element ).size(), 3 );
+
+    // with a change journal, updates without change count nothing again
+    s.set_change_journal( true );
+    BOOST_CHECK_EQUAL( c.update( s ), 0 );
+    BOOST_CHECK_EQUAL( c.update( s ), 0 );
+    s.remove( s.get_link_by_index( s.get_number_of_links() - 1 ) );
+    s.add( median_skeleton::atom_index( 8 ), median_skeleton::atom_index( 9 ) );
+    BOOST_CHECK( c.update( s ) );
+    check_classes( s, c );
+    BOOST_CHECK_EQUAL( c.update( s ), 0 );
+    check_classes( s, c );
+  }
+
+  static void clone_is_a_deep_copy()
+  {
+    median_skeleton s;
+    build_strip( s );
+    auto& dense = s.add_atom_property< int >( "dense" );
+    auto& names = s.add_atom_property< std::string >( "names" );
+    auto& paged = s.add_link_property< int >( "paged", base_property_buffer::paged );
+    auto& sparse = s.add_face_property< std::vector< int > >( "sparse", base_property_buffer::sparse );
+    for( median_skeleton::atom_index i = 0; i < s.get_number_of_atoms(); ++ i )
+      {
+        dense.get< int >( i ) = i;
+        names.get< std::string >( i ) = std::to_string( i );
+      }
+    paged.get< int >( 3 ) = 3;
+    sparse.get< std::vector< int > >( 1 ) = { 1, 2 };
+    const auto handle = s.get_handle( s.get_atom_by_index( 4 ) );
+
+    median_skeleton c = s.clone();
+    check_same_topology( c, s );
+    BOOST_REQUIRE( c.is_valid( handle ) );
+    BOOST_CHECK_EQUAL( c.get_index( handle ), 4 );
+    for( median_skeleton::atom_index i = 0; i < c.get_number_of_atoms(); ++ i )
+      {
+        BOOST_CHECK_EQUAL( c.get_atom_by_index( i ).x, s.get_atom_by_index( i ).x );
+        BOOST_CHECK_EQUAL( c.get_atom_by_index( i ).y, s.get_atom_by_index( i ).y );
+        BOOST_CHECK_EQUAL( c.get_atom_faces( i ).size(), s.get_atom_faces( i ).size() );
+      }
+    auto& cloned_dense = c.get_atom_property( "dense" );
+    auto& cloned_names = c.get_atom_property( "names" );
+    BOOST_REQUIRE( &cloned_dense != &dense );
+    for( median_skeleton::atom_index i = 0; i < c.get_number_of_atoms(); ++ i )
+      {
+        BOOST_CHECK_EQUAL( cloned_dense.get< int >( i ), int( i ) );
+        BOOST_CHECK_EQUAL( cloned_names.get< std::string >( i ), std::to_string( i ) );
+      }
+    BOOST_CHECK_EQUAL( c.get_link_property( "paged" ).get< int >( 3 ), 3 );
+    BOOST_CHECK( !c.get_link_property( "paged" ).is_allocated( 3000 ) );
+    BOOST_CHECK( c.get_face_property( "sparse" ).get< std::vector< int > >( 1 ) == std::vector< int >( { 1, 2 } ) );
+
+    // both skeletons can be edited independently
+    const auto natoms = s.get_number_of_atoms();
+    const auto nlinks = s.get_number_of_links();
+    c.remove( handle );
+    c.add( vec4{ 10, 10, 10, 1 } );
+    cloned_dense.get< int >( 0 ) = 42;
+    BOOST_CHECK_EQUAL( s.get_number_of_atoms(), natoms );
+    BOOST_CHECK_EQUAL( s.get_number_of_links(), nlinks );
+    BOOST_CHECK( s.is_valid( handle ) );
+    BOOST_CHECK_EQUAL( dense.get< int >( 0 ), 0 );
+
+    // a frozen topology is cloned frozen
+    s.freeze();
+    median_skeleton f = s.clone();
+    BOOST_CHECK( f.is_frozen() );
+    check_same_topology( f, s );
+
+    median_skeleton g = s.clone_geometry_only();
+    BOOST_CHECK_EQUAL( g.get_number_of_atoms(), natoms );
+    BOOST_CHECK_EQUAL( g.get_number_of_links(), 0 );
+    BOOST_CHECK_EQUAL( g.get_number_of_faces(), 0 );
+    BOOST_CHECK( g.is_valid( handle ) );
+    BOOST_CHECK_EQUAL( g.get_number_of_links( g.get_index( handle ) ), 0 );
+    BOOST_CHECK_EQUAL( g.get_atom_property( "names" ).get< std::string >( 7 ), "7" );
+    g.add( 0, 1 );
+    BOOST_CHECK_EQUAL( g.get_number_of_links(), 1 );
+
+    s.add_atom_property< std::unique_ptr< int > >( "not copyable" );
+    BOOST_CHECK_THROW( s.clone(), skeleton_property_not_copyable );
+  }
+
+  test_suite* topology_management_test_suite()
+  {
+    test_suite* suite = BOOST_TEST_SUITE( "topology_management" );
+    ADD_TEST_CASE( freeze_keeps_the_topology );
+    ADD_TEST_CASE( freeze_keeps_the_topology_of_long_strips );
+    ADD_TEST_CASE( edit_thaws_the_topology );
+    ADD_TEST_CASE( bulk_insertion_matches_single_insertion );
+    ADD_TEST_CASE( bulk_insertion_checks_indices );
+    ADD_TEST_CASE( topology_builder_merges_thread_buffers );
+    ADD_TEST_CASE( duplicate_faces_are_not_inserted );
+    ADD_TEST_CASE( topology_index_follows_edits );
+    ADD_TEST_CASE( small_vector_overflows_into_arena );
+    ADD_TEST_CASE( high_valence_atoms );
+    ADD_TEST_CASE( large_removal_keeps_the_topology_consistent );
+    ADD_TEST_CASE( reorder_keeps_handles_and_properties );
+    ADD_TEST_CASE( clone_is_a_deep_copy );
+    ADD_TEST_CASE( batch_indices_match_single_ones );
+    ADD_TEST_CASE( topology_classifier_matches_definitions );
+    return suite;
+  }
+
+END_MP_NAMESPACE
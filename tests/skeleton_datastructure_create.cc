@@ -3,6 +3,9 @@
  */
 # include "test.h"
 
+# include <array>
+# include <string>
+
 BEGIN_MP_NAMESPACE
 
   static void create_on_empty_skeleton_dont_throw()
@@ -96,6 +99,41 @@ BEGIN_MP_NAMESPACE
       }
   }
 
+  static void trivial_properties_are_aligned_and_kept_by_growth()
+  {
+    typedef std::array< float, 3 > triple;
+    datastructure s;
+    s.add_atom_property< triple >( "array" );
+    s.add_atom_property< std::string >( "name" );
+    auto& array = *s.m_atom_properties[0];
+    auto& name = *s.m_atom_properties[1];
+
+    for( size_t i = 0; i < 1000; ++ i )
+      {
+        s.create_atom();
+        BOOST_REQUIRE_EQUAL( reinterpret_cast< uintptr_t >( array.m_buffer ) % simd_alignment, 0 );
+        BOOST_REQUIRE_EQUAL( array.get< triple >( i )[ 0 ], 0 );
+        array.get< triple >( i ) = { float( i ), float( 2 * i ), float( 3 * i ) };
+        name.get< std::string >( i ) = std::to_string( i );
+      }
+
+    for( size_t i = 0; i < 1000; ++ i )
+      {
+        auto& value = array.get< triple >( i );
+        BOOST_REQUIRE_EQUAL( value[ 0 ], float( i ) );
+        BOOST_REQUIRE_EQUAL( value[ 2 ], float( 3 * i ) );
+        BOOST_REQUIRE_EQUAL( name.get< std::string >( i ), std::to_string( i ) );
+      }
+
+    array.move( 999, 0 );
+    BOOST_CHECK_EQUAL( array.get< triple >( 0 )[ 1 ], float( 2 * 999 ) );
+    BOOST_CHECK_EQUAL( array.get< triple >( 999 )[ 1 ], 0 );
+    array.destroy( 10, 20 );
+    for( size_t i = 10; i < 20; ++ i )
+      BOOST_CHECK_EQUAL( array.get< triple >( i )[ 2 ], 0 );
+    BOOST_CHECK_EQUAL( array.get< triple >( 20 )[ 2 ], float( 60 ) );
+  }
+
   test_suite* create_element_test_suite()
   {
     test_suite* suite = BOOST_TEST_SUITE( "destruction" );
@@ -105,6 +143,7 @@ BEGIN_MP_NAMESPACE
     ADD_TEST_CASE( handle_points_to_the_new_element );
     ADD_TEST_CASE( new_element_has_the_expected_handle );
     ADD_TEST_CASE( new_element_has_expected_property );
+    ADD_TEST_CASE( trivial_properties_are_aligned_and_kept_by_growth );
     return suite;
   }
 